@@ -49,6 +49,7 @@
 #include <libnotify/notify.h>
 
 #include "brasero-burn-dialog.h"
+#include "brasero-burn-duplicate.h"
 
 #include "brasero-session-cfg.h"
 #include "brasero-session-helper.h"
@@ -80,6 +81,11 @@ struct BraseroBurnDialogPrivate {
 	BraseroBurn *burn;
 	BraseroBurnSession *session;
 
+	/* When copies are made on several drives at once */
+	BraseroBurnDuplicate *duplicate;
+	GHashTable *drive_bars;
+	GtkWidget *drives;
+
 	/* This is to remember some settins after ejection */
 	BraseroTrackType input;
 	BraseroMedia media;
@@ -2199,10 +2205,153 @@ brasero_burn_dialog_record_spanned_session (BraseroBurnDialog *dialog,
 	return result;
 }
 
+static void
+brasero_burn_dialog_duplicate_changed_cb (BraseroBurnDuplicate *duplicate,
+					  BraseroDrive *drive,
+					  BraseroBurnDialog *dialog)
+{
+	BraseroBurnDialogPrivate *priv;
+	BraseroBurnAction action;
+	BraseroBurnResult result;
+	const GError *error = NULL;
+	gdouble progress = 0.0;
+	gdouble overall = 0.0;
+	GHashTableIter iter;
+	GtkWidget *bar;
+	gpointer key;
+	guint num = 0;
+
+	priv = BRASERO_BURN_DIALOG_PRIVATE (dialog);
+
+	bar = g_hash_table_lookup (priv->drive_bars, drive);
+	if (!bar)
+		return;
+
+	result = brasero_burn_duplicate_get_drive_status (duplicate,
+							  drive,
+							  &progress,
+							  &action,
+							  &error);
+
+	gtk_progress_bar_set_fraction (GTK_PROGRESS_BAR (bar), CLAMP (progress, 0.0, 1.0));
+	if (result == BRASERO_BURN_RUNNING)
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), brasero_burn_action_to_string (action));
+	else if (result == BRASERO_BURN_OK)
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), _("Success"));
+	else if (result == BRASERO_BURN_CANCEL)
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), _("Cancelled"));
+	else if (result == BRASERO_BURN_NOT_RUNNING)
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), _("Waiting"));
+	else
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), error? error->message:_("Error"));
+
+	/* The main progress shows the mean of all drives */
+	g_hash_table_iter_init (&iter, priv->drive_bars);
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		progress = 0.0;
+		brasero_burn_duplicate_get_drive_status (duplicate,
+							 key,
+							 &progress,
+							 NULL,
+							 NULL);
+		overall += CLAMP (progress, 0.0, 1.0);
+		num ++;
+	}
+
+	overall /= num;
+	brasero_burn_dialog_progress_changed_real (dialog,
+						   -1,
+						   -1,
+						   -1,
+						   overall,
+						   overall,
+						   -1,
+						   priv->media);
+}
+
+static void
+brasero_burn_dialog_duplicate_add_drives (BraseroBurnDialog *dialog,
+					  GSList *drives)
+{
+	BraseroBurnDialogPrivate *priv;
+	guint row = 0;
+
+	priv = BRASERO_BURN_DIALOG_PRIVATE (dialog);
+
+	gtk_container_foreach (GTK_CONTAINER (priv->drives),
+			       (GtkCallback) gtk_widget_destroy,
+			       NULL);
+	g_hash_table_remove_all (priv->drive_bars);
+
+	for (; drives; drives = drives->next) {
+		BraseroDrive *drive;
+		GtkWidget *label;
+		GtkWidget *bar;
+		gchar *name;
+
+		drive = drives->data;
+
+		name = brasero_drive_get_display_name (drive);
+		label = gtk_label_new (name);
+		g_free (name);
+
+		gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
+		gtk_grid_attach (GTK_GRID (priv->drives), label, 0, row, 1, 1);
+
+		bar = gtk_progress_bar_new ();
+		gtk_progress_bar_set_show_text (GTK_PROGRESS_BAR (bar), TRUE);
+		gtk_progress_bar_set_text (GTK_PROGRESS_BAR (bar), _("Waiting"));
+		gtk_widget_set_hexpand (bar, TRUE);
+		gtk_grid_attach (GTK_GRID (priv->drives), bar, 1, row, 1, 1);
+
+		g_hash_table_insert (priv->drive_bars, drive, bar);
+		row ++;
+	}
+
+	gtk_widget_show_all (priv->drives);
+}
+
+static BraseroBurnResult
+brasero_burn_dialog_record_duplicate (BraseroBurnDialog *dialog,
+				      GSList *drives,
+				      GError **error)
+{
+	BraseroBurnDialogPrivate *priv;
+	BraseroBurnResult result;
+
+	priv = BRASERO_BURN_DIALOG_PRIVATE (dialog);
+
+	brasero_burn_dialog_duplicate_add_drives (dialog, drives);
+
+	/* The source is read with our own BraseroBurn so that all questions
+	 * and the reading progress go through the usual callbacks */
+	priv->duplicate = brasero_burn_duplicate_new (priv->burn);
+	g_signal_connect (priv->duplicate,
+			  "drive-changed",
+			  G_CALLBACK (brasero_burn_dialog_duplicate_changed_cb),
+			  dialog);
+
+	result = brasero_burn_duplicate_record (priv->duplicate,
+						priv->session,
+						drives,
+						error);
+
+	g_signal_handlers_disconnect_by_func (priv->duplicate,
+					      brasero_burn_dialog_duplicate_changed_cb,
+					      dialog);
+	g_object_unref (priv->duplicate);
+	priv->duplicate = NULL;
+
+	/* Keep the drives shown so that the user can see which failed */
+	g_hash_table_remove_all (priv->drive_bars);
+	return result;
+}
+
 static BraseroBurnResult
 brasero_burn_dialog_record_session (BraseroBurnDialog *dialog)
 {
 	gboolean retry;
+	GSList *drives;
 	GError *error = NULL;
 	BraseroBurnResult result;
 	BraseroBurnDialogPrivate *priv;
@@ -2221,13 +2370,19 @@ brasero_burn_dialog_record_session (BraseroBurnDialog *dialog)
 	if (result != BRASERO_BURN_OK)
 		return result;
 
-	if (BRASERO_IS_SESSION_SPAN (priv->session))
+	drives = brasero_burn_duplicate_get_session_drives (priv->session);
+	if (drives && drives->next)
+		result = brasero_burn_dialog_record_duplicate (dialog, drives, &error);
+	else if (BRASERO_IS_SESSION_SPAN (priv->session))
 		result = brasero_burn_dialog_record_spanned_session (dialog, &error);
 	else
 		result = brasero_burn_record (priv->burn,
 					      priv->session,
 					      &error);
 
+	g_slist_foreach (drives, (GFunc) g_object_unref, NULL);
+	g_slist_free (drives);
+
 	retry = brasero_burn_dialog_end_session (dialog,
 						 result,
 						 error);
@@ -2497,6 +2652,16 @@ brasero_burn_dialog_cancel (BraseroBurnDialog *dialog,
 		return TRUE;
 	}
 
+	if (priv->duplicate) {
+		if (brasero_burn_duplicate_cancel (priv->duplicate, (force_cancellation == TRUE)) == BRASERO_BURN_DANGEROUS) {
+			if (!brasero_burn_dialog_cancel_dialog (dialog))
+				return FALSE;
+
+			brasero_burn_duplicate_cancel (priv->duplicate, FALSE);
+		}
+		return TRUE;
+	}
+
 	if (!priv->burn)
 		return TRUE;
 
@@ -2566,6 +2731,19 @@ brasero_burn_dialog_init (BraseroBurnDialog * obj)
 			    TRUE,
 			    0);
 
+	/* Only shown when burning to several drives at once */
+	priv->drives = gtk_grid_new ();
+	gtk_grid_set_row_spacing (GTK_GRID (priv->drives), 6);
+	gtk_grid_set_column_spacing (GTK_GRID (priv->drives), 12);
+	gtk_widget_set_margin_top (priv->drives, 12);
+	gtk_box_pack_start (GTK_BOX (vbox),
+			    priv->drives,
+			    FALSE,
+			    TRUE,
+			    0);
+
+	priv->drive_bars = g_hash_table_new (g_direct_hash, g_direct_equal);
+
 	/* buttons */
 	priv->cancel = gtk_dialog_add_button (GTK_DIALOG (obj),
 					      GTK_STOCK_CANCEL,
@@ -2599,6 +2777,17 @@ brasero_burn_dialog_finalize (GObject * object)
 		priv->initial_icon = NULL;
 	}
 
+	if (priv->duplicate) {
+		brasero_burn_duplicate_cancel (priv->duplicate, FALSE);
+		g_object_unref (priv->duplicate);
+		priv->duplicate = NULL;
+	}
+
+	if (priv->drive_bars) {
+		g_hash_table_destroy (priv->drive_bars);
+		priv->drive_bars = NULL;
+	}
+
 	if (priv->burn) {
 		brasero_burn_cancel (priv->burn, TRUE);
 		g_object_unref (priv->burn);
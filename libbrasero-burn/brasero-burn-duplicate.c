@@ -0,0 +1,987 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gi18n-lib.h>
+
+#include "brasero-burn-duplicate.h"
+#include "brasero-burn-private.h"
+
+#include "brasero-medium-monitor.h"
+#include "brasero-drive.h"
+
+#include "burn-basics.h"
+#include "burn-debug.h"
+#include "burn-image-format.h"
+#include "brasero-session-helper.h"
+#include "brasero-track-type-private.h"
+#include "brasero-track-image.h"
+#include "brasero-tags.h"
+
+/**
+ * Makes several copies of the same contents at the same time with one
+ * BraseroBurn (and therefore one BraseroTask) per destination drive.
+ *
+ * The source is read or generated only once into a temporary image by the
+ * "reader" BraseroBurn. That image (held in memory when the session budget
+ * allows it, otherwise on disk where the page cache serves it) is then the
+ * read-only source for all recorders which are all started before any of
+ * them finishes.
+ *
+ * All recorders are driven from one main loop: their recording tasks run
+ * without a loop of their own (see brasero_burn_record_start ()). What
+ * comes before and after (locking the disc, questions, checksum, ejection)
+ * is done for one drive at a time from that loop so that no drive has to
+ * wait for another to return before it is unlocked.
+ *
+ * The questions of the recorders are emitted again by the reader so that
+ * the caller answers them as it does for any other burn.
+ */
+
+typedef struct _BraseroBurnDuplicateDrive BraseroBurnDuplicateDrive;
+struct _BraseroBurnDuplicateDrive {
+	BraseroBurnDuplicate *self;
+
+	BraseroDrive *drive;
+	BraseroBurnSession *session;
+	BraseroBurn *burn;
+
+	BraseroBurnAction action;
+	gdouble progress;
+
+	BraseroBurnResult result;
+	GError *error;
+
+	guint running:1;
+	guint started:1;
+};
+
+typedef struct _BraseroBurnDuplicatePrivate BraseroBurnDuplicatePrivate;
+struct _BraseroBurnDuplicatePrivate
+{
+	BraseroBurn *reader;
+	BraseroBurnSession *session;
+
+	GSList *drives;
+	GSList *tracks;
+
+	GMainLoop *loop;
+
+	/* Drives waiting for brasero_burn_record_start () or
+	 * brasero_burn_record_resume () to be called */
+	GSList *queue;
+	guint step_id;
+	guint running;
+
+	guint cancelled:1;
+	guint busy:1;
+};
+
+#define BRASERO_BURN_DUPLICATE_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_BURN_DUPLICATE, BraseroBurnDuplicatePrivate))
+
+G_DEFINE_TYPE (BraseroBurnDuplicate, brasero_burn_duplicate, G_TYPE_OBJECT);
+
+enum {
+	DRIVE_CHANGED_SIGNAL,
+	LAST_SIGNAL
+};
+static guint brasero_burn_duplicate_signals [LAST_SIGNAL] = { 0 };
+
+static BraseroBurnDuplicateDrive *
+brasero_burn_duplicate_find_drive (BraseroBurnDuplicate *self,
+				   BraseroDrive *drive)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	GSList *iter;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	for (iter = priv->drives; iter; iter = iter->next) {
+		BraseroBurnDuplicateDrive *dup;
+
+		dup = iter->data;
+		if (dup->drive == drive)
+			return dup;
+	}
+
+	return NULL;
+}
+
+static void
+brasero_burn_duplicate_drive_changed (BraseroBurnDuplicateDrive *dup)
+{
+	g_signal_emit (dup->self,
+		       brasero_burn_duplicate_signals [DRIVE_CHANGED_SIGNAL],
+		       0,
+		       dup->drive);
+}
+
+static void
+brasero_burn_duplicate_progress_changed_cb (BraseroBurn *burn,
+					    gdouble overall_progress,
+					    gdouble action_progress,
+					    glong time_remaining,
+					    BraseroBurnDuplicateDrive *dup)
+{
+	/* -1.0 is sent when ejecting; keep the last value */
+	if (overall_progress < 0.0)
+		return;
+
+	dup->progress = overall_progress;
+	brasero_burn_duplicate_drive_changed (dup);
+}
+
+static void
+brasero_burn_duplicate_action_changed_cb (BraseroBurn *burn,
+					  BraseroBurnAction action,
+					  BraseroBurnDuplicateDrive *dup)
+{
+	dup->action = action;
+	brasero_burn_duplicate_drive_changed (dup);
+}
+
+/**
+ * The signal emitted by a recorder is emitted again by the reader with the
+ * same parameters. @instance_and_params [0] is set here.
+ */
+
+static BraseroBurnResult
+brasero_burn_duplicate_forward (BraseroBurn *burn,
+				BraseroBurnDuplicateDrive *dup,
+				GValue *instance_and_params)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	GSignalInvocationHint *hint;
+	GValue return_value;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (dup->self);
+	hint = g_signal_get_invocation_hint (burn);
+
+	BRASERO_BURN_LOG ("Forwarding %s from %s",
+			  g_signal_name (hint->signal_id),
+			  brasero_drive_get_device (dup->drive));
+
+	instance_and_params [0].g_type = 0;
+	g_value_init (instance_and_params, G_TYPE_FROM_INSTANCE (priv->reader));
+	g_value_set_instance (instance_and_params, priv->reader);
+
+	return_value.g_type = 0;
+	g_value_init (&return_value, G_TYPE_INT);
+	g_value_set_int (&return_value, BRASERO_BURN_CANCEL);
+
+	g_signal_emitv (instance_and_params,
+			hint->signal_id,
+			0,
+			&return_value);
+
+	g_value_unset (instance_and_params);
+
+	return g_value_get_int (&return_value);
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_question_cb (BraseroBurn *burn,
+				    BraseroBurnDuplicateDrive *dup)
+{
+	GValue instance_and_params [1];
+
+	return brasero_burn_duplicate_forward (burn, dup, instance_and_params);
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_insert_media_cb (BraseroBurn *burn,
+					BraseroDrive *drive,
+					BraseroBurnError error,
+					BraseroMedia required_media,
+					BraseroBurnDuplicateDrive *dup)
+{
+	GValue instance_and_params [4];
+	BraseroBurnResult result;
+
+	instance_and_params [1].g_type = 0;
+	g_value_init (instance_and_params + 1, BRASERO_TYPE_DRIVE);
+	g_value_set_object (instance_and_params + 1, drive);
+
+	instance_and_params [2].g_type = 0;
+	g_value_init (instance_and_params + 2, G_TYPE_INT);
+	g_value_set_int (instance_and_params + 2, error);
+
+	instance_and_params [3].g_type = 0;
+	g_value_init (instance_and_params + 3, G_TYPE_INT);
+	g_value_set_int (instance_and_params + 3, required_media);
+
+	result = brasero_burn_duplicate_forward (burn, dup, instance_and_params);
+
+	g_value_unset (instance_and_params + 1);
+	return result;
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_eject_failure_cb (BraseroBurn *burn,
+					 BraseroDrive *drive,
+					 BraseroBurnDuplicateDrive *dup)
+{
+	GValue instance_and_params [2];
+	BraseroBurnResult result;
+
+	instance_and_params [1].g_type = 0;
+	g_value_init (instance_and_params + 1, BRASERO_TYPE_DRIVE);
+	g_value_set_object (instance_and_params + 1, drive);
+
+	result = brasero_burn_duplicate_forward (burn, dup, instance_and_params);
+
+	g_value_unset (instance_and_params + 1);
+	return result;
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_location_request_cb (BraseroBurn *burn,
+					    GError *error,
+					    gboolean is_temporary,
+					    BraseroBurnDuplicateDrive *dup)
+{
+	GValue instance_and_params [3];
+
+	instance_and_params [1].g_type = 0;
+	g_value_init (instance_and_params + 1, G_TYPE_POINTER);
+	g_value_set_pointer (instance_and_params + 1, error);
+
+	instance_and_params [2].g_type = 0;
+	g_value_init (instance_and_params + 2, G_TYPE_INT);
+	g_value_set_int (instance_and_params + 2, is_temporary);
+
+	return brasero_burn_duplicate_forward (burn, dup, instance_and_params);
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_install_missing_cb (BraseroBurn *burn,
+					   BraseroPluginErrorType error,
+					   const gchar *detail,
+					   BraseroBurnDuplicateDrive *dup)
+{
+	GValue instance_and_params [3];
+	BraseroBurnResult result;
+
+	instance_and_params [1].g_type = 0;
+	g_value_init (instance_and_params + 1, G_TYPE_INT);
+	g_value_set_int (instance_and_params + 1, error);
+
+	instance_and_params [2].g_type = 0;
+	g_value_init (instance_and_params + 2, G_TYPE_STRING);
+	g_value_set_string (instance_and_params + 2, detail);
+
+	result = brasero_burn_duplicate_forward (burn, dup, instance_and_params);
+
+	g_value_unset (instance_and_params + 2);
+	return result;
+}
+
+static void
+brasero_burn_duplicate_drive_free (BraseroBurnDuplicateDrive *dup)
+{
+	if (dup->burn) {
+		g_signal_handlers_disconnect_matched (dup->burn,
+						      G_SIGNAL_MATCH_DATA,
+						      0,
+						      0,
+						      NULL,
+						      NULL,
+						      dup);
+		g_object_unref (dup->burn);
+	}
+
+	if (dup->session)
+		g_object_unref (dup->session);
+
+	if (dup->error)
+		g_error_free (dup->error);
+
+	g_object_unref (dup->drive);
+	g_free (dup);
+}
+
+/**
+ * Returns the list of destination drives for @session: its burner first and
+ * then those set with the BRASERO_SESSION_DUPLICATE_DRIVES tag. The list
+ * holds a reference on each drive.
+ */
+
+GSList *
+brasero_burn_duplicate_get_session_drives (BraseroBurnSession *session)
+{
+	BraseroMediumMonitor *monitor;
+	BraseroDrive *burner;
+	GValue *value = NULL;
+	GSList *drives = NULL;
+	gchar **devices;
+	gint i;
+
+	burner = brasero_burn_session_get_burner (session);
+	if (!burner || brasero_drive_is_fake (burner))
+		return NULL;
+
+	drives = g_slist_prepend (drives, g_object_ref (burner));
+
+	brasero_burn_session_tag_lookup (session,
+					 BRASERO_SESSION_DUPLICATE_DRIVES,
+					 &value);
+	if (!value || !G_VALUE_HOLDS (value, G_TYPE_STRV))
+		return drives;
+
+	devices = g_value_get_boxed (value);
+	if (!devices)
+		return drives;
+
+	monitor = brasero_medium_monitor_get_default ();
+	for (i = 0; devices [i]; i ++) {
+		BraseroDrive *drive;
+
+		drive = brasero_medium_monitor_get_drive (monitor, devices [i]);
+		if (!drive) {
+			BRASERO_BURN_LOG ("Drive %s could not be found", devices [i]);
+			continue;
+		}
+
+		if (g_slist_find (drives, drive)
+		|| !brasero_drive_can_write (drive)) {
+			BRASERO_BURN_LOG ("Drive %s ignored for duplication", devices [i]);
+			g_object_unref (drive);
+			continue;
+		}
+
+		drives = g_slist_prepend (drives, drive);
+	}
+	g_object_unref (monitor);
+
+	return g_slist_reverse (drives);
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_read (BraseroBurnDuplicate *self,
+			     BraseroImageFormat format,
+			     GError **error)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	BraseroTrackImage *track;
+	BraseroBurnResult result;
+	guint64 blocks = 0;
+	goffset bytes = 0;
+	gboolean res;
+	gchar *image = NULL;
+	gchar *toc = NULL;
+	gchar *uri;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+
+	/* The image belongs to the session (like any other temporary file)
+	 * and lives as long as it does. */
+	brasero_burn_session_get_size (priv->session, NULL, &bytes);
+	result = brasero_burn_session_get_tmp_image (priv->session,
+						     format,
+						     bytes > 0? bytes:-1,
+						     &image,
+						     &toc,
+						     error);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	BRASERO_BURN_LOG ("Reading source once to %s (toc = %s)",
+			  image,
+			  toc ? toc:"none");
+
+	brasero_burn_session_push_settings (priv->session);
+	brasero_burn_session_set_flags (priv->session,
+					BRASERO_BURN_FLAG_CHECK_SIZE|
+					BRASERO_BURN_FLAG_NOGRACE);
+	brasero_burn_session_set_image_output_full (priv->session,
+						    format,
+						    image,
+						    toc);
+
+	result = brasero_burn_record (priv->reader,
+				      priv->session,
+				      error);
+
+	brasero_burn_session_pop_settings (priv->session);
+
+	if (result != BRASERO_BURN_OK) {
+		g_free (image);
+		g_free (toc);
+		return result;
+	}
+
+	if (format == BRASERO_IMAGE_FORMAT_BIN) {
+		uri = g_filename_to_uri (image, NULL, NULL);
+		res = brasero_image_format_get_iso_size (uri, &blocks, NULL, NULL, error);
+	}
+	else {
+		uri = g_filename_to_uri (toc, NULL, NULL);
+		if (format == BRASERO_IMAGE_FORMAT_CLONE)
+			res = brasero_image_format_get_clone_size (uri, &blocks, NULL, NULL, error);
+		else if (format == BRASERO_IMAGE_FORMAT_CUE)
+			res = brasero_image_format_get_cue_size (uri, &blocks, NULL, NULL, error);
+		else
+			res = brasero_image_format_get_cdrdao_size (uri, &blocks, NULL, NULL, error);
+	}
+	g_free (uri);
+
+	if (!res) {
+		g_free (image);
+		g_free (toc);
+		return BRASERO_BURN_ERR;
+	}
+
+	track = brasero_track_image_new ();
+	brasero_track_image_set_source (track, image, toc, format);
+	brasero_track_image_set_block_num (track, blocks);
+	priv->tracks = g_slist_prepend (NULL, track);
+
+	g_free (image);
+	g_free (toc);
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_burn_duplicate_setup_drive (BraseroBurnDuplicate *self,
+				    BraseroBurnDuplicateDrive *dup,
+				    BraseroBurnFlag flags)
+{
+	const gchar *questions [] = { "disable-joliet",
+				      "warn-data-loss",
+				      "warn-previous-session-loss",
+				      "warn-audio-to-appendable",
+				      "warn-rewritable",
+				      "dummy-success",
+				      "blank-failure",
+				      NULL };
+	BraseroBurnDuplicatePrivate *priv;
+	GSList *iter;
+	gint i;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+
+	dup->session = brasero_burn_session_new ();
+	brasero_burn_session_set_tmpdir (dup->session, brasero_burn_session_get_tmpdir (priv->session));
+	brasero_burn_session_set_label (dup->session, brasero_burn_session_get_label (priv->session));
+	brasero_burn_session_set_burner (dup->session, dup->drive);
+	brasero_burn_session_set_rate (dup->session, brasero_burn_session_get_rate (priv->session));
+	brasero_burn_session_set_flags (dup->session, flags);
+
+	for (iter = priv->tracks; iter; iter = iter->next)
+		brasero_burn_session_add_track (dup->session, iter->data, NULL);
+
+	dup->burn = brasero_burn_new ();
+	g_signal_connect (dup->burn,
+			  "progress-changed",
+			  G_CALLBACK (brasero_burn_duplicate_progress_changed_cb),
+			  dup);
+	g_signal_connect (dup->burn,
+			  "action-changed",
+			  G_CALLBACK (brasero_burn_duplicate_action_changed_cb),
+			  dup);
+
+	/* All the questions go to the reader */
+	for (i = 0; questions [i]; i ++)
+		g_signal_connect (dup->burn,
+				  questions [i],
+				  G_CALLBACK (brasero_burn_duplicate_question_cb),
+				  dup);
+
+	g_signal_connect (dup->burn,
+			  "insert-media",
+			  G_CALLBACK (brasero_burn_duplicate_insert_media_cb),
+			  dup);
+	g_signal_connect (dup->burn,
+			  "eject-failure",
+			  G_CALLBACK (brasero_burn_duplicate_eject_failure_cb),
+			  dup);
+	g_signal_connect (dup->burn,
+			  "location-request",
+			  G_CALLBACK (brasero_burn_duplicate_location_request_cb),
+			  dup);
+	g_signal_connect (dup->burn,
+			  "install-missing",
+			  G_CALLBACK (brasero_burn_duplicate_install_missing_cb),
+			  dup);
+}
+
+static gboolean
+brasero_burn_duplicate_step_cb (gpointer data);
+
+static void
+brasero_burn_duplicate_queue (BraseroBurnDuplicateDrive *dup)
+{
+	BraseroBurnDuplicatePrivate *priv;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (dup->self);
+	priv->queue = g_slist_append (priv->queue, dup);
+
+	/* While a step is carried out the next one is scheduled after it */
+	if (!priv->busy && !priv->step_id)
+		priv->step_id = g_idle_add (brasero_burn_duplicate_step_cb, dup->self);
+}
+
+static void
+brasero_burn_duplicate_recorder_done_cb (BraseroBurn *burn,
+					 gpointer user_data)
+{
+	BraseroBurnDuplicateDrive *dup = user_data;
+
+	BRASERO_BURN_LOG ("Recorder on %s stopped", brasero_drive_get_device (dup->drive));
+	brasero_burn_duplicate_queue (dup);
+}
+
+/**
+ * Starts a drive or carries on with it once its recorder stopped. Only one
+ * drive is handled at a time.
+ */
+
+static gboolean
+brasero_burn_duplicate_step_cb (gpointer data)
+{
+	BraseroBurnDuplicate *self = BRASERO_BURN_DUPLICATE (data);
+	BraseroBurnDuplicateDrive *dup;
+	BraseroBurnDuplicatePrivate *priv;
+	BraseroBurnResult result;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	priv->step_id = 0;
+
+	if (!priv->queue)
+		return FALSE;
+
+	dup = priv->queue->data;
+	priv->queue = g_slist_remove (priv->queue, dup);
+
+	/* Make sure the object is still around once the step returns */
+	g_object_ref (self);
+	priv->busy = TRUE;
+
+	if (!dup->started) {
+		BRASERO_BURN_LOG ("Starting copy on %s", brasero_drive_get_device (dup->drive));
+
+		dup->started = TRUE;
+		dup->running = TRUE;
+		priv->running ++;
+		brasero_burn_duplicate_drive_changed (dup);
+
+		result = brasero_burn_record_start (dup->burn,
+						    dup->session,
+						    brasero_burn_duplicate_recorder_done_cb,
+						    dup,
+						    &dup->error);
+	}
+	else
+		result = brasero_burn_record_resume (dup->burn, &dup->error);
+
+	priv->busy = FALSE;
+
+	if (result != BRASERO_BURN_RUNNING) {
+		dup->result = result;
+		dup->running = FALSE;
+		priv->running --;
+
+		BRASERO_BURN_LOG ("Copy on %s finished (result = %i)",
+				  brasero_drive_get_device (dup->drive),
+				  dup->result);
+
+		if (dup->result == BRASERO_BURN_OK)
+			dup->progress = 1.0;
+
+		brasero_burn_duplicate_drive_changed (dup);
+	}
+
+	if (priv->queue)
+		priv->step_id = g_idle_add (brasero_burn_duplicate_step_cb, self);
+	else if (!priv->running && priv->loop)
+		g_main_loop_quit (priv->loop);
+
+	g_object_unref (self);
+	return FALSE;
+}
+
+static BraseroBurnResult
+brasero_burn_duplicate_get_result (BraseroBurnDuplicate *self,
+				   GError **error)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	GString *failures = NULL;
+	guint cancelled = 0;
+	guint failed = 0;
+	GSList *iter;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	for (iter = priv->drives; iter; iter = iter->next) {
+		BraseroBurnDuplicateDrive *dup;
+		gchar *name;
+
+		dup = iter->data;
+		if (dup->result == BRASERO_BURN_OK)
+			continue;
+
+		if (dup->result == BRASERO_BURN_CANCEL) {
+			cancelled ++;
+			continue;
+		}
+
+		failed ++;
+		if (!failures)
+			failures = g_string_new (NULL);
+		else
+			g_string_append_c (failures, '\n');
+
+		name = brasero_drive_get_display_name (dup->drive);
+		g_string_append_printf (failures,
+					"%s: %s",
+					name,
+					dup->error? dup->error->message:_("An internal error occurred"));
+		g_free (name);
+	}
+
+	BRASERO_BURN_LOG ("%i copies made, %i failed, %i cancelled",
+			  g_slist_length (priv->drives) - failed - cancelled,
+			  failed,
+			  cancelled);
+
+	if (failed) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     failures->str);
+		g_string_free (failures, TRUE);
+		return BRASERO_BURN_ERR;
+	}
+
+	if (cancelled)
+		return BRASERO_BURN_CANCEL;
+
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Burns the contents of @session on every drive of @drives at the same time.
+ * The source is read only once. A failure on one drive does not stop the
+ * others; the result is BRASERO_BURN_ERR if any of them failed with @error
+ * listing the failures. The status of each drive is reported through the
+ * "drive-changed" signal and brasero_burn_duplicate_get_drive_status ().
+ */
+
+BraseroBurnResult
+brasero_burn_duplicate_record (BraseroBurnDuplicate *self,
+			       BraseroBurnSession *session,
+			       GSList *drives,
+			       GError **error)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	BraseroTrackType *input = NULL;
+	BraseroTrackType *tmp_type = NULL;
+	BraseroBurnResult result;
+	BraseroBurnFlag flags;
+	GSList *iter;
+
+	g_return_val_if_fail (BRASERO_IS_BURN_DUPLICATE (self), BRASERO_BURN_ERR);
+	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	if (priv->session)
+		return BRASERO_BURN_RUNNING;
+
+	priv->session = g_object_ref (session);
+	priv->cancelled = FALSE;
+
+	for (iter = drives; iter; iter = iter->next) {
+		BraseroBurnDuplicateDrive *dup;
+
+		dup = g_new0 (BraseroBurnDuplicateDrive, 1);
+		dup->self = self;
+		dup->drive = g_object_ref (iter->data);
+		dup->result = BRASERO_BURN_NOT_RUNNING;
+		dup->action = BRASERO_BURN_ACTION_NONE;
+		priv->drives = g_slist_prepend (priv->drives, dup);
+	}
+	priv->drives = g_slist_reverse (priv->drives);
+
+	flags = brasero_burn_session_get_flags (session);
+
+	input = brasero_track_type_new ();
+	brasero_burn_session_get_input_type (session, input);
+
+	if (brasero_track_type_get_has_image (input)) {
+		/* Nothing to read, all drives use the image */
+		BRASERO_BURN_LOG ("Duplicating image to %i drives", g_slist_length (drives));
+		priv->tracks = g_slist_copy (brasero_burn_session_get_tracks (session));
+		g_slist_foreach (priv->tracks, (GFunc) g_object_ref, NULL);
+	}
+	else {
+		tmp_type = brasero_track_type_new ();
+		result = brasero_burn_session_get_tmp_image_type_same_src_dest (session, tmp_type);
+		if (result == BRASERO_BURN_OK && brasero_track_type_get_has_image (tmp_type)) {
+			BRASERO_BURN_LOG ("Duplicating to %i drives through one temporary image",
+					  g_slist_length (drives));
+
+			result = brasero_burn_duplicate_read (self,
+							      brasero_track_type_get_image_format (tmp_type),
+							      error);
+			if (result != BRASERO_BURN_OK)
+				goto end;
+
+			/* These flags only make sense with the original input */
+			flags &= ~(BRASERO_BURN_FLAG_MERGE|BRASERO_BURN_FLAG_NO_TMP_FILES);
+		}
+		else if (brasero_track_type_get_has_medium (input)) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     "%s", _("No format for the temporary image could be found"));
+			result = BRASERO_BURN_ERR;
+			goto end;
+		}
+		else {
+			/* Files (like audio tracks) that can't be turned into
+			 * an image; each recorder processes them itself. */
+			BRASERO_BURN_LOG ("No temporary image format; each drive will read the tracks");
+			priv->tracks = g_slist_copy (brasero_burn_session_get_tracks (session));
+			g_slist_foreach (priv->tracks, (GFunc) g_object_ref, NULL);
+		}
+	}
+
+	if (priv->cancelled) {
+		result = BRASERO_BURN_CANCEL;
+		goto end;
+	}
+
+	for (iter = priv->drives; iter; iter = iter->next)
+		brasero_burn_duplicate_setup_drive (self, iter->data, flags);
+
+	/* Start all drives and wait for all of them to be done */
+	priv->loop = g_main_loop_new (NULL, FALSE);
+	for (iter = priv->drives; iter; iter = iter->next)
+		brasero_burn_duplicate_queue (iter->data);
+
+	g_main_loop_run (priv->loop);
+	g_main_loop_unref (priv->loop);
+	priv->loop = NULL;
+
+	result = brasero_burn_duplicate_get_result (self, error);
+
+end:
+
+	if (input)
+		brasero_track_type_free (input);
+
+	if (tmp_type)
+		brasero_track_type_free (tmp_type);
+
+	g_object_unref (priv->session);
+	priv->session = NULL;
+
+	return result;
+}
+
+/**
+ * Cancels all drives. If @protect is TRUE, the drives at a point where
+ * cancelling could render their disc unusable keep running and
+ * BRASERO_BURN_DANGEROUS is returned; the others are cancelled anyway.
+ */
+
+BraseroBurnResult
+brasero_burn_duplicate_cancel (BraseroBurnDuplicate *self,
+			       gboolean protect)
+{
+	BraseroBurnDuplicatePrivate *priv;
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	GSList *iter;
+
+	g_return_val_if_fail (BRASERO_IS_BURN_DUPLICATE (self), BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	priv->cancelled = TRUE;
+
+	for (iter = priv->drives; iter; iter = iter->next) {
+		BraseroBurnDuplicateDrive *dup;
+
+		dup = iter->data;
+		if (dup->running) {
+			if (brasero_burn_cancel (dup->burn, protect) == BRASERO_BURN_DANGEROUS)
+				result = BRASERO_BURN_DANGEROUS;
+		}
+		else if (!dup->started) {
+			/* Drives that haven't started yet won't */
+			priv->queue = g_slist_remove (priv->queue, dup);
+			dup->started = TRUE;
+			dup->result = BRASERO_BURN_CANCEL;
+			brasero_burn_duplicate_drive_changed (dup);
+		}
+	}
+
+	if (!priv->queue && priv->step_id) {
+		g_source_remove (priv->step_id);
+		priv->step_id = 0;
+	}
+
+	/* Nothing may be left to wake up the loop */
+	if (!priv->busy && !priv->step_id && !priv->running && priv->loop)
+		g_main_loop_quit (priv->loop);
+
+	if (priv->reader
+	&&  brasero_burn_cancel (priv->reader, protect) == BRASERO_BURN_DANGEROUS)
+		result = BRASERO_BURN_DANGEROUS;
+
+	if (!priv->running && priv->loop)
+		g_main_loop_quit (priv->loop);
+
+	return result;
+}
+
+/**
+ * Returns the result for @drive (BRASERO_BURN_NOT_RUNNING if it hasn't
+ * started, BRASERO_BURN_RUNNING while it runs), its overall progress, its
+ * current action and its error if any.
+ */
+
+BraseroBurnResult
+brasero_burn_duplicate_get_drive_status (BraseroBurnDuplicate *self,
+					 BraseroDrive *drive,
+					 gdouble *progress,
+					 BraseroBurnAction *action,
+					 const GError **error)
+{
+	BraseroBurnDuplicateDrive *dup;
+
+	g_return_val_if_fail (BRASERO_IS_BURN_DUPLICATE (self), BRASERO_BURN_ERR);
+
+	dup = brasero_burn_duplicate_find_drive (self, drive);
+	if (!dup)
+		return BRASERO_BURN_ERR;
+
+	if (progress)
+		*progress = dup->progress;
+
+	if (action)
+		*action = dup->action;
+
+	if (error)
+		*error = dup->error;
+
+	if (dup->running)
+		return BRASERO_BURN_RUNNING;
+
+	return dup->result;
+}
+
+/**
+ * @reader is the BraseroBurn used to read the source once. It's up to the
+ * caller to connect to its signals (to answer questions and follow its
+ * progress) as it would for any other burn. The questions of the recorders
+ * are emitted by @reader as well.
+ */
+
+BraseroBurnDuplicate *
+brasero_burn_duplicate_new (BraseroBurn *reader)
+{
+	BraseroBurnDuplicate *self;
+	BraseroBurnDuplicatePrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_BURN (reader), NULL);
+
+	self = g_object_new (BRASERO_TYPE_BURN_DUPLICATE, NULL);
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (self);
+	priv->reader = g_object_ref (reader);
+
+	return self;
+}
+
+static void
+brasero_burn_duplicate_init (BraseroBurnDuplicate *object)
+{ }
+
+static void
+brasero_burn_duplicate_finalize (GObject *object)
+{
+	BraseroBurnDuplicatePrivate *priv;
+
+	priv = BRASERO_BURN_DUPLICATE_PRIVATE (object);
+
+	if (priv->step_id) {
+		g_source_remove (priv->step_id);
+		priv->step_id = 0;
+	}
+
+	if (priv->queue) {
+		g_slist_free (priv->queue);
+		priv->queue = NULL;
+	}
+
+	if (priv->drives) {
+		g_slist_foreach (priv->drives, (GFunc) brasero_burn_duplicate_drive_free, NULL);
+		g_slist_free (priv->drives);
+		priv->drives = NULL;
+	}
+
+	if (priv->tracks) {
+		g_slist_foreach (priv->tracks, (GFunc) g_object_unref, NULL);
+		g_slist_free (priv->tracks);
+		priv->tracks = NULL;
+	}
+
+	if (priv->reader) {
+		g_object_unref (priv->reader);
+		priv->reader = NULL;
+	}
+
+	G_OBJECT_CLASS (brasero_burn_duplicate_parent_class)->finalize (object);
+}
+
+static void
+brasero_burn_duplicate_class_init (BraseroBurnDuplicateClass *klass)
+{
+	GObjectClass* object_class = G_OBJECT_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (BraseroBurnDuplicatePrivate));
+
+	object_class->finalize = brasero_burn_duplicate_finalize;
+
+	brasero_burn_duplicate_signals [DRIVE_CHANGED_SIGNAL] =
+		g_signal_new ("drive_changed",
+			      G_OBJECT_CLASS_TYPE (klass),
+			      G_SIGNAL_RUN_LAST,
+			      0,
+			      NULL, NULL,
+			      g_cclosure_marshal_VOID__OBJECT,
+			      G_TYPE_NONE,
+			      1,
+			      BRASERO_TYPE_DRIVE);
+}
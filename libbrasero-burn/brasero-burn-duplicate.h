@@ -0,0 +1,89 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BRASERO_BURN_DUPLICATE_H_
+#define _BRASERO_BURN_DUPLICATE_H_
+
+#include <glib-object.h>
+
+#include "brasero-burn.h"
+#include "brasero-session.h"
+#include "brasero-drive.h"
+
+G_BEGIN_DECLS
+
+#define BRASERO_TYPE_BURN_DUPLICATE             (brasero_burn_duplicate_get_type ())
+#define BRASERO_BURN_DUPLICATE(obj)             (G_TYPE_CHECK_INSTANCE_CAST ((obj), BRASERO_TYPE_BURN_DUPLICATE, BraseroBurnDuplicate))
+#define BRASERO_BURN_DUPLICATE_CLASS(klass)     (G_TYPE_CHECK_CLASS_CAST ((klass), BRASERO_TYPE_BURN_DUPLICATE, BraseroBurnDuplicateClass))
+#define BRASERO_IS_BURN_DUPLICATE(obj)          (G_TYPE_CHECK_INSTANCE_TYPE ((obj), BRASERO_TYPE_BURN_DUPLICATE))
+#define BRASERO_IS_BURN_DUPLICATE_CLASS(klass)  (G_TYPE_CHECK_CLASS_TYPE ((klass), BRASERO_TYPE_BURN_DUPLICATE))
+#define BRASERO_BURN_DUPLICATE_GET_CLASS(obj)   (G_TYPE_INSTANCE_GET_CLASS ((obj), BRASERO_TYPE_BURN_DUPLICATE, BraseroBurnDuplicateClass))
+
+typedef struct _BraseroBurnDuplicateClass BraseroBurnDuplicateClass;
+typedef struct _BraseroBurnDuplicate BraseroBurnDuplicate;
+
+struct _BraseroBurnDuplicateClass
+{
+	GObjectClass parent_class;
+};
+
+struct _BraseroBurnDuplicate
+{
+	GObject parent_instance;
+};
+
+GType brasero_burn_duplicate_get_type (void) G_GNUC_CONST;
+
+BraseroBurnDuplicate *
+brasero_burn_duplicate_new (BraseroBurn *reader);
+
+GSList *
+brasero_burn_duplicate_get_session_drives (BraseroBurnSession *session);
+
+BraseroBurnResult
+brasero_burn_duplicate_record (BraseroBurnDuplicate *duplicate,
+			       BraseroBurnSession *session,
+			       GSList *drives,
+			       GError **error);
+
+BraseroBurnResult
+brasero_burn_duplicate_cancel (BraseroBurnDuplicate *duplicate,
+			       gboolean protect);
+
+BraseroBurnResult
+brasero_burn_duplicate_get_drive_status (BraseroBurnDuplicate *duplicate,
+					 BraseroDrive *drive,
+					 gdouble *progress,
+					 BraseroBurnAction *action,
+					 const GError **error);
+
+G_END_DECLS
+
+#endif /* _BRASERO_BURN_DUPLICATE_H_ */
@@ -46,6 +46,7 @@
 #include <glib/gstdio.h>
 
 #include "brasero-burn.h"
+#include "brasero-burn-private.h"
 
 #include "libbrasero-marshal.h"
 #include "burn-basics.h"
@@ -59,6 +60,8 @@
 
 #include "brasero-volume.h"
 #include "brasero-drive.h"
+#include "brasero-speed-profile.h"
+#include "brasero-source-rate.h"
 
 #include "brasero-tags.h"
 #include "brasero-track.h"
@@ -77,6 +80,8 @@ struct _BraseroBurnPrivate {
 	GMainLoop *sleep_loop;
 	guint timeout_id;
 
+	GCancellable *cancel;
+
 	guint tasks_done;
 	guint task_nb;
 	BraseroTask *task;
@@ -89,7 +94,25 @@ struct _BraseroBurnPrivate {
 	guint64 session_start;
 	guint64 session_end;
 
+	/* Speed profile of the medium being recorded and requested rate */
+	gchar *profile;
+	guint64 rate;
+
+	/* Session settings changed for the source to keep up */
+	gint64 session_rate;
+	gint session_flags;
+
+	/* Set when the recorder runs without a loop of its own */
+	BraseroBurnDoneFunc done_func;
+	gpointer done_data;
+	BraseroBurnResult task_result;
+	GError *task_error;
+
 	guint mounted_by_us:1;
+	guint qualified:1;
+	guint erase_allowed:1;
+	guint dummy_session:1;
+	guint dummy_removed:1;
 };
 
 #define BRASERO_BURN_NOT_SUPPORTED_LOG(burn)					\
@@ -1469,13 +1492,48 @@ brasero_burn_can_use_drive_exclusively (BraseroBurn *burn,
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_burn_update_speed_profile (BraseroBurn *burn,
+				   const gchar *profile,
+				   guint64 rate,
+				   BraseroBurnResult result,
+				   GError *error)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+	guint64 measured = 0;
+
+	if (!profile || !rate)
+		return;
+
+	/* A simulation tells nothing about the quality of the burn */
+	if (brasero_burn_session_get_flags (priv->session) & BRASERO_BURN_FLAG_DUMMY)
+		return;
+
+	if (result == BRASERO_BURN_OK) {
+		brasero_task_ctx_get_average_rate (BRASERO_TASK_CTX (priv->task), &measured);
+		BRASERO_BURN_LOG ("Recorded at %" G_GUINT64_FORMAT " B/s (requested %" G_GUINT64_FORMAT ")",
+				  measured,
+				  rate);
+		brasero_speed_profile_add_burn (profile, rate, measured, TRUE);
+		return;
+	}
+
+	/* Only count the errors that can be blamed on the speed */
+	if (result != BRASERO_BURN_ERR
+	|| !error
+	||  error->domain != BRASERO_BURN_ERROR)
+		return;
+
+	if (error->code == BRASERO_BURN_ERROR_SLOW_DMA
+	||  error->code == BRASERO_BURN_ERROR_WRITE_MEDIUM)
+		brasero_speed_profile_add_burn (profile, rate, 0, FALSE);
+}
+
 static BraseroBurnResult
-brasero_burn_run_recorder (BraseroBurn *burn, GError **error)
+brasero_burn_start_recorder (BraseroBurn *burn, GError **error)
 {
-	gint error_code;
 	BraseroDrive *src;
 	BraseroDrive *burner;
-	GError *ret_error = NULL;
 	BraseroBurnResult result;
 	BraseroMedium *src_medium;
 	BraseroMedium *burnt_medium;
@@ -1487,8 +1545,6 @@ brasero_burn_run_recorder (BraseroBurn *burn, GError **error)
 	burner = brasero_burn_session_get_burner (priv->session);
 	burnt_medium = brasero_drive_get_medium (burner);
 
-start:
-
 	/* this is just in case */
 	if (BRASERO_BURN_SESSION_NO_TMP_FILE (priv->session)) {
 		result = brasero_burn_unmount (burn, src_medium, error);
@@ -1510,8 +1566,36 @@ start:
 	if (result != BRASERO_BURN_OK)
 		return result;
 
-	/* actual running of task */
-	result = brasero_task_run (priv->task, &ret_error);
+	/* The medium is probed again once burnt so keep what identifies its
+	 * speed profile beforehand */
+	g_free (priv->profile);
+	priv->profile = g_strdup (brasero_medium_get_speed_profile (burnt_medium));
+	priv->rate = brasero_burn_session_get_rate (priv->session);
+
+	return BRASERO_BURN_OK;
+}
+
+/**
+ * Handles the result of the recording task. @restart is set to TRUE when
+ * the error could be recovered from and the recorder should be run again.
+ */
+
+static BraseroBurnResult
+brasero_burn_recorder_done (BraseroBurn *burn,
+			    BraseroBurnResult result,
+			    GError *ret_error,
+			    gboolean *restart,
+			    GError **error)
+{
+	gint error_code;
+	guint64 rate;
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	*restart = FALSE;
+
+	brasero_burn_update_speed_profile (burn, priv->profile, priv->rate, result, ret_error);
+	g_free (priv->profile);
+	priv->profile = NULL;
 
 	/* let's see the results */
 	if (result == BRASERO_BURN_OK) {
@@ -1551,7 +1635,9 @@ start:
 
 		g_error_free (ret_error);
 		ret_error = NULL;
-		goto start;
+
+		*restart = TRUE;
+		return BRASERO_BURN_OK;
 	}
 	else if (error_code == BRASERO_BURN_ERROR_MEDIUM_NEED_RELOADING) {
 		/* NOTE: this error can only come from the source when 
@@ -1568,11 +1654,10 @@ start:
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		goto start;
+		*restart = TRUE;
+		return BRASERO_BURN_OK;
 	}
 	else if (error_code == BRASERO_BURN_ERROR_SLOW_DMA) {
-		guint64 rate;
-
 		/* The whole system has just made a great effort. Sometimes it 
 		 * helps to let it rest for a sec or two => that's what we do
 		 * before retrying. (That's why usually cdrecord waits a little
@@ -1596,7 +1681,9 @@ start:
 			rate = BRASERO_SPEED_TO_RATE_CD (8);
 
 		brasero_burn_session_set_rate (priv->session, rate);
-		goto start;
+
+		*restart = TRUE;
+		return BRASERO_BURN_OK;
 	}
 	else if (error_code == BRASERO_BURN_ERROR_MEDIUM_SPACE) {
 		/* NOTE: this error can only come from the dest drive */
@@ -1632,7 +1719,8 @@ start:
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		goto start;
+		*restart = TRUE;
+		return BRASERO_BURN_OK;
 	}
 	else if (error_code >= BRASERO_BURN_ERROR_MEDIUM_NONE
 	     &&  error_code <=  BRASERO_BURN_ERROR_MEDIUM_NEED_RELOADING) {
@@ -1650,7 +1738,8 @@ start:
 		if (result != BRASERO_BURN_OK)
 			return result;
 
-		goto start;
+		*restart = TRUE;
+		return BRASERO_BURN_OK;
 	}
 
 	if (ret_error)
@@ -1659,6 +1748,57 @@ start:
 	return BRASERO_BURN_ERR;
 }
 
+static void
+brasero_burn_recorder_done_cb (BraseroTask *task,
+			       BraseroBurnResult result,
+			       GError *error,
+			       gpointer data)
+{
+	BraseroBurn *burn = BRASERO_BURN (data);
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	priv->task_result = result;
+	priv->task_error = error;
+
+	priv->done_func (burn, priv->done_data);
+}
+
+static BraseroBurnResult
+brasero_burn_run_recorder (BraseroBurn *burn, GError **error)
+{
+	gboolean restart;
+	BraseroBurnResult result;
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	do {
+		GError *ret_error = NULL;
+
+		result = brasero_burn_start_recorder (burn, error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+
+		/* actual running of task */
+		if (priv->done_func) {
+			result = brasero_task_run_async (priv->task,
+							 brasero_burn_recorder_done_cb,
+							 burn,
+							 &ret_error);
+			if (result == BRASERO_BURN_RUNNING)
+				return result;
+		}
+		else
+			result = brasero_task_run (priv->task, &ret_error);
+
+		result = brasero_burn_recorder_done (burn,
+						     result,
+						     ret_error,
+						     &restart,
+						     error);
+	} while (restart);
+
+	return result;
+}
+
 static BraseroBurnResult
 brasero_burn_install_missing (BraseroPluginErrorType error,
 			      const gchar *details,
@@ -2037,12 +2177,34 @@ reload:
 	return BRASERO_BURN_RETRY;
 }
 
+/**
+ * Called once the last task of the session is done
+ */
+
+static BraseroBurnResult
+brasero_burn_run_tasks_end (BraseroBurn *burn,
+			    BraseroBurnResult result)
+{
+	BraseroBurnPrivate *priv = BRASERO_BURN_PRIVATE (burn);
+
+	/* restore the session settings. Keep the used flags
+	 * nevertheless to make sure we actually use the flags that were
+	 * set after checking for session consistency. */
+	brasero_burn_session_pop_settings (priv->session);
+
+	if (priv->task) {
+		g_object_unref (priv->task);
+		priv->task = NULL;
+	}
+
+	return result;
+}
+
 /* FIXME: at the moment we don't allow for mixed CD type */
 static BraseroBurnResult
 brasero_burn_run_tasks (BraseroBurn *burn,
 			gboolean erase_allowed,
                         BraseroTrackType *temp_output,
-                        gboolean *dummy_session,
 			GError **error)
 {
 	BraseroBurnResult result;
@@ -2232,8 +2394,13 @@ brasero_burn_run_tasks (BraseroBurn *burn,
 		/* see if we reached a recording task: it's the last task */
 		if (!next) {
 			if (!brasero_burn_session_is_dest_file (priv->session)) {
-				*dummy_session = (brasero_burn_session_get_flags (priv->session) & BRASERO_BURN_FLAG_DUMMY);
+				priv->dummy_session = (brasero_burn_session_get_flags (priv->session) & BRASERO_BURN_FLAG_DUMMY) != 0;
 				result = brasero_burn_run_recorder (burn, error);
+
+				/* It's the last task so there is nothing left
+				 * in the list to free */
+				if (result == BRASERO_BURN_RUNNING)
+					return result;
 			}
 			else
 				result = brasero_burn_run_imager (burn, FALSE, error);
@@ -2254,20 +2421,10 @@ brasero_burn_run_tasks (BraseroBurn *burn,
 		priv->tasks_done ++;
 	}
 
-	/* restore the session settings. Keep the used flags
-	 * nevertheless to make sure we actually use the flags that were
-	 * set after checking for session consistency. */
-	brasero_burn_session_pop_settings (priv->session);
-
-	if (priv->task) {
-		g_object_unref (priv->task);
-		priv->task = NULL;
-	}
-
 	g_slist_foreach (tasks, (GFunc) g_object_unref, NULL);
 	g_slist_free (tasks);
 
-	return result;
+	return brasero_burn_run_tasks_end (burn, result);
 }
 
 static BraseroBurnResult
@@ -2364,22 +2521,16 @@ static BraseroBurnResult
 brasero_burn_record_session (BraseroBurn *burn,
 			     gboolean erase_allowed,
                              BraseroTrackType *temp_output,
-			     GError **error)
+			     GError **error);
+
+static BraseroBurnResult
+brasero_burn_run_session_tasks (BraseroBurn *burn,
+				gboolean erase_allowed,
+				BraseroTrackType *temp_output,
+				GError **error)
 {
-	gboolean dummy_session = FALSE;
-	const gchar *checksum = NULL;
-	BraseroTrack *track = NULL;
-	BraseroChecksumType type;
-	BraseroBurnPrivate *priv;
 	BraseroBurnResult result;
 	GError *ret_error = NULL;
-	GSList *tracks;
-
-	priv = BRASERO_BURN_PRIVATE (burn);
-
-	/* unset checksum since no image has the exact
-	 * same even if it is created from the same files */
-	brasero_burn_unset_checksums (burn);
 
 	do {
 		if (ret_error) {
@@ -2390,24 +2541,45 @@ brasero_burn_record_session (BraseroBurn *burn,
 		result = brasero_burn_run_tasks (burn,
 						 erase_allowed,
 		                                 temp_output,
-		                                 &dummy_session,
 						 &ret_error);
 	} while (result == BRASERO_BURN_RETRY);
 
-	if (result != BRASERO_BURN_OK) {
+	if (ret_error) {
 		/* handle errors */
-		if (ret_error) {
+		if (result != BRASERO_BURN_OK)
 			g_propagate_error (error, ret_error);
-			ret_error = NULL;
-		}
+		else
+			g_error_free (ret_error);
+	}
 
+	return result;
+}
+
+/**
+ * Called once all the tasks of the session are done to run a simulation
+ * again for real or to check the disc.
+ */
+static BraseroBurnResult
+brasero_burn_record_session_end (BraseroBurn *burn,
+				 BraseroBurnResult result,
+				 BraseroTrackType *temp_output,
+				 GError **error)
+{
+	const gchar *checksum = NULL;
+	BraseroTrack *track = NULL;
+	BraseroChecksumType type;
+	BraseroBurnPrivate *priv;
+	GSList *tracks;
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	if (result != BRASERO_BURN_OK)
 		return result;
-	}
 
 	if (brasero_burn_session_is_dest_file (priv->session))
 		return BRASERO_BURN_OK;
 
-	if (dummy_session) {
+	if (priv->dummy_session) {
 		/* if we are in dummy mode and successfully completed then:
 		 * - no need to checksum the media afterward (done later)
 		 * - no eject to have automatic real burning */
@@ -2433,8 +2605,13 @@ brasero_burn_record_session (BraseroBurn *burn,
 		 * that were made. */
 		brasero_burn_session_remove_flag (priv->session, BRASERO_BURN_FLAG_DUMMY);
 		result = brasero_burn_record_session (burn, FALSE, temp_output, error);
-		brasero_burn_session_add_flag (priv->session, BRASERO_BURN_FLAG_DUMMY);
+		if (result == BRASERO_BURN_RUNNING) {
+			/* The flag is set again once the recorder is done */
+			priv->dummy_removed = TRUE;
+			return result;
+		}
 
+		brasero_burn_session_add_flag (priv->session, BRASERO_BURN_FLAG_DUMMY);
 		return result;
 	}
 
@@ -2534,6 +2711,33 @@ brasero_burn_record_session (BraseroBurn *burn,
 	return result;
 }
 
+static BraseroBurnResult
+brasero_burn_record_session (BraseroBurn *burn,
+			     gboolean erase_allowed,
+                             BraseroTrackType *temp_output,
+			     GError **error)
+{
+	BraseroBurnPrivate *priv;
+	BraseroBurnResult result;
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+	priv->erase_allowed = erase_allowed;
+	priv->dummy_session = FALSE;
+
+	/* unset checksum since no image has the exact
+	 * same even if it is created from the same files */
+	brasero_burn_unset_checksums (burn);
+
+	result = brasero_burn_run_session_tasks (burn,
+						 erase_allowed,
+						 temp_output,
+						 error);
+	if (result == BRASERO_BURN_RUNNING)
+		return result;
+
+	return brasero_burn_record_session_end (burn, result, temp_output, error);
+}
+
 /**
  * brasero_burn_check:
  * @burn: a #BraseroBurn
@@ -2737,31 +2941,203 @@ again:
 	return BRASERO_BURN_OK;
 }
 
+/* Margin kept between what the source produces and the write rate so that the
+ * buffers of the drive and of the imagers do not drain */
+#define BRASERO_BURN_SOURCE_RATE_MARGIN		1.15
+
+static BraseroBurnResult
+brasero_burn_qualify_source (BraseroBurn *burn)
+{
+	BraseroBurnFlag compulsory = BRASERO_BURN_FLAG_NONE;
+	BraseroBurnFlag supported = BRASERO_BURN_FLAG_NONE;
+	BraseroBurnPrivate *priv;
+	BraseroTrackType *type;
+	BraseroBurnFlag flags;
+	BraseroMedium *medium;
+	guint64 measured = 0;
+	guint64 lower = 0;
+	gboolean sampled;
+	guint64 *speeds;
+	gboolean image;
+	gboolean live;
+	guint64 rate;
+	guint i;
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	if (brasero_burn_session_is_dest_file (priv->session))
+		return BRASERO_BURN_OK;
+
+	/* Only the sources read while the drive is writing matter: an image or,
+	 * when burning on the fly, the files the imagers are fed with */
+	flags = brasero_burn_session_get_flags (priv->session);
+	type = brasero_track_type_new ();
+	brasero_burn_session_get_input_type (priv->session, type);
+	image = brasero_track_type_get_has_image (type);
+	live = image
+	    || ((flags & BRASERO_BURN_FLAG_NO_TMP_FILES)
+	    &&  (brasero_track_type_get_has_data (type)
+	    ||   brasero_track_type_get_has_stream (type)));
+	brasero_track_type_free (type);
+
+	if (!live)
+		return BRASERO_BURN_OK;
+
+	rate = brasero_burn_session_get_rate (priv->session);
+	if (!rate)
+		return BRASERO_BURN_OK;
+
+	priv->cancel = g_cancellable_new ();
+	sampled = brasero_source_rate_measure (priv->session,
+					       priv->cancel,
+					       &measured);
+	if (g_cancellable_is_cancelled (priv->cancel)) {
+		g_object_unref (priv->cancel);
+		priv->cancel = NULL;
+		return BRASERO_BURN_CANCEL;
+	}
+
+	g_object_unref (priv->cancel);
+	priv->cancel = NULL;
+
+	if (!sampled)
+		return BRASERO_BURN_OK;
+
+	BRASERO_BURN_LOG ("Source produces %" G_GUINT64_FORMAT " B/s, writing at %" G_GUINT64_FORMAT " B/s",
+			  measured,
+			  rate);
+
+	if (measured >= rate * BRASERO_BURN_SOURCE_RATE_MARGIN)
+		return BRASERO_BURN_OK;
+
+	/* Use the fastest speed the source can keep up with */
+	medium = brasero_drive_get_medium (brasero_burn_session_get_burner (priv->session));
+	speeds = medium ? brasero_medium_get_write_speeds (medium):NULL;
+	for (i = 0; speeds && speeds [i]; i ++) {
+		if (speeds [i] < rate
+		&&  speeds [i] > lower
+		&&  speeds [i] * BRASERO_BURN_SOURCE_RATE_MARGIN <= measured)
+			lower = speeds [i];
+	}
+	g_free (speeds);
+
+	if (lower) {
+		BRASERO_BURN_LOG ("Source too slow, lowering rate to %" G_GUINT64_FORMAT " B/s", lower);
+		brasero_burn_session_set_rate (priv->session, lower);
+		return BRASERO_BURN_OK;
+	}
+
+	/* Even the slowest speed is too fast: image first if we can. That's
+	 * only possible for data and streams; an image is already what gets
+	 * written so nothing more can be done about it. */
+	brasero_burn_session_get_burn_flags (priv->session,
+					     &supported,
+					     &compulsory);
+	if (!image
+	&&  (flags & BRASERO_BURN_FLAG_NO_TMP_FILES)
+	&& !(compulsory & BRASERO_BURN_FLAG_NO_TMP_FILES)) {
+		BRASERO_BURN_LOG ("Source too slow for any speed, using an intermediate image");
+		brasero_burn_session_remove_flag (priv->session, BRASERO_BURN_FLAG_NO_TMP_FILES);
+		return BRASERO_BURN_OK;
+	}
+
+	if (flags & BRASERO_BURN_FLAG_BURNPROOF)
+		BRASERO_BURN_LOG ("Source too slow for any speed, relying on buffer underrun protection");
+	else
+		BRASERO_BURN_LOG ("Source too slow for any speed, buffer underruns are likely");
+
+	return BRASERO_BURN_OK;
+}
+
 /**
- * brasero_burn_record:
- * @burn: a #BraseroBurn
- * @session: a #BraseroBurnSession
- * @error: a #GError
- *
- * Burns or creates a disc image according to the parameters
- * set in @session.
- *
- * Return value: a #BraseroBurnResult. The result of the operation. 
- * BRASERO_BURN_OK if it was successful.
- **/
+ * Everything that comes after the session was recorded (successfully or not)
+ */
 
-BraseroBurnResult 
-brasero_burn_record (BraseroBurn *burn,
-		     BraseroBurnSession *session,
-		     GError **error)
+static BraseroBurnResult
+brasero_burn_record_end (BraseroBurn *burn,
+			 BraseroBurnResult result,
+			 GError **error)
+{
+	BraseroBurnPrivate *priv;
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+
+	if (priv->qualified) {
+		gint64 rate = 0;
+		gint flags = 0;
+
+		/* The properties hold the values as set by the user (0 for
+		 * the default speed) unlike brasero_burn_session_get_rate () */
+		g_object_get (priv->session,
+			      "speed", &rate,
+			      "flags", &flags,
+			      NULL);
+		if (rate != priv->session_rate)
+			g_object_set (priv->session, "speed", priv->session_rate, NULL);
+		if (flags != priv->session_flags)
+			g_object_set (priv->session, "flags", priv->session_flags, NULL);
+
+		priv->qualified = FALSE;
+	}
+
+	if (result == BRASERO_BURN_OK)
+		result = brasero_burn_unlock_medias (burn, error);
+	else
+		brasero_burn_unlock_medias (burn, NULL);
+
+	if (error && (*error) == NULL
+	&& (result == BRASERO_BURN_NOT_READY
+	||  result == BRASERO_BURN_NOT_SUPPORTED
+	||  result == BRASERO_BURN_RUNNING
+	||  result == BRASERO_BURN_NOT_RUNNING)) {
+		BRASERO_BURN_LOG ("Internal error with result %i", result);
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s", _("An internal error occurred"));
+	}
+
+	if (result == BRASERO_BURN_CANCEL) {
+		BRASERO_BURN_DEBUG (burn, "Session cancelled by user");
+	}
+	else if (result != BRASERO_BURN_OK) {
+		if (error && (*error)) {
+			BRASERO_BURN_DEBUG (burn,
+					    "Session error : %s",
+					    (*error)->message);
+		}
+		else
+			BRASERO_BURN_DEBUG (burn, "Session error : unknown");
+	}
+	else {
+		BRASERO_BURN_DEBUG (burn, "Session successfully finished");
+		brasero_burn_action_changed_real (burn,
+		                                  BRASERO_BURN_ACTION_FINISHED);
+	}
+
+	brasero_burn_powermanagement (burn, FALSE);
+
+	/* release session */
+	g_object_unref (priv->session);
+	priv->session = NULL;
+
+	priv->done_func = NULL;
+	priv->done_data = NULL;
+
+	return result;
+}
+
+static BraseroBurnResult
+brasero_burn_record_real (BraseroBurn *burn,
+			  BraseroBurnSession *session,
+			  BraseroBurnDoneFunc func,
+			  gpointer user_data,
+			  GError **error)
 {
 	BraseroTrackType *type = NULL;
 	BraseroBurnResult result;
 	BraseroBurnPrivate *priv;
 
-	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
-	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_BURN_ERR);
-
 	priv = BRASERO_BURN_PRIVATE (burn);
 
 	/* make sure we're ready */
@@ -2822,6 +3198,25 @@ brasero_burn_record (BraseroBurn *burn,
 			goto end;
 	}
 
+	/* make sure the source can keep up with the drive. The speed and the
+	 * flags it may change are saved to be restored afterwards: they are
+	 * bound to the drive settings and the change must only last for this
+	 * burn. */
+	g_object_get (session,
+		      "speed", &priv->session_rate,
+		      "flags", &priv->session_flags,
+		      NULL);
+	priv->qualified = TRUE;
+
+	result = brasero_burn_qualify_source (burn);
+	if (result != BRASERO_BURN_OK)
+		goto end;
+
+	/* Only the recorder may run without a loop of its own; that's why
+	 * it's set that late (the special case above records a session) */
+	priv->done_func = func;
+	priv->done_data = user_data;
+
 	/* burn the session except if dummy session */
 	result = brasero_burn_record_session (burn, TRUE, NULL, error);
 
@@ -2829,48 +3224,125 @@ end:
 
 	brasero_track_type_free (type);
 
-	if (result == BRASERO_BURN_OK)
-		result = brasero_burn_unlock_medias (burn, error);
-	else
-		brasero_burn_unlock_medias (burn, NULL);
+	if (result == BRASERO_BURN_RUNNING)
+		return result;
 
-	if (error && (*error) == NULL
-	&& (result == BRASERO_BURN_NOT_READY
-	||  result == BRASERO_BURN_NOT_SUPPORTED
-	||  result == BRASERO_BURN_RUNNING
-	||  result == BRASERO_BURN_NOT_RUNNING)) {
-		BRASERO_BURN_LOG ("Internal error with result %i", result);
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s", _("An internal error occurred"));
-	}
+	return brasero_burn_record_end (burn, result, error);
+}
 
-	if (result == BRASERO_BURN_CANCEL) {
-		BRASERO_BURN_DEBUG (burn, "Session cancelled by user");
+/**
+ * brasero_burn_record:
+ * @burn: a #BraseroBurn
+ * @session: a #BraseroBurnSession
+ * @error: a #GError
+ *
+ * Burns or creates a disc image according to the parameters
+ * set in @session.
+ *
+ * Return value: a #BraseroBurnResult. The result of the operation. 
+ * BRASERO_BURN_OK if it was successful.
+ **/
+
+BraseroBurnResult 
+brasero_burn_record (BraseroBurn *burn,
+		     BraseroBurnSession *session,
+		     GError **error)
+{
+	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
+	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_BURN_ERR);
+
+	return brasero_burn_record_real (burn, session, NULL, NULL, error);
+}
+
+/**
+ * Same as brasero_burn_record () except that the recording task doesn't
+ * run in a loop of its own. BRASERO_BURN_RUNNING is returned while it runs
+ * and @func is called from the main loop once it is over. The caller must
+ * then call brasero_burn_record_resume () to carry on with the rest of the
+ * session. Any other value is the result of the whole operation.
+ */
+
+BraseroBurnResult
+brasero_burn_record_start (BraseroBurn *burn,
+			   BraseroBurnSession *session,
+			   BraseroBurnDoneFunc func,
+			   gpointer user_data,
+			   GError **error)
+{
+	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
+	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_BURN_ERR);
+	g_return_val_if_fail (func != NULL, BRASERO_BURN_ERR);
+
+	return brasero_burn_record_real (burn, session, func, user_data, error);
+}
+
+/**
+ * Carries on with a session started with brasero_burn_record_start () once
+ * its recording task is over. It mirrors what brasero_burn_record () does
+ * after the recorder returned. BRASERO_BURN_RUNNING is returned when the
+ * recorder was started again (after a recoverable error or a simulation).
+ */
+
+BraseroBurnResult
+brasero_burn_record_resume (BraseroBurn *burn,
+			    GError **error)
+{
+	BraseroBurnPrivate *priv;
+	BraseroBurnResult result;
+	GError *ret_error;
+	gboolean restart;
+
+	g_return_val_if_fail (BRASERO_IS_BURN (burn), BRASERO_BURN_ERR);
+
+	priv = BRASERO_BURN_PRIVATE (burn);
+	g_return_val_if_fail (priv->done_func != NULL, BRASERO_BURN_ERR);
+
+	ret_error = priv->task_error;
+	priv->task_error = NULL;
+
+	/* That's what brasero_burn_run_recorder () does after the task */
+	result = brasero_burn_recorder_done (burn,
+					     priv->task_result,
+					     ret_error,
+					     &restart,
+					     error);
+	if (restart) {
+		result = brasero_burn_run_recorder (burn, error);
+		if (result == BRASERO_BURN_RUNNING)
+			return result;
 	}
-	else if (result != BRASERO_BURN_OK) {
-		if (error && (*error)) {
-			BRASERO_BURN_DEBUG (burn,
-					    "Session error : %s",
-					    (*error)->message);
+
+	/* That's what brasero_burn_run_tasks () does */
+	if (result == BRASERO_BURN_OK)
+		priv->tasks_done ++;
+
+	result = brasero_burn_run_tasks_end (burn, result);
+
+	/* That's what brasero_burn_record_session () does */
+	if (result == BRASERO_BURN_RETRY) {
+		if (error && *error) {
+			g_error_free (*error);
+			*error = NULL;
 		}
-		else
-			BRASERO_BURN_DEBUG (burn, "Session error : unknown");
-	}
-	else {
-		BRASERO_BURN_DEBUG (burn, "Session successfully finished");
-		brasero_burn_action_changed_real (burn,
-		                                  BRASERO_BURN_ACTION_FINISHED);
+
+		result = brasero_burn_run_session_tasks (burn,
+							 priv->erase_allowed,
+							 NULL,
+							 error);
+		if (result == BRASERO_BURN_RUNNING)
+			return result;
 	}
 
-	brasero_burn_powermanagement (burn, FALSE);
+	result = brasero_burn_record_session_end (burn, result, NULL, error);
+	if (result == BRASERO_BURN_RUNNING)
+		return result;
 
-	/* release session */
-	g_object_unref (priv->session);
-	priv->session = NULL;
+	if (priv->dummy_removed) {
+		brasero_burn_session_add_flag (priv->session, BRASERO_BURN_FLAG_DUMMY);
+		priv->dummy_removed = FALSE;
+	}
 
-	return result;
+	return brasero_burn_record_end (burn, result, error);
 }
 
 static BraseroBurnResult
@@ -3017,6 +3489,9 @@ brasero_burn_cancel (BraseroBurn *burn, gboolean protect)
 		priv->sleep_loop = NULL;
 	}
 
+	if (priv->cancel)
+		g_cancellable_cancel (priv->cancel);
+
 	if (priv->dest)
 		brasero_drive_cancel_current_operation (priv->dest);
 
@@ -3049,6 +3524,16 @@ brasero_burn_finalize (GObject *object)
 		priv->task = NULL;
 	}
 
+	if (priv->task_error) {
+		g_error_free (priv->task_error);
+		priv->task_error = NULL;
+	}
+
+	if (priv->profile) {
+		g_free (priv->profile);
+		priv->profile = NULL;
+	}
+
 	if (priv->session) {
 		g_object_unref (priv->session);
 		priv->session = NULL;
@@ -0,0 +1,557 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "brasero-data-layout.h"
+
+/**
+ * This estimates the size of the image that mkisofs/genisoimage produce when
+ * run with the options used by the plugins (-r, -J, -iso-level 3, -D) from
+ * the tree directly. It is only used to display the size of a project and
+ * to span it: the image creator is still run with -print-size to know the
+ * actual size since name mangling, the targets of symlinks (SL entries),
+ * hard links and UDF are not laid out.
+ * The layout is:
+ * - the system area
+ * - the volume descriptors (primary, Joliet, terminator) and the version
+ *   descriptor mkisofs adds
+ * - the little and big endian path tables for ISO9660 and Joliet
+ * - the ISO9660 directories (with their Rock Ridge continuation areas) and
+ *   the Joliet directories
+ * - the file contents
+ * - the padding
+ */
+
+#define BRASERO_LAYOUT_SECTOR			2048
+#define BRASERO_LAYOUT_SECTORS(MACRO_bytes)	(((MACRO_bytes) + BRASERO_LAYOUT_SECTOR - 1) / BRASERO_LAYOUT_SECTOR)
+
+#define BRASERO_LAYOUT_SYSTEM_AREA		16
+#define BRASERO_LAYOUT_DESCRIPTOR		1
+#define BRASERO_LAYOUT_PADDING			150
+
+/* Directory and path table records */
+#define BRASERO_LAYOUT_RECORD			33
+#define BRASERO_LAYOUT_RECORD_MAX		254
+#define BRASERO_LAYOUT_DOT_RECORD		34
+#define BRASERO_LAYOUT_PATH_RECORD		8
+
+/* Rock Ridge entries written for every record with -r */
+#define BRASERO_LAYOUT_RR_RR			5
+#define BRASERO_LAYOUT_RR_PX			36
+#define BRASERO_LAYOUT_RR_TF			26
+#define BRASERO_LAYOUT_RR_NM			5
+#define BRASERO_LAYOUT_RR_COMMON		(BRASERO_LAYOUT_RR_RR + BRASERO_LAYOUT_RR_PX + BRASERO_LAYOUT_RR_TF)
+
+/* ... and for the "." record of the root directory */
+#define BRASERO_LAYOUT_RR_SP			7
+#define BRASERO_LAYOUT_RR_CE			28
+#define BRASERO_LAYOUT_RR_ER			237
+
+#define BRASERO_LAYOUT_LEVEL_1_BASE		8
+#define BRASERO_LAYOUT_LEVEL_1_EXT		3
+#define BRASERO_LAYOUT_LEVEL_3_NAME		31
+#define BRASERO_LAYOUT_JOLIET_NAME		64
+#define BRASERO_LAYOUT_MAX_DEPTH		8
+
+/* Largest extent that a single directory record can address */
+#define BRASERO_LAYOUT_MAX_EXTENT		(0xFFFFF800 / BRASERO_LAYOUT_SECTOR)
+
+/* Upper bounds used for what is not laid out:
+ * - the SL entry of a symlink (its target is not known) and the records of
+ *   a relocated directory or of the extra extents of a large file
+ * - the UDF descriptors (the first ones start at sector 256 and the anchor
+ *   is repeated at the end) plus a file entry for every node and the
+ *   contents of every directory */
+#define BRASERO_LAYOUT_MAX_EXTRA		1
+#define BRASERO_LAYOUT_UDF			512
+#define BRASERO_LAYOUT_UDF_ENTRY		1
+
+typedef struct _BraseroDataLayout BraseroDataLayout;
+struct _BraseroDataLayout {
+	BraseroImageFS fs_type;
+
+	/* in bytes */
+	guint64 path_table;
+	guint64 joliet_path_table;
+
+	/* in sectors */
+	guint64 directories;
+	guint64 joliet_directories;
+	guint64 files;
+
+	/* in sectors, what couldn't be laid out */
+	guint64 extra;
+
+	/* URIs already laid out; mkisofs only writes the contents of a file
+	 * once even if it appears several times in the tree */
+	GHashTable *uris;
+
+	guint exact:1;
+
+	/* Counts the largest size possible for what couldn't be laid out and
+	 * never shares contents */
+	guint conservative:1;
+};
+
+typedef struct _BraseroDataLayoutEntry BraseroDataLayoutEntry;
+struct _BraseroDataLayoutEntry {
+	gchar *name;
+	guint record;
+};
+
+static gchar
+brasero_data_layout_d_char (gunichar c)
+{
+	/* Rock Ridge keeps the real names; ISO9660 ones only use d-characters */
+	if (c < 128 && g_ascii_isalnum (c))
+		return g_ascii_toupper (c);
+
+	return '_';
+}
+
+static gchar *
+brasero_data_layout_iso_name (const gchar *name,
+			      gboolean is_file,
+			      gboolean level_3)
+{
+	const gchar *dot = NULL;
+	const gchar *iter;
+	GString *base;
+	GString *ext;
+
+	/* Only the last dot of a file name is kept; a leading one is not an
+	 * extension separator */
+	if (is_file) {
+		dot = strrchr (name, '.');
+		if (dot == name)
+			dot = NULL;
+	}
+
+	base = g_string_new (NULL);
+	for (iter = name; *iter && iter != dot; iter = g_utf8_next_char (iter))
+		g_string_append_c (base, brasero_data_layout_d_char (g_utf8_get_char (iter)));
+
+	ext = g_string_new (NULL);
+	if (dot) {
+		for (iter = dot + 1; *iter; iter = g_utf8_next_char (iter))
+			g_string_append_c (ext, brasero_data_layout_d_char (g_utf8_get_char (iter)));
+	}
+
+	if (!level_3) {
+		/* 8.3 */
+		if (base->len > BRASERO_LAYOUT_LEVEL_1_BASE)
+			g_string_truncate (base, BRASERO_LAYOUT_LEVEL_1_BASE);
+		if (ext->len > BRASERO_LAYOUT_LEVEL_1_EXT)
+			g_string_truncate (ext, BRASERO_LAYOUT_LEVEL_1_EXT);
+	}
+	else if (!is_file) {
+		if (base->len > BRASERO_LAYOUT_LEVEL_3_NAME)
+			g_string_truncate (base, BRASERO_LAYOUT_LEVEL_3_NAME);
+	}
+	else {
+		/* Keep the extension and shorten the base; the dot counts */
+		if (ext->len > BRASERO_LAYOUT_LEVEL_3_NAME - 1)
+			g_string_truncate (ext, BRASERO_LAYOUT_LEVEL_3_NAME - 1);
+		if (base->len + ext->len + 1 > BRASERO_LAYOUT_LEVEL_3_NAME)
+			g_string_truncate (base, BRASERO_LAYOUT_LEVEL_3_NAME - 1 - ext->len);
+	}
+
+	/* Files always have a dot and a version number */
+	if (is_file) {
+		g_string_append_c (base, '.');
+		g_string_append (base, ext->str);
+		g_string_append (base, ";1");
+	}
+
+	g_string_free (ext, TRUE);
+	return g_string_free (base, FALSE);
+}
+
+static guint
+brasero_data_layout_joliet_len (const gchar *name,
+				gboolean is_file)
+{
+	const gchar *iter;
+	guint len = 0;
+
+	/* Number of UCS-2 units, truncated */
+	for (iter = name; *iter; iter = g_utf8_next_char (iter)) {
+		guint units;
+
+		units = g_utf8_get_char (iter) > 0xFFFF? 2:1;
+		if (len + units > BRASERO_LAYOUT_JOLIET_NAME)
+			break;
+
+		len += units;
+	}
+
+	/* version number */
+	if (is_file)
+		len += 2;
+
+	return len * 2;
+}
+
+static guint
+brasero_data_layout_record_len (guint len)
+{
+	/* records always have an even size */
+	return len + (len & 1);
+}
+
+static guint
+brasero_data_layout_rr_record_len (guint name_len,
+				   guint susp,
+				   guint *continuation)
+{
+	guint base;
+
+	base = BRASERO_LAYOUT_RECORD + name_len + ((name_len & 1)? 0:1);
+	if (base + susp <= BRASERO_LAYOUT_RECORD_MAX)
+		return brasero_data_layout_record_len (base + susp);
+
+	/* What does not fit goes into the continuation area; the NM entry
+	 * is split and continued there */
+	*continuation += susp - (BRASERO_LAYOUT_RECORD_MAX - BRASERO_LAYOUT_RR_CE - base) + BRASERO_LAYOUT_RR_NM;
+	return BRASERO_LAYOUT_RECORD_MAX;
+}
+
+static void
+brasero_data_layout_add_record (guint64 *size,
+				guint record)
+{
+	guint used;
+
+	/* records can't cross a sector boundary */
+	used = *size % BRASERO_LAYOUT_SECTOR;
+	if (used + record > BRASERO_LAYOUT_SECTOR)
+		*size += BRASERO_LAYOUT_SECTOR - used;
+
+	*size += record;
+}
+
+static gint
+brasero_data_layout_sort_entries (gconstpointer a,
+				  gconstpointer b)
+{
+	const BraseroDataLayoutEntry *entry_a = a;
+	const BraseroDataLayoutEntry *entry_b = b;
+
+	return strcmp (entry_a->name, entry_b->name);
+}
+
+static guint64
+brasero_data_layout_directory_size (GArray *entries,
+				    guint dot,
+				    guint dotdot)
+{
+	guint64 size = 0;
+	guint i;
+
+	/* mkisofs sorts directory records by name */
+	g_array_sort (entries, brasero_data_layout_sort_entries);
+
+	brasero_data_layout_add_record (&size, dot);
+	brasero_data_layout_add_record (&size, dotdot);
+	for (i = 0; i < entries->len; i ++) {
+		BraseroDataLayoutEntry *entry;
+
+		entry = &g_array_index (entries, BraseroDataLayoutEntry, i);
+		brasero_data_layout_add_record (&size, entry->record);
+		g_free (entry->name);
+	}
+
+	return BRASERO_LAYOUT_SECTORS (size);
+}
+
+static void
+brasero_data_layout_directory (BraseroDataLayout *layout,
+			       BraseroFileNode *directory,
+			       GSList *children,
+			       guint depth,
+			       gboolean shared)
+{
+	BraseroFileNode *child;
+	GArray *joliet_entries;
+	GArray *iso_entries;
+	guint continuation;
+	guint dot;
+
+	iso_entries = g_array_new (FALSE, FALSE, sizeof (BraseroDataLayoutEntry));
+	joliet_entries = g_array_new (FALSE, FALSE, sizeof (BraseroDataLayoutEntry));
+
+	if (depth == 1) {
+		/* the root "." record has also SP and CE pointing to ER */
+		dot = BRASERO_LAYOUT_DOT_RECORD +
+		      BRASERO_LAYOUT_RR_SP +
+		      BRASERO_LAYOUT_RR_COMMON +
+		      BRASERO_LAYOUT_RR_CE;
+		continuation = BRASERO_LAYOUT_RR_ER;
+	}
+	else {
+		dot = BRASERO_LAYOUT_DOT_RECORD + BRASERO_LAYOUT_RR_COMMON;
+		continuation = 0;
+	}
+
+	child = children? children->data:BRASERO_FILE_NODE_CHILDREN (directory);
+	while (child) {
+		BraseroDataLayoutEntry entry;
+		gboolean child_shared;
+		const gchar *name;
+
+		/* Virtual nodes are not written */
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			goto next;
+
+		/* Imported nodes come from the previous session which mkisofs
+		 * merges itself; symlinks have a SL entry whose size depends
+		 * on their target which we don't have. */
+		if (child->is_imported) {
+			layout->exact = FALSE;
+			goto next;
+		}
+
+		if (child->is_symlink) {
+			layout->exact = FALSE;
+			if (layout->conservative)
+				layout->extra += BRASERO_LAYOUT_MAX_EXTRA;
+		}
+
+		if (layout->conservative
+		&& (layout->fs_type & BRASERO_IMAGE_FS_UDF))
+			layout->extra += BRASERO_LAYOUT_UDF_ENTRY * (child->is_file? 1:2);
+
+		name = BRASERO_FILE_NODE_NAME (child);
+
+		/* ISO9660 record with its Rock Ridge entries */
+		entry.name = brasero_data_layout_iso_name (name,
+							   child->is_file,
+							   (layout->fs_type & BRASERO_IMAGE_ISO_FS_LEVEL_3) != 0);
+		entry.record = brasero_data_layout_rr_record_len (strlen (entry.name),
+								  BRASERO_LAYOUT_RR_COMMON +
+								  BRASERO_LAYOUT_RR_NM +
+								  strlen (name),
+								  &continuation);
+		g_array_append_val (iso_entries, entry);
+
+		if (!child->is_file) {
+			guint name_len;
+
+			name_len = strlen (entry.name);
+			layout->path_table += brasero_data_layout_record_len (BRASERO_LAYOUT_PATH_RECORD + name_len);
+		}
+
+		if (layout->fs_type & BRASERO_IMAGE_FS_JOLIET) {
+			guint joliet_len;
+
+			joliet_len = brasero_data_layout_joliet_len (name, child->is_file);
+			entry.name = g_strdup (name);
+			entry.record = brasero_data_layout_record_len (BRASERO_LAYOUT_RECORD + joliet_len);
+			g_array_append_val (joliet_entries, entry);
+
+			if (!child->is_file)
+				layout->joliet_path_table += BRASERO_LAYOUT_PATH_RECORD + joliet_len;
+		}
+
+		/* The contents of grafted nodes whose URI was already laid out
+		 * are shared */
+		child_shared = shared;
+		if (!child_shared
+		&&  !layout->conservative
+		&&  child->is_grafted
+		&&  !child->is_fake) {
+			BraseroGraft *graft;
+
+			graft = BRASERO_FILE_NODE_GRAFT (child);
+			if (g_hash_table_lookup (layout->uris, graft->node->uri))
+				child_shared = TRUE;
+			else
+				g_hash_table_insert (layout->uris,
+						     graft->node->uri,
+						     GINT_TO_POINTER (1));
+		}
+
+		if (child->is_file) {
+			if (BRASERO_FILE_NODE_SECTORS (child) > BRASERO_LAYOUT_MAX_EXTENT) {
+				layout->exact = FALSE;
+				layout->extra += BRASERO_LAYOUT_MAX_EXTRA;
+			}
+
+			if (!child_shared)
+				layout->files += BRASERO_FILE_NODE_SECTORS (child);
+		}
+		else {
+			/* Without -D mkisofs relocates deep directories */
+			if (depth + 1 > BRASERO_LAYOUT_MAX_DEPTH
+			&& !(layout->fs_type & BRASERO_IMAGE_ISO_FS_DEEP_DIRECTORY)) {
+				layout->exact = FALSE;
+				layout->extra += BRASERO_LAYOUT_MAX_EXTRA;
+			}
+
+			brasero_data_layout_directory (layout,
+						       child,
+						       NULL,
+						       depth + 1,
+						       child_shared);
+		}
+
+next:
+		if (children) {
+			children = children->next;
+			child = children? children->data:NULL;
+		}
+		else
+			child = child->next;
+	}
+
+	layout->directories += brasero_data_layout_directory_size (iso_entries,
+								   brasero_data_layout_record_len (dot),
+								   brasero_data_layout_record_len (BRASERO_LAYOUT_DOT_RECORD + BRASERO_LAYOUT_RR_COMMON));
+	layout->directories += BRASERO_LAYOUT_SECTORS (continuation);
+	g_array_free (iso_entries, TRUE);
+
+	if (layout->fs_type & BRASERO_IMAGE_FS_JOLIET)
+		layout->joliet_directories += brasero_data_layout_directory_size (joliet_entries,
+										  BRASERO_LAYOUT_DOT_RECORD,
+										  BRASERO_LAYOUT_DOT_RECORD);
+	g_array_free (joliet_entries, TRUE);
+}
+
+static BraseroBurnResult
+brasero_data_layout_get_sectors_real (BraseroFileNode *root,
+				      GSList *children,
+				      BraseroImageFS fs_type,
+				      gboolean conservative,
+				      goffset *sectors)
+{
+	BraseroDataLayout layout = { 0, };
+	guint64 total;
+
+	layout.fs_type = fs_type;
+	layout.exact = TRUE;
+	layout.conservative = conservative;
+	layout.uris = g_hash_table_new (g_str_hash, g_str_equal);
+
+	if (fs_type & (BRASERO_IMAGE_FS_UDF|BRASERO_IMAGE_FS_VIDEO)) {
+		layout.exact = FALSE;
+		if (conservative)
+			layout.extra += BRASERO_LAYOUT_UDF;
+	}
+
+	/* The root directory is the first entry of both path tables */
+	layout.path_table = brasero_data_layout_record_len (BRASERO_LAYOUT_PATH_RECORD + 1);
+	layout.joliet_path_table = brasero_data_layout_record_len (BRASERO_LAYOUT_PATH_RECORD + 1);
+
+	brasero_data_layout_directory (&layout, root, children, 1, FALSE);
+	g_hash_table_destroy (layout.uris);
+
+	total = BRASERO_LAYOUT_SYSTEM_AREA;
+
+	/* primary, terminator and version descriptors */
+	total += BRASERO_LAYOUT_DESCRIPTOR * 3;
+
+	/* little and big endian path tables */
+	total += BRASERO_LAYOUT_SECTORS (layout.path_table) * 2;
+	total += layout.directories;
+
+	if (fs_type & BRASERO_IMAGE_FS_JOLIET) {
+		total += BRASERO_LAYOUT_DESCRIPTOR;
+		total += BRASERO_LAYOUT_SECTORS (layout.joliet_path_table) * 2;
+		total += layout.joliet_directories;
+	}
+
+	total += layout.files;
+	total += layout.extra;
+	total += BRASERO_LAYOUT_PADDING;
+
+	if (sectors)
+		*sectors = total;
+
+	return layout.exact? BRASERO_BURN_OK:BRASERO_BURN_NOT_SUPPORTED;
+}
+
+/**
+ * brasero_data_layout_get_sectors:
+ * @root: the root #BraseroFileNode
+ * @children: a #GSList of children of @root to lay out or NULL for all
+ * @fs_type: the #BraseroImageFS of the image
+ * @sectors: the number of sectors of the image
+ *
+ * Sets in @sectors an estimate of the size of the image, good enough to be
+ * displayed. Returns BRASERO_BURN_OK if all the tree could be laid out and
+ * BRASERO_BURN_NOT_SUPPORTED if some part of the image (UDF, multisession,
+ * symlinks, ...) was left out.
+ **/
+
+BraseroBurnResult
+brasero_data_layout_get_sectors (BraseroFileNode *root,
+				 GSList *children,
+				 BraseroImageFS fs_type,
+				 goffset *sectors)
+{
+	return brasero_data_layout_get_sectors_real (root,
+						     children,
+						     fs_type,
+						     FALSE,
+						     sectors);
+}
+
+/**
+ * brasero_data_layout_get_max_sectors:
+ * @root: the root #BraseroFileNode
+ * @children: a #GSList of children of @root to lay out or NULL for all
+ * @fs_type: the #BraseroImageFS of the image
+ * @sectors: the number of sectors of the image
+ *
+ * Same as brasero_data_layout_get_sectors () except that @sectors is never
+ * less than the size of the image: what can't be laid out is counted with
+ * its largest size and files appearing several times are counted each time.
+ * This is what should be used when the image must fit on a disc.
+ **/
+
+void
+brasero_data_layout_get_max_sectors (BraseroFileNode *root,
+				     GSList *children,
+				     BraseroImageFS fs_type,
+				     goffset *sectors)
+{
+	brasero_data_layout_get_sectors_real (root,
+					      children,
+					      fs_type,
+					      TRUE,
+					      sectors);
+}
@@ -45,6 +45,8 @@
 #include "brasero-units.h"
 
 #include "brasero-data-project.h"
+#include "brasero-data-snapshot.h"
+#include "brasero-data-layout.h"
 #include "libbrasero-marshal.h"
 
 #include "brasero-misc.h"
@@ -85,7 +87,14 @@ struct _BraseroDataProjectPrivate
 	/* This is a counter for the number of files to be loaded */
 	guint loading;
 
+	/* Temporary folders created while contents are loaded in batches */
+	GSList *loading_folders;
+
+	/* Nesting of batches of additions and whether size changed meanwhile */
+	guint batch;
+
 	guint is_loading_contents:1;
+	guint batch_size_changed:1;
 };
 
 #define BRASERO_DATA_PROJECT_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_DATA_PROJECT, BraseroDataProjectPrivate))
@@ -116,6 +125,56 @@ enum {
 
 static guint brasero_data_project_signals [LAST_SIGNAL] = {0};
 
+static void
+brasero_data_project_size_changed (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (priv->batch) {
+		priv->batch_size_changed = TRUE;
+		return;
+	}
+
+	g_signal_emit (self,
+		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+		       0);
+}
+
+/**
+ * Between these two calls "size-changed" is only emitted once at the end
+ * (if need be) which saves the listeners from updating after each of the
+ * nodes of a directory.
+ */
+
+void
+brasero_data_project_batch_begin (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	priv->batch ++;
+}
+
+void
+brasero_data_project_batch_end (BraseroDataProject *self)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (!priv->batch)
+		return;
+
+	priv->batch --;
+	if (priv->batch || !priv->batch_size_changed)
+		return;
+
+	priv->batch_size_changed = FALSE;
+	g_signal_emit (self,
+		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
+		       0);
+}
+
 /**
  * This is used in grafts hash table to identify created directories
  */
@@ -1236,9 +1295,7 @@ brasero_data_project_remove_real (BraseroDataProject *self,
 						 former_parent,
 						 priv->sort_func);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 }
 
 static void
@@ -1336,9 +1393,7 @@ brasero_data_project_destroy_node (BraseroDataProject *self,
 	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
 	brasero_file_node_destroy (node, stats);
 
-	g_signal_emit (self,
-		       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-		       0);
+	brasero_data_project_size_changed (self);
 
 	/* NOTE: no need to check for imported_sibling here since this function
 	 * actually destroys all nodes including imported ones and is mainly 
@@ -1803,6 +1858,19 @@ brasero_data_project_exclude_uri (BraseroDataProject *self,
 	}
 }
 
+/**
+ * Returns TRUE if uri was either excluded or added through a graft point
+ */
+gboolean
+brasero_data_project_uri_has_graft (BraseroDataProject *self,
+				    const gchar *uri)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	return (g_hash_table_lookup (priv->grafts, uri) != NULL);
+}
+
 BraseroFileNode *
 brasero_data_project_add_imported_session_file (BraseroDataProject *self,
 						GFileInfo *info,
@@ -2109,9 +2177,7 @@ brasero_data_project_node_loaded (BraseroDataProject *self,
 	/* signal the changes */
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 
 	return TRUE;
 }
@@ -2132,6 +2198,25 @@ brasero_data_project_node_reloaded (BraseroDataProject *self,
 
 	node->is_reloading = FALSE;
 
+	/* Nodes restored from a snapshot were never monitored */
+	if (node->is_restored) {
+		node->is_restored = FALSE;
+#ifdef BUILD_INOTIFY
+		if (!node->is_monitored) {
+			if (node->is_grafted)
+				brasero_file_monitor_single_file (BRASERO_FILE_MONITOR (self),
+								  uri,
+								  node);
+
+			if (!node->is_file)
+				brasero_file_monitor_directory_contents (BRASERO_FILE_MONITOR (self),
+									 uri,
+									 node);
+			node->is_monitored = TRUE;
+		}
+#endif
+	}
+
 	/* the only thing that can have changed here is size. Readability was 
 	 * checked in data-vfs.c. That's why we're only interested in files
 	 * since directories don't have size. */ 
@@ -2148,7 +2233,7 @@ brasero_data_project_node_reloaded (BraseroDataProject *self,
 		}
 	}
 
-	size_changed = (BRASERO_BYTES_TO_SECTORS (size, 2048) == BRASERO_FILE_NODE_SECTORS (node));
+	size_changed = (BRASERO_BYTES_TO_SECTORS (size, 2048) != BRASERO_FILE_NODE_SECTORS (node));
 	if (BRASERO_FILE_NODE_MIME (node) && !size_changed)
 		return;
 
@@ -2163,9 +2248,7 @@ brasero_data_project_node_reloaded (BraseroDataProject *self,
 
 	brasero_data_project_node_changed (self, node);
 	if (size_changed)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 }
 
 static BraseroFileNode *
@@ -2432,9 +2515,7 @@ brasero_data_project_add_node_from_info (BraseroDataProject *self,
 	}
 
 	if (type != G_FILE_TYPE_DIRECTORY)
-		g_signal_emit (self,
-			       brasero_data_project_signals [SIZE_CHANGED_SIGNAL],
-			       0);
+		brasero_data_project_size_changed (self);
 
 	/* at this point we know all we need to know about our node and in 
 	 * particular if it's a file or a directory, if it's grafted or not
@@ -2738,6 +2819,7 @@ brasero_data_project_span_generate (BraseroDataProject *self,
 	GHashTableIter hiter;
 	GSList *grafts = NULL;
 	GSList *excluded = NULL;
+	GHashTable *grafted;
 	BraseroDataProjectPrivate *priv;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
@@ -2771,15 +2853,38 @@ brasero_data_project_span_generate (BraseroDataProject *self,
 	}
 
 	/* NOTE about excluded file list:
-	 * don't try to check for every empty BraseroUriNode whether its URI is
-	 * a child of one of the grafted node that would take too much time for
-	 * almost no win; better add all of them (which includes the above graft
-	 * list as well. */
+	 * only the URIs below one of the grafted directories of this span can
+	 * be met by mkisofs while exploring; the others are useless and make
+	 * it match every path against them. Looking up the parents of each URI
+	 * in a table of the grafted directories is cheap. */
+	grafted = g_hash_table_new (g_str_hash, g_str_equal);
+	for (iter = grafts; iter; iter = iter->next) {
+		BraseroGraftPt *graft;
+
+		graft = iter->data;
+		if (graft->uri)
+			g_hash_table_insert (grafted, graft->uri, graft->uri);
+	}
+
 	g_hash_table_iter_init (&hiter, priv->grafts);
 	while (g_hash_table_iter_next (&hiter, &uri_data, NULL)) {
-		if (uri_data != NEW_FOLDER)
-			excluded = g_slist_prepend (excluded, g_strdup (uri_data));
+		gchar *parent;
+		gchar *end;
+
+		if (uri_data == NEW_FOLDER)
+			continue;
+
+		parent = g_strdup (uri_data);
+		while ((end = strrchr (parent, G_DIR_SEPARATOR))) {
+			*end = '\0';
+			if (g_hash_table_lookup (grafted, parent)) {
+				excluded = g_slist_prepend (excluded, g_strdup (uri_data));
+				break;
+			}
+		}
+		g_free (parent);
 	}
+	g_hash_table_destroy (grafted);
 
 	if (data->fs_type & BRASERO_IMAGE_FS_JOLIET) {
 		/* Add the joliet grafts */
@@ -2900,7 +3005,9 @@ brasero_data_project_span (BraseroDataProject *self,
 	MakeTrackDataSpan callback_data;
 	BraseroDataProjectPrivate *priv;
 	BraseroFileNode *children;
+	goffset image_sectors = 0;
 	goffset total_sectors = 0;
+	GSList *top = NULL;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 
@@ -2918,7 +3025,9 @@ brasero_data_project_span (BraseroDataProject *self,
 
 	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
 	while (children) {
+		MakeTrackDataSpan saved;
 		goffset child_sectors;
+		goffset sectors;
 
 		if (g_slist_find (priv->spanned, children)) {
 			children = children->next;
@@ -2936,6 +3045,9 @@ brasero_data_project_span (BraseroDataProject *self,
 			continue;
 		}
 
+		/* Grafts are only prepended so this is enough to undo */
+		saved = callback_data;
+
 		/* FIXME: we need a better algorithm here that would add first
 		 * the biggest top folders/files and that would try to fill as
 		 * much as possible the disc. */
@@ -2987,10 +3099,33 @@ brasero_data_project_span (BraseroDataProject *self,
 			callback_data.dir_num ++;
 		}
 
+		/* The selected nodes must fit on the disc whatever mkisofs
+		 * does with them so don't underestimate their size */
+		top = g_slist_prepend (top, children);
+		brasero_data_layout_get_max_sectors (priv->root,
+						     top,
+						     callback_data.fs_type,
+						     &sectors);
+		if (sectors > max_sectors) {
+			top = g_slist_delete_link (top, top);
+			while (callback_data.grafts != saved.grafts)
+				callback_data.grafts = g_slist_delete_link (callback_data.grafts, callback_data.grafts);
+			while (callback_data.joliet_grafts != saved.joliet_grafts)
+				callback_data.joliet_grafts = g_slist_delete_link (callback_data.joliet_grafts, callback_data.joliet_grafts);
+
+			callback_data = saved;
+			total_sectors -= child_sectors;
+			children = children->next;
+			continue;
+		}
+
+		image_sectors = sectors;
 		priv->spanned = g_slist_prepend (priv->spanned, children);
 		children = children->next;
 	}
 
+	g_slist_free (top);
+
 	/* This means it's finished */
 	if (!callback_data.grafts) {
 		BRASERO_BURN_LOG ("No graft found for spanning");
@@ -3002,15 +3137,11 @@ brasero_data_project_span (BraseroDataProject *self,
 					    append_slash,
 					    track);
 
-	total_sectors = brasero_data_project_improve_image_size_accuracy (total_sectors,
-									  callback_data.dir_num,
-									  callback_data.fs_type);
-
-	brasero_track_data_set_data_blocks (track, total_sectors);
+	brasero_track_data_set_data_blocks (track, image_sectors);
 	brasero_track_data_add_fs (track, callback_data.fs_type);
 	brasero_track_data_set_file_num (track, callback_data.files_num);
 
-	BRASERO_BURN_LOG ("Set object (size %" G_GOFFSET_FORMAT ")", total_sectors);
+	BRASERO_BURN_LOG ("Set object (size %" G_GOFFSET_FORMAT ")", image_sectors);
 
 	g_slist_free (callback_data.grafts);
 	g_slist_free (callback_data.joliet_grafts);
@@ -3034,20 +3165,32 @@ brasero_data_project_span_possible (BraseroDataProject *self,
 
 	children = BRASERO_FILE_NODE_CHILDREN (priv->root);
 	while (children) {
+		MakeTrackDataSpan data;
 		goffset child_sectors;
+		GSList top;
 
 		if (g_slist_find (priv->spanned, children)) {
 			children = children->next;
 			continue;
 		}
 
+		/* Find at least one file or directory that can be spanned,
+		 * counted the way brasero_data_project_span () does */
+		memset (&data, 0, sizeof (MakeTrackDataSpan));
+		data.fs_type = BRASERO_IMAGE_FS_ISO|BRASERO_IMAGE_FS_JOLIET;
 		if (children->is_file)
-			child_sectors = BRASERO_FILE_NODE_SECTORS (children);
+			brasero_data_project_span_set_fs_type (&data, children);
 		else
-			child_sectors = brasero_data_project_get_folder_sectors (self, children);
-
-		/* Find at least one file or directory that can be spanned */
-		if (child_sectors < max_sectors)
+			brasero_data_project_span_explore_folder_children (&data, children);
+		g_slist_free (data.grafts);
+
+		top.data = children;
+		top.next = NULL;
+		brasero_data_layout_get_max_sectors (priv->root,
+						     &top,
+						     data.fs_type,
+						     &child_sectors);
+		if (child_sectors <= max_sectors)
 			return BRASERO_BURN_RETRY;
 
 		/* if the top directory is too large, continue */
@@ -3569,18 +3712,36 @@ brasero_data_project_load_contents_notify (BraseroDataProject *self)
 	return num;
 }
 
-guint
-brasero_data_project_load_contents (BraseroDataProject *self,
-				    GSList *grafts,
-				    GSList *excluded)
+/**
+ * Contents can be loaded in several batches of grafts and excluded URIs
+ * between brasero_data_project_load_contents_begin () and
+ * brasero_data_project_load_contents_end () so that the caller does not have
+ * to build the whole list first. Nodes are only signalled at the end.
+ * NOTE: excluded URIs should come after the grafts they apply to.
+ */
+
+void
+brasero_data_project_load_contents_begin (BraseroDataProject *self)
 {
-	GSList *iter;
-	GSList *folders = NULL;
 	BraseroDataProjectPrivate *priv;
 
 	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
 	priv->is_loading_contents = 1;
+}
+
+void
+brasero_data_project_load_contents_add (BraseroDataProject *self,
+					GSList *grafts,
+					GSList *excluded)
+{
+	GSList *iter;
+	GSList *folders;
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	g_return_if_fail (priv->is_loading_contents);
 
+	folders = priv->loading_folders;
 	for (iter = grafts; iter; iter = iter->next) {
 		BraseroGraftPt *graft;
 		GFile *file;
@@ -3633,6 +3794,22 @@ brasero_data_project_load_contents (BraseroDataProject *self,
 		g_free (uri);
 	}
 
+	priv->loading_folders = folders;
+}
+
+guint
+brasero_data_project_load_contents_end (BraseroDataProject *self)
+{
+	GSList *iter;
+	GSList *folders;
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	g_return_val_if_fail (priv->is_loading_contents, 0);
+
+	folders = priv->loading_folders;
+	priv->loading_folders = NULL;
+
 	/* Now load the temporary folders that were created */
 	for (iter = folders; iter; iter = iter->next) {
 		BraseroURINode *graft;
@@ -3679,6 +3856,454 @@ brasero_data_project_load_contents (BraseroDataProject *self,
 	return priv->loading;
 }
 
+guint
+brasero_data_project_load_contents (BraseroDataProject *self,
+				    GSList *grafts,
+				    GSList *excluded)
+{
+	brasero_data_project_load_contents_begin (self);
+	brasero_data_project_load_contents_add (self, grafts, excluded);
+	return brasero_data_project_load_contents_end (self);
+}
+
+/**
+ * Snapshots hold the whole tree so that a project can be restored without
+ * exploring the file system again. Restored nodes are then only revalidated
+ * in the background (see data-vfs.c).
+ */
+
+static gboolean
+brasero_data_project_snapshot_has_own_nodes (BraseroFileNode *node)
+{
+	BraseroFileNode *child;
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (node); child; child = child->next) {
+		if (!child->is_imported)
+			return TRUE;
+
+		if (!child->is_file
+		&&   brasero_data_project_snapshot_has_own_nodes (child))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+brasero_data_project_export_is_loading (BraseroFileNode *parent)
+{
+	BraseroFileNode *child;
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (parent); child; child = child->next) {
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		if (child->is_loading)
+			return TRUE;
+
+		if (!child->is_file && brasero_data_project_export_is_loading (child))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+static BraseroBurnResult
+brasero_data_project_export_children (BraseroDataProject *self,
+				      BraseroFileNode *parent,
+				      const gchar *parent_uri,
+				      gpointer handle,
+				      const BraseroTrackDataVisitor *visitor,
+				      gpointer user_data)
+{
+	BraseroBurnResult result = BRASERO_BURN_OK;
+	BraseroFileNode *child;
+
+	for (child = BRASERO_FILE_NODE_CHILDREN (parent); child && result == BRASERO_BURN_OK; child = child->next) {
+		gpointer child_handle = NULL;
+		BraseroGraft *graft;
+		const gchar *name;
+		gchar *uri = NULL;
+
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		name = BRASERO_FILE_NODE_NAME (child);
+
+		/* Files from a previous session are already in the image;
+		 * only the directories are needed to reach the new files */
+		if (child->is_imported) {
+			if (child->is_file)
+				continue;
+
+			result = visitor->add_directory (handle,
+							 name,
+							 NULL,
+							 FALSE,
+							 TRUE,
+							 &child_handle,
+							 user_data);
+			if (result == BRASERO_BURN_OK)
+				result = brasero_data_project_export_children (self,
+									       child,
+									       NULL,
+									       child_handle,
+									       visitor,
+									       user_data);
+			if (visitor->end_directory && child_handle)
+				visitor->end_directory (child_handle, user_data);
+			continue;
+		}
+
+		/* Only grafted nodes can have a name different from the one
+		 * of their URI so the others have the URI of their parent
+		 * plus their name. */
+		graft = BRASERO_FILE_NODE_GRAFT (child);
+		if (graft) {
+			if (graft->node->uri != NEW_FOLDER)
+				uri = g_strdup (graft->node->uri);
+		}
+		else if (parent_uri) {
+			gchar *escaped_name;
+
+			escaped_name = g_uri_escape_string (name,
+							    G_URI_RESERVED_CHARS_ALLOWED_IN_PATH,
+							    FALSE);
+			uri = g_strconcat (parent_uri, G_DIR_SEPARATOR_S, escaped_name, NULL);
+			g_free (escaped_name);
+		}
+
+		if (child->is_file) {
+			if (uri)
+				result = visitor->add_file (handle,
+							    name,
+							    uri,
+							    user_data);
+		}
+		else {
+			result = visitor->add_directory (handle,
+							 name,
+							 uri,
+							 (graft != NULL),
+							 FALSE,
+							 &child_handle,
+							 user_data);
+			if (result == BRASERO_BURN_OK)
+				result = brasero_data_project_export_children (self,
+									       child,
+									       uri,
+									       child_handle,
+									       visitor,
+									       user_data);
+			if (visitor->end_directory && child_handle)
+				visitor->end_directory (child_handle, user_data);
+		}
+
+		g_free (uri);
+	}
+
+	return result;
+}
+
+/**
+ * Hands every node of the tree to the visitor, depth first, with the handle
+ * the visitor returned for its parent directory so that image creators don't
+ * need to resolve and explore graft points again.
+ * Returns BRASERO_BURN_NOT_READY while files are being loaded; this is known
+ * before any node is handed to the visitor.
+ */
+
+BraseroBurnResult
+brasero_data_project_export (BraseroDataProject *self,
+			     const BraseroTrackDataVisitor *visitor,
+			     gpointer root,
+			     gpointer user_data)
+{
+	BraseroDataProjectPrivate *priv;
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	if (priv->loading
+	||  brasero_data_project_export_is_loading (priv->root))
+		return BRASERO_BURN_NOT_READY;
+
+	return brasero_data_project_export_children (self,
+						     priv->root,
+						     NULL,
+						     root,
+						     visitor,
+						     user_data);
+}
+
+static gint
+brasero_data_project_snapshot_sort_cb (gconstpointer a,
+				       gconstpointer b)
+{
+	BraseroFileNode *node_a = *(BraseroFileNode **) a;
+	BraseroFileNode *node_b = *(BraseroFileNode **) b;
+
+	/* Nodes are written so that, when they are loaded, each one of them
+	 * is inserted at the head of its siblings: hidden nodes come first
+	 * and the others in reverse order. */
+	if (node_a->is_hidden != node_b->is_hidden)
+		return node_a->is_hidden? -1:1;
+
+	return brasero_file_node_sort_default_cb (node_b, node_a);
+}
+
+static gboolean
+brasero_data_project_snapshot_add_children (BraseroDataProject *self,
+					    BraseroDataSnapshot *snapshot,
+					    BraseroFileNode *parent,
+					    guint parent_index,
+					    GError **error)
+{
+	BraseroFileNode *child;
+	GPtrArray *children;
+	gboolean result = TRUE;
+	guint i;
+
+	children = g_ptr_array_new ();
+	for (child = BRASERO_FILE_NODE_CHILDREN (parent); child; child = child->next) {
+		/* Virtual nodes are only placeholders */
+		if (BRASERO_FILE_NODE_VIRTUAL (child))
+			continue;
+
+		/* Imported nodes are not saved (like with grafts); their
+		 * directories are only kept (as fake ones) for the nodes the
+		 * user added to them. */
+		if (child->is_imported
+		&& (child->is_file || !brasero_data_project_snapshot_has_own_nodes (child)))
+			continue;
+
+		if (child->is_loading) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     "%s",
+				     _("The project is still being loaded"));
+			g_ptr_array_free (children, TRUE);
+			return FALSE;
+		}
+
+		g_ptr_array_add (children, child);
+	}
+
+	g_ptr_array_sort (children, brasero_data_project_snapshot_sort_cb);
+
+	for (i = 0; i < children->len && result; i ++) {
+		BraseroDataSnapshotNodeFlags flags = BRASERO_DATA_SNAPSHOT_NODE_NONE;
+		BraseroGraft *graft;
+		const gchar *uri;
+		guint index;
+
+		child = g_ptr_array_index (children, i);
+
+		uri = NULL;
+		graft = BRASERO_FILE_NODE_GRAFT (child);
+		if (graft) {
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_GRAFTED;
+			if (graft->node->uri != NEW_FOLDER)
+				uri = graft->node->uri;
+		}
+
+		if (child->is_imported)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_FAKE|
+				 BRASERO_DATA_SNAPSHOT_NODE_GRAFTED;
+		else if (child->is_fake)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_FAKE;
+
+		if (child->is_file)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_FILE;
+		if (child->is_symlink)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_SYMLINK;
+		if (child->is_hidden)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_HIDDEN;
+		if (child->is_2GiB)
+			flags |= BRASERO_DATA_SNAPSHOT_NODE_2GiB;
+
+		index = brasero_data_snapshot_add_node (snapshot,
+							parent_index,
+							BRASERO_FILE_NODE_NAME (child),
+							child->is_file? child->union2.mime:NULL,
+							(flags & BRASERO_DATA_SNAPSHOT_NODE_FAKE)? NULL:uri,
+							child->is_file? child->union3.sectors:0,
+							flags);
+
+		if (!child->is_file)
+			result = brasero_data_project_snapshot_add_children (self,
+									     snapshot,
+									     child,
+									     index,
+									     error);
+	}
+	g_ptr_array_free (children, TRUE);
+
+	return result;
+}
+
+static void
+brasero_data_project_snapshot_excluded_cb (gchar *key,
+					   BraseroURINode *graft,
+					   BraseroDataSnapshot *snapshot)
+{
+	/* URIs with a graft but without nodes are excluded */
+	if (graft->nodes || key == NEW_FOLDER)
+		return;
+
+	brasero_data_snapshot_add_excluded (snapshot, key);
+}
+
+gboolean
+brasero_data_project_save_snapshot (BraseroDataProject *self,
+				    const gchar *path,
+				    GError **error)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroDataSnapshot *snapshot;
+	gboolean result;
+	guint index;
+
+	g_return_val_if_fail (BRASERO_IS_DATA_PROJECT (self), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+
+	snapshot = brasero_data_snapshot_new ();
+	index = brasero_data_snapshot_add_node (snapshot,
+						BRASERO_DATA_SNAPSHOT_NONE,
+						NULL,
+						NULL,
+						NULL,
+						0,
+						BRASERO_DATA_SNAPSHOT_NODE_NONE);
+
+	result = brasero_data_project_snapshot_add_children (self,
+							     snapshot,
+							     priv->root,
+							     index,
+							     error);
+	if (result) {
+		g_hash_table_foreach (priv->grafts,
+				      (GHFunc) brasero_data_project_snapshot_excluded_cb,
+				      snapshot);
+		result = brasero_data_snapshot_write (snapshot, path, error);
+	}
+
+	brasero_data_snapshot_free (snapshot);
+	return result;
+}
+
+gboolean
+brasero_data_project_load_snapshot (BraseroDataProject *self,
+				    const gchar *path,
+				    GError **error)
+{
+	BraseroDataProjectPrivate *priv;
+	BraseroDataSnapshot *snapshot;
+	BraseroFileTreeStats *stats;
+	BraseroFileNode **nodes;
+	guint num;
+	guint i;
+
+	g_return_val_if_fail (BRASERO_IS_DATA_PROJECT (self), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	priv = BRASERO_DATA_PROJECT_PRIVATE (self);
+	if (BRASERO_FILE_NODE_CHILDREN (priv->root) || priv->is_loading_contents) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     _("The project is not empty"));
+		return FALSE;
+	}
+
+	snapshot = brasero_data_snapshot_open (path, error);
+	if (!snapshot)
+		return FALSE;
+
+	BRASERO_BURN_LOG ("Loading project snapshot %s", path);
+
+	/* The snapshot was checked when opened: every record comes after its
+	 * parent which is a directory so the tree can be built in one pass. */
+	num = brasero_data_snapshot_get_n_nodes (snapshot);
+	nodes = g_new (BraseroFileNode *, num);
+	nodes [0] = priv->root;
+
+	stats = brasero_file_node_get_tree_stats (priv->root, NULL);
+	for (i = 1; i < num; i ++) {
+		const BraseroDataSnapshotNode *record;
+		BraseroFileNode *node;
+		const gchar *name;
+
+		record = brasero_data_snapshot_get_node (snapshot, i);
+		name = brasero_data_snapshot_get_string (snapshot, record->name);
+
+		node = brasero_file_node_new (name);
+		node->is_file = (record->flags & BRASERO_DATA_SNAPSHOT_NODE_FILE) != 0;
+		node->is_fake = (record->flags & BRASERO_DATA_SNAPSHOT_NODE_FAKE) != 0;
+		node->is_symlink = (record->flags & BRASERO_DATA_SNAPSHOT_NODE_SYMLINK) != 0;
+		node->is_hidden = (record->flags & BRASERO_DATA_SNAPSHOT_NODE_HIDDEN) != 0;
+
+		if (node->is_file) {
+			const gchar *mime;
+
+			mime = brasero_data_snapshot_get_string (snapshot, record->mime);
+			if (mime)
+				node->union2.mime = brasero_utils_register_string (mime);
+
+			node->union3.sectors = record->sectors;
+		}
+
+		/* Nodes that exist on the file system are revalidated later */
+		if (!node->is_fake)
+			node->is_restored = TRUE;
+
+		/* NOTE: graft before adding so that the size of the node is not
+		 * propagated to its parents */
+		if (record->flags & BRASERO_DATA_SNAPSHOT_NODE_GRAFTED) {
+			const gchar *uri;
+			BraseroURINode *graft;
+
+			uri = brasero_data_snapshot_get_string (snapshot, record->uri);
+			if (!uri || node->is_fake)
+				uri = NEW_FOLDER;
+
+			graft = brasero_data_project_uri_ensure_graft (self, uri);
+			brasero_file_node_graft (node, graft);
+		}
+
+		brasero_file_node_add (nodes [record->parent], node, priv->sort_func);
+
+		if (record->flags & BRASERO_DATA_SNAPSHOT_NODE_2GiB) {
+			node->is_2GiB = TRUE;
+			stats->num_2GiB ++;
+		}
+
+		if (node->is_symlink)
+			stats->num_sym ++;
+
+		if (strlen (name) > 64)
+			brasero_data_project_joliet_add_node (self, node);
+
+		nodes [i] = node;
+	}
+	g_free (nodes);
+
+	for (i = 0; i < brasero_data_snapshot_get_n_excluded (snapshot); i ++)
+		brasero_data_project_exclude_uri (self, brasero_data_snapshot_get_excluded (snapshot, i));
+
+	brasero_data_snapshot_free (snapshot);
+
+	/* Nothing needs loading; restored nodes are only revalidated */
+	priv->loading = 0;
+	brasero_data_project_load_contents_notify (self);
+
+	brasero_data_project_size_changed (self);
+	return TRUE;
+}
+
 /**
  * get the size of the whole tree in sectors 
  */
@@ -3877,6 +4502,12 @@ brasero_data_project_clear (BraseroDataProject *self)
 		priv->spanned = NULL;
 	}
 
+	if (priv->loading_folders) {
+		g_slist_free (priv->loading_folders);
+		priv->loading_folders = NULL;
+	}
+	priv->is_loading_contents = 0;
+
 	/* clear the tables.
 	 * NOTE: reference hash doesn't need to be cleared. */
 	g_hash_table_foreach_remove (priv->grafts,
@@ -158,6 +158,33 @@ brasero_data_project_load_contents (BraseroDataProject *project,
 				    GSList *grafts,
 				    GSList *excluded);
 
+void
+brasero_data_project_load_contents_begin (BraseroDataProject *project);
+
+void
+brasero_data_project_load_contents_add (BraseroDataProject *project,
+					GSList *grafts,
+					GSList *excluded);
+
+guint
+brasero_data_project_load_contents_end (BraseroDataProject *project);
+
+BraseroBurnResult
+brasero_data_project_export (BraseroDataProject *project,
+			     const BraseroTrackDataVisitor *visitor,
+			     gpointer root,
+			     gpointer user_data);
+
+gboolean
+brasero_data_project_save_snapshot (BraseroDataProject *project,
+				    const gchar *path,
+				    GError **error);
+
+gboolean
+brasero_data_project_load_snapshot (BraseroDataProject *project,
+				    const gchar *path,
+				    GError **error);
+
 BraseroFileNode *
 brasero_data_project_add_hidden_node (BraseroDataProject *project,
 				      const gchar *uri,
@@ -173,6 +200,13 @@ brasero_data_project_add_node_from_info (BraseroDataProject *project,
 					 const gchar *uri,
 					 GFileInfo *info,
 					 BraseroFileNode *parent);
+
+void
+brasero_data_project_batch_begin (BraseroDataProject *project);
+
+void
+brasero_data_project_batch_end (BraseroDataProject *project);
+
 BraseroFileNode *
 brasero_data_project_add_empty_directory (BraseroDataProject *project,
 					  const gchar *name,
@@ -219,6 +253,9 @@ brasero_data_project_restore_uri (BraseroDataProject *project,
 void
 brasero_data_project_exclude_uri (BraseroDataProject *project,
 				  const gchar *uri);
+gboolean
+brasero_data_project_uri_has_graft (BraseroDataProject *project,
+				    const gchar *uri);
 
 guint
 brasero_data_project_reference_new (BraseroDataProject *project,
@@ -0,0 +1,372 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+
+#include "brasero-data-snapshot.h"
+#include "brasero-error.h"
+
+#define BRASERO_DATA_SNAPSHOT_MAGIC		"BRSNAP01"
+#define BRASERO_DATA_SNAPSHOT_BYTE_ORDER	0x01020304
+
+typedef struct _BraseroDataSnapshotHeader BraseroDataSnapshotHeader;
+struct _BraseroDataSnapshotHeader {
+	gchar magic [8];
+	guint32 byte_order;
+
+	guint32 num_nodes;
+	guint32 num_excluded;
+
+	guint32 nodes_offset;
+	guint32 excluded_offset;
+	guint32 strings_offset;
+	guint32 strings_size;
+
+	guint32 reserved;
+};
+
+struct _BraseroDataSnapshot {
+	/* Used while writing */
+	GHashTable *strings;
+	GString *table;
+	GArray *nodes;
+	GArray *excluded;
+
+	/* Used while reading */
+	GMappedFile *file;
+	const BraseroDataSnapshotHeader *header;
+	const BraseroDataSnapshotNode *node_records;
+	const guint32 *excluded_records;
+	const gchar *string_table;
+};
+
+BraseroDataSnapshot *
+brasero_data_snapshot_new (void)
+{
+	BraseroDataSnapshot *snapshot;
+
+	snapshot = g_new0 (BraseroDataSnapshot, 1);
+	snapshot->strings = g_hash_table_new_full (g_str_hash,
+						   g_str_equal,
+						   g_free,
+						   NULL);
+
+	/* Offset 0 is always the empty string */
+	snapshot->table = g_string_sized_new (4096);
+	g_string_append_c (snapshot->table, '\0');
+
+	snapshot->nodes = g_array_new (FALSE, FALSE, sizeof (BraseroDataSnapshotNode));
+	snapshot->excluded = g_array_new (FALSE, FALSE, sizeof (guint32));
+	return snapshot;
+}
+
+static guint32
+brasero_data_snapshot_intern (BraseroDataSnapshot *snapshot,
+			      const gchar *string)
+{
+	guint32 offset;
+
+	if (!string)
+		return BRASERO_DATA_SNAPSHOT_NONE;
+
+	if (!string [0])
+		return 0;
+
+	offset = GPOINTER_TO_UINT (g_hash_table_lookup (snapshot->strings, string));
+	if (offset)
+		return offset;
+
+	offset = snapshot->table->len;
+	g_string_append_len (snapshot->table, string, strlen (string) + 1);
+	g_hash_table_insert (snapshot->strings,
+			     g_strdup (string),
+			     GUINT_TO_POINTER (offset));
+	return offset;
+}
+
+guint
+brasero_data_snapshot_add_node (BraseroDataSnapshot *snapshot,
+				guint parent,
+				const gchar *name,
+				const gchar *mime,
+				const gchar *uri,
+				guint sectors,
+				BraseroDataSnapshotNodeFlags flags)
+{
+	BraseroDataSnapshotNode record;
+
+	g_return_val_if_fail (snapshot->nodes != NULL, BRASERO_DATA_SNAPSHOT_NONE);
+
+	record.parent = parent;
+	record.name = brasero_data_snapshot_intern (snapshot, name);
+	record.mime = brasero_data_snapshot_intern (snapshot, mime);
+	record.uri = brasero_data_snapshot_intern (snapshot, uri);
+	record.sectors = sectors;
+	record.flags = flags;
+
+	g_array_append_val (snapshot->nodes, record);
+	return snapshot->nodes->len - 1;
+}
+
+void
+brasero_data_snapshot_add_excluded (BraseroDataSnapshot *snapshot,
+				    const gchar *uri)
+{
+	guint32 offset;
+
+	g_return_if_fail (snapshot->excluded != NULL);
+
+	offset = brasero_data_snapshot_intern (snapshot, uri);
+	g_array_append_val (snapshot->excluded, offset);
+}
+
+gboolean
+brasero_data_snapshot_write (BraseroDataSnapshot *snapshot,
+			     const gchar *path,
+			     GError **error)
+{
+	BraseroDataSnapshotHeader header;
+	gboolean result;
+	GString *buffer;
+
+	g_return_val_if_fail (snapshot->nodes != NULL, FALSE);
+
+	memset (&header, 0, sizeof (header));
+	memcpy (header.magic, BRASERO_DATA_SNAPSHOT_MAGIC, sizeof (header.magic));
+	header.byte_order = BRASERO_DATA_SNAPSHOT_BYTE_ORDER;
+	header.num_nodes = snapshot->nodes->len;
+	header.num_excluded = snapshot->excluded->len;
+	header.nodes_offset = sizeof (header);
+	header.excluded_offset = header.nodes_offset + snapshot->nodes->len * sizeof (BraseroDataSnapshotNode);
+	header.strings_offset = header.excluded_offset + snapshot->excluded->len * sizeof (guint32);
+	header.strings_size = snapshot->table->len;
+
+	buffer = g_string_sized_new (header.strings_offset + header.strings_size);
+	g_string_append_len (buffer, (gchar *) &header, sizeof (header));
+	g_string_append_len (buffer,
+			     snapshot->nodes->data,
+			     snapshot->nodes->len * sizeof (BraseroDataSnapshotNode));
+	g_string_append_len (buffer,
+			     snapshot->excluded->data,
+			     snapshot->excluded->len * sizeof (guint32));
+	g_string_append_len (buffer,
+			     snapshot->table->str,
+			     snapshot->table->len);
+
+	/* This is atomic so a former snapshot is never left half written */
+	result = g_file_set_contents (path, buffer->str, buffer->len, error);
+	g_string_free (buffer, TRUE);
+
+	return result;
+}
+
+static gboolean
+brasero_data_snapshot_check_string (BraseroDataSnapshot *snapshot,
+				    guint32 offset,
+				    gboolean allow_none)
+{
+	if (offset == BRASERO_DATA_SNAPSHOT_NONE)
+		return allow_none;
+
+	return (offset < snapshot->header->strings_size);
+}
+
+static gboolean
+brasero_data_snapshot_check (BraseroDataSnapshot *snapshot)
+{
+	const BraseroDataSnapshotHeader *header;
+	gsize length;
+	guint i;
+
+	length = g_mapped_file_get_length (snapshot->file);
+	if (length < sizeof (BraseroDataSnapshotHeader))
+		return FALSE;
+
+	header = (const BraseroDataSnapshotHeader *) g_mapped_file_get_contents (snapshot->file);
+	if (memcmp (header->magic, BRASERO_DATA_SNAPSHOT_MAGIC, sizeof (header->magic))
+	||  header->byte_order != BRASERO_DATA_SNAPSHOT_BYTE_ORDER)
+		return FALSE;
+
+	/* Check all sections follow each other and fill the file exactly; be
+	 * careful not to overflow while doing so. */
+	if (header->nodes_offset != sizeof (BraseroDataSnapshotHeader)
+	||  header->num_nodes < 1
+	||  header->num_nodes > (length - header->nodes_offset) / sizeof (BraseroDataSnapshotNode))
+		return FALSE;
+
+	if (header->excluded_offset != header->nodes_offset + header->num_nodes * sizeof (BraseroDataSnapshotNode)
+	||  header->num_excluded > (length - header->excluded_offset) / sizeof (guint32))
+		return FALSE;
+
+	if (header->strings_offset != header->excluded_offset + header->num_excluded * sizeof (guint32)
+	||  header->strings_size < 1
+	||  header->strings_size != length - header->strings_offset)
+		return FALSE;
+
+	snapshot->header = header;
+	snapshot->node_records = (const BraseroDataSnapshotNode *) ((const gchar *) header + header->nodes_offset);
+	snapshot->excluded_records = (const guint32 *) ((const gchar *) header + header->excluded_offset);
+	snapshot->string_table = (const gchar *) header + header->strings_offset;
+
+	/* Every string must be NUL terminated */
+	if (snapshot->string_table [header->strings_size - 1] != '\0')
+		return FALSE;
+
+	/* The first record is the root; then each record comes after its
+	 * parent which must be a directory. This is what allows the caller
+	 * to rebuild the tree in a single pass. */
+	if (snapshot->node_records [0].parent != BRASERO_DATA_SNAPSHOT_NONE)
+		return FALSE;
+
+	for (i = 1; i < header->num_nodes; i ++) {
+		const BraseroDataSnapshotNode *record;
+
+		record = snapshot->node_records + i;
+		if (record->parent >= i
+		|| (snapshot->node_records [record->parent].flags & BRASERO_DATA_SNAPSHOT_NODE_FILE))
+			return FALSE;
+
+		if (!brasero_data_snapshot_check_string (snapshot, record->name, FALSE)
+		|| !snapshot->string_table [record->name])
+			return FALSE;
+
+		if (!brasero_data_snapshot_check_string (snapshot, record->mime, TRUE)
+		||  !brasero_data_snapshot_check_string (snapshot, record->uri, TRUE))
+			return FALSE;
+	}
+
+	for (i = 0; i < header->num_excluded; i ++) {
+		if (!brasero_data_snapshot_check_string (snapshot, snapshot->excluded_records [i], FALSE))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+BraseroDataSnapshot *
+brasero_data_snapshot_open (const gchar *path,
+			    GError **error)
+{
+	BraseroDataSnapshot *snapshot;
+	GMappedFile *file;
+
+	file = g_mapped_file_new (path, FALSE, error);
+	if (!file)
+		return NULL;
+
+	snapshot = g_new0 (BraseroDataSnapshot, 1);
+	snapshot->file = file;
+
+	if (!brasero_data_snapshot_check (snapshot)) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_FILE_INVALID,
+			     _("\"%s\" is not a valid project snapshot"),
+			     path);
+		brasero_data_snapshot_free (snapshot);
+		return NULL;
+	}
+
+	return snapshot;
+}
+
+guint
+brasero_data_snapshot_get_n_nodes (BraseroDataSnapshot *snapshot)
+{
+	g_return_val_if_fail (snapshot->header != NULL, 0);
+	return snapshot->header->num_nodes;
+}
+
+const BraseroDataSnapshotNode *
+brasero_data_snapshot_get_node (BraseroDataSnapshot *snapshot,
+				guint index)
+{
+	g_return_val_if_fail (snapshot->header != NULL, NULL);
+	g_return_val_if_fail (index < snapshot->header->num_nodes, NULL);
+
+	return snapshot->node_records + index;
+}
+
+guint
+brasero_data_snapshot_get_n_excluded (BraseroDataSnapshot *snapshot)
+{
+	g_return_val_if_fail (snapshot->header != NULL, 0);
+	return snapshot->header->num_excluded;
+}
+
+const gchar *
+brasero_data_snapshot_get_excluded (BraseroDataSnapshot *snapshot,
+				    guint index)
+{
+	g_return_val_if_fail (snapshot->header != NULL, NULL);
+	g_return_val_if_fail (index < snapshot->header->num_excluded, NULL);
+
+	return snapshot->string_table + snapshot->excluded_records [index];
+}
+
+const gchar *
+brasero_data_snapshot_get_string (BraseroDataSnapshot *snapshot,
+				  guint32 offset)
+{
+	g_return_val_if_fail (snapshot->header != NULL, NULL);
+
+	if (offset == BRASERO_DATA_SNAPSHOT_NONE)
+		return NULL;
+
+	return snapshot->string_table + offset;
+}
+
+void
+brasero_data_snapshot_free (BraseroDataSnapshot *snapshot)
+{
+	if (snapshot->strings)
+		g_hash_table_destroy (snapshot->strings);
+
+	if (snapshot->table)
+		g_string_free (snapshot->table, TRUE);
+
+	if (snapshot->nodes)
+		g_array_free (snapshot->nodes, TRUE);
+
+	if (snapshot->excluded)
+		g_array_free (snapshot->excluded, TRUE);
+
+	if (snapshot->file)
+		g_mapped_file_unref (snapshot->file);
+
+	g_free (snapshot);
+}
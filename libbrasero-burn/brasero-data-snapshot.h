@@ -0,0 +1,127 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BRASERO_DATA_SNAPSHOT_H_
+#define _BRASERO_DATA_SNAPSHOT_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * A snapshot is a flat image of a data project tree that can be mapped in
+ * memory and turned back into nodes without exploring the file system again.
+ * It is made of:
+ * - a header
+ * - the node records in pre-order (the first one is the root)
+ * - the offsets of the excluded URIs in the string table
+ * - a table of all (interned) strings
+ * All integers are stored in host byte order; a snapshot written on another
+ * architecture is simply rejected.
+ */
+
+#define BRASERO_DATA_SNAPSHOT_NONE		G_MAXUINT32
+
+typedef enum {
+	BRASERO_DATA_SNAPSHOT_NODE_NONE		= 0,
+	BRASERO_DATA_SNAPSHOT_NODE_FILE		= 1,
+	BRASERO_DATA_SNAPSHOT_NODE_FAKE		= 1 << 1,
+	BRASERO_DATA_SNAPSHOT_NODE_SYMLINK	= 1 << 2,
+	BRASERO_DATA_SNAPSHOT_NODE_GRAFTED	= 1 << 3,
+	BRASERO_DATA_SNAPSHOT_NODE_HIDDEN	= 1 << 4,
+	BRASERO_DATA_SNAPSHOT_NODE_2GiB		= 1 << 5
+} BraseroDataSnapshotNodeFlags;
+
+typedef struct _BraseroDataSnapshotNode BraseroDataSnapshotNode;
+struct _BraseroDataSnapshotNode {
+	/* index of the parent record (always lower than the node's own) */
+	guint32 parent;
+
+	/* offsets in the string table or BRASERO_DATA_SNAPSHOT_NONE */
+	guint32 name;
+	guint32 mime;
+	guint32 uri;
+
+	/* only meaningful for files; directory sizes are computed again */
+	guint32 sectors;
+	guint32 flags;
+};
+
+typedef struct _BraseroDataSnapshot BraseroDataSnapshot;
+
+BraseroDataSnapshot *
+brasero_data_snapshot_new (void);
+
+guint
+brasero_data_snapshot_add_node (BraseroDataSnapshot *snapshot,
+				guint parent,
+				const gchar *name,
+				const gchar *mime,
+				const gchar *uri,
+				guint sectors,
+				BraseroDataSnapshotNodeFlags flags);
+
+void
+brasero_data_snapshot_add_excluded (BraseroDataSnapshot *snapshot,
+				    const gchar *uri);
+
+gboolean
+brasero_data_snapshot_write (BraseroDataSnapshot *snapshot,
+			     const gchar *path,
+			     GError **error);
+
+BraseroDataSnapshot *
+brasero_data_snapshot_open (const gchar *path,
+			    GError **error);
+
+guint
+brasero_data_snapshot_get_n_nodes (BraseroDataSnapshot *snapshot);
+
+const BraseroDataSnapshotNode *
+brasero_data_snapshot_get_node (BraseroDataSnapshot *snapshot,
+				guint index);
+
+guint
+brasero_data_snapshot_get_n_excluded (BraseroDataSnapshot *snapshot);
+
+const gchar *
+brasero_data_snapshot_get_excluded (BraseroDataSnapshot *snapshot,
+				    guint index);
+
+const gchar *
+brasero_data_snapshot_get_string (BraseroDataSnapshot *snapshot,
+				  guint32 offset);
+
+void
+brasero_data_snapshot_free (BraseroDataSnapshot *snapshot);
+
+G_END_DECLS
+
+#endif /* _BRASERO_DATA_SNAPSHOT_H_ */
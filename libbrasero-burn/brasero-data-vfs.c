@@ -59,6 +59,9 @@ struct _BraseroDataVFSPrivate
 	GHashTable *loading;
 	GHashTable *directories;
 
+	/* directories restored from a snapshot being explored again */
+	GHashTable *restored;
+
 	BraseroFilteredUri *filtered;
 
 	BraseroIOJobBase *load_uri;
@@ -115,6 +118,15 @@ brasero_data_vfs_is_loading_uri (BraseroDataVFS *self)
 	return (g_hash_table_size (priv->loading) != 0);
 }
 
+gboolean
+brasero_data_vfs_is_exploring (BraseroDataVFS *self)
+{
+	BraseroDataVFSPrivate *priv;
+
+	priv = BRASERO_DATA_VFS_PRIVATE (self);
+	return (g_hash_table_size (priv->directories) != 0);
+}
+
 static BraseroBurnResult
 brasero_data_vfs_emit_image_signal (BraseroDataVFS *self,
 				    const gchar *uri)
@@ -278,6 +290,7 @@ brasero_data_vfs_directory_load_end (GObject *object,
 	}
 
 	brasero_data_vfs_remove_from_hash (self, priv->directories, uri);
+	g_hash_table_remove (priv->restored, uri);
 	brasero_utils_unregister_string (uri);
 
 	if (cancelled)
@@ -382,29 +395,62 @@ brasero_data_vfs_directory_check_symlink_loop (BraseroDataVFS *self,
 	return FALSE;
 }
 
+static gboolean
+brasero_data_vfs_directory_check_restored (BraseroDataVFS *self,
+					   const gchar *parent_uri,
+					   const gchar *uri,
+					   const gchar *name)
+{
+	BraseroDataVFSPrivate *priv;
+	GSList *nodes;
+	GSList *iter;
+
+	priv = BRASERO_DATA_VFS_PRIVATE (self);
+
+	/* Excluded files must stay excluded and files moved or renamed in the
+	 * project are grafted elsewhere */
+	if (brasero_data_project_uri_has_graft (BRASERO_DATA_PROJECT (self), uri))
+		return TRUE;
+
+	/* See if there is a parent which doesn't have this file yet */
+	nodes = g_hash_table_lookup (priv->directories, parent_uri);
+	for (iter = nodes; iter; iter = iter->next) {
+		BraseroFileNode *parent;
+		guint reference;
+
+		reference = GPOINTER_TO_INT (iter->data);
+		parent = brasero_data_project_reference_get (BRASERO_DATA_PROJECT (self), reference);
+		if (parent && !brasero_file_node_check_name_existence (parent, name))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
 static void
-brasero_data_vfs_directory_load_result (GObject *owner,
-					GError *error,
-					const gchar *uri,
-					GFileInfo *info,
-					gpointer data)
+brasero_data_vfs_directory_load_entry (BraseroDataVFS *self,
+				       const gchar *parent_uri,
+				       const gchar *uri,
+				       GFileInfo *info)
 {
-	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
 	BraseroDataVFSPrivate *priv;
-	gchar *parent_uri = data;
 	const gchar *name;
+	gboolean restored;
 	GSList *nodes;
 	GSList *iter;
 
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
-	/* check the status of the operation.
-	 * NOTE: no need to remove the nodes. */
-	if (!brasero_data_vfs_check_uri_result (self, uri, error, info))
+	name = g_file_info_get_name (info);
+
+	/* A directory restored from a snapshot already has the children it had
+	 * then; they are revalidated on their own. Only add the new ones. */
+	restored = (g_hash_table_lookup (priv->restored, parent_uri) != NULL);
+	if (restored
+	&&  brasero_data_vfs_directory_check_restored (self, parent_uri, uri, name))
 		return;
 
 	/* Filtering part */
-	name = g_file_info_get_name (info);
 
 	/* See if it's a broken symlink */
 	if (g_file_info_get_is_symlink (info)
@@ -443,6 +489,9 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 		if (!parent)
 			continue;
 
+		if (restored && brasero_file_node_check_name_existence (parent, name))
+			continue;
+
 		if (parent->is_root) {
 			/* This may be true in some rare situations (when the root of a
 			 * volume has been added like burn:/// */
@@ -480,6 +529,47 @@ brasero_data_vfs_directory_load_result (GObject *owner,
 	}
 }
 
+static void
+brasero_data_vfs_directory_load_result (GObject *owner,
+					GError *error,
+					const gchar *uri,
+					GFileInfo *info,
+					gpointer data)
+{
+	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
+
+	/* check the status of the operation.
+	 * NOTE: no need to remove the nodes. */
+	if (!brasero_data_vfs_check_uri_result (self, uri, error, info))
+		return;
+
+	brasero_data_vfs_directory_load_entry (self, data, uri, info);
+}
+
+static void
+brasero_data_vfs_directory_load_batch (GObject *owner,
+				       BraseroIOEntry *entries,
+				       guint num,
+				       gpointer data)
+{
+	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
+	guint i;
+
+	/* Add all the children at once so that the project only signals its
+	 * size changed once for all of them */
+	brasero_data_project_batch_begin (BRASERO_DATA_PROJECT (self));
+	for (i = 0; i < num; i ++) {
+		if (!brasero_data_vfs_check_uri_result (self, entries [i].uri, NULL, entries [i].info))
+			continue;
+
+		brasero_data_vfs_directory_load_entry (self,
+						       data,
+						       entries [i].uri,
+						       entries [i].info);
+	}
+	brasero_data_project_batch_end (BRASERO_DATA_PROJECT (self));
+}
+
 static gboolean
 brasero_data_vfs_load_directory (BraseroDataVFS *self,
 				 BraseroFileNode *node,
@@ -508,16 +598,21 @@ brasero_data_vfs_load_directory (BraseroDataVFS *self,
 			     registered,
 			     g_slist_prepend (NULL, GINT_TO_POINTER (reference)));
 
-	if (!priv->load_contents)
+	if (!priv->load_contents) {
 		priv->load_contents = brasero_io_register (G_OBJECT (self),
 							   brasero_data_vfs_directory_load_result,
 							   brasero_data_vfs_directory_load_end,
 							   NULL);
+		brasero_io_job_base_set_batch (priv->load_contents,
+					       brasero_data_vfs_directory_load_batch);
+	}
 
-	/* no need to require mime types here as these rows won't be visible */
+	/* no need to sniff mime types here as most of these rows won't be
+	 * visible; a guess from the name costs nothing though */
 	brasero_io_load_directory (uri,
 				   priv->load_contents,
 				   BRASERO_IO_INFO_PERM|
+				   BRASERO_IO_INFO_MIME_FAST|
 				  (priv->replace_sym ? BRASERO_IO_INFO_FOLLOW_SYMLINK:BRASERO_IO_INFO_NONE),
 				   registered);
 
@@ -533,6 +628,29 @@ brasero_data_vfs_load_directory (BraseroDataVFS *self,
 	return TRUE;
 }
 
+static gboolean
+brasero_data_vfs_load_restored_directory (BraseroDataVFS *self,
+					  BraseroFileNode *node,
+					  const gchar *uri)
+{
+	BraseroDataVFSPrivate *priv;
+	gchar *registered;
+
+	priv = BRASERO_DATA_VFS_PRIVATE (self);
+
+	if (!brasero_data_vfs_load_directory (self, node, uri))
+		return FALSE;
+
+	/* NOTE: the key is the string registered by the exploration and is
+	 * removed when it ends */
+	registered = brasero_utils_register_string (uri);
+	if (!g_hash_table_lookup (priv->restored, registered))
+		g_hash_table_insert (priv->restored, registered, GINT_TO_POINTER (1));
+	brasero_utils_unregister_string (registered);
+
+	return TRUE;
+}
+
 /**
  * Update a node already in the tree
  */
@@ -572,6 +690,7 @@ brasero_data_vfs_loading_node_result (GObject *owner,
 	GSList *nodes;
 	BraseroFileNode *root;
 	BraseroFileTreeStats *stats;
+	const gchar *mime;
 	gchar *registered = callback_data;
 	BraseroDataVFS *self = BRASERO_DATA_VFS (owner);
 	BraseroDataVFSPrivate *priv = BRASERO_DATA_VFS_PRIVATE (self);
@@ -603,12 +722,19 @@ brasero_data_vfs_loading_node_result (GObject *owner,
 	root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (self));
 	stats = BRASERO_FILE_NODE_STATS (root);
 
+	/* Most of the time only the fast content type was requested */
+	if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE))
+		mime = g_file_info_get_content_type (info);
+	else
+		mime = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+
 	if (stats && !stats->children
 	&&  brasero_file_node_get_n_children (root) <= 1
-	&& (!strcmp (g_file_info_get_content_type (info), "application/x-toc")
-	||  !strcmp (g_file_info_get_content_type (info), "application/x-cdrdao-toc")
-	||  !strcmp (g_file_info_get_content_type (info), "application/x-cue")
-	||  !strcmp (g_file_info_get_content_type (info), "application/x-cd-image"))) {
+	&&  mime
+	&& (!strcmp (mime, "application/x-toc")
+	||  !strcmp (mime, "application/x-cdrdao-toc")
+	||  !strcmp (mime, "application/x-cue")
+	||  !strcmp (mime, "application/x-cd-image"))) {
 		BraseroBurnResult result;
 
 		result = brasero_data_vfs_emit_image_signal (self, uri);
@@ -669,10 +795,20 @@ brasero_data_vfs_loading_node_result (GObject *owner,
 		}
 
 		if (!node->is_loading) {
+			gboolean restored;
+
+			restored = node->is_restored;
 			brasero_data_project_node_reloaded (BRASERO_DATA_PROJECT (self),
 							    node,
 							    uri,
 							    info);
+
+			/* Files may have been added to a directory since the
+			 * snapshot was taken: now that it is known to still
+			 * be there, explore it again. */
+			if (restored && !node->is_file)
+				brasero_data_vfs_load_restored_directory (self, node, uri);
+
 			continue;
 		}
 
@@ -750,6 +886,7 @@ brasero_data_vfs_loading_node (BraseroDataVFS *self,
 	priv = BRASERO_DATA_VFS_PRIVATE (self);
 
 	if (!node->is_reloading
+	&&  !node->is_restored
 	&&   BRASERO_FILE_NODE_NAME (node)
 	&&  !strcmp (BRASERO_FILE_NODE_NAME (node), G_DIR_SEPARATOR_S)) {
 		/* This is a root directory: we don't add it since a
@@ -775,10 +912,22 @@ brasero_data_vfs_loading_node (BraseroDataVFS *self,
 		return TRUE;
 	}
 
-	/* loading nodes are almost always visible already so get mime type */
+	/* Nodes restored from a snapshot already have all their information;
+	 * only check that they are still there, readable and of the same size.
+	 * Their mime type is only needed if it was not known. */
+	if (node->is_restored && !node->is_loading)
+		return brasero_data_vfs_load_node (self,
+						   BRASERO_IO_INFO_PERM|
+						   (BRASERO_FILE_NODE_MIME (node)? BRASERO_IO_INFO_NONE:BRASERO_IO_INFO_MIME_FAST),
+						   reference,
+						   uri);
+
+	/* Only guess the mime type from the name here: sniffing contents means
+	 * reading every file. That's done once the node is actually shown
+	 * through brasero_data_vfs_load_mime (). */
 	return brasero_data_vfs_load_node (self,
 					   BRASERO_IO_INFO_PERM|
-					   BRASERO_IO_INFO_MIME|
+					   BRASERO_IO_INFO_MIME_FAST|
 					   BRASERO_IO_INFO_CHECK_PARENT_SYMLINK,
 					   reference,
 					   uri);
@@ -925,8 +1074,9 @@ brasero_data_vfs_node_added (BraseroDataProject *project,
 	if (!uri)
 		goto chain;
 
-	/* Is it loading or reloading? if not, only explore directories. */
-	if (node->is_loading || node->is_reloading) {
+	/* Is it loading or reloading? if not, only explore directories.
+	 * Restored directories are only explored again once revalidated. */
+	if (node->is_loading || node->is_reloading || node->is_restored) {
 		if (brasero_data_vfs_loading_node (self, node, uri))
 			goto chain;
 
@@ -992,6 +1142,7 @@ brasero_data_vfs_clear (BraseroDataVFS *self)
 	g_hash_table_foreach_remove (priv->loading,
 				     brasero_data_vfs_empty_loading_cb,
 				     self);
+	g_hash_table_remove_all (priv->restored);
 	g_hash_table_foreach_remove (priv->directories,
 				     brasero_data_vfs_empty_loading_cb,
 				     self);
@@ -1063,6 +1214,7 @@ brasero_data_vfs_init (BraseroDataVFS *object)
 	/* create the hash tables */
 	priv->loading = g_hash_table_new (g_str_hash, g_str_equal);
 	priv->directories = g_hash_table_new (g_str_hash, g_str_equal);
+	priv->restored = g_hash_table_new (g_str_hash, g_str_equal);
 }
 
 static void
@@ -1084,6 +1236,11 @@ brasero_data_vfs_finalize (GObject *object)
 		priv->directories = NULL;
 	}
 
+	if (priv->restored) {
+		g_hash_table_destroy (priv->restored);
+		priv->restored = NULL;
+	}
+
 	if (priv->filtered) {
 		g_object_unref (priv->filtered);
 		priv->filtered = NULL;
@@ -75,6 +75,9 @@ brasero_data_vfs_is_active (BraseroDataVFS *vfs);
 gboolean
 brasero_data_vfs_is_loading_uri (BraseroDataVFS *vfs);
 
+gboolean
+brasero_data_vfs_is_exploring (BraseroDataVFS *vfs);
+
 gboolean
 brasero_data_vfs_load_mime (BraseroDataVFS *vfs,
 			    BraseroFileNode *node);
@@ -858,6 +858,18 @@ brasero_file_node_set_from_info (BraseroFileNode *node,
 
 			mime = g_file_info_get_content_type (info);
 			node->union2.mime = brasero_utils_register_string (mime);
+			node->is_mime_guessed = FALSE;
+		}
+		else if (g_file_info_has_attribute (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE)
+		     && (!BRASERO_FILE_NODE_MIME (node) || node->is_mime_guessed)) {
+			const gchar *mime;
+
+			if (BRASERO_FILE_NODE_MIME (node))
+				brasero_utils_unregister_string (BRASERO_FILE_NODE_MIME (node));
+
+			mime = g_file_info_get_attribute_string (info, G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
+			node->union2.mime = brasero_utils_register_string (mime);
+			node->is_mime_guessed = TRUE;
 		}
 
 		sectors = BRASERO_BYTES_TO_SECTORS (g_file_info_get_size (info), 2048);
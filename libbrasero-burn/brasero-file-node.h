@@ -139,6 +139,13 @@ struct _BraseroFileNode {
 	guint is_reloading:1;
 	guint is_exploring:1;
 
+	/* restored from a snapshot and not revalidated yet */
+	guint is_restored:1;
+
+	/* mime type only guessed from the name; contents are sniffed when
+	 * the node is shown */
+	guint is_mime_guessed:1;
+
 	/* that's for some special nodes (usually counted in statistics) */
 	guint is_2GiB:1;
 	guint is_deep:1;
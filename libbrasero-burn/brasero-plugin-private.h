@@ -46,6 +46,9 @@ brasero_plugin_new (const gchar *path);
 void
 brasero_plugin_set_group (BraseroPlugin *plugin, gint group_id);
 
+gboolean
+brasero_plugin_get_on_request (BraseroPlugin *plugin);
+
 gboolean
 brasero_plugin_get_image_flags (BraseroPlugin *plugin,
 			        BraseroMedia media,
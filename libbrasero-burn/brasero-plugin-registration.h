@@ -76,6 +76,10 @@ void
 brasero_plugin_set_compulsory (BraseroPlugin *self,
 			       gboolean compulsory);
 
+void
+brasero_plugin_set_on_request (BraseroPlugin *self,
+			       gboolean on_request);
+
 void
 brasero_plugin_register_group (BraseroPlugin *plugin,
 			       const gchar *name);
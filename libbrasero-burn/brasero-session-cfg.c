@@ -55,6 +55,7 @@
 #include "brasero-session-cfg.h"
 #include "brasero-burn-lib.h"
 #include "brasero-session-helper.h"
+#include "brasero-speed-profile.h"
 
 
 /**
@@ -701,6 +702,34 @@ brasero_session_cfg_check_drive_settings (BraseroSessionCfg *self)
 	brasero_session_cfg_add_drive_properties_flags (self, flags);
 }
 
+static void
+brasero_session_cfg_check_rate (BraseroSessionCfg *self)
+{
+	BraseroMedium *medium;
+	BraseroDrive *burner;
+	guint64 *rates;
+	guint64 rate;
+
+	burner = brasero_burn_session_get_burner (BRASERO_BURN_SESSION (self));
+	if (!burner || brasero_drive_is_fake (burner))
+		return;
+
+	medium = brasero_drive_get_medium (burner);
+	if (!medium)
+		return;
+
+	/* Pick the fastest speed this drive proved to sustain with this kind
+	 * of medium. It is only used when the user did not set any speed. */
+	rates = brasero_medium_get_write_speeds (medium);
+	rate = brasero_speed_profile_get_rate (brasero_medium_get_speed_profile (medium), rates);
+	g_free (rates);
+
+	if (rate)
+		BRASERO_BURN_LOG ("Speed profile rate %" G_GUINT64_FORMAT, rate);
+
+	brasero_burn_session_set_automatic_rate (BRASERO_BURN_SESSION (self), rate);
+}
+
 static BraseroSessionError
 brasero_session_cfg_check_volume_size (BraseroSessionCfg *self)
 {
@@ -1391,9 +1420,11 @@ brasero_session_cfg_output_changed (BraseroBurnSession *session,
 
 	/* In this case need to :
 	 * - check if all flags are supported
-	 * - for images, set a path if it wasn't already set */
+	 * - for images, set a path if it wasn't already set
+	 * - choose a speed from the profile of the new medium */
 	brasero_session_cfg_update (BRASERO_SESSION_CFG (session));
 	brasero_session_cfg_check_drive_settings (BRASERO_SESSION_CFG (session));
+	brasero_session_cfg_check_rate (BRASERO_SESSION_CFG (session));
 }
 
 static void
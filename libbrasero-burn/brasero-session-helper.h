@@ -69,6 +69,10 @@ brasero_burn_session_is_dest_file (BraseroBurnSession *session);
 gboolean
 brasero_burn_session_same_src_dest_drive (BraseroBurnSession *session);
 
+void
+brasero_burn_session_set_automatic_rate (BraseroBurnSession *session,
+					 guint64 rate);
+
 #define BRASERO_BURN_SESSION_EJECT(session)					\
 (brasero_burn_session_get_flags ((session)) & BRASERO_BURN_FLAG_EJECT)
 
@@ -87,10 +91,15 @@ brasero_burn_session_same_src_dest_drive (BraseroBurnSession *session);
 BraseroBurnResult
 brasero_burn_session_get_tmp_image (BraseroBurnSession *session,
 				    BraseroImageFormat format,
+				    goffset size,
 				    gchar **image,
 				    gchar **toc,
 				    GError **error);
 
+gboolean
+brasero_burn_session_is_tmp_image_in_memory (BraseroBurnSession *session,
+					     const gchar *path);
+
 BraseroBurnResult
 brasero_burn_session_get_tmp_file (BraseroBurnSession *session,
 				   const gchar *suffix,
@@ -37,6 +37,11 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
 
 #include <glib.h>
 #include <glib-object.h>
@@ -95,6 +100,13 @@ struct _BraseroSessionSetting {
 };
 typedef struct _BraseroSessionSetting BraseroSessionSetting;
 
+struct _BraseroTmpImageMem {
+	gchar *path;
+	goffset reserved;
+	int fd;
+};
+typedef struct _BraseroTmpImageMem BraseroTmpImageMem;
+
 struct _BraseroBurnSessionPrivate {
 	int session;
 	gchar *session_path;
@@ -102,6 +114,10 @@ struct _BraseroBurnSessionPrivate {
 	gchar *tmpdir;
 	GSList *tmpfiles;
 
+	GSList *tmpmem;
+	goffset tmpmem_staged;
+	guint tmpmem_spills;
+
 	BraseroSessionSetting settings [1];
 	GSList *pile_settings;
 
@@ -113,6 +129,14 @@ struct _BraseroBurnSessionPrivate {
 	GSList *tracks;
 	GSList *pile_tracks;
 
+	/* Last known size of each monitored track and their sum */
+	GHashTable *track_sizes;
+	goffset blocks;
+	goffset bytes;
+
+	/* Rate chosen from the speed profile of the medium when none was set */
+	guint64 automatic_rate;
+
 	guint strict_checks:1;
 };
 typedef struct _BraseroBurnSessionPrivate BraseroBurnSessionPrivate;
@@ -182,10 +206,74 @@ brasero_session_settings_free (BraseroSessionSetting *settings)
 	g_free (settings);
 }
 
+struct _BraseroSessionTrackSize {
+	goffset blocks;
+	goffset bytes;
+};
+typedef struct _BraseroSessionTrackSize BraseroSessionTrackSize;
+
+/**
+ * Only the size of a track that changed is queried again; the difference
+ * with its former size is applied to the session totals.
+ */
+
+static void
+brasero_burn_session_update_track_size (BraseroBurnSession *self,
+					BraseroTrack *track)
+{
+	BraseroSessionTrackSize *size;
+	BraseroBurnSessionPrivate *priv;
+	BraseroBurnResult res;
+	goffset blocks = 0;
+	goffset bytes = 0;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+
+	size = g_hash_table_lookup (priv->track_sizes, track);
+	if (!size) {
+		size = g_new0 (BraseroSessionTrackSize, 1);
+		g_hash_table_insert (priv->track_sizes, track, size);
+	}
+
+	/* That way we get the size even if the track has not completed
+	 * what's it's doing which allows to show progress */
+	res = brasero_track_get_size (track, &blocks, &bytes);
+	if (res != BRASERO_BURN_OK && res != BRASERO_BURN_NOT_READY) {
+		blocks = 0;
+		bytes = 0;
+	}
+
+	priv->blocks += blocks - size->blocks;
+	priv->bytes += bytes - size->bytes;
+	size->blocks = blocks;
+	size->bytes = bytes;
+}
+
+static void
+brasero_burn_session_forget_track_size (BraseroBurnSession *self,
+					BraseroTrack *track)
+{
+	BraseroSessionTrackSize *size;
+	BraseroBurnSessionPrivate *priv;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+
+	size = g_hash_table_lookup (priv->track_sizes, track);
+	if (!size)
+		return;
+
+	priv->blocks -= size->blocks;
+	priv->bytes -= size->bytes;
+	g_hash_table_remove (priv->track_sizes, track);
+}
+
 static void
 brasero_burn_session_track_changed (BraseroTrack *track,
 				    BraseroBurnSession *self)
 {
+	/* Update before anyone asks for the new size */
+	brasero_burn_session_update_track_size (self, track);
+
 	g_signal_emit (self,
 		       brasero_burn_session_signals [TRACK_CHANGED_SIGNAL],
 		       0,
@@ -200,6 +288,17 @@ brasero_burn_session_start_track_monitoring (BraseroBurnSession *self,
 			  "changed",
 			  G_CALLBACK (brasero_burn_session_track_changed),
 			  self);
+	brasero_burn_session_update_track_size (self, track);
+}
+
+static void
+brasero_burn_session_stop_track_monitoring (BraseroBurnSession *self,
+					    BraseroTrack *track)
+{
+	g_signal_handlers_disconnect_by_func (track,
+					      brasero_burn_session_track_changed,
+					      self);
+	brasero_burn_session_forget_track_size (self, track);
 }
 
 static void
@@ -214,9 +313,7 @@ brasero_burn_session_stop_tracks_monitoring (BraseroBurnSession *self)
 		BraseroTrack *track;
 
 		track = iter->data;
-		g_signal_handlers_disconnect_by_func (track,
-						      brasero_burn_session_track_changed,
-						      self);
+		brasero_burn_session_stop_track_monitoring (self, track);
 	}
 }
 
@@ -457,9 +554,7 @@ brasero_burn_session_remove_track (BraseroBurnSession *session,
 	/* Find the track, remove it */
 	former_position = g_slist_index (priv->tracks, track);
 	priv->tracks = g_slist_remove (priv->tracks, track);
-	g_signal_handlers_disconnect_by_func (track,
-					      brasero_burn_session_track_changed,
-					      session);
+	brasero_burn_session_stop_track_monitoring (session, track);
 
 	g_signal_emit (session,
 		       brasero_burn_session_signals [TRACK_REMOVED_SIGNAL],
@@ -589,8 +684,8 @@ brasero_burn_session_get_size (BraseroBurnSession *session,
 			       goffset *bytes)
 {
 	BraseroBurnSessionPrivate *priv;
-	gsize session_blocks = 0;
-	gsize session_bytes = 0;
+	goffset session_blocks = 0;
+	goffset session_bytes = 0;
 	GSList *iter;
 
 	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (session), BRASERO_TRACK_TYPE_NONE);
@@ -599,25 +694,38 @@ brasero_burn_session_get_size (BraseroBurnSession *session,
 	if (!priv->tracks)
 		return BRASERO_BURN_ERR;
 
-	for (iter = priv->tracks; iter; iter = iter->next) {
-		BraseroBurnResult res;
-		BraseroTrack *track;
-		goffset track_blocks;
-		goffset track_bytes;
+	session_blocks = priv->blocks;
+	session_bytes = priv->bytes;
 
-		track = iter->data;
-		track_blocks = 0;
-		track_bytes = 0;
+	/* When debugging, make sure the running totals didn't drift from the
+	 * sum of the sizes of all tracks (a track whose size changed without
+	 * signalling it for example) */
+	if (brasero_burn_debug_get ()) {
+		goffset sum_blocks = 0;
+		goffset sum_bytes = 0;
 
-		res = brasero_track_get_size (track, &track_blocks, &track_bytes);
+		for (iter = priv->tracks; iter; iter = iter->next) {
+			BraseroBurnResult res;
+			goffset track_blocks = 0;
+			goffset track_bytes = 0;
 
-		/* That way we get the size even if the track has not completed
-		 * what's it's doing which allows to show progress */
-		if (res != BRASERO_BURN_OK && res != BRASERO_BURN_NOT_READY)
-			continue;
+			res = brasero_track_get_size (iter->data, &track_blocks, &track_bytes);
+			if (res != BRASERO_BURN_OK && res != BRASERO_BURN_NOT_READY)
+				continue;
+
+			sum_blocks += track_blocks;
+			sum_bytes += track_bytes;
+		}
 
-		session_blocks += track_blocks;
-		session_bytes += track_bytes;
+		if (sum_blocks != session_blocks || sum_bytes != session_bytes) {
+			g_warning ("Session size out of sync (%" G_GOFFSET_FORMAT " / %" G_GOFFSET_FORMAT " blocks, %" G_GOFFSET_FORMAT " / %" G_GOFFSET_FORMAT " bytes)",
+				   session_blocks,
+				   sum_blocks,
+				   session_bytes,
+				   sum_bytes);
+			session_blocks = sum_blocks;
+			session_bytes = sum_bytes;
+		}
 	}
 
 	if (blocks)
@@ -675,6 +783,11 @@ brasero_burn_session_dest_media_added (BraseroDrive *drive,
 				       BraseroMedium *medium,
 				       BraseroBurnSession *self)
 {
+	BraseroBurnSessionPrivate *priv;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+	priv->automatic_rate = 0;
+
 	/* No medium before */
 	g_signal_emit (self,
 		       brasero_burn_session_signals [OUTPUT_CHANGED_SIGNAL],
@@ -687,6 +800,11 @@ brasero_burn_session_dest_media_removed (BraseroDrive *drive,
 					 BraseroMedium *medium,
 					 BraseroBurnSession *self)
 {
+	BraseroBurnSessionPrivate *priv;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+	priv->automatic_rate = 0;
+
 	g_signal_emit (self,
 		       brasero_burn_session_signals [OUTPUT_CHANGED_SIGNAL],
 		       0,
@@ -750,6 +868,7 @@ brasero_burn_session_set_burner (BraseroBurnSession *self,
 	}
 
 	priv->settings->burner = drive;
+	priv->automatic_rate = 0;
 
 	g_signal_emit (self,
 		       brasero_burn_session_signals [OUTPUT_CHANGED_SIGNAL],
@@ -841,10 +960,40 @@ brasero_burn_session_get_rate (BraseroBurnSession *self)
 		return 0;
 
 	max_rate = brasero_medium_get_max_write_speed (medium);
-	if (priv->settings->rate <= 0)
-		return max_rate;
-	else
+	if (priv->settings->rate > 0)
 		return MIN (max_rate, priv->settings->rate);
+
+	if (priv->automatic_rate > 0)
+		return MIN (max_rate, priv->automatic_rate);
+
+	return max_rate;
+}
+
+/**
+ * brasero_burn_session_set_automatic_rate:
+ * @session: a #BraseroBurnSession
+ * @rate: a #guint64 or 0
+ *
+ * Sets the speed used when none was set with brasero_burn_session_set_rate ().
+ * It is forgotten whenever the burner or its medium change.
+ * (used internally)
+ **/
+
+void
+brasero_burn_session_set_automatic_rate (BraseroBurnSession *self,
+					 guint64 rate)
+{
+	BraseroBurnSessionPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_BURN_SESSION (self));
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+	if (priv->automatic_rate == rate)
+		return;
+
+	priv->automatic_rate = rate;
+	if (priv->settings->rate <= 0)
+		g_object_notify (G_OBJECT (self), "speed");
 }
 
 /**
@@ -1404,13 +1553,147 @@ brasero_burn_session_get_image_complement (BraseroBurnSession *self,
 	return retval;
 }
 
+/**
+ * Try to stage a temporary image of @size bytes in an anonymous memory file
+ * (memfd). The returned path is the /proc entry for the descriptor so that
+ * any process (and not only ourselves) can open it like a regular file.
+ * Returns BRASERO_BURN_NOT_SUPPORTED when the image should go to disk.
+ */
+
+static BraseroBurnResult
+brasero_burn_session_get_tmp_image_mem (BraseroBurnSession *self,
+					goffset size,
+					gchar **path)
+{
+#ifdef HAVE_MEMFD_CREATE
+	BraseroBurnSessionPrivate *priv;
+	BraseroTmpImageMem *mem;
+	goffset budget;
+	int fd;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+
+	budget = brasero_burn_session_tag_lookup_int (self, BRASERO_SESSION_TMP_IMAGE_RAM_BUDGET);
+	if (budget <= 0)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	budget *= 1048576;
+
+	/* We can't move an image to disk once a process started to write it
+	 * so the decision must be taken now. Without a size, play it safe. */
+	if (size <= 0 || priv->tmpmem_staged + size > budget) {
+		priv->tmpmem_spills ++;
+		BRASERO_BURN_LOG ("Temporary image (%lli bytes) spilled to disk (%lli bytes already staged in memory, budget is %lli)",
+				  size,
+				  priv->tmpmem_staged,
+				  budget);
+		return BRASERO_BURN_NOT_SUPPORTED;
+	}
+
+	/* NOTE: MFD_CLOEXEC doesn't prevent children from opening the file
+	 * through /proc; it only avoids leaking the descriptor to them. */
+	fd = memfd_create ("brasero-image", MFD_CLOEXEC);
+	if (fd < 0) {
+		int errsv = errno;
+
+		priv->tmpmem_spills ++;
+		BRASERO_BURN_LOG ("Temporary image spilled to disk (memfd_create failed: %s)",
+				  g_strerror (errsv));
+		return BRASERO_BURN_NOT_SUPPORTED;
+	}
+
+	mem = g_new0 (BraseroTmpImageMem, 1);
+	mem->fd = fd;
+	mem->reserved = size;
+
+	/* Use the pid and not "self" since the path is passed to children */
+	mem->path = g_strdup_printf ("/proc/%i/fd/%i", getpid (), fd);
+
+	priv->tmpmem = g_slist_prepend (priv->tmpmem, mem);
+	priv->tmpmem_staged += size;
+
+	BRASERO_BURN_LOG ("Temporary image (%lli bytes) staged in memory at %s (%lli / %lli bytes used)",
+			  size,
+			  mem->path,
+			  priv->tmpmem_staged,
+			  budget);
+
+	*path = g_strdup (mem->path);
+	return BRASERO_BURN_OK;
+#else
+	return BRASERO_BURN_NOT_SUPPORTED;
+#endif
+}
+
+static void
+brasero_burn_session_clean_tmp_image_mem (BraseroBurnSessionPrivate *priv)
+{
+	GSList *iter;
+
+	for (iter = priv->tmpmem; iter; iter = iter->next) {
+		BraseroTmpImageMem *mem;
+		struct stat info;
+
+		mem = iter->data;
+		if (!fstat (mem->fd, &info))
+			BRASERO_BURN_LOG ("Temporary image %s held %lli bytes in memory (%lli expected)",
+					  mem->path,
+					  (goffset) info.st_size,
+					  mem->reserved);
+
+		close (mem->fd);
+		g_free (mem->path);
+		g_free (mem);
+	}
+
+	if (priv->tmpmem || priv->tmpmem_spills)
+		BRASERO_BURN_LOG ("%i temporary image(s) staged in memory, %i spilled to disk",
+				  g_slist_length (priv->tmpmem),
+				  priv->tmpmem_spills);
+
+	g_slist_free (priv->tmpmem);
+	priv->tmpmem = NULL;
+	priv->tmpmem_staged = 0;
+	priv->tmpmem_spills = 0;
+}
+
 /**
  * This function is used internally and is not public API
  */
 
+gboolean
+brasero_burn_session_is_tmp_image_in_memory (BraseroBurnSession *self,
+					     const gchar *path)
+{
+	BraseroBurnSessionPrivate *priv;
+	GSList *iter;
+
+	g_return_val_if_fail (BRASERO_IS_BURN_SESSION (self), FALSE);
+
+	if (!path)
+		return FALSE;
+
+	priv = BRASERO_BURN_SESSION_PRIVATE (self);
+	for (iter = priv->tmpmem; iter; iter = iter->next) {
+		BraseroTmpImageMem *mem;
+
+		mem = iter->data;
+		if (!strcmp (mem->path, path))
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * This function is used internally and is not public API
+ * @size is the expected size of the image in bytes or -1 if unknown.
+ */
+
 BraseroBurnResult
 brasero_burn_session_get_tmp_image (BraseroBurnSession *self,
 				    BraseroImageFormat format,
+				    goffset size,
 				    gchar **image,
 				    gchar **toc,
 				    GError **error)
@@ -1424,6 +1707,21 @@ brasero_burn_session_get_tmp_image (BraseroBurnSession *self,
 
 	priv = BRASERO_BURN_SESSION_PRIVATE (self);
 
+	/* Only plain images can be held in memory: the other formats come
+	 * with a toc/cue file that refers to the image by its path. */
+	if (format == BRASERO_IMAGE_FORMAT_BIN
+	&&  brasero_burn_session_get_tmp_image_mem (self, size, &path) == BRASERO_BURN_OK) {
+		if (image)
+			*image = path;
+		else
+			g_free (path);
+
+		if (toc)
+			*toc = NULL;
+
+		return BRASERO_BURN_OK;
+	}
+
 	/* Image tmp file */
 	result = brasero_burn_session_get_tmp_file (self,
 						    (format == BRASERO_IMAGE_FORMAT_CLONE)? NULL:".bin",
@@ -2408,6 +2706,11 @@ brasero_burn_session_finalize (GObject *object)
 
 	brasero_burn_session_stop_tracks_monitoring (BRASERO_BURN_SESSION (object));
 
+	if (priv->track_sizes) {
+		g_hash_table_destroy (priv->track_sizes);
+		priv->track_sizes = NULL;
+	}
+
 	if (priv->pile_tracks) {
 		g_slist_foreach (priv->pile_tracks,
 				(GFunc) brasero_burn_session_track_list_free,
@@ -2449,6 +2752,8 @@ brasero_burn_session_finalize (GObject *object)
 	}
 	g_slist_free (priv->tmpfiles);
 
+	brasero_burn_session_clean_tmp_image_mem (priv);
+
 	if (priv->session > 0) {
 		close (priv->session);
 		priv->session = -1;
@@ -2472,6 +2777,10 @@ brasero_burn_session_init (BraseroBurnSession *obj)
 
 	priv = BRASERO_BURN_SESSION_PRIVATE (obj);
 	priv->session = -1;
+	priv->track_sizes = g_hash_table_new_full (g_direct_hash,
+						   g_direct_equal,
+						   NULL,
+						   g_free);
 }
 
 static void
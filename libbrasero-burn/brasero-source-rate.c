@@ -0,0 +1,368 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+#include <gio/gio.h>
+
+#include "brasero-source-rate.h"
+#include "burn-debug.h"
+
+#include "brasero-track.h"
+#include "brasero-track-data.h"
+#include "brasero-track-image.h"
+#include "brasero-track-stream.h"
+
+/**
+ * Limits of the sampling: it must not delay the burning noticeably. Files are
+ * read from their start, the way the imagers will read them.
+ */
+#define BRASERO_SOURCE_RATE_MAX_TIME		2.0
+#define BRASERO_SOURCE_RATE_MAX_BYTES		(16 * 1048576)
+#define BRASERO_SOURCE_RATE_MAX_FILE_BYTES	(4 * 1048576)
+#define BRASERO_SOURCE_RATE_MAX_FILES		64
+#define BRASERO_SOURCE_RATE_BUFFER		65536
+
+typedef struct _BraseroSourceRateFile BraseroSourceRateFile;
+struct _BraseroSourceRateFile {
+	GFile *file;
+
+	/* Number of bytes the whole file becomes once imaged (decoded audio
+	 * for streams) or 0 when that is the size of the file */
+	goffset produced;
+};
+
+typedef struct _BraseroSourceRateThreadData BraseroSourceRateThreadData;
+struct _BraseroSourceRateThreadData {
+	GSList *files;
+	GCancellable *cancel;
+	GMainLoop *loop;
+
+	/* These are set in the thread */
+	guint sampled;
+	goffset read;
+	gdouble produced;
+	gdouble elapsed;
+};
+
+static void
+brasero_source_rate_add_file (BraseroSourceRateThreadData *data,
+			      GFile *file,
+			      goffset produced)
+{
+	BraseroSourceRateFile *source;
+
+	source = g_new0 (BraseroSourceRateFile, 1);
+	source->file = file;
+	source->produced = produced;
+	data->files = g_slist_append (data->files, source);
+}
+
+static void
+brasero_source_rate_add_children (BraseroSourceRateThreadData *data,
+				  GFile *directory,
+				  GSList *next)
+{
+	GFileEnumerator *enumerator;
+	GFileInfo *info;
+	GSList *children = NULL;
+
+	enumerator = g_file_enumerate_children (directory,
+						G_FILE_ATTRIBUTE_STANDARD_NAME ","
+						G_FILE_ATTRIBUTE_STANDARD_TYPE,
+						G_FILE_QUERY_INFO_NONE,
+						data->cancel,
+						NULL);
+	if (!enumerator)
+		return;
+
+	/* Only the first level: that gives enough files to sample and avoids
+	 * walking a whole tree before burning */
+	while ((info = g_file_enumerator_next_file (enumerator, data->cancel, NULL))) {
+		BraseroSourceRateFile *source;
+
+		if (g_file_info_get_file_type (info) != G_FILE_TYPE_REGULAR) {
+			g_object_unref (info);
+			continue;
+		}
+
+		source = g_new0 (BraseroSourceRateFile, 1);
+		source->file = g_file_get_child (directory, g_file_info_get_name (info));
+		children = g_slist_prepend (children, source);
+		g_object_unref (info);
+
+		if (g_slist_length (children) >= BRASERO_SOURCE_RATE_MAX_FILES)
+			break;
+	}
+
+	g_file_enumerator_close (enumerator, NULL, NULL);
+	g_object_unref (enumerator);
+
+	/* Insert them right after the directory so that they are sampled
+	 * before the other grafts */
+	children = g_slist_reverse (children);
+	if (children) {
+		g_slist_last (children)->next = next->next;
+		next->next = children;
+	}
+}
+
+static void
+brasero_source_rate_sample (BraseroSourceRateThreadData *data,
+			    BraseroSourceRateFile *source,
+			    GTimer *timer,
+			    gchar *buffer)
+{
+	GFileInputStream *input;
+	goffset read = 0;
+	GFileInfo *info;
+	gdouble ratio = 1.0;
+
+	input = g_file_read (source->file, data->cancel, NULL);
+	if (!input)
+		return;
+
+	if (source->produced > 0) {
+		info = g_file_input_stream_query_info (input,
+						       G_FILE_ATTRIBUTE_STANDARD_SIZE,
+						       data->cancel,
+						       NULL);
+		if (info) {
+			if (g_file_info_get_size (info) > 0)
+				ratio = (gdouble) source->produced / (gdouble) g_file_info_get_size (info);
+
+			g_object_unref (info);
+		}
+	}
+
+	while (read < BRASERO_SOURCE_RATE_MAX_FILE_BYTES
+	&&     data->read + read < BRASERO_SOURCE_RATE_MAX_BYTES
+	&&     g_timer_elapsed (timer, NULL) < BRASERO_SOURCE_RATE_MAX_TIME) {
+		gssize bytes;
+
+		bytes = g_input_stream_read (G_INPUT_STREAM (input),
+					     buffer,
+					     BRASERO_SOURCE_RATE_BUFFER,
+					     data->cancel,
+					     NULL);
+		if (bytes <= 0)
+			break;
+
+		read += bytes;
+	}
+
+	g_input_stream_close (G_INPUT_STREAM (input), NULL, NULL);
+	g_object_unref (input);
+
+	data->sampled ++;
+	data->read += read;
+	data->produced += (gdouble) read * ratio;
+}
+
+static gboolean
+brasero_source_rate_thread_finished (gpointer user_data)
+{
+	BraseroSourceRateThreadData *data = user_data;
+
+	g_main_loop_quit (data->loop);
+	return FALSE;
+}
+
+static gpointer
+brasero_source_rate_thread (gpointer user_data)
+{
+	BraseroSourceRateThreadData *data = user_data;
+	GTimer *timer;
+	gchar *buffer;
+	GSList *iter;
+
+	buffer = g_new (gchar, BRASERO_SOURCE_RATE_BUFFER);
+	timer = g_timer_new ();
+
+	for (iter = data->files; iter; iter = iter->next) {
+		BraseroSourceRateFile *source;
+		GFileType type;
+
+		if (g_cancellable_is_cancelled (data->cancel)
+		||  data->sampled >= BRASERO_SOURCE_RATE_MAX_FILES
+		||  data->read >= BRASERO_SOURCE_RATE_MAX_BYTES
+		||  g_timer_elapsed (timer, NULL) >= BRASERO_SOURCE_RATE_MAX_TIME)
+			break;
+
+		source = iter->data;
+		type = g_file_query_file_type (source->file,
+					       G_FILE_QUERY_INFO_NONE,
+					       data->cancel);
+		if (type == G_FILE_TYPE_DIRECTORY)
+			brasero_source_rate_add_children (data, source->file, iter);
+		else if (type == G_FILE_TYPE_REGULAR)
+			brasero_source_rate_sample (data, source, timer, buffer);
+	}
+
+	data->elapsed = g_timer_elapsed (timer, NULL);
+
+	g_timer_destroy (timer);
+	g_free (buffer);
+
+	/* Stop the loop waiting for us */
+	g_idle_add (brasero_source_rate_thread_finished, data);
+
+	g_thread_exit (NULL);
+	return NULL;
+}
+
+static void
+brasero_source_rate_add_tracks (BraseroSourceRateThreadData *data,
+				BraseroBurnSession *session)
+{
+	GSList *tracks;
+
+	for (tracks = brasero_burn_session_get_tracks (session); tracks; tracks = tracks->next) {
+		BraseroTrack *track;
+		gchar *uri;
+
+		track = tracks->data;
+		if (BRASERO_IS_TRACK_DATA (track)) {
+			GSList *grafts;
+
+			grafts = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (track));
+			for (; grafts; grafts = grafts->next) {
+				BraseroGraftPt *graft;
+
+				/* Grafts without URI are directories created
+				 * in the image: nothing to read */
+				graft = grafts->data;
+				if (graft->uri)
+					brasero_source_rate_add_file (data,
+								      g_file_new_for_uri (graft->uri),
+								      0);
+			}
+		}
+		else if (BRASERO_IS_TRACK_STREAM (track)) {
+			goffset bytes = 0;
+
+			uri = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), TRUE);
+			if (!uri)
+				continue;
+
+			/* The transcoder produces raw audio: a compressed file
+			 * yields more bytes than are read */
+			brasero_track_get_size (track, NULL, &bytes);
+			brasero_source_rate_add_file (data, g_file_new_for_uri (uri), bytes);
+			g_free (uri);
+		}
+		else if (BRASERO_IS_TRACK_IMAGE (track)) {
+			uri = brasero_track_image_get_source (BRASERO_TRACK_IMAGE (track), TRUE);
+			if (!uri)
+				continue;
+
+			brasero_source_rate_add_file (data, g_file_new_for_uri (uri), 0);
+			g_free (uri);
+		}
+	}
+}
+
+static void
+brasero_source_rate_file_free (BraseroSourceRateFile *source)
+{
+	g_object_unref (source->file);
+	g_free (source);
+}
+
+/**
+ * brasero_source_rate_measure:
+ * @session: a #BraseroBurnSession
+ * @cancel: a #GCancellable
+ * @rate: a #guint64
+ *
+ * Reads the beginning of the files the tracks of @session are made of for a
+ * short while and sets @rate to the number of bytes per second they produce
+ * once imaged. This is a sample of the source only; it does not account for
+ * the cost of the imagers themselves.
+ * This function runs a main loop while the files are read in a thread.
+ *
+ * Return value: a #gboolean. TRUE if @rate was set, FALSE if there was nothing
+ * to sample or if @cancel was cancelled.
+ **/
+gboolean
+brasero_source_rate_measure (BraseroBurnSession *session,
+			     GCancellable *cancel,
+			     guint64 *rate)
+{
+	BraseroSourceRateThreadData data = { NULL, };
+	GThread *thread;
+
+	brasero_source_rate_add_tracks (&data, session);
+	if (!data.files) {
+		BRASERO_BURN_LOG ("No source file to sample");
+		return FALSE;
+	}
+
+	data.cancel = cancel;
+	data.loop = g_main_loop_new (NULL, FALSE);
+
+	thread = g_thread_create (brasero_source_rate_thread,
+				  &data,
+				  TRUE,
+				  NULL);
+	if (!thread) {
+		g_main_loop_unref (data.loop);
+		g_slist_foreach (data.files, (GFunc) brasero_source_rate_file_free, NULL);
+		g_slist_free (data.files);
+		return FALSE;
+	}
+
+	/* The thread always stops the loop, even when cancelled */
+	g_main_loop_run (data.loop);
+	g_thread_join (thread);
+
+	g_main_loop_unref (data.loop);
+	g_slist_foreach (data.files, (GFunc) brasero_source_rate_file_free, NULL);
+	g_slist_free (data.files);
+
+	if (g_cancellable_is_cancelled (cancel))
+		return FALSE;
+
+	BRASERO_BURN_LOG ("Sampled %u source files: %"G_GOFFSET_FORMAT" bytes read in %.3f s (%.0f bytes produced)",
+			  data.sampled,
+			  data.read,
+			  data.elapsed,
+			  data.produced);
+
+	if (data.read <= 0 || data.elapsed <= 0.0)
+		return FALSE;
+
+	*rate = data.produced / data.elapsed;
+	return TRUE;
+}
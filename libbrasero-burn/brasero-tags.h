@@ -82,6 +82,31 @@ G_BEGIN_DECLS
  */
 #define BRASERO_COVER_URI			"session::art::cover"
 
+/**
+ * Maximum amount of memory (in MiB) that can be used to hold temporary images
+ * instead of writing them to the temporary directory. 0 disables it. (Int)
+ */
+#define BRASERO_SESSION_TMP_IMAGE_RAM_BUDGET	"session::tmp::image::ram_budget"
+
+/**
+ * Device paths of the drives that should burn a copy of the session at the
+ * same time as the session burner. (G_TYPE_STRV)
+ */
+#define BRASERO_SESSION_DUPLICATE_DRIVES	"session::duplicate::drives"
+
+/**
+ * Size (in MiB) of the buffer between the reader and the recorder when a disc
+ * is copied on the fly. 0 means the default size, a negative value disables
+ * it. (Int)
+ */
+#define BRASERO_SESSION_STREAM_BUFFER_SIZE	"session::stream::buffer::size"
+
+/**
+ * Percentage of the above buffer to fill before recording starts. 0 means the
+ * default. (Int)
+ */
+#define BRASERO_SESSION_STREAM_BUFFER_PREFILL	"session::stream::buffer::prefill"
+
 /**
  * Define the audio streams for a DVD
  */
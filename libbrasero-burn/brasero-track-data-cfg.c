@@ -53,6 +53,7 @@
 #include "burn-basics.h"
 #include "brasero-data-project.h"
 #include "brasero-data-tree-model.h"
+#include "brasero-data-layout.h"
 
 typedef struct _BraseroTrackDataCfgPrivate BraseroTrackDataCfgPrivate;
 struct _BraseroTrackDataCfgPrivate
@@ -71,6 +72,11 @@ struct _BraseroTrackDataCfgPrivate
 	GSList *grafts;
 	GSList *excluded;
 
+	/* size of the image estimated from the layout of the tree */
+	goffset image_sectors;
+	BraseroImageFS image_fs;
+	guint image_exact:1;
+
 	guint loading;
 	guint loading_remaining;
 	GSList *load_errors;
@@ -535,10 +541,11 @@ brasero_track_data_cfg_node_shown (GtkTreeModel *model,
 		/* in this case have vfs to increase priority for this node */
 		brasero_data_vfs_require_node_load (BRASERO_DATA_VFS (priv->tree), node);
 	}
-	else if (!BRASERO_FILE_NODE_MIME (node)) {
+	else if (!BRASERO_FILE_NODE_MIME (node) || node->is_mime_guessed) {
 		/* that means that file wasn't completly loaded. To save
 		 * some time we delayed the detection of the mime type
-		 * since that takes a lot of time. */
+		 * since that takes a lot of time (the name only gave a
+		 * guess at best). */
 		brasero_data_vfs_load_mime (BRASERO_DATA_VFS (priv->tree), node);
 	}
 
@@ -1414,6 +1421,8 @@ brasero_track_data_cfg_clean_cache (BraseroTrackDataCfg *track)
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
 
+	priv->image_sectors = -1;
+
 	if (priv->grafts) {
 		g_slist_foreach (priv->grafts, (GFunc) brasero_graft_point_free, NULL);
 		g_slist_free (priv->grafts);
@@ -1427,6 +1436,22 @@ brasero_track_data_cfg_clean_cache (BraseroTrackDataCfg *track)
 	}
 }
 
+static void
+brasero_track_data_cfg_layout_changed (BraseroTrackDataCfg *self)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+	priv->image_sectors = -1;
+
+	/* Our size is laid out from the tree once it is fully explored (see
+	 * brasero_track_data_cfg_get_size ()) so it may change even if the
+	 * sum of the file sizes does not */
+	if (!priv->loading
+	&&  !brasero_data_vfs_is_active (BRASERO_DATA_VFS (priv->tree)))
+		brasero_track_changed (BRASERO_TRACK (self));
+}
+
 static void
 brasero_track_data_cfg_node_added (BraseroDataProject *project,
 				   BraseroFileNode *node,
@@ -1439,6 +1464,9 @@ brasero_track_data_cfg_node_added (BraseroDataProject *project,
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
 
+	/* Names and directories change the layout of the image */
+	brasero_track_data_cfg_layout_changed (self);
+
 	if (priv->icon == node) {
 		/* Our icon node has showed up, signal that */
 		g_signal_emit (self,
@@ -1568,6 +1596,9 @@ brasero_track_data_cfg_node_removed (BraseroDataProject *project,
 	GtkTreePath *path;
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
+
+	/* Names and directories change the layout of the image */
+	brasero_track_data_cfg_layout_changed (self);
 	/* NOTE: there is no special case of autorun.inf here when we created
 	 * it as a temprary file since it's hidden and BraseroDataTreeModel
 	 * won't emit a signal for removed file in this case.
@@ -1641,6 +1672,9 @@ brasero_track_data_cfg_node_changed (BraseroDataProject *project,
 
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (self);
 
+	/* Names and directories change the layout of the image */
+	brasero_track_data_cfg_layout_changed (self);
+
 	/* Get the iter for the node */
 	iter.stamp = priv->stamp;
 	iter.user_data = node;
@@ -2230,6 +2264,174 @@ brasero_track_data_cfg_get_available_media (BraseroTrackDataCfg *track)
 	return brasero_data_session_get_available_media (BRASERO_DATA_SESSION (priv->tree));
 }
 
+/**
+ * brasero_track_data_cfg_load_begin:
+ * @track: a #BraseroTrackDataCfg
+ *
+ * Starts loading contents in batches with brasero_track_data_cfg_load_add ().
+ * This is useful for very large projects whose list of grafts should not be
+ * built all at once.
+ * Loading is over when brasero_track_data_cfg_load_end () is called.
+ *
+ * Return value: a #gboolean. FALSE if contents are already being loaded.
+ **/
+
+gboolean
+brasero_track_data_cfg_load_begin (BraseroTrackDataCfg *track)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA_CFG (track), FALSE);
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	if (priv->loading)
+		return FALSE;
+
+	brasero_data_project_load_contents_begin (BRASERO_DATA_PROJECT (priv->tree));
+	return TRUE;
+}
+
+/**
+ * brasero_track_data_cfg_load_add:
+ * @track: a #BraseroTrackDataCfg
+ * @grafts: (element-type BraseroBurn.GraftPt) (in) (transfer full): a #GSList of #BraseroGraftPt.
+ * @excluded: (element-type utf8) (in) (transfer full): a #GSList of URIS
+ *
+ * Adds a batch of grafts and excluded URIs after
+ * brasero_track_data_cfg_load_begin () was called.
+ * Excluded URIs should be added after the grafts they apply to.
+ *
+ * Note: @track takes ownership of @grafts and @excluded.
+ **/
+
+void
+brasero_track_data_cfg_load_add (BraseroTrackDataCfg *track,
+				 GSList *grafts,
+				 GSList *excluded)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_if_fail (BRASERO_IS_TRACK_DATA_CFG (track));
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	brasero_data_project_load_contents_add (BRASERO_DATA_PROJECT (priv->tree),
+						grafts,
+						excluded);
+
+	g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
+	g_slist_free (grafts);
+
+	g_slist_foreach (excluded, (GFunc) g_free, NULL);
+	g_slist_free (excluded);
+}
+
+/**
+ * brasero_track_data_cfg_load_end:
+ * @track: a #BraseroTrackDataCfg
+ *
+ * Ends the loading of contents started with brasero_track_data_cfg_load_begin ().
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if all contents are
+ * loaded, BRASERO_BURN_NOT_READY if some files still need to be explored.
+ **/
+
+BraseroBurnResult
+brasero_track_data_cfg_load_end (BraseroTrackDataCfg *track)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA_CFG (track), BRASERO_BURN_ERR);
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	priv->loading = brasero_data_project_load_contents_end (BRASERO_DATA_PROJECT (priv->tree));
+	if (!priv->loading) {
+		/* The size is now laid out from the tree instead of estimated */
+		brasero_track_changed (BRASERO_TRACK (track));
+		return BRASERO_BURN_OK;
+	}
+
+	return BRASERO_BURN_NOT_READY;
+}
+
+/**
+ * brasero_track_data_cfg_save_snapshot:
+ * @track: a #BraseroTrackDataCfg
+ * @path: a #gchar
+ * @error: a #GError
+ *
+ * Saves the whole tree of @track to a binary file at @path. Unlike a list of
+ * grafts, it can be loaded with brasero_track_data_cfg_load_snapshot ()
+ * without exploring the file system again.
+ * The contents must be fully loaded.
+ *
+ * Return value: a #gboolean. TRUE if the snapshot was written.
+ **/
+
+gboolean
+brasero_track_data_cfg_save_snapshot (BraseroTrackDataCfg *track,
+				      const gchar *path,
+				      GError **error)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA_CFG (track), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	if (priv->loading
+	||  brasero_data_vfs_is_exploring (BRASERO_DATA_VFS (priv->tree))) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     _("The project is still being loaded"));
+		return FALSE;
+	}
+
+	return brasero_data_project_save_snapshot (BRASERO_DATA_PROJECT (priv->tree),
+						   path,
+						   error);
+}
+
+/**
+ * brasero_track_data_cfg_load_snapshot:
+ * @track: a #BraseroTrackDataCfg
+ * @path: a #gchar
+ * @error: a #GError
+ *
+ * Loads the contents of @track from a file written by
+ * brasero_track_data_cfg_save_snapshot (). @track must be empty.
+ * Files are only checked in the background to make sure they still exist
+ * and have the same size; directories are then explored again for new files.
+ *
+ * Return value: a #gboolean. TRUE if the contents were loaded.
+ **/
+
+gboolean
+brasero_track_data_cfg_load_snapshot (BraseroTrackDataCfg *track,
+				      const gchar *path,
+				      GError **error)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA_CFG (track), FALSE);
+	g_return_val_if_fail (path != NULL, FALSE);
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+	if (priv->loading) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     _("The project is still being loaded"));
+		return FALSE;
+	}
+
+	return brasero_data_project_load_snapshot (BRASERO_DATA_PROJECT (priv->tree),
+						   path,
+						   error);
+}
+
 static BraseroBurnResult
 brasero_track_data_cfg_set_source (BraseroTrackData *track,
 				   GSList *grafts,
@@ -2436,6 +2638,80 @@ brasero_track_data_cfg_get_status (BraseroTrack *track,
 	return BRASERO_BURN_OK;
 }
 
+static BraseroBurnResult
+brasero_track_data_cfg_layout (BraseroTrackDataCfg *track,
+			       goffset *sectors)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroBurnResult result;
+	BraseroImageFS fs_type;
+	BraseroFileNode *root;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+
+	fs_type = brasero_track_data_cfg_get_fs (BRASERO_TRACK_DATA (track));
+	if (priv->image_sectors >= 0 && priv->image_fs == fs_type) {
+		*sectors = priv->image_sectors;
+		return priv->image_exact? BRASERO_BURN_OK:BRASERO_BURN_NOT_SUPPORTED;
+	}
+
+	root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
+	result = brasero_data_layout_get_sectors (root, NULL, fs_type, sectors);
+
+	priv->image_sectors = *sectors;
+	priv->image_fs = fs_type;
+	priv->image_exact = (result == BRASERO_BURN_OK);
+
+	return result;
+}
+
+static BraseroBurnResult
+brasero_track_data_cfg_get_image_size (BraseroTrackData *track,
+				       goffset *blocks)
+{
+	BraseroTrackDataCfgPrivate *priv;
+	BraseroBurnResult result;
+	goffset sectors = 0;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+
+	if (priv->loading
+	||  brasero_data_vfs_is_active (BRASERO_DATA_VFS (priv->tree)))
+		return BRASERO_BURN_NOT_READY;
+
+	if (brasero_data_project_is_empty (BRASERO_DATA_PROJECT (priv->tree)))
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	result = brasero_track_data_cfg_layout (BRASERO_TRACK_DATA_CFG (track), &sectors);
+	if (result != BRASERO_BURN_OK)
+		return result;
+
+	if (blocks)
+		*blocks = sectors;
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_track_data_cfg_export (BraseroTrackData *track,
+			       const BraseroTrackDataVisitor *visitor,
+			       gpointer root,
+			       gpointer user_data)
+{
+	BraseroTrackDataCfgPrivate *priv;
+
+	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (track);
+
+	if (priv->loading
+	||  brasero_data_vfs_is_active (BRASERO_DATA_VFS (priv->tree)))
+		return BRASERO_BURN_NOT_READY;
+
+	return brasero_data_project_export (BRASERO_DATA_PROJECT (priv->tree),
+					    visitor,
+					    root,
+					    user_data);
+}
+
 static BraseroBurnResult
 brasero_track_data_cfg_get_size (BraseroTrack *track,
 				 goffset *blocks,
@@ -2455,13 +2731,22 @@ brasero_track_data_cfg_get_size (BraseroTrack *track,
 		if (!sectors)
 			return sectors;
 
-		fs_type = brasero_track_data_cfg_get_fs (BRASERO_TRACK_DATA (track));
-		root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
-		stats = BRASERO_FILE_NODE_STATS (root);
-		sectors = brasero_data_project_improve_image_size_accuracy (sectors,
-									    stats->num_dir,
-									    fs_type);
-		*blocks = sectors;
+		/* While files are still being explored the tree changes all
+		 * the time so don't lay it out each time */
+		if (!priv->loading
+		&&  !brasero_data_vfs_is_active (BRASERO_DATA_VFS (priv->tree))) {
+			brasero_track_data_cfg_layout (BRASERO_TRACK_DATA_CFG (track), &sectors);
+			*blocks = sectors;
+		}
+		else {
+			fs_type = brasero_track_data_cfg_get_fs (BRASERO_TRACK_DATA (track));
+			root = brasero_data_project_get_root (BRASERO_DATA_PROJECT (priv->tree));
+			stats = BRASERO_FILE_NODE_STATS (root);
+			sectors = brasero_data_project_improve_image_size_accuracy (sectors,
+										    stats->num_dir,
+										    fs_type);
+			*blocks = sectors;
+		}
 	}
 
 	if (block_size)
@@ -2841,6 +3126,9 @@ brasero_track_data_cfg_project_loaded (BraseroDataProject *project,
 		       brasero_track_data_cfg_signals [SOURCE_LOADED],
 		       0,
 		       priv->load_errors);
+
+	/* The size is now laid out from the tree instead of estimated */
+	brasero_track_changed (BRASERO_TRACK (self));
 }
 
 static void
@@ -3293,6 +3581,7 @@ brasero_track_data_cfg_init (BraseroTrackDataCfg *object)
 	priv = BRASERO_TRACK_DATA_CFG_PRIVATE (object);
 
 	priv->sort_column = GTK_TREE_SORTABLE_UNSORTED_SORT_COLUMN_ID;
+	priv->image_sectors = -1;
 	do {
 		priv->stamp = g_random_int ();
 	} while (!priv->stamp);
@@ -3435,6 +3724,8 @@ brasero_track_data_cfg_class_init (BraseroTrackDataCfgClass *klass)
 	parent_class->get_grafts = brasero_track_data_cfg_get_grafts;
 	parent_class->get_excluded = brasero_track_data_cfg_get_excluded;
 	parent_class->get_file_num = brasero_track_data_cfg_get_file_num;
+	parent_class->get_image_size = brasero_track_data_cfg_get_image_size;
+	parent_class->export = brasero_track_data_cfg_export;
 
 	brasero_track_data_cfg_signals [AVAILABLE] = 
 	    g_signal_new ("session_available",
@@ -121,6 +121,31 @@ brasero_track_data_cfg_get_current_medium (BraseroTrackDataCfg *track);
 GSList *
 brasero_track_data_cfg_get_available_media (BraseroTrackDataCfg *track);
 
+/**
+ * Loading contents in batches
+ */
+
+gboolean
+brasero_track_data_cfg_load_begin (BraseroTrackDataCfg *track);
+
+void
+brasero_track_data_cfg_load_add (BraseroTrackDataCfg *track,
+				 GSList *grafts,
+				 GSList *excluded);
+
+BraseroBurnResult
+brasero_track_data_cfg_load_end (BraseroTrackDataCfg *track);
+
+gboolean
+brasero_track_data_cfg_save_snapshot (BraseroTrackDataCfg *track,
+				      const gchar *path,
+				      GError **error);
+
+gboolean
+brasero_track_data_cfg_load_snapshot (BraseroTrackDataCfg *track,
+				      const gchar *path,
+				      GError **error);
+
 /**
  * For filtered URIs tree model
  */
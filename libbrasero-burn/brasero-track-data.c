@@ -276,7 +276,11 @@ brasero_track_data_set_data_blocks (BraseroTrackData *track,
 	g_return_val_if_fail (BRASERO_IS_TRACK_DATA (track), BRASERO_BURN_NOT_SUPPORTED);
 
 	priv = BRASERO_TRACK_DATA_PRIVATE (track);
+	if (priv->data_blocks == blocks)
+		return BRASERO_BURN_OK;
+
 	priv->data_blocks = blocks;
+	brasero_track_changed (BRASERO_TRACK (track));
 
 	return BRASERO_BURN_OK;
 }
@@ -624,6 +628,74 @@ brasero_track_data_get_file_num_real (BraseroTrackData *track)
 	return priv->file_num;
 }
 
+/**
+ * brasero_track_data_get_image_size:
+ * @track: a #BraseroTrackData.
+ * @blocks: (allow-none) (out): a #goffset or %NULL.
+ *
+ * Sets in @blocks the number of 2048 bytes sectors of the image that
+ * would be created from @track, when it can be computed without running
+ * the image creator.
+ * It is an estimate good enough to be displayed: name mangling, sort
+ * order and hard links are not accounted for. Only the image creator
+ * knows the actual size.
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if @blocks
+ * was set, BRASERO_BURN_NOT_READY if @track is still being loaded
+ * and BRASERO_BURN_NOT_SUPPORTED otherwise.
+ **/
+
+BraseroBurnResult
+brasero_track_data_get_image_size (BraseroTrackData *track,
+				   goffset *blocks)
+{
+	BraseroTrackDataClass *klass;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA (track), BRASERO_BURN_NOT_SUPPORTED);
+
+	klass = BRASERO_TRACK_DATA_GET_CLASS (track);
+	if (!klass->get_image_size)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	return klass->get_image_size (track, blocks);
+}
+
+/**
+ * brasero_track_data_export:
+ * @track: a #BraseroTrackData.
+ * @visitor: a #BraseroTrackDataVisitor.
+ * @root: the handle for the root directory of the image.
+ * @user_data: data passed to the functions of @visitor.
+ *
+ * Walks the tree of @track depth first and calls the functions of @visitor
+ * for each directory and file that should be in the image (exclusions are
+ * already applied). Each directory is visited before its children.
+ * Image creators can use that instead of the graft points from
+ * brasero_track_data_get_grafts () which they would have to resolve and
+ * explore again.
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_NOT_SUPPORTED if @track
+ * has no tree to walk; the graft points must be used then.
+ **/
+
+BraseroBurnResult
+brasero_track_data_export (BraseroTrackData *track,
+			   const BraseroTrackDataVisitor *visitor,
+			   gpointer root,
+			   gpointer user_data)
+{
+	BraseroTrackDataClass *klass;
+
+	g_return_val_if_fail (BRASERO_IS_TRACK_DATA (track), BRASERO_BURN_NOT_SUPPORTED);
+	g_return_val_if_fail (visitor != NULL, BRASERO_BURN_NOT_SUPPORTED);
+
+	klass = BRASERO_TRACK_DATA_GET_CLASS (track);
+	if (!klass->export)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	return klass->export (track, visitor, root, user_data);
+}
+
 static BraseroBurnResult
 brasero_track_data_get_size (BraseroTrack *track,
 			     goffset *blocks,
@@ -68,6 +68,37 @@ brasero_graft_point_copy (BraseroGraftPt *graft);
 typedef struct _BraseroTrackDataClass BraseroTrackDataClass;
 typedef struct _BraseroTrackData BraseroTrackData;
 
+/**
+ * BraseroTrackDataVisitor:
+ * @add_directory: called for each directory; @uri is %NULL for directories
+ * created by the user, @grafted is %TRUE for the directories added by the
+ * user (as opposed to their contents) and @imported is %TRUE for the
+ * directories of a previous session. Sets in @handle what is passed as
+ * @parent for its children.
+ * @add_file: called for each file
+ * @end_directory: (allow-none): called once all children of a directory were visited
+ *
+ * Used by brasero_track_data_export () to hand each node of a track to an
+ * image creator. Returning anything but BRASERO_BURN_OK stops the export.
+ **/
+
+typedef struct _BraseroTrackDataVisitor BraseroTrackDataVisitor;
+struct _BraseroTrackDataVisitor {
+	BraseroBurnResult	(*add_directory)	(gpointer parent,
+							 const gchar *name,
+							 const gchar *uri,
+							 gboolean grafted,
+							 gboolean imported,
+							 gpointer *handle,
+							 gpointer user_data);
+	BraseroBurnResult	(*add_file)		(gpointer parent,
+							 const gchar *name,
+							 const gchar *uri,
+							 gpointer user_data);
+	void			(*end_directory)	(gpointer handle,
+							 gpointer user_data);
+};
+
 struct _BraseroTrackDataClass
 {
 	BraseroTrackClass parent_class;
@@ -95,6 +126,12 @@ struct _BraseroTrackDataClass
 	GSList*			(*get_grafts)		(BraseroTrackData *track);
 	GSList*			(*get_excluded)		(BraseroTrackData *track);
 	guint64			(*get_file_num)		(BraseroTrackData *track);
+	BraseroBurnResult	(*get_image_size)	(BraseroTrackData *track,
+							 goffset *blocks);
+	BraseroBurnResult	(*export)		(BraseroTrackData *track,
+							 const BraseroTrackDataVisitor *visitor,
+							 gpointer root,
+							 gpointer user_data);
 };
 
 struct _BraseroTrackData
@@ -146,6 +183,16 @@ BraseroBurnResult
 brasero_track_data_get_file_num (BraseroTrackData *track,
 				 guint64 *file_num);
 
+BraseroBurnResult
+brasero_track_data_get_image_size (BraseroTrackData *track,
+				   goffset *blocks);
+
+BraseroBurnResult
+brasero_track_data_export (BraseroTrackData *track,
+			   const BraseroTrackDataVisitor *visitor,
+			   gpointer root,
+			   gpointer user_data);
+
 BraseroImageFS
 brasero_track_data_get_fs (BraseroTrackData *track);
 
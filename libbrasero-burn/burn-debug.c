@@ -62,6 +62,12 @@ brasero_burn_library_set_debug (gboolean value)
 	debug = value;
 }
 
+gboolean
+brasero_burn_debug_get (void)
+{
+	return debug;
+}
+
 /**
  * brasero_burn_library_get_option_group:
  *
@@ -90,6 +90,9 @@ G_BEGIN_DECLS
 void
 brasero_burn_library_set_debug (gboolean value);
 
+gboolean
+brasero_burn_debug_get (void);
+
 void
 brasero_burn_debug_setup_module (GModule *handle);
 
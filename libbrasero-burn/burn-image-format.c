@@ -46,257 +46,220 @@
 #include "burn-debug.h"
 #include "burn-image-format.h"
 
-static const gchar *
-brasero_image_format_read_path (const gchar *ptr,
-				gchar **path)
-{
-	const gchar *start, *end;
-
-	/* make sure there is a white space */
-	if (!isspace (*ptr))
-		return NULL;
-
-	/* jump over the white spaces */
-	while (isspace (*ptr)) ptr ++;
-
-	/* seek the first '"' if any */
-	start = g_utf8_strchr (ptr, -1, '"');
-	if (start) {
-		start ++;
-
-		/* seek the last '"' */
-		end = g_utf8_strchr (start, -1, '"');
-		if (!end)
-			return NULL;
+/**
+ * Cue sheets (.cue), cdrdao tables of contents (.toc) and clone .toc files
+ * are all parsed in a single pass by the following tokenizer. The result is
+ * a BraseroImageSheet that is cached per URI and modification time so that
+ * identifying, measuring and checking the byte order of a sheet only reads
+ * it once.
+ */
 
-		ptr = end + 1;
-	}
-	else {
-		/* there is no starting '"' seek last space */
-		start = ptr;
-		end = ptr;
-		while (!isspace (*end)) end ++;
+typedef enum {
+	BRASERO_SHEET_KEY_NONE,
+	BRASERO_SHEET_KEY_FILE,
+	BRASERO_SHEET_KEY_DATAFILE,
+	BRASERO_SHEET_KEY_AUDIOFILE,
+	BRASERO_SHEET_KEY_TRACK,
+	BRASERO_SHEET_KEY_INDEX,
+	BRASERO_SHEET_KEY_START,
+	BRASERO_SHEET_KEY_PREGAP,
+	BRASERO_SHEET_KEY_POSTGAP,
+	BRASERO_SHEET_KEY_SILENCE,
+	BRASERO_SHEET_KEY_ZERO,
+	BRASERO_SHEET_KEY_TOC_TYPE
+} BraseroImageSheetKey;
+
+static const struct {
+	const gchar *name;
+	BraseroImageSheetKey key;
+} sheet_keywords [] = {
+	{ "FILE",	BRASERO_SHEET_KEY_FILE		},
+	{ "DATAFILE",	BRASERO_SHEET_KEY_DATAFILE	},
+	{ "AUDIOFILE",	BRASERO_SHEET_KEY_AUDIOFILE	},
+	{ "TRACK",	BRASERO_SHEET_KEY_TRACK		},
+	{ "INDEX",	BRASERO_SHEET_KEY_INDEX		},
+	{ "START",	BRASERO_SHEET_KEY_START		},
+	{ "PREGAP",	BRASERO_SHEET_KEY_PREGAP	},
+	{ "POSTGAP",	BRASERO_SHEET_KEY_POSTGAP	},
+	{ "SILENCE",	BRASERO_SHEET_KEY_SILENCE	},
+	{ "ZERO",	BRASERO_SHEET_KEY_ZERO		},
+
+	/* Keywords for cdrdao cuesheets */
+	{ "CD_ROM_XA",	BRASERO_SHEET_KEY_TOC_TYPE	},
+	{ "CD_ROM",	BRASERO_SHEET_KEY_TOC_TYPE	},
+	{ "CD_DA",	BRASERO_SHEET_KEY_TOC_TYPE	},
+	{ "CD_TEXT",	BRASERO_SHEET_KEY_TOC_TYPE	},
+	{ NULL,		BRASERO_SHEET_KEY_NONE		}
+};
+
+/* Data file types that can only be found in a .cue file */
+static const gchar *cue_file_types [] = { "MOTOROLA",
+					  "BINARY",
+					  "AIFF",
+					  "WAVE",
+					  "MP3",
+					  NULL };
+
+/* Track modes that can only be found in a .toc file (AUDIO is common) */
+static const gchar *toc_track_modes [] = { "MODE0",
+					   "MODE1",
+					   "MODE1_RAW",
+					   "MODE2",
+					   "MODE2_FORM1",
+					   "MODE2_FORM2",
+					   "MODE2_FORM_MIX",
+					   "MODE2_RAW",
+					   NULL };
+
+/* Track modes that can only be found in a .cue file */
+static const gchar *cue_track_modes [] = { "CDG",
+					   "MODE1/2048",
+					   "MODE1/2352",
+					   "MODE2/2336",
+					   "MODE2/2352",
+					   "CDI/2336",
+					   "CDI/2352",
+					   NULL };
+
+struct _BraseroImageSheetCache {
+	BraseroImageSheet *sheet;
+	guint64 mtime;
+	guint32 mtime_usec;
+};
+typedef struct _BraseroImageSheetCache BraseroImageSheetCache;
+
+#define BRASERO_IMAGE_SHEET_CACHE_MAX	16
+
+G_LOCK_DEFINE_STATIC (sheets);
+static GHashTable *sheets = NULL;
 
-		ptr = end;
-		if (isspace (*end))
-			end --;
+static gboolean
+brasero_image_sheet_strv_has (const gchar **strv,
+			      const gchar *string)
+{
+	for (; *strv; strv ++) {
+		if (!strcmp (*strv, string))
+			return TRUE;
 	}
 
-	if (path)
-		*path = g_strndup (start, end-start);
-
-	return ptr;
+	return FALSE;
 }
 
-static gchar *
-brasero_image_format_get_cue_file_complement (const gchar *path)
+static BraseroImageSheetKey
+brasero_image_sheet_get_key (const gchar *token)
 {
-	FILE *file;
-	gchar *ptr;
-	gchar *complement = NULL;
-	/* a path can't be over MAXPATHLEN then buffer doesn't need to be over
-	 * this value + 4 + white space + commas */
-	gchar buffer [MAXPATHLEN+8+3];
-
-	file = fopen (path, "r");
-	if (!file) {
-		if (g_str_has_suffix (path, ".cue"))
-			return g_strdup_printf ("%.*sbin",
-						(int) strlen (path) - 3,
-						path);
-
-		return g_strdup_printf ("%s.bin", path);
-	}
+	guint i;
 
-	while (fgets (buffer, sizeof (buffer), file)) {
-		ptr = strstr (buffer, "FILE");
-		if (ptr) {
-			ptr += 4;
-			if (brasero_image_format_read_path (ptr, &complement))
-				break;
-		}
+	for (i = 0; sheet_keywords [i].name; i ++) {
+		if (!strcmp (sheet_keywords [i].name, token))
+			return sheet_keywords [i].key;
 	}
-	fclose (file);
 
-	/* check if the path is relative, if so then add the root path */
-	if (complement && !g_path_is_absolute (complement)) {
-		gchar *directory;
-		gchar *tmp;
-
-		directory = g_path_get_dirname (path);
-
-		tmp = complement;
-		complement = g_build_path (G_DIR_SEPARATOR_S,
-					   directory,
-					   complement,
-					   NULL);
-		g_free (tmp);
-	}
-
-	return complement;
+	return BRASERO_SHEET_KEY_NONE;
 }
 
-static gchar *
-brasero_image_format_get_toc_file_complement (const gchar *path)
+/**
+ * Splits a line into whitespace separated tokens. Quotes delimit a token
+ * (paths can have spaces) and cdrdao comments end the line.
+ */
+
+static gchar **
+brasero_image_sheet_tokenize (const gchar *line)
 {
-	FILE *file;
-	gchar *ptr;
-	gchar *complement = NULL;
-	/* a path can't be over MAXPATHLEN then buffer doesn't need to be over
-	 * this value + keyword size + white space + commas */
-	gchar buffer [MAXPATHLEN+8+3];
-
-	/* NOTE: the problem here is that cdrdao files can have references to 
-	 * multiple files. Which is great but not for us ... */
-	file = fopen (path, "r");
-	if (!file) {
-		if (g_str_has_suffix (path, ".cue"))
-			return g_strdup_printf ("%.*sbin",
-						(int) strlen (path) - 3,
-						path);
+	GPtrArray *tokens;
+	const gchar *ptr;
 
-		return g_strdup_printf ("%s.bin", path);
-	}
+	tokens = g_ptr_array_new ();
 
-	while (fgets (buffer, sizeof (buffer), file)) {
-		ptr = strstr (buffer, "DATAFILE");
-		if (ptr) {
-			ptr += 8;
-			if (brasero_image_format_read_path (ptr, &complement))
-				break;
-		}
+	ptr = line;
+	while (*ptr) {
+		const gchar *start;
 
-		ptr = strstr (buffer, "FILE");
-		if (ptr) {
-			ptr += 4;
-			if (brasero_image_format_read_path (ptr, &complement))
-				break;
-		}
-	}
-	fclose (file);
+		while (isspace ((guchar) *ptr)) ptr ++;
+		if (*ptr == '\0')
+			break;
 
-	/* check if the path is relative, if so then add the root path */
-	if (complement && !g_path_is_absolute (complement)) {
-		gchar *directory;
-		gchar *tmp;
-
-		directory = g_path_get_dirname (path);
-
-		tmp = complement;
-		complement = g_build_path (G_DIR_SEPARATOR_S,
-					   directory,
-					   complement,
-					   NULL);
-		g_free (tmp);
-	}
+		if (ptr [0] == '/' && ptr [1] == '/')
+			break;
 
-	return complement;
-}
+		if (*ptr == '"') {
+			ptr ++;
+			start = ptr;
+			while (*ptr && *ptr != '"') ptr ++;
 
-/* FIXME this function is flawed at the moment. A cue file or toc file can 
- * hold different paths */
-gchar *
-brasero_image_format_get_complement (BraseroImageFormat format,
-				     const gchar *path)
-{
-	gchar *retval = NULL;
+			g_ptr_array_add (tokens, g_strndup (start, ptr - start));
+			if (*ptr)
+				ptr ++;
 
-	if (format == BRASERO_IMAGE_FORMAT_CLONE) {
-		/* These are set rules no need to parse:
-		 * the toc file has to end with .toc suffix */
-		if (g_str_has_suffix (path, ".toc"))
-			retval = g_strndup (path, strlen (path) - 4);
-	}
-	else if (format == BRASERO_IMAGE_FORMAT_CUE) {
-		/* need to parse */
-		retval = brasero_image_format_get_cue_file_complement (path);
-	}
-	else if (format == BRASERO_IMAGE_FORMAT_CDRDAO) {
-		/* need to parse */
-		retval = brasero_image_format_get_toc_file_complement (path);
+			continue;
+		}
+
+		start = ptr;
+		while (*ptr && !isspace ((guchar) *ptr)) ptr ++;
+		g_ptr_array_add (tokens, g_strndup (start, ptr - start));
 	}
-	else
-		retval = NULL;
 
-	return retval;
+	g_ptr_array_add (tokens, NULL);
+	return (gchar **) g_ptr_array_free (tokens, FALSE);
 }
 
-static gchar *
-brasero_image_format_get_MSF_address (const gchar *ptr,
-				      gint64 *block)
+/**
+ * Parses either a number of sectors or a MM:SS:FF address
+ */
+
+static gboolean
+brasero_image_sheet_get_MSF_address (const gchar *token,
+				     gint64 *block)
 {
+	const gchar *ptr;
 	gchar *next;
-	gint64 address = 0;
+	gint64 address;
 
-	address = strtoll (ptr, &next, 10); 
-	if (isspace (*next)) {
-		*block = address;
-		return next;
+	if (!token || !isdigit ((guchar) *token))
+		return FALSE;
+
+	address = strtoll (token, &next, 10);
+	if (*next == '\0') {
+		if (block)
+			*block = address;
+		return TRUE;
 	}
 
 	if (*next != ':')
-		return NULL;
+		return FALSE;
 
-	next ++;
-	ptr = next;
+	ptr = next + 1;
 	address *= 60;
 	address += strtoll (ptr, &next, 10);
-	if (ptr == next)
-		return NULL;
-
-	if (*next != ':')
-		return NULL;
+	if (ptr == next || *next != ':')
+		return FALSE;
 
-	next ++;
-	ptr = next;
+	ptr = next + 1;
 	address *= 75;
 	address += strtoll (ptr, &next, 10);
-	if (ptr == next)
-		return NULL;
+	if (ptr == next || *next != '\0')
+		return FALSE;
 
 	if (block)
 		*block = address;
 
-	return next;	
+	return TRUE;
 }
 
-static gboolean
-brasero_image_format_get_DATAFILE_info (const gchar *ptr,
-					GFile *parent,
-					gint64 *size_file,
-					GError **error)
+static BraseroImageSheetFile *
+brasero_image_sheet_add_file (BraseroImageSheet *sheet,
+			      GFile *parent,
+			      const gchar *path)
 {
-	gchar *path = NULL;
-	GFileInfo *info;
+	BraseroImageSheetFile *sheet_file;
 	GFile *file;
-
-	/* get the path. NOTE: no need to check if it's relative since that's
-	 * just to skip it. */
-	ptr = brasero_image_format_read_path (ptr, &path);
-	if (!ptr)
-		return FALSE;
-
-	/* skip white spaces */
-	while (isspace (*ptr)) ptr++;
-
-	if (ptr [0] == '\0'
-	|| (ptr [0] == '/' && ptr [1] == '/'))
-		goto stat_end;
-
-	if (!brasero_image_format_get_MSF_address (ptr, size_file)) {
-		g_free (path);
-		return FALSE;
-	}
-
-	g_free (path);
-	return TRUE;
-
-stat_end:
+	gchar *uri;
+	GSList *iter;
 
 	/* check if the path is relative, if so then add the root path */
-	if (path && !g_path_is_absolute (path))
+	if (!g_path_is_absolute (path))
 		file = g_file_resolve_relative_path (parent, path);
-	else if (path) {
+	else {
 		gchar *img_uri;
 		gchar *scheme;
 
@@ -307,462 +270,641 @@ stat_end:
 		file = g_file_new_for_commandline_arg (img_uri);
 		g_free (img_uri);
 	}
-	else
-		return FALSE;
-
-	g_free (path);
 
-	/* NOTE: follow symlink if any */
-	info = g_file_query_info (file,
-				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
-				  G_FILE_QUERY_INFO_NONE,
-				  NULL,
-				  error);
+	uri = g_file_get_uri (file);
 	g_object_unref (file);
-	if (!info)
-		return FALSE;
 
-	if (size_file)
-		*size_file = BRASERO_BYTES_TO_SECTORS (g_file_info_get_size (info), 2352);
+	/* The same file can be used by several tracks */
+	for (iter = sheet->files; iter; iter = iter->next) {
+		sheet_file = iter->data;
+		if (!strcmp (sheet_file->uri, uri)) {
+			g_free (uri);
+			return sheet_file;
+		}
+	}
 
-	g_object_unref (info);
+	sheet_file = g_new0 (BraseroImageSheetFile, 1);
+	sheet_file->uri = uri;
+	sheet_file->size = -1;
+	sheet->files = g_slist_append (sheet->files, sheet_file);
 
-	return TRUE;
+	return sheet_file;
 }
 
-static gboolean
-brasero_image_format_get_FILE_info (const gchar *ptr,
-				    GFile *parent,
-				    gint64 *size_img,
-				    GError **error)
+static BraseroImageSheetTrack *
+brasero_image_sheet_add_track (BraseroImageSheet *sheet)
+{
+	BraseroImageSheetTrack *track;
+
+	track = g_new0 (BraseroImageSheetTrack, 1);
+	track->indices = g_array_new (FALSE, FALSE, sizeof (gint64));
+	sheet->tracks = g_slist_append (sheet->tracks, track);
+
+	return track;
+}
+
+static void
+brasero_image_sheet_add_chunk (BraseroImageSheetTrack *track,
+			       BraseroImageSheetFile *file,
+			       gint64 start,
+			       gint64 length)
+{
+	BraseroImageSheetChunk *chunk;
+
+	chunk = g_new0 (BraseroImageSheetChunk, 1);
+	chunk->file = file;
+	chunk->start = start;
+	chunk->length = length;
+	track->chunks = g_slist_append (track->chunks, chunk);
+}
+
+static void
+brasero_image_sheet_set_format (BraseroImageSheet *sheet,
+				BraseroImageFormat format)
 {
-	gchar *path = NULL;
+	/* The first hint wins */
+	if (sheet->format == BRASERO_IMAGE_FORMAT_NONE)
+		sheet->format = format;
+}
+
+static void
+brasero_image_sheet_parse_file (BraseroImageSheet *sheet,
+				BraseroImageSheetTrack **track,
+				GFile *parent,
+				BraseroImageSheetKey key,
+				gchar **tokens)
+{
+	BraseroImageSheetFile *file;
 	gint64 start = 0;
-	GFileInfo *info;
-	GFile *file = NULL;
-	gchar *tmp;
+	gint64 length = -1;
+	guint num;
 
-	/* get the path and skip it */
-	ptr = brasero_image_format_read_path (ptr, &path);
-	if (!ptr)
-		return FALSE;
+	if (!tokens [1])
+		return;
 
-	/* skip white spaces */
-	while (isspace (*ptr)) ptr++;
+	num = g_strv_length (tokens);
+	file = brasero_image_sheet_add_file (sheet, parent, tokens [1]);
 
-	/* skip a possible #.... (offset in bytes) */
-	tmp = g_utf8_strchr (ptr, -1, '#');
-	if (tmp) {
-		tmp ++;
-		while (isdigit (*tmp)) tmp ++;
-		while (isspace (*tmp)) tmp++;
-		ptr = tmp;
-	}
+	/* FILE "path" TYPE in a .cue: the file is for the following tracks */
+	if (key == BRASERO_SHEET_KEY_FILE
+	&&  num == 3
+	&&  brasero_image_sheet_strv_has (cue_file_types, tokens [2])) {
+		brasero_image_sheet_set_format (sheet, BRASERO_IMAGE_FORMAT_CUE);
 
-	/* get the start */
-	ptr = brasero_image_format_get_MSF_address (ptr, &start);
-	if (!ptr) {
-		g_free (path);
-		return FALSE;
+		g_free (file->type);
+		file->type = g_strdup (tokens [2]);
+
+		if (!strcmp (tokens [2], "BINARY"))
+			sheet->has_binary = 1;
+
+		sheet->cue_file = file;
+		return;
 	}
 
-	/* skip white spaces */
-	while (isspace (*ptr)) ptr++;
+	/* .toc: DATAFILE "path" [#offset] [length]
+	 * 	 FILE/AUDIOFILE "path" [#offset] start [length] */
+	tokens += 2;
+	if (*tokens && **tokens == '#')
+		tokens ++;
 
-	if (ptr [0] == '\0'
-	|| (ptr [0] == '/' && ptr [1] == '/'))
-		goto stat_end;
+	if (key != BRASERO_SHEET_KEY_DATAFILE) {
+		if (!brasero_image_sheet_get_MSF_address (*tokens, &start))
+			return;
 
-	/* get the size */
-	if (!brasero_image_format_get_MSF_address (ptr, size_img)) {
-		g_free (path);
-		return FALSE;
+		tokens ++;
 	}
 
-	g_free (path);
-	return TRUE;
+	if (*tokens && !brasero_image_sheet_get_MSF_address (*tokens, &length))
+		return;
 
-stat_end:
+	if (!*track)
+		*track = brasero_image_sheet_add_track (sheet);
 
-	/* check if the path is relative, if so then add the root path */
-	if (path && !g_path_is_absolute (path))
-		file = g_file_resolve_relative_path (parent, path);
-	else if (path) {
-		gchar *img_uri;
-		gchar *scheme;
+	brasero_image_sheet_add_chunk (*track, file, start, length);
+}
 
-		scheme = g_file_get_uri_scheme (parent);
-		img_uri = g_strconcat (scheme, "://", path, NULL);
-		g_free (scheme);
+static void
+brasero_image_sheet_parse_line (BraseroImageSheet *sheet,
+				BraseroImageSheetTrack **track,
+				GFile *parent,
+				gchar **tokens)
+{
+	BraseroImageSheetKey key;
+	gint64 address = 0;
+	guint num;
+
+	num = g_strv_length (tokens);
+	if (!num)
+		return;
+
+	key = brasero_image_sheet_get_key (tokens [0]);
+	switch (key) {
+	case BRASERO_SHEET_KEY_TOC_TYPE:
+		brasero_image_sheet_set_format (sheet, BRASERO_IMAGE_FORMAT_CDRDAO);
+		break;
+
+	case BRASERO_SHEET_KEY_FILE:
+	case BRASERO_SHEET_KEY_DATAFILE:
+	case BRASERO_SHEET_KEY_AUDIOFILE:
+		brasero_image_sheet_parse_file (sheet, track, parent, key, tokens);
+		break;
+
+	case BRASERO_SHEET_KEY_TRACK:
+		if (num < 2)
+			break;
 
-		file = g_file_new_for_commandline_arg (img_uri);
-		g_free (img_uri);
+		*track = brasero_image_sheet_add_track (sheet);
+
+		/* .cue: TRACK number mode; .toc: TRACK mode [sub-channel] */
+		if (num >= 3 && isdigit ((guchar) *tokens [1])) {
+			(*track)->number = strtol (tokens [1], NULL, 10);
+			(*track)->mode = g_strdup (tokens [2]);
+			(*track)->file = sheet->cue_file;
+
+			if (brasero_image_sheet_strv_has (cue_track_modes, tokens [2]))
+				brasero_image_sheet_set_format (sheet, BRASERO_IMAGE_FORMAT_CUE);
+		}
+		else {
+			(*track)->number = g_slist_length (sheet->tracks);
+			(*track)->mode = g_strdup (tokens [1]);
+
+			if (brasero_image_sheet_strv_has (toc_track_modes, tokens [1]))
+				brasero_image_sheet_set_format (sheet, BRASERO_IMAGE_FORMAT_CDRDAO);
+		}
+
+		if (!strcmp ((*track)->mode, "AUDIO"))
+			sheet->has_audio = 1;
+		break;
+
+	case BRASERO_SHEET_KEY_INDEX:
+	case BRASERO_SHEET_KEY_START:
+		/* .cue: INDEX number MSF; .toc: INDEX MSF or START [MSF] */
+		if (!*track)
+			break;
+
+		if (brasero_image_sheet_get_MSF_address (tokens [num - 1], &address))
+			g_array_append_val ((*track)->indices, address);
+		break;
+
+	case BRASERO_SHEET_KEY_PREGAP:
+	case BRASERO_SHEET_KEY_POSTGAP:
+		if (!*track)
+			*track = brasero_image_sheet_add_track (sheet);
+
+		if (num == 2 && brasero_image_sheet_get_MSF_address (tokens [1], &address)) {
+			if (key == BRASERO_SHEET_KEY_PREGAP)
+				(*track)->pregap += address;
+			else
+				(*track)->postgap += address;
+		}
+		break;
+
+	case BRASERO_SHEET_KEY_SILENCE:
+	case BRASERO_SHEET_KEY_ZERO:
+		/* ZERO can have a mode before the length */
+		if (!*track)
+			*track = brasero_image_sheet_add_track (sheet);
+
+		if (num >= 2 && brasero_image_sheet_get_MSF_address (tokens [num - 1], &address))
+			brasero_image_sheet_add_chunk (*track, NULL, 0, address);
+		break;
+
+	default:
+		break;
 	}
-	else
-		return FALSE;
+}
 
-	g_free (path);
+static gboolean
+brasero_image_sheet_stat_file (BraseroImageSheetFile *file,
+			       GCancellable *cancel,
+			       GError **error)
+{
+	GFileInfo *info;
+	GFile *gfile;
+
+	if (file->size >= 0)
+		return TRUE;
 
 	/* NOTE: follow symlink if any */
-	info = g_file_query_info (file,
+	gfile = g_file_new_for_uri (file->uri);
+	info = g_file_query_info (gfile,
 				  G_FILE_ATTRIBUTE_STANDARD_SIZE,
 				  G_FILE_QUERY_INFO_NONE,
-				  NULL,
+				  cancel,
 				  error);
-	g_object_unref (file);
+	g_object_unref (gfile);
 	if (!info)
 		return FALSE;
 
-	if (size_img)
-		*size_img = BRASERO_BYTES_TO_SECTORS (g_file_info_get_size (info), 2352) - start;
-
+	file->size = g_file_info_get_size (info);
 	g_object_unref (info);
 
 	return TRUE;
 }
 
-gboolean
-brasero_image_format_get_cdrdao_size (gchar *uri,
-				      guint64 *sectors,
-				      guint64 *size_img,
-				      GCancellable *cancel,
-				      GError **error)
+/**
+ * Once the format is known, compute the size of the image from the parsed
+ * structure. Data files are only stat'ed (once) when that's necessary.
+ */
+
+static void
+brasero_image_sheet_compute_size (BraseroImageSheet *sheet,
+				  const gchar *uri,
+				  GCancellable *cancel)
 {
-	GFile *file;
-	gchar *line;
-	GFile *parent;
-	gint64 cue_size = 0;
-	GFileInputStream *input;
-	GDataInputStream *stream;
+	GSList *iter;
 
-	file = g_file_new_for_uri (uri);
-	input = g_file_read (file, cancel, error);
+	if (sheet->format == BRASERO_IMAGE_FORMAT_CUE) {
+		goffset bytes = 0;
 
-	if (!input) {
-		g_object_unref (file);
-		return FALSE;
-	}
+		/* .cue can use various data files but have to use them ALL. So
+		 * we don't need to care about a start/size address. */
+		for (iter = sheet->files; iter; iter = iter->next) {
+			BraseroImageSheetFile *file;
 
-	stream = g_data_input_stream_new (G_INPUT_STREAM (input));
-	g_object_unref (input);
+			file = iter->data;
+			if (!brasero_image_sheet_stat_file (file, cancel, &sheet->error))
+				return;
 
-	parent = g_file_get_parent (file);
-	while ((line = g_data_input_stream_read_line (stream, NULL, cancel, error))) {
-		gchar *ptr;
+			bytes += file->size;
+		}
 
-		if ((ptr = strstr (line, "DATAFILE"))) {
-			gint64 size_file;
+		for (iter = sheet->tracks; iter; iter = iter->next) {
+			BraseroImageSheetTrack *track;
 
-			ptr += 8;
-			if (brasero_image_format_get_DATAFILE_info (ptr, parent, &size_file, error))
-				cue_size += size_file;
+			track = iter->data;
+			bytes += (track->pregap + track->postgap) * 2352;
 		}
-		else if ((ptr = strstr (line, "FILE"))) {
-			gint64 size_file;
-
-			ptr += 4;
-			/* first number is the position, the second the size,
-			 * number after '#' is the offset (in bytes). */
-			if (brasero_image_format_get_FILE_info (ptr, parent, &size_file, error))
-				cue_size += size_file;
-		}
-		else if ((ptr = strstr (line, "AUDIOFILE"))) {
-			gint64 size_file;
-
-			ptr += 4;
-			/* first number is the position, the second the size,
-			 * number after '#' is the offset (in bytes). */
-			if (brasero_image_format_get_FILE_info (ptr, parent, &size_file, error))
-				cue_size += size_file;
-		}
-		else if ((ptr = strstr (line, "SILENCE"))) {
-			gint64 size_silence;
 
-			ptr += 7;
-			if (isspace (*ptr)
-			&&  brasero_image_format_get_MSF_address (ptr, &size_silence))
-				cue_size += size_silence;
-		}
-		else if ((ptr = strstr (line, "PREGAP"))) {
-			gint64 size_pregap;
+		sheet->bytes = bytes;
+		sheet->blocks = BRASERO_BYTES_TO_SECTORS (bytes, 2352);
+	}
+	else if (sheet->format == BRASERO_IMAGE_FORMAT_CDRDAO) {
+		gint64 blocks = 0;
 
-			ptr += 6;
-			if (isspace (*ptr)
-			&&  brasero_image_format_get_MSF_address (ptr, &size_pregap))
-				cue_size += size_pregap;
-		}
-		else if ((ptr = strstr (line, "ZERO"))) {
-			gint64 size_zero;
+		for (iter = sheet->tracks; iter; iter = iter->next) {
+			BraseroImageSheetTrack *track;
+			GSList *chunks;
+
+			track = iter->data;
+			blocks += track->pregap;
 
-			ptr += 4;
-			if (isspace (*ptr)
-			&&  brasero_image_format_get_MSF_address (ptr, &size_zero))
-				cue_size += size_zero;
+			for (chunks = track->chunks; chunks; chunks = chunks->next) {
+				BraseroImageSheetChunk *chunk;
+
+				chunk = chunks->data;
+				if (chunk->length >= 0) {
+					blocks += chunk->length;
+					continue;
+				}
+
+				if (!brasero_image_sheet_stat_file (chunk->file, cancel, &sheet->error))
+					return;
+
+				blocks += BRASERO_BYTES_TO_SECTORS (chunk->file->size, 2352) - chunk->start;
+			}
 		}
 
-		g_free (line);
+		sheet->blocks = blocks;
+		sheet->bytes = blocks * 2352;
 	}
-	g_object_unref (parent);
+	else if (g_str_has_suffix (uri, ".toc")) {
+		BraseroImageSheetFile *file;
 
-	g_object_unref (stream);
-	g_object_unref (file);
+		/* No known keyword so that's a clone .toc. These are set rules,
+		 * no need to parse: the image is the .toc without its suffix */
+		sheet->format = BRASERO_IMAGE_FORMAT_CLONE;
 
-	if (sectors)
-		*sectors = cue_size;
+		file = g_new0 (BraseroImageSheetFile, 1);
+		file->uri = g_strndup (uri, strlen (uri) - 4);
+		file->size = -1;
+		sheet->files = g_slist_append (sheet->files, file);
 
-	if (size_img)
-		*size_img = cue_size * 2352;
+		if (!brasero_image_sheet_stat_file (file, cancel, &sheet->error))
+			return;
 
-	return TRUE;
+		sheet->bytes = file->size;
+		sheet->blocks = BRASERO_BYTES_TO_SECTORS (file->size, 2448);
+	}
 }
 
-gboolean
-brasero_image_format_cue_bin_byte_swap (gchar *uri,
-					GCancellable *cancel,
-					GError **error)
+static BraseroImageSheet *
+brasero_image_sheet_parse (const gchar *uri,
+			   const gchar *contents,
+			   GCancellable *cancel)
 {
+	BraseroImageSheetTrack *track = NULL;
+	BraseroImageSheet *sheet;
+	gchar **lines;
+	GFile *parent;
 	GFile *file;
-	gchar *line;
-	GFileInputStream *input;
-	GDataInputStream *stream;
-	gboolean is_audio = FALSE;
-	gboolean is_binary = FALSE;
+	guint i;
+
+	sheet = g_new0 (BraseroImageSheet, 1);
+	sheet->ref = 1;
 
 	file = g_file_new_for_uri (uri);
-	input = g_file_read (file, cancel, error);
+	parent = g_file_get_parent (file);
+	g_object_unref (file);
 
-	if (!input) {
-		g_object_unref (file);
-		return FALSE;
+	lines = g_strsplit_set (contents, "\r\n", -1);
+	for (i = 0; lines [i]; i ++) {
+		gchar **tokens;
+
+		tokens = brasero_image_sheet_tokenize (lines [i]);
+		brasero_image_sheet_parse_line (sheet, &track, parent, tokens);
+		g_strfreev (tokens);
 	}
+	g_strfreev (lines);
 
-	stream = g_data_input_stream_new (G_INPUT_STREAM (input));
-	g_object_unref (input);
+	if (parent)
+		g_object_unref (parent);
 
-	while ((line = g_data_input_stream_read_line (stream, NULL, cancel, error))) {
-		const gchar *ptr;
-		
-		if ((ptr = strstr (line, "FILE"))) {
-			if (strstr (ptr, "BINARY"))
-				is_binary = TRUE;
-		}
-		else if ((ptr = strstr (line, "TRACK"))) {
-			if (strstr (ptr, "AUDIO"))
-				is_audio = TRUE;
-		}
-		g_free (line);
-	}
+	brasero_image_sheet_compute_size (sheet, uri, cancel);
 
-	g_object_unref (stream);
-	g_object_unref (file);
+	/* The data of a cue file need swapping when they are raw audio */
+	if (sheet->format == BRASERO_IMAGE_FORMAT_CUE)
+		sheet->byte_swap = sheet->has_binary && sheet->has_audio;
 
-	return is_binary && is_audio;
+	return sheet;
+}
+
+static void
+brasero_image_sheet_track_free (BraseroImageSheetTrack *track)
+{
+	g_slist_foreach (track->chunks, (GFunc) g_free, NULL);
+	g_slist_free (track->chunks);
+	g_array_free (track->indices, TRUE);
+	g_free (track->mode);
+	g_free (track);
+}
+
+static void
+brasero_image_sheet_file_free (BraseroImageSheetFile *file)
+{
+	g_free (file->uri);
+	g_free (file->type);
+	g_free (file);
+}
+
+void
+brasero_image_sheet_unref (BraseroImageSheet *sheet)
+{
+	if (!g_atomic_int_dec_and_test (&sheet->ref))
+		return;
+
+	g_slist_foreach (sheet->tracks, (GFunc) brasero_image_sheet_track_free, NULL);
+	g_slist_free (sheet->tracks);
+
+	g_slist_foreach (sheet->files, (GFunc) brasero_image_sheet_file_free, NULL);
+	g_slist_free (sheet->files);
+
+	if (sheet->error)
+		g_error_free (sheet->error);
+
+	g_free (sheet);
+}
+
+static void
+brasero_image_sheet_cache_free (gpointer data)
+{
+	BraseroImageSheetCache *cache = data;
+
+	brasero_image_sheet_unref (cache->sheet);
+	g_free (cache);
 }
 
 /**
- * .cue can use various data files but have to use them ALL. So we don't need
- * to care about a start/size address. We just go through the whole file and
- * stat every time we catch a FILE keyword.
+ * Returns the parsed sheet for @uri. It comes from the cache unless the file
+ * was modified since it was last parsed. The result must be released with
+ * brasero_image_sheet_unref (). NOTE: a sheet is returned even if one of its
+ * data files could not be stat'ed; sheet->error is set then.
  */
 
-gboolean
-brasero_image_format_get_cue_size (gchar *uri,
-				   guint64 *blocks,
-				   guint64 *size_img,
-				   GCancellable *cancel,
-				   GError **error)
+BraseroImageSheet *
+brasero_image_sheet_get (const gchar *uri,
+			 GCancellable *cancel,
+			 GError **error)
 {
+	BraseroImageSheetCache *cache;
+	BraseroImageSheet *sheet;
+	GFileInfo *info;
+	guint32 mtime_usec;
+	guint64 mtime;
+	gchar *contents;
 	GFile *file;
-	gchar *line;
-	gint64 cue_size = 0;
-	GFileInputStream *input;
-	GDataInputStream *stream;
 
 	file = g_file_new_for_uri (uri);
-	input = g_file_read (file, cancel, error);
+	info = g_file_query_info (file,
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+				  G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC,
+				  G_FILE_QUERY_INFO_NONE,
+				  cancel,
+				  error);
+	if (!info) {
+		g_object_unref (file);
+		return NULL;
+	}
+
+	mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+	mtime_usec = g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	g_object_unref (info);
+
+	G_LOCK (sheets);
+	if (sheets) {
+		cache = g_hash_table_lookup (sheets, uri);
+		if (cache
+		&&  cache->mtime == mtime
+		&&  cache->mtime_usec == mtime_usec) {
+			sheet = cache->sheet;
+			g_atomic_int_inc (&sheet->ref);
+			G_UNLOCK (sheets);
+
+			g_object_unref (file);
+			return sheet;
+		}
+	}
+	G_UNLOCK (sheets);
 
-	if (!input) {
+	if (!g_file_load_contents (file, cancel, &contents, NULL, NULL, error)) {
 		g_object_unref (file);
-		return FALSE;
+		return NULL;
 	}
+	g_object_unref (file);
 
-	stream = g_data_input_stream_new (G_INPUT_STREAM (input));
-	g_object_unref (input);
+	sheet = brasero_image_sheet_parse (uri, contents, cancel);
+	g_free (contents);
 
-	while ((line = g_data_input_stream_read_line (stream, NULL, cancel, error))) {
-		const gchar *ptr;
+	/* Don't cache a sheet whose data files are not (yet) all there */
+	if (sheet->error)
+		return sheet;
 
-		if ((ptr = strstr (line, "FILE"))) {
-			GFileInfo *info;
-			gchar *file_path;
-			GFile *file_img = NULL;
+	cache = g_new0 (BraseroImageSheetCache, 1);
+	cache->sheet = sheet;
+	cache->mtime = mtime;
+	cache->mtime_usec = mtime_usec;
+	g_atomic_int_inc (&sheet->ref);
 
-			ptr += 4;
+	G_LOCK (sheets);
+	if (!sheets)
+		sheets = g_hash_table_new_full (g_str_hash,
+						g_str_equal,
+						g_free,
+						brasero_image_sheet_cache_free);
+	else if (g_hash_table_size (sheets) >= BRASERO_IMAGE_SHEET_CACHE_MAX)
+		g_hash_table_remove_all (sheets);
 
-			/* get the path (NOTE: if ptr is NULL file_path as well) */
-			ptr = brasero_image_format_read_path (ptr, &file_path);
-			if (!ptr) {
-				g_object_unref (stream);
-				g_object_unref (file);
-				g_free (line);
-				return FALSE;
-			}
+	g_hash_table_replace (sheets, g_strdup (uri), cache);
+	G_UNLOCK (sheets);
 
-			/* check if the path is relative, if so then add the root path */
-			if (file_path && !g_path_is_absolute (file_path)) {
-				GFile *parent;
+	return sheet;
+}
 
-				parent = g_file_get_parent (file);
-				file_img = g_file_resolve_relative_path (parent, file_path);
-				g_object_unref (parent);
-			}
-			else if (file_path) {
-				gchar *img_uri;
-				gchar *scheme;
+static gchar *
+brasero_image_format_get_sheet_complement (const gchar *path)
+{
+	BraseroImageSheetFile *file;
+	BraseroImageSheet *sheet;
+	gchar *complement;
+	gchar *uri;
 
-				scheme = g_file_get_uri_scheme (file);
-				img_uri = g_strconcat (scheme, "://", file_path, NULL);
-				g_free (scheme);
+	uri = g_filename_to_uri (path, NULL, NULL);
+	sheet = uri? brasero_image_sheet_get (uri, NULL, NULL):NULL;
+	g_free (uri);
 
-				file_img = g_file_new_for_commandline_arg (img_uri);
-				g_free (img_uri);
-			}
+	if (!sheet) {
+		if (g_str_has_suffix (path, ".cue"))
+			return g_strdup_printf ("%.*sbin",
+						(int) strlen (path) - 3,
+						path);
 
-			g_free (file_path);
-
-			/* NOTE: follow symlink if any */
-			info = g_file_query_info (file_img,
-						  G_FILE_ATTRIBUTE_STANDARD_SIZE,
-						  G_FILE_QUERY_INFO_NONE,
-						  NULL,
-						  error);
-			g_object_unref (file_img);
-
-			if (!info) {
-				g_free (line);
-				g_object_unref (file);
-				g_object_unref (stream);
-				return FALSE;
-			}
+		return g_strdup_printf ("%s.bin", path);
+	}
 
-			cue_size += g_file_info_get_size (info);
-			g_object_unref (info);
-		}
-		else if ((ptr = strstr (line, "PREGAP"))) {
-			ptr += 6;
-			if (isspace (*ptr)) {
-				gint64 size_pregap;
+	/* NOTE: the problem here is that sheets can have references to
+	 * multiple files. Which is great but not for us ... */
+	if (!sheet->files) {
+		brasero_image_sheet_unref (sheet);
+		return NULL;
+	}
 
-				ptr ++;
-				ptr = brasero_image_format_get_MSF_address (ptr, &size_pregap);
-				if (ptr)
-					cue_size += size_pregap * 2352;
-			}
-		}
-		else if ((ptr = strstr (line, "POSTGAP"))) {
-			ptr += 7;
-			if (isspace (*ptr)) {
-				gint64 size_postgap;
+	file = sheet->files->data;
+	complement = g_filename_from_uri (file->uri, NULL, NULL);
+	brasero_image_sheet_unref (sheet);
 
-				ptr ++;
-				ptr = brasero_image_format_get_MSF_address (ptr, &size_postgap);
-				if (ptr)
-					cue_size += size_postgap * 2352;
-			}
-		}
+	return complement;
+}
 
-		g_free (line);
+/* FIXME this function is flawed at the moment. A cue file or toc file can 
+ * hold different paths */
+gchar *
+brasero_image_format_get_complement (BraseroImageFormat format,
+				     const gchar *path)
+{
+	gchar *retval = NULL;
+
+	if (format == BRASERO_IMAGE_FORMAT_CLONE) {
+		/* These are set rules no need to parse:
+		 * the toc file has to end with .toc suffix */
+		if (g_str_has_suffix (path, ".toc"))
+			retval = g_strndup (path, strlen (path) - 4);
+	}
+	else if (format == BRASERO_IMAGE_FORMAT_CUE
+	     ||  format == BRASERO_IMAGE_FORMAT_CDRDAO) {
+		/* need to parse */
+		retval = brasero_image_format_get_sheet_complement (path);
 	}
+	else
+		retval = NULL;
 
-	g_object_unref (stream);
-	g_object_unref (file);
+	return retval;
+}
+
+static gboolean
+brasero_image_format_get_sheet_size (gchar *uri,
+				     guint64 *blocks,
+				     guint64 *size_img,
+				     GCancellable *cancel,
+				     GError **error)
+{
+	BraseroImageSheet *sheet;
+
+	sheet = brasero_image_sheet_get (uri, cancel, error);
+	if (!sheet)
+		return FALSE;
+
+	if (sheet->error) {
+		g_propagate_error (error, g_error_copy (sheet->error));
+		brasero_image_sheet_unref (sheet);
+		return FALSE;
+	}
 
-	if (size_img)
-		*size_img = cue_size;
 	if (blocks)
-		*blocks = BRASERO_BYTES_TO_SECTORS (cue_size, 2352);
+		*blocks = sheet->blocks;
+
+	if (size_img)
+		*size_img = sheet->bytes;
 
+	brasero_image_sheet_unref (sheet);
 	return TRUE;
 }
 
+gboolean
+brasero_image_format_get_cdrdao_size (gchar *uri,
+				      guint64 *sectors,
+				      guint64 *size_img,
+				      GCancellable *cancel,
+				      GError **error)
+{
+	return brasero_image_format_get_sheet_size (uri, sectors, size_img, cancel, error);
+}
+
+gboolean
+brasero_image_format_cue_bin_byte_swap (gchar *uri,
+					GCancellable *cancel,
+					GError **error)
+{
+	BraseroImageSheet *sheet;
+	gboolean retval;
+
+	sheet = brasero_image_sheet_get (uri, cancel, error);
+	if (!sheet)
+		return FALSE;
+
+	retval = sheet->byte_swap;
+	brasero_image_sheet_unref (sheet);
+
+	return retval;
+}
+
+gboolean
+brasero_image_format_get_cue_size (gchar *uri,
+				   guint64 *blocks,
+				   guint64 *size_img,
+				   GCancellable *cancel,
+				   GError **error)
+{
+	return brasero_image_format_get_sheet_size (uri, blocks, size_img, cancel, error);
+}
+
 BraseroImageFormat
 brasero_image_format_identify_cuesheet (const gchar *uri,
 					GCancellable *cancel,
 					GError **error)
 {
-	GFile *file;
-	gchar *line;
-	GFileInputStream *input;
-	GDataInputStream *stream;
+	BraseroImageSheet *sheet;
 	BraseroImageFormat format;
 
-	file = g_file_new_for_uri (uri);
-	input = g_file_read (file, cancel, error);
-	if (!input) {
-		g_object_unref (file);
-		return FALSE;
-	}
+	sheet = brasero_image_sheet_get (uri, cancel, error);
+	if (!sheet)
+		return BRASERO_IMAGE_FORMAT_NONE;
 
-	stream = g_data_input_stream_new (G_INPUT_STREAM (input));
-	g_object_unref (input);
-
-	format = BRASERO_IMAGE_FORMAT_NONE;
-	while ((line = g_data_input_stream_read_line (stream, NULL, cancel, error))) {
-		/* Keywords for cdrdao cuesheets */
-		if (strstr (line, "CD_ROM_XA")
-		||  strstr (line, "CD_ROM")
-		||  strstr (line, "CD_DA")
-		||  strstr (line, "CD_TEXT")) {
-			format = BRASERO_IMAGE_FORMAT_CDRDAO;
-			g_free (line);
-			break;
-		}
-		else if (strstr (line, "TRACK")) {
-			/* NOTE: there is also "AUDIO" but it's common to both */
-
-			/* CDRDAO */
-			if (strstr (line, "MODE1")
-			||  strstr (line, "MODE1_RAW")
-			||  strstr (line, "MODE2_FORM1")
-			||  strstr (line, "MODE2_FORM2")
-			||  strstr (line, "MODE_2_RAW")
-			||  strstr (line, "MODE2_FORM_MIX")
-			||  strstr (line, "MODE2")) {
-				format = BRASERO_IMAGE_FORMAT_CDRDAO;
-				g_free (line);
-				break;
-			}
+	/* Clone .toc files can't be identified through their contents */
+	format = sheet->format;
+	if (format == BRASERO_IMAGE_FORMAT_CLONE)
+		format = BRASERO_IMAGE_FORMAT_NONE;
 
-			/* .CUE file */
-			else if (strstr (line, "CDG")
-			     ||  strstr (line, "MODE1/2048")
-			     ||  strstr (line, "MODE1/2352")
-			     ||  strstr (line, "MODE2/2336")
-			     ||  strstr (line, "MODE2/2352")
-			     ||  strstr (line, "CDI/2336")
-			     ||  strstr (line, "CDI/2352")) {
-				format = BRASERO_IMAGE_FORMAT_CUE;
-				g_free (line);
-				break;
-			}
-		}
-		else if (strstr (line, "FILE")) {
-			if (strstr (line, "MOTOROLA")
-			||  strstr (line, "BINARY")
-			||  strstr (line, "AIFF")
-			||  strstr (line, "WAVE")
-			||  strstr (line, "MP3")) {
-				format = BRASERO_IMAGE_FORMAT_CUE;
-				g_free (line);
-				break;
-			}
-		}
-		g_free (line);
-		line = NULL;
-	}
-
-	g_object_unref (stream);
-	g_object_unref (file);
+	brasero_image_sheet_unref (sheet);
 
 	BRASERO_BURN_LOG_WITH_FULL_TYPE (BRASERO_TRACK_TYPE_IMAGE,
 					 format,
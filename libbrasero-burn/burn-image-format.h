@@ -37,6 +37,64 @@
 
 G_BEGIN_DECLS
 
+typedef struct _BraseroImageSheetFile BraseroImageSheetFile;
+struct _BraseroImageSheetFile {
+	gchar *uri;
+	gchar *type;			/* .cue only: BINARY, MOTOROLA, WAVE ... */
+	goffset size;			/* in bytes, -1 if not stat'ed */
+};
+
+/* A chunk is a part of a .toc track: a piece of a data file or silence */
+typedef struct _BraseroImageSheetChunk BraseroImageSheetChunk;
+struct _BraseroImageSheetChunk {
+	BraseroImageSheetFile *file;	/* NULL for silence */
+	gint64 start;			/* in sectors */
+	gint64 length;			/* in sectors, -1 up to the end of file */
+};
+
+typedef struct _BraseroImageSheetTrack BraseroImageSheetTrack;
+struct _BraseroImageSheetTrack {
+	guint number;
+	gchar *mode;
+
+	BraseroImageSheetFile *file;	/* .cue only */
+	GSList *chunks;			/* .toc only */
+
+	GArray *indices;		/* gint64 addresses in sectors */
+	gint64 pregap;
+	gint64 postgap;
+};
+
+typedef struct _BraseroImageSheet BraseroImageSheet;
+struct _BraseroImageSheet {
+	BraseroImageFormat format;
+
+	GSList *files;
+	GSList *tracks;
+
+	guint64 blocks;
+	guint64 bytes;
+
+	/* Set when a data file could not be stat'ed */
+	GError *error;
+
+	guint byte_swap:1;
+
+	/* private */
+	BraseroImageSheetFile *cue_file;
+	guint has_binary:1;
+	guint has_audio:1;
+	gint ref;
+};
+
+BraseroImageSheet *
+brasero_image_sheet_get (const gchar *uri,
+			 GCancellable *cancel,
+			 GError **error);
+
+void
+brasero_image_sheet_unref (BraseroImageSheet *sheet);
+
 BraseroImageFormat
 brasero_image_format_identify_cuesheet (const gchar *path,
 					GCancellable *cancel,
@@ -0,0 +1,520 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <pthread.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n-lib.h>
+#include <gio/gio.h>
+
+#include "brasero-error.h"
+#include "burn-debug.h"
+#include "burn-jitter-buffer.h"
+
+#define BRASERO_JITTER_BUFFER_CHUNK		65536
+#define BRASERO_JITTER_BUFFER_READ_RETRIES	5
+
+typedef enum {
+	BRASERO_JITTER_BUFFER_PREFILL,
+	BRASERO_JITTER_BUFFER_STREAMING,
+	BRASERO_JITTER_BUFFER_SPILLING
+} BraseroJitterBufferState;
+
+struct _BraseroJitterBuffer {
+	int fd_in;
+	int fd_out;
+	int fd_spill;
+
+	/* Ring buffer */
+	guchar *data;
+	gsize size;
+	gsize start;
+	gsize fill;
+
+	gsize prefill;
+
+	guint64 write_rate;
+	guint64 source_size;
+	gchar *tmpdir;
+
+	guchar *chunk;
+
+	GThread *thread;
+	gint cancel;
+
+	GTimer *timer;
+	BraseroJitterBufferState state;
+
+	guint64 read_bytes;
+	guint64 written_bytes;
+	guint64 spilled_bytes;
+	gsize min_fill;
+	guint retries;
+
+	guint eof:1;
+};
+
+static gboolean
+brasero_jitter_buffer_has_space (BraseroJitterBuffer *self)
+{
+	GFileInfo *info;
+	guint64 needed;
+	guint64 free;
+	GFile *file;
+
+	/* Without the size of the source we can't know whether it fits */
+	if (!self->source_size)
+		return FALSE;
+
+	needed = self->source_size > self->read_bytes ? self->source_size - self->read_bytes:0;
+
+	file = g_file_new_for_path (self->tmpdir);
+	info = g_file_query_filesystem_info (file,
+					     G_FILE_ATTRIBUTE_FILESYSTEM_FREE,
+					     NULL,
+					     NULL);
+	g_object_unref (file);
+	if (!info)
+		return FALSE;
+
+	free = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_FILESYSTEM_FREE);
+	g_object_unref (info);
+
+	BRASERO_BURN_LOG ("Volume size %" G_GUINT64_FORMAT ", needed %" G_GUINT64_FORMAT, free, needed);
+	return (free >= needed);
+}
+
+static void
+brasero_jitter_buffer_spill (BraseroJitterBuffer *self)
+{
+	gchar *path;
+
+	if (!brasero_jitter_buffer_has_space (self)) {
+		BRASERO_BURN_LOG ("Not enough space to store the stream in %s; keep streaming", self->tmpdir);
+		self->state = BRASERO_JITTER_BUFFER_STREAMING;
+		return;
+	}
+
+	/* The ring keeps the beginning of the stream; all that is read from
+	 * now on goes to a file and is only written once the source is read
+	 * entirely. That's an image in all but name. */
+	path = g_build_filename (self->tmpdir, "brasero-stream-XXXXXX", NULL);
+	self->fd_spill = g_mkstemp (path);
+	if (self->fd_spill < 0) {
+		BRASERO_BURN_LOG ("Temporary file for the stream could not be created (%s); keep streaming",
+				  g_strerror (errno));
+		self->fd_spill = -1;
+		self->state = BRASERO_JITTER_BUFFER_STREAMING;
+	}
+	else {
+		/* Removed as soon as we close it */
+		g_remove (path);
+		self->state = BRASERO_JITTER_BUFFER_SPILLING;
+	}
+
+	g_free (path);
+}
+
+static void
+brasero_jitter_buffer_update_state (BraseroJitterBuffer *self)
+{
+	switch (self->state) {
+	case BRASERO_JITTER_BUFFER_PREFILL:
+		if (self->fill < self->prefill && !self->eof)
+			break;
+
+		if (!self->eof && self->write_rate && self->timer) {
+			gdouble elapsed;
+			guint64 read_rate;
+
+			elapsed = g_timer_elapsed (self->timer, NULL);
+			read_rate = elapsed > 0.0 ? (guint64) (self->read_bytes / elapsed) : G_MAXUINT64;
+
+			BRASERO_BURN_LOG ("Jitter buffer prefilled with %" G_GSIZE_FORMAT " bytes in %.2f s (read rate %" G_GUINT64_FORMAT " B/s, write rate %" G_GUINT64_FORMAT " B/s)",
+					  self->fill,
+					  elapsed,
+					  read_rate,
+					  self->write_rate);
+
+			if (read_rate < self->write_rate) {
+				BRASERO_BURN_LOG ("Source too slow for streaming, falling back to an image");
+				brasero_jitter_buffer_spill (self);
+				break;
+			}
+		}
+
+		self->state = BRASERO_JITTER_BUFFER_STREAMING;
+		break;
+
+	case BRASERO_JITTER_BUFFER_SPILLING:
+		if (!self->eof)
+			break;
+
+		BRASERO_BURN_LOG ("Source read (%" G_GUINT64_FORMAT " bytes spilled), writing", self->spilled_bytes);
+		lseek (self->fd_spill, 0, SEEK_SET);
+		self->state = BRASERO_JITTER_BUFFER_STREAMING;
+		break;
+
+	case BRASERO_JITTER_BUFFER_STREAMING:
+		if (self->eof)
+			break;
+
+		/* The recorder is always fed what we have: holding data back
+		 * would only cause the underrun we're here to avoid */
+		if (self->fill < self->min_fill)
+			self->min_fill = self->fill;
+		break;
+	}
+}
+
+static gboolean
+brasero_jitter_buffer_read (BraseroJitterBuffer *self)
+{
+	ssize_t bytes;
+
+	if (self->state == BRASERO_JITTER_BUFFER_SPILLING) {
+		bytes = read (self->fd_in, self->chunk, BRASERO_JITTER_BUFFER_CHUNK);
+		if (bytes > 0) {
+			gsize written = 0;
+
+			while (written < (gsize) bytes) {
+				ssize_t res;
+
+				res = write (self->fd_spill, self->chunk + written, bytes - written);
+				if (res < 0) {
+					if (errno == EINTR)
+						continue;
+
+					BRASERO_BURN_LOG ("Writing to the temporary file failed (%s)", g_strerror (errno));
+					return FALSE;
+				}
+				written += res;
+			}
+
+			self->spilled_bytes += bytes;
+		}
+	}
+	else {
+		gsize pos;
+		gsize len;
+
+		pos = (self->start + self->fill) % self->size;
+		len = MIN (self->size - self->fill, self->size - pos);
+		bytes = read (self->fd_in, self->data + pos, len);
+		if (bytes > 0)
+			self->fill += bytes;
+	}
+
+	if (bytes == 0) {
+		BRASERO_BURN_LOG ("End of source reached after %" G_GUINT64_FORMAT " bytes", self->read_bytes);
+		self->eof = TRUE;
+		return TRUE;
+	}
+
+	if (bytes < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return TRUE;
+
+		/* Give the reader a chance to recover */
+		if (self->retries ++ < BRASERO_JITTER_BUFFER_READ_RETRIES) {
+			BRASERO_BURN_LOG ("Read error (%s), retrying", g_strerror (errno));
+			g_usleep (G_USEC_PER_SEC / 10 * self->retries);
+			return TRUE;
+		}
+
+		BRASERO_BURN_LOG ("Read error (%s)", g_strerror (errno));
+		return FALSE;
+	}
+
+	if (!self->timer)
+		self->timer = g_timer_new ();
+
+	self->retries = 0;
+	self->read_bytes += bytes;
+	return TRUE;
+}
+
+static gboolean
+brasero_jitter_buffer_refill (BraseroJitterBuffer *self)
+{
+	ssize_t bytes;
+	gsize pos;
+	gsize len;
+
+	pos = (self->start + self->fill) % self->size;
+	len = MIN (self->size - self->fill, self->size - pos);
+	if (!len)
+		return TRUE;
+
+	bytes = read (self->fd_spill, self->data + pos, len);
+	if (bytes < 0) {
+		if (errno == EINTR)
+			return TRUE;
+
+		BRASERO_BURN_LOG ("Reading the temporary file failed (%s)", g_strerror (errno));
+		return FALSE;
+	}
+
+	if (!bytes) {
+		close (self->fd_spill);
+		self->fd_spill = -1;
+		return TRUE;
+	}
+
+	self->fill += bytes;
+	return TRUE;
+}
+
+static gboolean
+brasero_jitter_buffer_write (BraseroJitterBuffer *self)
+{
+	ssize_t bytes;
+
+	bytes = write (self->fd_out,
+		       self->data + self->start,
+		       MIN (self->fill, self->size - self->start));
+	if (bytes < 0) {
+		if (errno == EAGAIN || errno == EINTR)
+			return TRUE;
+
+		BRASERO_BURN_LOG ("Write error (%s)", g_strerror (errno));
+		return FALSE;
+	}
+
+	self->start = (self->start + bytes) % self->size;
+	self->fill -= bytes;
+	self->written_bytes += bytes;
+	return TRUE;
+}
+
+static gpointer
+brasero_jitter_buffer_thread (gpointer data)
+{
+	BraseroJitterBuffer *self = data;
+	sigset_t set;
+
+	/* A recorder going away must not kill us */
+	sigemptyset (&set);
+	sigaddset (&set, SIGPIPE);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+	while (!g_atomic_int_get (&self->cancel)) {
+		struct pollfd fds [2];
+		int in_index = -1;
+		int out_index = -1;
+		nfds_t nfds = 0;
+		int res;
+
+		brasero_jitter_buffer_update_state (self);
+
+		/* Once the source is read, empty the spill file */
+		if (self->eof
+		&&  self->fd_spill != -1
+		&&  self->state == BRASERO_JITTER_BUFFER_STREAMING
+		&& !brasero_jitter_buffer_refill (self))
+			break;
+
+		if (self->eof && !self->fill && self->fd_spill == -1)
+			break;
+
+		if (!self->eof
+		&& (self->state == BRASERO_JITTER_BUFFER_SPILLING || self->fill < self->size)) {
+			fds [nfds].fd = self->fd_in;
+			fds [nfds].events = POLLIN;
+			in_index = nfds ++;
+		}
+
+		if (self->fill && self->state == BRASERO_JITTER_BUFFER_STREAMING) {
+			fds [nfds].fd = self->fd_out;
+			fds [nfds].events = POLLOUT;
+			out_index = nfds ++;
+		}
+
+		if (!nfds)
+			continue;
+
+		res = poll (fds, nfds, 500);
+		if (res < 0) {
+			if (errno == EINTR)
+				continue;
+
+			BRASERO_BURN_LOG ("Poll error (%s)", g_strerror (errno));
+			break;
+		}
+
+		if (in_index >= 0 && fds [in_index].revents
+		&& !brasero_jitter_buffer_read (self))
+			break;
+
+		if (out_index >= 0) {
+			if (fds [out_index].revents & (POLLERR|POLLHUP)) {
+				BRASERO_BURN_LOG ("Recorder closed its input");
+				break;
+			}
+
+			if ((fds [out_index].revents & POLLOUT)
+			&& !brasero_jitter_buffer_write (self))
+				break;
+		}
+	}
+
+	BRASERO_BURN_LOG ("Jitter buffer: %" G_GUINT64_FORMAT " bytes read, %" G_GUINT64_FORMAT " written, %" G_GUINT64_FORMAT " spilled, lowest fill %" G_GSIZE_FORMAT " / %" G_GSIZE_FORMAT,
+			  self->read_bytes,
+			  self->written_bytes,
+			  self->spilled_bytes,
+			  self->min_fill,
+			  self->size);
+
+	/* Closing both ends tells the reader and the recorder we're done */
+	close (self->fd_in);
+	self->fd_in = -1;
+
+	close (self->fd_out);
+	self->fd_out = -1;
+
+	if (self->fd_spill != -1) {
+		close (self->fd_spill);
+		self->fd_spill = -1;
+	}
+
+	return NULL;
+}
+
+/**
+ * @fd_in and @fd_out are owned by the buffer from now on. @prefill bytes
+ * are buffered before the first byte goes to @fd_out. If the source turns
+ * out to be slower than @write_rate (bytes per second) while prefilling,
+ * the rest of the source (@source_size bytes in all) is buffered in @tmpdir
+ * first, provided there is enough free space there.
+ */
+
+BraseroJitterBuffer *
+brasero_jitter_buffer_new (int fd_in,
+			   int fd_out,
+			   gsize size,
+			   gsize prefill,
+			   guint64 write_rate,
+			   guint64 source_size,
+			   const gchar *tmpdir)
+{
+	BraseroJitterBuffer *self;
+
+	self = g_new0 (BraseroJitterBuffer, 1);
+	self->fd_in = fd_in;
+	self->fd_out = fd_out;
+	self->fd_spill = -1;
+
+	self->size = size;
+	self->prefill = MIN (prefill, size);
+	self->min_fill = size;
+
+	self->write_rate = write_rate;
+	self->source_size = source_size;
+	self->tmpdir = g_strdup (tmpdir);
+
+	self->state = BRASERO_JITTER_BUFFER_PREFILL;
+	return self;
+}
+
+gboolean
+brasero_jitter_buffer_start (BraseroJitterBuffer *self,
+			     GError **error)
+{
+	long flags = 0;
+
+	/* Our ends only; the children keep blocking descriptors */
+	flags = fcntl (self->fd_in, F_GETFL);
+	fcntl (self->fd_in, F_SETFL, flags | O_NONBLOCK);
+	flags = fcntl (self->fd_out, F_GETFL);
+	fcntl (self->fd_out, F_SETFL, flags | O_NONBLOCK);
+
+	self->data = g_try_malloc (self->size);
+	if (!self->data) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     g_strerror (ENOMEM));
+		return FALSE;
+	}
+
+	self->chunk = g_malloc (BRASERO_JITTER_BUFFER_CHUNK);
+
+	BRASERO_BURN_LOG ("Starting jitter buffer (%" G_GSIZE_FORMAT " bytes, prefill %" G_GSIZE_FORMAT ")",
+			  self->size,
+			  self->prefill);
+
+	self->thread = g_thread_create (brasero_jitter_buffer_thread,
+					self,
+					TRUE,
+					error);
+	return (self->thread != NULL);
+}
+
+void
+brasero_jitter_buffer_free (BraseroJitterBuffer *self)
+{
+	if (!self)
+		return;
+
+	if (self->thread) {
+		g_atomic_int_set (&self->cancel, 1);
+		g_thread_join (self->thread);
+		self->thread = NULL;
+	}
+
+	if (self->fd_in != -1)
+		close (self->fd_in);
+
+	if (self->fd_out != -1)
+		close (self->fd_out);
+
+	if (self->fd_spill != -1)
+		close (self->fd_spill);
+
+	if (self->timer)
+		g_timer_destroy (self->timer);
+
+	g_free (self->chunk);
+	g_free (self->data);
+	g_free (self->tmpdir);
+	g_free (self);
+}
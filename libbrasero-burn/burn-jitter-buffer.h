@@ -0,0 +1,63 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef BURN_JITTER_BUFFER_H
+#define BURN_JITTER_BUFFER_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * Sits between a reader writing to a pipe and a recorder reading another one
+ * to absorb the irregular throughput of the reader.
+ */
+
+typedef struct _BraseroJitterBuffer BraseroJitterBuffer;
+
+BraseroJitterBuffer *
+brasero_jitter_buffer_new (int fd_in,
+			   int fd_out,
+			   gsize size,
+			   gsize prefill,
+			   guint64 write_rate,
+			   guint64 source_size,
+			   const gchar *tmpdir);
+
+gboolean
+brasero_jitter_buffer_start (BraseroJitterBuffer *buffer,
+			     GError **error);
+
+void
+brasero_jitter_buffer_free (BraseroJitterBuffer *buffer);
+
+G_END_DECLS
+
+#endif /* BURN_JITTER_BUFFER_H */
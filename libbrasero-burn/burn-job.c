@@ -56,6 +56,8 @@
 #include "burn-job.h"
 #include "burn-task-ctx.h"
 #include "burn-task-item.h"
+#include "burn-jitter-buffer.h"
+#include "brasero-tags.h"
 #include "libbrasero-marshal.h"
 
 #include "brasero-track-type-private.h"
@@ -68,8 +70,13 @@ typedef struct _BraseroJobOutput {
 typedef struct _BraseroJobInput {
 	int out;
 	int in;
+
+	BraseroJitterBuffer *buffer;
 } BraseroJobInput;
 
+#define BRASERO_JOB_STREAM_BUFFER_SIZE		64	/* MiB */
+#define BRASERO_JOB_STREAM_BUFFER_PREFILL	75	/* % */
+
 static void brasero_job_iface_init_task_item (BraseroTaskItemIFace *iface);
 G_DEFINE_TYPE_WITH_CODE (BraseroJob, brasero_job, G_TYPE_OBJECT,
 			 G_IMPLEMENT_INTERFACE (BRASERO_TYPE_TASK_ITEM,
@@ -226,6 +233,9 @@ brasero_job_input_free (BraseroJobInput *input)
 	if (input->out > 0)
 		close (input->out);
 
+	/* Closing the above first makes the buffer thread stop */
+	brasero_jitter_buffer_free (input->buffer);
+
 	g_free (input);
 }
 
@@ -647,6 +657,7 @@ brasero_job_set_output_file (BraseroJob *self,
 			/* NOTE: no need to check for the existence here */
 			result = brasero_burn_session_get_tmp_image (session,
 								     priv->type.subtype.img_format,
+								     output_size > 0? output_size:-1,
 								     &image,
 								     &toc,
 								     error);
@@ -676,6 +687,11 @@ brasero_job_set_output_file (BraseroJob *self,
 	priv->output->image = image;
 	priv->output->toc = toc;
 
+	/* There is no volume to check for images staged in memory; the
+	 * session made sure they fit in the budget. */
+	if (brasero_burn_session_is_tmp_image_in_memory (session, image))
+		return result;
+
 	if (brasero_burn_session_get_flags (session) & BRASERO_BURN_FLAG_CHECK_SIZE)
 		return brasero_job_check_output_volume_space (self, error);
 
@@ -706,6 +722,92 @@ brasero_job_get_next_active (BraseroJob *self)
 	return NULL;
 }
 
+/**
+ * When a disc is copied on the fly, the reader has an irregular throughput
+ * (seeks, retries on a bad sector) which can make the recorder underrun.
+ * Put a buffer between both pipes to absorb that.
+ */
+
+static BraseroBurnResult
+brasero_job_input_add_buffer (BraseroJob *self,
+			      BraseroJobInput *input,
+			      GError **error)
+{
+	BraseroBurnSession *session;
+	BraseroJobPrivate *priv;
+	BraseroTrackType *type;
+	gboolean has_medium;
+	goffset source_size = 0;
+	GValue *value = NULL;
+	gint64 size;
+	gint prefill;
+	int fd [2];
+
+	priv = BRASERO_JOB_PRIVATE (self);
+	session = brasero_task_ctx_get_session (priv->ctx);
+
+	type = brasero_track_type_new ();
+	brasero_burn_session_get_input_type (session, type);
+	has_medium = brasero_track_type_get_has_medium (type);
+	brasero_track_type_free (type);
+
+	if (!has_medium)
+		return BRASERO_BURN_OK;
+
+	size = BRASERO_JOB_STREAM_BUFFER_SIZE;
+	brasero_burn_session_tag_lookup (session,
+					 BRASERO_SESSION_STREAM_BUFFER_SIZE,
+					 &value);
+	if (value) {
+		if (g_value_get_int (value) < 0) {
+			BRASERO_JOB_LOG (self, "stream buffer disabled");
+			return BRASERO_BURN_OK;
+		}
+
+		if (g_value_get_int (value) > 0)
+			size = g_value_get_int (value);
+	}
+
+	prefill = brasero_burn_session_tag_lookup_int (session, BRASERO_SESSION_STREAM_BUFFER_PREFILL);
+	if (prefill <= 0 || prefill > 100)
+		prefill = BRASERO_JOB_STREAM_BUFFER_PREFILL;
+
+	if (pipe (fd)) {
+                int errsv = errno;
+
+		BRASERO_BURN_LOG ("A pipe couldn't be created");
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("An internal error occurred (%s)"),
+			     g_strerror (errsv));
+
+		return BRASERO_BURN_ERR;
+	}
+
+	/* Needed to know whether the source fits in the temporary directory
+	 * should it be too slow to be streamed */
+	if (brasero_burn_session_get_size (session, NULL, &source_size) != BRASERO_BURN_OK)
+		source_size = 0;
+
+	/* The reader still writes to input->out but we read the other end
+	 * of its pipe and write to a new one for the recorder */
+	size *= 1024 * 1024;
+	input->buffer = brasero_jitter_buffer_new (input->in,
+						   fd [1],
+						   size,
+						   size * prefill / 100,
+						   brasero_burn_session_get_rate (session),
+						   source_size,
+						   brasero_burn_session_get_tmpdir (session));
+	input->in = fd [0];
+
+	if (!brasero_jitter_buffer_start (input->buffer, error))
+		return BRASERO_BURN_ERR;
+
+	return BRASERO_BURN_OK;
+}
+
 static BraseroBurnResult
 brasero_job_item_start (BraseroTaskItem *item,
 		        GError **error)
@@ -776,6 +878,12 @@ brasero_job_item_start (BraseroTaskItem *item,
 		priv->input = g_new0 (BraseroJobInput, 1);
 		priv->input->in = fd [0];
 		priv->input->out = fd [1];
+
+		if (action == BRASERO_JOB_ACTION_RECORD) {
+			result = brasero_job_input_add_buffer (self, priv->input, error);
+			if (result != BRASERO_BURN_OK)
+				return result;
+		}
 	}
 
 	klass = BRASERO_JOB_GET_CLASS (self);
@@ -1905,6 +2013,25 @@ brasero_job_set_rate (BraseroJob *self,
 	return brasero_task_ctx_set_rate (priv->ctx, rate);
 }
 
+/**
+ * Recording jobs tell here how full (in %) the fifo of the tool and the
+ * buffer of the drive are; -1 for a buffer whose level is unknown.
+ */
+
+BraseroBurnResult
+brasero_job_set_buffer_fill (BraseroJob *self,
+			     gint fifo,
+			     gint drive)
+{
+	BraseroJobPrivate *priv;
+
+	priv = BRASERO_JOB_PRIVATE (self);
+	if (priv->next)
+		return BRASERO_BURN_NOT_RUNNING;
+
+	return brasero_task_ctx_set_buffer_fill (priv->ctx, fifo, drive);
+}
+
 BraseroBurnResult
 brasero_job_set_output_size_for_current_track (BraseroJob *self,
 					       goffset sectors,
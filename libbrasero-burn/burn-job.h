@@ -265,6 +265,10 @@ BraseroBurnResult
 brasero_job_set_rate (BraseroJob *job,
 		      gint64 rate);
 BraseroBurnResult
+brasero_job_set_buffer_fill (BraseroJob *job,
+			     gint fifo,
+			     gint drive);
+BraseroBurnResult
 brasero_job_set_written_track (BraseroJob *job,
 			       goffset written);
 BraseroBurnResult
@@ -34,11 +34,14 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/param.h>
 #include <fcntl.h>
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
 #include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
 
 
 #include <glib.h>
@@ -49,78 +52,190 @@
 #include "burn-basics.h"
 #include "burn-debug.h"
 #include "brasero-track.h"
+#include "brasero-track-data.h"
 #include "burn-mkisofs-base.h"
 
+/* Size of the buffer of a list before it is written */
+#define BRASERO_MKISOFS_LIST_BUFFER	65536
+
+/* How long a writer waits for mkisofs to open a list (in ms) */
+#define BRASERO_MKISOFS_LIST_TIMEOUT	60000
+
+/* How long a job waits for a writer to finish once mkisofs exited (in ms) */
+#define BRASERO_MKISOFS_LIST_CHECK_TIMEOUT	2000
+
 struct _BraseroMkisofsBase {
 	const gchar *emptydir;
 	const gchar *videodir;
 
-	gint grafts_fd;
-	gint excluded_fd;
-
+	/* URI => list of graft points */
 	GHashTable *grafts;
 
+	/* Local paths of all graft points; excluded URIs that are not
+	 * below one of them would never be met by mkisofs */
+	GHashTable *graft_paths;
+
+	/* graft points of the directories without URI */
+	GSList *empty;
+
+	/* Our own copies of what the track gave us since the lists can be
+	 * written after brasero_mkisofs_base_write_to_files () returned */
+	GSList *copies;
+	GSList *excluded;
+
+	gint ref;
+
 	guint found_video_ts:1;
 	guint use_joliet:1;
 };
 typedef struct _BraseroMkisofsBase BraseroMkisofsBase;
 
+struct _BraseroMkisofsList {
+	gint fd;
+	GString *buffer;
+	guint lines;
+};
+typedef struct _BraseroMkisofsList BraseroMkisofsList;
+
+typedef BraseroBurnResult (*BraseroMkisofsListFunc)	(BraseroMkisofsBase *base,
+							 BraseroMkisofsList *list,
+							 GError **error);
+
+/* Outcome of a list written by a thread, kept until the job checks it */
+struct _BraseroMkisofsListStatus {
+	GError *error;
+
+	guint running:1;
+	guint forgotten:1;
+};
+typedef struct _BraseroMkisofsListStatus BraseroMkisofsListStatus;
+
+struct _BraseroMkisofsWriter {
+	BraseroMkisofsBase *base;
+	BraseroMkisofsListFunc func;
+	BraseroMkisofsListStatus *status;
+	gchar *path;
+};
+typedef struct _BraseroMkisofsWriter BraseroMkisofsWriter;
+
+/* path => BraseroMkisofsListStatus */
+static GHashTable *list_status = NULL;
+G_LOCK_DEFINE_STATIC (list_status);
+
 struct _BraseroWriteGraftData {
 	BraseroMkisofsBase *base;
+	BraseroMkisofsList *list;
 	GError **error;
 };
 typedef struct _BraseroWriteGraftData BraseroWriteGraftData;
 
 static void
-brasero_mkisofs_base_clean (BraseroMkisofsBase *base)
+brasero_mkisofs_base_unref (BraseroMkisofsBase *base)
 {
-	/* now we clean base we have the most important :
-	 * graft and excluded list, flags and that's what
-	 * we're going to use when we'll start the image 
-	 * creation */
-	if (base->grafts_fd)
-		close (base->grafts_fd);
-	if (base->excluded_fd)
-		close (base->excluded_fd);
-	if (base->grafts) {
+	/* The base is shared by the two writers */
+	if (!g_atomic_int_dec_and_test (&base->ref))
+		return;
+
+	if (base->grafts)
 		g_hash_table_destroy (base->grafts);
-		base->grafts = NULL;
-	}
+
+	if (base->graft_paths)
+		g_hash_table_destroy (base->graft_paths);
+
+	g_slist_foreach (base->empty, (GFunc) g_free, NULL);
+	g_slist_free (base->empty);
+
+	g_slist_foreach (base->copies, (GFunc) brasero_graft_point_free, NULL);
+	g_slist_free (base->copies);
+
+	g_slist_foreach (base->excluded, (GFunc) g_free, NULL);
+	g_slist_free (base->excluded);
+
+	g_free (base);
 }
 
 static BraseroBurnResult
-_write_line (int fd, const gchar *filepath, GError **error)
+_flush_list (BraseroMkisofsList *list, GError **error)
 {
-	gint len;
-	gint w_len;
+	gsize written = 0;
+
+	while (written < list->buffer->len) {
+		gssize w_len;
+
+		w_len = write (list->fd,
+			       list->buffer->str + written,
+			       list->buffer->len - written);
+		if (w_len < 0) {
+			if (errno == EINTR)
+				continue;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     "%s",
+				     g_strerror (errno));
+			return BRASERO_BURN_ERR;
+		}
 
-	if (lseek (fd, 0, SEEK_CUR)
-	&&  write (fd, "\n", 1) != 1) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
+		written += w_len;
 	}
 
-	len = strlen (filepath);
-	w_len = write (fd, filepath, len);
+	g_string_truncate (list->buffer, 0);
+	return BRASERO_BURN_OK;
+}
 
-	if (w_len != len) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
+static BraseroBurnResult
+_write_line (BraseroMkisofsList *list, const gchar *filepath, GError **error)
+{
+	if (list->lines)
+		g_string_append_c (list->buffer, '\n');
+
+	g_string_append (list->buffer, filepath);
+	list->lines ++;
+
+	if (list->buffer->len < BRASERO_MKISOFS_LIST_BUFFER)
+		return BRASERO_BURN_OK;
+
+	return _flush_list (list, error);
+}
+
+static gchar *
+_uri_to_path (const gchar *uri)
+{
+	if (uri [0] == '/')
+		return g_strdup (uri);
+
+	return g_filename_from_uri (uri, NULL, NULL);
+}
+
+static gboolean
+brasero_mkisofs_base_is_below_graft (BraseroMkisofsBase *base,
+				     const gchar *uri)
+{
+	gboolean result = FALSE;
+	gchar *path;
+	gchar *end;
+
+	path = _uri_to_path (uri);
+	if (!path)
+		return TRUE;
+
+	/* check all parents */
+	while ((end = strrchr (path, G_DIR_SEPARATOR)) && end != path) {
+		*end = '\0';
+		if (g_hash_table_lookup (base->graft_paths, path)) {
+			result = TRUE;
+			break;
+		}
 	}
 
-	return BRASERO_BURN_OK;
+	g_free (path);
+	return result;
 }
 
 static BraseroBurnResult
 brasero_mkisofs_base_write_excluded (BraseroMkisofsBase *base,
+				     BraseroMkisofsList *list,
 				     const gchar *uri,
 				     GError **error)
 {
@@ -202,7 +317,7 @@ brasero_mkisofs_base_write_excluded (BraseroMkisofsBase *base,
 	/* we just ignore if localpath is NULL:
 	 * - it could be a non local whose graft point couldn't be downloaded */
 	if (localpath)
-		result = _write_line (base->excluded_fd, localpath, error);
+		result = _write_line (list, localpath, error);
 
 	g_free (localpath);
 	return result;
@@ -282,6 +397,7 @@ _build_graft_point (const gchar *uri, const gchar *discpath)
 
 static BraseroBurnResult
 brasero_mkisofs_base_write_graft (BraseroMkisofsBase *base,
+				  BraseroMkisofsList *list,
 				  const gchar *uri,
 				  const gchar *disc_path,
 				  GError **error)
@@ -303,7 +419,7 @@ brasero_mkisofs_base_write_graft (BraseroMkisofsBase *base,
 		return BRASERO_BURN_ERR;
 	}
 
-	result = _write_line (base->grafts_fd, graft_point, error);
+	result = _write_line (list, graft_point, error);
 	g_free (graft_point);
 	if (result != BRASERO_BURN_OK)
 		return result;
@@ -324,6 +440,7 @@ _foreach_write_grafts (const gchar *uri,
 
 		if (!graft->path) {
 			result = brasero_mkisofs_base_write_graft (data->base,
+								   data->list,
 								   graft->uri,
 								   NULL,
 								   data->error);
@@ -334,6 +451,7 @@ _foreach_write_grafts (const gchar *uri,
 		}
 
 		result = brasero_mkisofs_base_write_graft (data->base,
+							   data->list,
 							   graft->uri,
 							   graft->path,
 							   data->error);
@@ -346,13 +464,25 @@ _foreach_write_grafts (const gchar *uri,
 
 static BraseroBurnResult
 brasero_mkisofs_base_write_grafts (BraseroMkisofsBase *base,
+				   BraseroMkisofsList *list,
 				   GError **error)
 {
 	BraseroWriteGraftData callback_data;
 	gpointer result;
+	GSList *iter;
+
+	/* directories without URI first */
+	for (iter = base->empty; iter; iter = iter->next) {
+		BraseroBurnResult res;
+
+		res = _write_line (list, iter->data, error);
+		if (res != BRASERO_BURN_OK)
+			return res;
+	}
 
 	callback_data.error = error;
 	callback_data.base = base;
+	callback_data.list = list;
 
 	result = g_hash_table_find (base->grafts,
 				    (GHRFunc) _foreach_write_grafts,
@@ -364,6 +494,335 @@ brasero_mkisofs_base_write_grafts (BraseroMkisofsBase *base,
 	return BRASERO_BURN_OK;
 }
 
+static BraseroBurnResult
+brasero_mkisofs_base_write_excluded_list (BraseroMkisofsBase *base,
+					  BraseroMkisofsList *list,
+					  GError **error)
+{
+	guint skipped = 0;
+	GSList *iter;
+
+	for (iter = base->excluded; iter; iter = iter->next) {
+		BraseroBurnResult result;
+		gchar *uri;
+
+		uri = iter->data;
+		if (!uri) {
+			BRASERO_BURN_LOG ("NULL URI");
+			continue;
+		}
+
+		/* mkisofs only needs the exclusions it can meet while
+		 * exploring a grafted directory; matching all the others
+		 * against every path is a waste of time. */
+		if (!brasero_mkisofs_base_is_below_graft (base, uri)) {
+			skipped ++;
+			continue;
+		}
+
+		result = brasero_mkisofs_base_write_excluded (base,
+							      list,
+							      uri,
+							      error);
+		if (result != BRASERO_BURN_OK)
+			return result;
+	}
+
+	BRASERO_BURN_LOG ("%i excluded URIs not below a graft point were skipped", skipped);
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_mkisofs_base_write_list (BraseroMkisofsBase *base,
+				 BraseroMkisofsListFunc func,
+				 gint fd,
+				 GError **error)
+{
+	BraseroMkisofsList list;
+	BraseroBurnResult result;
+
+	list.fd = fd;
+	list.lines = 0;
+	list.buffer = g_string_sized_new (BRASERO_MKISOFS_LIST_BUFFER + MAXPATHLEN);
+
+	result = func (base, &list, error);
+	if (result == BRASERO_BURN_OK)
+		result = _flush_list (&list, error);
+
+	g_string_free (list.buffer, TRUE);
+	return result;
+}
+
+static gint
+brasero_mkisofs_base_open_fifo (const gchar *path)
+{
+	gint waited = 0;
+	gint flags;
+	gint fd;
+
+	/* opening a FIFO blocks until there is a reader; don't wait forever
+	 * in case mkisofs failed before opening it */
+	while ((fd = open (path, O_WRONLY|O_NONBLOCK)) == -1) {
+		if (errno != ENXIO && errno != EINTR)
+			return -1;
+
+		if (waited >= BRASERO_MKISOFS_LIST_TIMEOUT) {
+			errno = ETIMEDOUT;
+			return -1;
+		}
+
+		g_usleep (10000);
+		waited += 10;
+	}
+
+	flags = fcntl (fd, F_GETFL);
+	fcntl (fd, F_SETFL, flags & ~O_NONBLOCK);
+	return fd;
+}
+
+static void
+brasero_mkisofs_list_status_free (BraseroMkisofsListStatus *status)
+{
+	if (status->error)
+		g_error_free (status->error);
+
+	g_free (status);
+}
+
+static gpointer
+brasero_mkisofs_base_writer_thread (gpointer data)
+{
+	BraseroMkisofsWriter *writer = data;
+	BraseroBurnResult result;
+	GError *error = NULL;
+	sigset_t set;
+	gint fd;
+
+	/* If mkisofs exits before reading everything, we want an error, not
+	 * to be killed */
+	sigemptyset (&set);
+	sigaddset (&set, SIGPIPE);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+	fd = brasero_mkisofs_base_open_fifo (writer->path);
+	if (fd == -1) {
+		int errsv = errno;
+
+		BRASERO_BURN_LOG ("Could not open list %s: %s",
+				  writer->path,
+				  g_strerror (errsv));
+		g_set_error (&error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     g_strerror (errsv));
+	}
+	else {
+		result = brasero_mkisofs_base_write_list (writer->base,
+							  writer->func,
+							  fd,
+							  &error);
+		close (fd);
+
+		if (result != BRASERO_BURN_OK) {
+			BRASERO_BURN_LOG ("Could not write list %s: %s",
+					  writer->path,
+					  error? error->message:"unknown error");
+			if (!error)
+				g_set_error (&error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     "%s",
+					     _("An internal error occurred"));
+		}
+		else
+			BRASERO_BURN_LOG ("List %s written", writer->path);
+	}
+
+	/* Hand the outcome over to the job unless it gave up on it */
+	G_LOCK (list_status);
+	writer->status->running = FALSE;
+	if (writer->status->forgotten) {
+		brasero_mkisofs_list_status_free (writer->status);
+		if (error)
+			g_error_free (error);
+	}
+	else
+		writer->status->error = error;
+	G_UNLOCK (list_status);
+
+	brasero_mkisofs_base_unref (writer->base);
+	g_free (writer->path);
+	g_free (writer);
+
+	return NULL;
+}
+
+static void
+brasero_mkisofs_base_register_list (BraseroMkisofsWriter *writer)
+{
+	BraseroMkisofsListStatus *former;
+
+	writer->status = g_new0 (BraseroMkisofsListStatus, 1);
+	writer->status->running = TRUE;
+
+	G_LOCK (list_status);
+
+	if (!list_status)
+		list_status = g_hash_table_new_full (g_str_hash,
+						     g_str_equal,
+						     g_free,
+						     NULL);
+
+	former = g_hash_table_lookup (list_status, writer->path);
+	if (former) {
+		if (former->running)
+			former->forgotten = TRUE;
+		else
+			brasero_mkisofs_list_status_free (former);
+	}
+
+	g_hash_table_replace (list_status, g_strdup (writer->path), writer->status);
+
+	G_UNLOCK (list_status);
+}
+
+static void
+brasero_mkisofs_base_unregister_list (BraseroMkisofsWriter *writer)
+{
+	G_LOCK (list_status);
+	g_hash_table_remove (list_status, writer->path);
+	G_UNLOCK (list_status);
+
+	brasero_mkisofs_list_status_free (writer->status);
+	writer->status = NULL;
+}
+
+/**
+ * brasero_mkisofs_base_check_list:
+ * @path: the path of a list given to brasero_mkisofs_base_write_to_files ()
+ * @error: a #GError or NULL
+ *
+ * Lists are written by threads while mkisofs reads them; to be called once
+ * mkisofs exited to know whether it was given the whole list. If a list
+ * could not be written entirely, the image lacks files or exclusions and the
+ * job must fail.
+ * With @error set to NULL, this only forgets about @path.
+ *
+ * Return value: a #BraseroBurnResult. BRASERO_BURN_OK if the list was written
+ * entirely or if it was not written by a thread.
+ **/
+BraseroBurnResult
+brasero_mkisofs_base_check_list (const gchar *path,
+				 GError **error)
+{
+	BraseroMkisofsListStatus *status;
+	gint waited = 0;
+
+	if (!path)
+		return BRASERO_BURN_OK;
+
+	G_LOCK (list_status);
+
+	status = list_status? g_hash_table_lookup (list_status, path):NULL;
+	if (!status) {
+		G_UNLOCK (list_status);
+		return BRASERO_BURN_OK;
+	}
+
+	/* mkisofs may exit right after it read the end of the list while the
+	 * writer has not reported yet */
+	while (error && status->running && waited < BRASERO_MKISOFS_LIST_CHECK_TIMEOUT) {
+		G_UNLOCK (list_status);
+		g_usleep (10000);
+		waited += 10;
+		G_LOCK (list_status);
+	}
+
+	g_hash_table_remove (list_status, path);
+
+	if (status->running) {
+		/* The thread frees it when it is done */
+		status->forgotten = TRUE;
+		G_UNLOCK (list_status);
+
+		if (!error)
+			return BRASERO_BURN_OK;
+
+		BRASERO_BURN_LOG ("List %s was not read entirely", path);
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     _("An internal error occurred"));
+		return BRASERO_BURN_ERR;
+	}
+
+	G_UNLOCK (list_status);
+
+	if (status->error && error) {
+		g_propagate_error (error, status->error);
+		status->error = NULL;
+		brasero_mkisofs_list_status_free (status);
+		return BRASERO_BURN_ERR;
+	}
+
+	brasero_mkisofs_list_status_free (status);
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_mkisofs_base_write_to_path (BraseroMkisofsBase *base,
+				    BraseroMkisofsListFunc func,
+				    const gchar *path,
+				    GError **error)
+{
+	BraseroMkisofsWriter *writer;
+	BraseroBurnResult result;
+	gint fd;
+
+	/* Replace the file by a FIFO and feed it from a thread so that mkisofs
+	 * can start reading while the list is being generated */
+	g_unlink (path);
+	if (mkfifo (path, S_IRUSR|S_IWUSR) == 0) {
+		writer = g_new0 (BraseroMkisofsWriter, 1);
+		writer->base = base;
+		writer->func = func;
+		writer->path = g_strdup (path);
+
+		g_atomic_int_inc (&base->ref);
+		brasero_mkisofs_base_register_list (writer);
+		if (g_thread_create (brasero_mkisofs_base_writer_thread,
+				     writer,
+				     FALSE,
+				     NULL))
+			return BRASERO_BURN_OK;
+
+		brasero_mkisofs_base_unregister_list (writer);
+		g_atomic_int_add (&base->ref, -1);
+		g_free (writer->path);
+		g_free (writer);
+		g_unlink (path);
+	}
+
+	BRASERO_BURN_LOG ("Writing list to a regular file");
+
+	fd = open (path, O_WRONLY|O_CREAT|O_TRUNC, S_IRUSR|S_IWUSR);
+	if (fd == -1) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     "%s",
+			     g_strerror (errno));
+		return BRASERO_BURN_ERR;
+	}
+
+	result = brasero_mkisofs_base_write_list (base, func, fd, error);
+	close (fd);
+
+	return result;
+}
+
 static BraseroBurnResult
 brasero_mkisofs_base_create_video_empty (BraseroMkisofsBase *base,
 					 const gchar *disc_path)
@@ -393,7 +852,6 @@ brasero_mkisofs_base_empty_directory (BraseroMkisofsBase *base,
 				      const gchar *disc_path,
 				      GError **error)
 {
-	BraseroBurnResult result;
 	gchar *graft_point;
 
 	/* This is a special case when the URI is NULL which can happen mainly
@@ -415,10 +873,16 @@ brasero_mkisofs_base_empty_directory (BraseroMkisofsBase *base,
 
 	/* Special case for uri = NULL; that is treated as if it were a directory */
 	graft_point = _build_graft_point (base->emptydir, disc_path);
-	result = _write_line (base->grafts_fd, graft_point, error);
-	g_free (graft_point);
+	if (!graft_point) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("An internal error occurred"));
+		return BRASERO_BURN_ERR;
+	}
 
-	return result;
+	base->empty = g_slist_prepend (base->empty, graft_point);
+	return BRASERO_BURN_OK;
 }
 
 static BraseroBurnResult
@@ -495,6 +959,19 @@ brasero_mkisofs_base_add_graft (BraseroMkisofsBase *base,
 		return BRASERO_BURN_ERR;
 	}
 
+	if (graft->uri) {
+		gchar *path;
+
+		path = _uri_to_path (graft->uri);
+		if (path) {
+			/* remove any trailing separator */
+			if (strlen (path) > 1 && g_str_has_suffix (path, G_DIR_SEPARATOR_S))
+				path [strlen (path) - 1] = '\0';
+
+			g_hash_table_insert (base->graft_paths, path, GINT_TO_POINTER (1));
+		}
+	}
+
 	/* This is a special case for VIDEO images. Given the tests I performed,
 	 * the option --dvd-video requires the parent directory of VIDEO_TS and
 	 * AUDIO_TS to be passed. If each of these two directories are passed
@@ -563,8 +1040,7 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 				     const gchar *excluded_path,
 				     GError **error)
 {
-	gchar *uri;
-	BraseroMkisofsBase base;
+	BraseroMkisofsBase *base;
 	BraseroBurnResult result;
 
 	if (!grafts) {
@@ -573,37 +1049,21 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 	}
 
 	/* initialize base */
-	bzero (&base, sizeof (base));
-
-	base.grafts_fd = open (grafts_path, O_WRONLY|O_TRUNC|O_EXCL);
-	if (base.grafts_fd == -1) {
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
-	}
-
-	base.excluded_fd = open (excluded_path, O_WRONLY|O_TRUNC|O_EXCL);
-	if (base.excluded_fd == -1) {
-		close (base.excluded_fd);
-		g_set_error (error,
-			     BRASERO_BURN_ERROR,
-			     BRASERO_BURN_ERROR_GENERAL,
-			     "%s",
-			     g_strerror (errno));
-		return BRASERO_BURN_ERR;
-	}
-
-	base.use_joliet = use_joliet;
-	base.emptydir = emptydir;
-	base.videodir = videodir;
-
-	base.grafts = g_hash_table_new_full (g_str_hash,
-					     g_str_equal,
-					     NULL,
-					    (GDestroyNotify) g_slist_free);
+	base = g_new0 (BraseroMkisofsBase, 1);
+	base->ref = 1;
+
+	base->use_joliet = use_joliet;
+	base->emptydir = emptydir;
+	base->videodir = videodir;
+
+	base->grafts = g_hash_table_new_full (g_str_hash,
+					      g_str_equal,
+					      NULL,
+					     (GDestroyNotify) g_slist_free);
+	base->graft_paths = g_hash_table_new_full (g_str_hash,
+						   g_str_equal,
+						   g_free,
+						   NULL);
 
 	/* we analyse the graft points:
 	 * first add graft points and excluded. At the same time create a hash 
@@ -615,12 +1075,13 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 	for (; grafts; grafts = grafts->next) {
 		BraseroGraftPt *graft;
 
-		graft = grafts->data;
+		graft = brasero_graft_point_copy (grafts->data);
+		base->copies = g_slist_prepend (base->copies, graft);
 
 		BRASERO_BURN_LOG ("New graft %s %s", graft->uri, graft->path);
 
 		if (!graft->uri) {
-			result = brasero_mkisofs_base_empty_directory (&base,
+			result = brasero_mkisofs_base_empty_directory (base,
 								       graft->path,
 								       error);
 			if (result != BRASERO_BURN_OK)
@@ -629,7 +1090,7 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 			continue;
 		}
 
-		result = brasero_mkisofs_base_add_graft (&base,
+		result = brasero_mkisofs_base_add_graft (base,
 							 graft,
 							 error);
 		if (result != BRASERO_BURN_OK)
@@ -637,40 +1098,37 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 	}
 
 	/* simple check */
-	if (base.videodir && !base.found_video_ts) {
+	if (base->videodir && !base->found_video_ts) {
 		g_set_error (error,
 			     BRASERO_BURN_ERROR,
 			     BRASERO_BURN_ERROR_GENERAL,
 			     _("VIDEO_TS directory is missing or invalid"));
-		return BRASERO_BURN_ERR;
-	}
-
-	/* write the grafts list */
-	result = brasero_mkisofs_base_write_grafts (&base, error);
-	if (result != BRASERO_BURN_OK)
+		result = BRASERO_BURN_ERR;
 		goto cleanup;
+	}
 
-	/* write the global excluded files list */
-	for (; excluded; excluded = excluded->next) {
-		uri = excluded->data;
-		if (!uri) {
-			BRASERO_BURN_LOG ("NULL URI");
-			continue;
-		}
+	/* These are not valid once we return */
+	base->emptydir = NULL;
+	base->videodir = NULL;
 
-		result = brasero_mkisofs_base_write_excluded (&base,
-							      uri,
-							      error);
-		if (result != BRASERO_BURN_OK)
-			goto cleanup;
-	}
+	for (; excluded; excluded = excluded->next)
+		base->excluded = g_slist_prepend (base->excluded, g_strdup (excluded->data));
 
-	brasero_mkisofs_base_clean (&base);
-	return BRASERO_BURN_OK;
+	/* write the grafts list and the global excluded files list */
+	result = brasero_mkisofs_base_write_to_path (base,
+						     brasero_mkisofs_base_write_grafts,
+						     grafts_path,
+						     error);
+	if (result != BRASERO_BURN_OK)
+		goto cleanup;
 
+	result = brasero_mkisofs_base_write_to_path (base,
+						     brasero_mkisofs_base_write_excluded_list,
+						     excluded_path,
+						     error);
 
 cleanup:
 
-	brasero_mkisofs_base_clean (&base);
+	brasero_mkisofs_base_unref (base);
 	return result;
 }
@@ -49,6 +49,10 @@ brasero_mkisofs_base_write_to_files (GSList *grafts,
 				     const gchar *excluded_path,
 				     GError **error);
 
+BraseroBurnResult
+brasero_mkisofs_base_check_list (const gchar *path,
+				 GError **error);
+
 G_END_DECLS
 
 #endif /* MKISOFS_CASE_H */
@@ -204,6 +204,10 @@ brasero_plugin_manager_set_plugins_state (BraseroPluginManager *self)
 			continue;
 		}
 
+		/* These keep the state stored in their own settings */
+		if (brasero_plugin_get_on_request (plugin))
+			continue;
+
 		/* See if this plugin is in the names list. If not, de-activate it. */
 		if (name_num) {
 			int i;
@@ -122,6 +122,7 @@ struct _BraseroPluginPrivate
 	BraseroPluginProcessFlag process_flags;
 
 	guint compulsory:1;
+	guint on_request:1;
 };
 
 static const gchar *default_icon = "gtk-cdrom";
@@ -314,6 +315,31 @@ brasero_plugin_get_compulsory (BraseroPlugin *self)
 	return priv->compulsory;
 }
 
+/**
+ * A plugin used on request is only active when its priority was set to a
+ * positive value in its settings. Activating it with
+ * brasero_plugin_set_active () sets such a value.
+ */
+
+void
+brasero_plugin_set_on_request (BraseroPlugin *self,
+			       gboolean on_request)
+{
+	BraseroPluginPrivate *priv;
+
+	priv = BRASERO_PLUGIN_PRIVATE (self);
+	priv->on_request = on_request;
+}
+
+gboolean
+brasero_plugin_get_on_request (BraseroPlugin *self)
+{
+	BraseroPluginPrivate *priv;
+
+	priv = BRASERO_PLUGIN_PRIVATE (self);
+	return priv->on_request;
+}
+
 void
 brasero_plugin_set_active (BraseroPlugin *self, gboolean active)
 {
@@ -326,6 +352,15 @@ brasero_plugin_set_active (BraseroPlugin *self, gboolean active)
 	was_active = brasero_plugin_get_active (self, FALSE);
 	priv->active = active;
 
+	/* Keep the choice in the settings for the next runs */
+	if (priv->on_request && priv->settings
+	&&  active != (priv->priority > 0)) {
+		priv->priority = active? MAX (priv->priority_original, 1):0;
+		g_settings_set_int (priv->settings,
+				    BRASERO_PROPS_PRIORITY_KEY,
+				    priv->priority);
+	}
+
 	now_active = brasero_plugin_get_active (self, FALSE);
 	if (was_active == now_active)
 		return;
@@ -359,6 +394,9 @@ brasero_plugin_get_active (BraseroPlugin *plugin,
 			return FALSE;
 	}
 
+	if (priv->on_request)
+		return (priv->priority > 0);
+
 	return priv->active;
 }
 
@@ -0,0 +1,173 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+
+#include "burn-process-parser.h"
+#include "burn-process-parser-check.h"
+
+static gchar *
+brasero_process_parser_check_line (BraseroProcessParser *parser,
+				   const gchar *line,
+				   gchar **expected)
+{
+	BraseroProcessMatch match;
+	guint i;
+
+	if (!expected [0])
+		return g_strdup ("no result expected");
+
+	if (!brasero_process_parser_match (parser, line, &match)) {
+		if (!strcmp (expected [0], "none"))
+			return NULL;
+
+		return g_strdup ("no rule matched");
+	}
+
+	if (strcmp (expected [0], "match"))
+		return g_strdup_printf ("\"%s\" matched", match.rule->pattern);
+
+	if (!expected [1] || strcmp (expected [1], match.rule->pattern))
+		return g_strdup_printf ("\"%s\" matched instead", match.rule->pattern);
+
+	for (i = 0; i < match.num; i ++) {
+		const BraseroProcessCapture *capture;
+		const gchar *text;
+
+		text = expected [i + 2];
+		if (!text)
+			return g_strdup_printf ("unexpected capture %i", i);
+
+		capture = match.captures + i;
+		if (strlen (text) != (gsize) capture->len
+		||  strncmp (text, capture->start, capture->len))
+			return g_strdup_printf ("capture %i is \"%.*s\" instead of \"%s\"",
+						i,
+						capture->len,
+						capture->start,
+						text);
+	}
+
+	if (expected [i + 2])
+		return g_strdup_printf ("capture %i is missing", i);
+
+	return NULL;
+}
+
+/**
+ * brasero_process_parser_check:
+ * @path: the path of a transcript
+ * @tables: an array of #BraseroProcessCheckTable
+ * @num: the number of tables
+ *
+ * Runs each line of output in @path through the table it names and prints
+ * a message for every result that differs from the expected one.
+ *
+ * Return value: a #gint. The number of failures.
+ **/
+gint
+brasero_process_parser_check (const gchar *path,
+			      const BraseroProcessCheckTable *tables,
+			      guint num)
+{
+	BraseroProcessParser **parsers;
+	gchar *contents = NULL;
+	GError *error = NULL;
+	gint failures = 0;
+	gint checked = 0;
+	gchar **lines;
+	guint i;
+
+	if (!g_file_get_contents (path, &contents, NULL, &error)) {
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+
+	lines = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+
+	parsers = g_new0 (BraseroProcessParser *, num);
+	for (i = 0; i < num; i ++)
+		parsers [i] = brasero_process_parser_new (tables [i].rules, tables [i].num);
+
+	for (i = 0; lines [i]; i ++) {
+		gchar **expected;
+		gchar **output;
+		gchar *message;
+		guint table;
+
+		if (lines [i][0] == '\0' || lines [i][0] == '#')
+			continue;
+
+		output = g_strsplit (lines [i], "\t", 2);
+		for (table = 0; table < num; table ++) {
+			if (!strcmp (output [0], tables [table].name))
+				break;
+		}
+
+		if (!output [1] || table >= num || !lines [i + 1]) {
+			g_printerr ("%s:%i: malformed entry\n", path, i + 1);
+			g_strfreev (output);
+			failures ++;
+			break;
+		}
+
+		i ++;
+		expected = g_strsplit (lines [i], "\t", -1);
+		message = brasero_process_parser_check_line (parsers [table],
+							     output [1],
+							     expected);
+		if (message) {
+			g_printerr ("%s:%i: %s: \"%s\"\n", path, i, message, output [1]);
+			g_free (message);
+			failures ++;
+		}
+
+		g_strfreev (expected);
+		g_strfreev (output);
+		checked ++;
+	}
+
+	for (i = 0; i < num; i ++)
+		brasero_process_parser_free (parsers [i]);
+
+	g_free (parsers);
+	g_strfreev (lines);
+
+	g_print ("%s: %i lines checked, %i failures\n", path, checked, failures);
+	return failures;
+}
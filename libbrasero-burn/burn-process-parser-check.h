@@ -0,0 +1,65 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_PROCESS_PARSER_CHECK_H_
+#define _BURN_PROCESS_PARSER_CHECK_H_
+
+#include <glib.h>
+
+#include "burn-process-parser.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Checks rule tables against transcripts of the output of a tool.
+ *
+ * Blank lines and lines starting with '#' are skipped. Any other line is
+ * the name of a table, a tab and a line the tool printed. The next line says
+ * what the parser must make of it:
+ * - "none" when no rule may match
+ * - "match", the pattern of the rule and the text of each capture, all
+ *   separated by tabs
+ */
+
+typedef struct _BraseroProcessCheckTable BraseroProcessCheckTable;
+struct _BraseroProcessCheckTable {
+	const gchar *name;
+	const BraseroProcessRule *rules;
+	guint num;
+};
+
+gint
+brasero_process_parser_check (const gchar *path,
+			      const BraseroProcessCheckTable *tables,
+			      guint num);
+
+G_END_DECLS
+
+#endif /* _BURN_PROCESS_PARSER_CHECK_H_ */
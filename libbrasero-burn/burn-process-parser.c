@@ -0,0 +1,665 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+
+#include "brasero-units.h"
+#include "brasero-error.h"
+
+#include "burn-job.h"
+#include "burn-process.h"
+#include "burn-process-parser.h"
+
+typedef enum {
+	BRASERO_PARSER_TOKEN_END,
+	BRASERO_PARSER_TOKEN_LITERAL,
+	BRASERO_PARSER_TOKEN_BLANKS,
+	BRASERO_PARSER_TOKEN_INT,
+	BRASERO_PARSER_TOKEN_UINT,
+	BRASERO_PARSER_TOKEN_REAL,
+	BRASERO_PARSER_TOKEN_WORD,
+	BRASERO_PARSER_TOKEN_UNTIL
+} BraseroParserTokenType;
+
+struct _BraseroParserToken {
+	BraseroParserTokenType type;
+
+	/* Literals (and the delimiter of %[^c]) point into the pattern of
+	 * the rule */
+	const gchar *literal;
+	gint len;
+
+	guint capture:1;
+};
+typedef struct _BraseroParserToken BraseroParserToken;
+
+struct _BraseroParserRule {
+	const BraseroProcessRule *rule;
+	BraseroParserToken *tokens;
+
+	/* length of the literal the pattern starts with (the key) */
+	gint key_len;
+
+	/* next rule with the same key */
+	gint next;
+};
+typedef struct _BraseroParserRule BraseroParserRule;
+
+/**
+ * Nodes of an Aho-Corasick automaton built on the keys of the rules. Children
+ * are kept in a list since there are few of them per node.
+ */
+struct _BraseroParserNode {
+	gint child;
+	gint sibling;
+	gint fail;
+
+	/* first rule whose key ends here and nearest node (following failure
+	 * links, starting with this one) that has rules */
+	gint rule;
+	gint output;
+
+	guchar c;
+};
+typedef struct _BraseroParserNode BraseroParserNode;
+
+struct _BraseroProcessParser {
+	BraseroParserRule *rules;
+	guint rules_num;
+
+	BraseroParserNode *nodes;
+	guint nodes_num;
+
+	/* rules whose pattern starts with a conversion */
+	GSList *keyless;
+};
+
+static BraseroParserToken *
+brasero_process_parser_compile (const gchar *pattern)
+{
+	GArray *tokens;
+	const gchar *p;
+
+	tokens = g_array_new (TRUE, TRUE, sizeof (BraseroParserToken));
+
+	p = pattern;
+	while (*p) {
+		BraseroParserToken token = { 0, };
+
+		if (g_ascii_isspace (*p)) {
+			while (g_ascii_isspace (*p))
+				p ++;
+
+			token.type = BRASERO_PARSER_TOKEN_BLANKS;
+		}
+		else if (*p == '%' && p [1] == '%') {
+			token.type = BRASERO_PARSER_TOKEN_LITERAL;
+			token.literal = p + 1;
+			token.len = 1;
+			p += 2;
+		}
+		else if (*p == '%') {
+			p ++;
+
+			token.capture = TRUE;
+			if (*p == '*') {
+				token.capture = FALSE;
+				p ++;
+			}
+
+			while (g_ascii_isdigit (*p))
+				p ++;
+
+			if (p [0] == '[' && p [1] == '^' && p [2] && p [3] == ']') {
+				token.type = BRASERO_PARSER_TOKEN_UNTIL;
+				token.literal = p + 2;
+				token.len = 1;
+				p += 4;
+
+				g_array_append_val (tokens, token);
+				continue;
+			}
+
+			switch (*p) {
+			case 'd':
+				token.type = BRASERO_PARSER_TOKEN_INT;
+				break;
+			case 'u':
+				token.type = BRASERO_PARSER_TOKEN_UINT;
+				break;
+			case 'f':
+				token.type = BRASERO_PARSER_TOKEN_REAL;
+				break;
+			case 's':
+				token.type = BRASERO_PARSER_TOKEN_WORD;
+				break;
+			default:
+				g_warning ("Unsupported conversion in \"%s\"", pattern);
+				g_array_free (tokens, TRUE);
+				return NULL;
+			}
+
+			p ++;
+		}
+		else {
+			token.type = BRASERO_PARSER_TOKEN_LITERAL;
+			token.literal = p;
+			while (*p && *p != '%' && !g_ascii_isspace (*p))
+				p ++;
+
+			token.len = p - token.literal;
+		}
+
+		g_array_append_val (tokens, token);
+	}
+
+	/* The array is zero terminated which is BRASERO_PARSER_TOKEN_END */
+	return (BraseroParserToken *) g_array_free (tokens, FALSE);
+}
+
+static gint
+brasero_process_parser_goto (BraseroParserNode *nodes,
+			     gint node,
+			     guchar c)
+{
+	gint child;
+
+	for (child = nodes [node].child; child >= 0; child = nodes [child].sibling) {
+		if (nodes [child].c == c)
+			return child;
+	}
+
+	return -1;
+}
+
+static void
+brasero_process_parser_add_key (BraseroProcessParser *parser,
+				GArray *nodes,
+				gint rule)
+{
+	BraseroParserToken *token;
+	gint node = 0;
+	gint i;
+
+	token = parser->rules [rule].tokens;
+	for (i = 0; i < token->len; i ++) {
+		guchar c;
+		gint next;
+
+		c = token->literal [i];
+		next = brasero_process_parser_goto ((BraseroParserNode *) nodes->data, node, c);
+		if (next < 0) {
+			BraseroParserNode new_node = { -1, -1, 0, -1, -1, c };
+
+			next = nodes->len;
+			new_node.sibling = g_array_index (nodes, BraseroParserNode, node).child;
+			g_array_append_val (nodes, new_node);
+			g_array_index (nodes, BraseroParserNode, node).child = next;
+		}
+
+		node = next;
+	}
+
+	/* Keep rules sharing a key in table order */
+	if (g_array_index (nodes, BraseroParserNode, node).rule < 0)
+		g_array_index (nodes, BraseroParserNode, node).rule = rule;
+	else {
+		gint last;
+
+		last = g_array_index (nodes, BraseroParserNode, node).rule;
+		while (parser->rules [last].next >= 0)
+			last = parser->rules [last].next;
+
+		parser->rules [last].next = rule;
+	}
+}
+
+static void
+brasero_process_parser_link (BraseroProcessParser *parser)
+{
+	BraseroParserNode *nodes;
+	GQueue queue = G_QUEUE_INIT;
+	gint child;
+
+	nodes = parser->nodes;
+	for (child = nodes [0].child; child >= 0; child = nodes [child].sibling) {
+		nodes [child].fail = 0;
+		nodes [child].output = nodes [child].rule >= 0 ? child:-1;
+		g_queue_push_tail (&queue, GINT_TO_POINTER (child));
+	}
+
+	while (!g_queue_is_empty (&queue)) {
+		gint node;
+
+		node = GPOINTER_TO_INT (g_queue_pop_head (&queue));
+		for (child = nodes [node].child; child >= 0; child = nodes [child].sibling) {
+			gint fail;
+			gint next;
+
+			fail = nodes [node].fail;
+			while (fail > 0 && brasero_process_parser_goto (nodes, fail, nodes [child].c) < 0)
+				fail = nodes [fail].fail;
+
+			next = brasero_process_parser_goto (nodes, fail, nodes [child].c);
+			nodes [child].fail = (next >= 0 && next != child) ? next:0;
+			nodes [child].output = nodes [child].rule >= 0 ? child:nodes [nodes [child].fail].output;
+
+			g_queue_push_tail (&queue, GINT_TO_POINTER (child));
+		}
+	}
+}
+
+/**
+ * brasero_process_parser_new:
+ * @rules: an array of #BraseroProcessRule
+ * @num: the number of rules
+ *
+ * Compiles @rules. They must stay valid as long as the parser is used.
+ *
+ * Return value: a #BraseroProcessParser. Free with brasero_process_parser_free ().
+ **/
+BraseroProcessParser *
+brasero_process_parser_new (const BraseroProcessRule *rules,
+			    guint num)
+{
+	BraseroParserNode root = { -1, -1, 0, -1, -1, 0 };
+	BraseroProcessParser *parser;
+	GArray *nodes;
+	guint i;
+
+	parser = g_new0 (BraseroProcessParser, 1);
+	parser->rules = g_new0 (BraseroParserRule, num);
+	parser->rules_num = num;
+
+	nodes = g_array_new (FALSE, FALSE, sizeof (BraseroParserNode));
+	g_array_append_val (nodes, root);
+
+	for (i = 0; i < num; i ++) {
+		BraseroParserRule *rule;
+
+		rule = parser->rules + i;
+		rule->rule = rules + i;
+		rule->next = -1;
+		rule->tokens = brasero_process_parser_compile (rules [i].pattern);
+		if (!rule->tokens)
+			continue;
+
+		if (rule->tokens->type != BRASERO_PARSER_TOKEN_LITERAL) {
+			if (rules [i].flags & BRASERO_PROCESS_RULE_ANYWHERE)
+				g_warning ("\"%s\" must start with some text to be matched anywhere",
+					   rules [i].pattern);
+
+			parser->keyless = g_slist_append (parser->keyless, GINT_TO_POINTER (i));
+			continue;
+		}
+
+		rule->key_len = rule->tokens->len;
+		brasero_process_parser_add_key (parser, nodes, i);
+	}
+
+	parser->nodes_num = nodes->len;
+	parser->nodes = (BraseroParserNode *) g_array_free (nodes, FALSE);
+	brasero_process_parser_link (parser);
+
+	return parser;
+}
+
+/**
+ * brasero_process_parser_free:
+ * @parser: a #BraseroProcessParser
+ *
+ * Frees @parser.
+ **/
+void
+brasero_process_parser_free (BraseroProcessParser *parser)
+{
+	guint i;
+
+	for (i = 0; i < parser->rules_num; i ++)
+		g_free (parser->rules [i].tokens);
+
+	g_slist_free (parser->keyless);
+	g_free (parser->nodes);
+	g_free (parser->rules);
+	g_free (parser);
+}
+
+static const gchar *
+brasero_process_parser_skip_blanks (const gchar *p)
+{
+	while (g_ascii_isspace (*p))
+		p ++;
+
+	return p;
+}
+
+static gboolean
+brasero_process_parser_match_tokens (const BraseroParserToken *token,
+				     const gchar *p,
+				     BraseroProcessMatch *match)
+{
+	match->num = 0;
+
+	for (; token->type != BRASERO_PARSER_TOKEN_END; token ++) {
+		BraseroProcessCapture capture = { NULL, 0, 0, 0.0 };
+
+		switch (token->type) {
+		case BRASERO_PARSER_TOKEN_LITERAL:
+			if (strncmp (p, token->literal, token->len))
+				return FALSE;
+
+			p += token->len;
+			continue;
+
+		case BRASERO_PARSER_TOKEN_BLANKS:
+			p = brasero_process_parser_skip_blanks (p);
+			continue;
+
+		case BRASERO_PARSER_TOKEN_INT:
+		case BRASERO_PARSER_TOKEN_UINT:
+			p = brasero_process_parser_skip_blanks (p);
+			capture.start = p;
+
+			if (token->type == BRASERO_PARSER_TOKEN_INT && (*p == '-' || *p == '+'))
+				p ++;
+
+			if (!g_ascii_isdigit (*p))
+				return FALSE;
+
+			while (g_ascii_isdigit (*p))
+				p ++;
+
+			capture.integer = g_ascii_strtoll (capture.start, NULL, 10);
+			capture.real = capture.integer;
+			break;
+
+		case BRASERO_PARSER_TOKEN_REAL: {
+			gboolean negative = FALSE;
+			gboolean digits = FALSE;
+			gdouble divisor = 1.0;
+
+			p = brasero_process_parser_skip_blanks (p);
+			capture.start = p;
+
+			if (*p == '-' || *p == '+')
+				negative = (*p ++ == '-');
+
+			for (; g_ascii_isdigit (*p); p ++) {
+				capture.real = capture.real * 10.0 + (*p - '0');
+				digits = TRUE;
+			}
+
+			if (*p == '.') {
+				for (p ++; g_ascii_isdigit (*p); p ++) {
+					divisor *= 10.0;
+					capture.real += (*p - '0') / divisor;
+					digits = TRUE;
+				}
+			}
+
+			if (!digits)
+				return FALSE;
+
+			if (negative)
+				capture.real = - capture.real;
+
+			capture.integer = capture.real;
+			break;
+		}
+
+		case BRASERO_PARSER_TOKEN_WORD:
+			p = brasero_process_parser_skip_blanks (p);
+			capture.start = p;
+
+			if (*p == '\0')
+				return FALSE;
+
+			while (*p && !g_ascii_isspace (*p))
+				p ++;
+
+			break;
+
+		case BRASERO_PARSER_TOKEN_UNTIL:
+			capture.start = p;
+
+			/* like scanf () at least one character is needed */
+			if (*p == '\0' || *p == *token->literal)
+				return FALSE;
+
+			while (*p && *p != *token->literal)
+				p ++;
+
+			break;
+
+		default:
+			return FALSE;
+		}
+
+		if (token->capture && match->num < BRASERO_PROCESS_MAX_CAPTURES) {
+			capture.len = p - capture.start;
+			match->captures [match->num ++] = capture;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * brasero_process_parser_match:
+ * @parser: a #BraseroProcessParser
+ * @line: a line of output
+ * @match: a #BraseroProcessMatch filled when a rule matched
+ *
+ * Looks for the first rule of the table matching @line.
+ *
+ * Return value: a #gboolean. TRUE if a rule matched.
+ **/
+gboolean
+brasero_process_parser_match (BraseroProcessParser *parser,
+			      const gchar *line,
+			      BraseroProcessMatch *match)
+{
+	BraseroProcessMatch candidate;
+	BraseroParserNode *nodes;
+	const gchar *p;
+	gint best = -1;
+	gint state = 0;
+	GSList *iter;
+
+	nodes = parser->nodes;
+
+	for (iter = parser->keyless; iter; iter = iter->next) {
+		gint rule;
+
+		rule = GPOINTER_TO_INT (iter->data);
+		if (brasero_process_parser_match_tokens (parser->rules [rule].tokens, line, &candidate)) {
+			best = rule;
+			*match = candidate;
+			break;
+		}
+	}
+
+	for (p = line; *p && best != 0; p ++) {
+		gint output;
+		gint next;
+
+		while (state > 0 && brasero_process_parser_goto (nodes, state, *p) < 0)
+			state = nodes [state].fail;
+
+		next = brasero_process_parser_goto (nodes, state, *p);
+		state = next >= 0 ? next:0;
+
+		for (output = nodes [state].output; output >= 0; output = nodes [nodes [output].fail].output) {
+			gint rule;
+
+			for (rule = nodes [output].rule; rule >= 0; rule = parser->rules [rule].next) {
+				const gchar *start;
+
+				if (best >= 0 && rule >= best)
+					break;
+
+				start = p + 1 - parser->rules [rule].key_len;
+				if (!(parser->rules [rule].rule->flags & BRASERO_PROCESS_RULE_ANYWHERE)
+				&&  start != line)
+					continue;
+
+				if (brasero_process_parser_match_tokens (parser->rules [rule].tokens, start, &candidate)) {
+					best = rule;
+					*match = candidate;
+					break;
+				}
+			}
+		}
+	}
+
+	if (best < 0)
+		return FALSE;
+
+	match->rule = parser->rules [best].rule;
+	match->line = line;
+	return TRUE;
+}
+
+static void
+brasero_process_parser_set_rate (BraseroProcess *process,
+				 gdouble speed)
+{
+	BraseroMedia media;
+	gdouble rate;
+
+	if (brasero_job_get_media (BRASERO_JOB (process), &media) != BRASERO_BURN_OK)
+		return;
+
+	if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_CD))
+		rate = speed * CD_RATE;
+	else if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_DVD))
+		rate = speed * DVD_RATE;
+	else if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_BD))
+		rate = speed * BD_RATE;
+	else
+		return;
+
+	brasero_job_set_rate (BRASERO_JOB (process), rate);
+}
+
+/**
+ * brasero_process_parser_dispatch:
+ * @parser: a #BraseroProcessParser
+ * @process: the #BraseroProcess that output @line
+ * @line: a line of output
+ * @matched: a #gboolean or NULL
+ *
+ * Runs the action of the first rule matching @line if any.
+ *
+ * Return value: a #BraseroBurnResult. What the callback returned or
+ * BRASERO_BURN_OK.
+ **/
+BraseroBurnResult
+brasero_process_parser_dispatch (BraseroProcessParser *parser,
+				 BraseroProcess *process,
+				 const gchar *line,
+				 gboolean *matched)
+{
+	const BraseroProcessRule *rule;
+	BraseroProcessMatch match;
+
+	if (!brasero_process_parser_match (parser, line, &match)) {
+		if (matched)
+			*matched = FALSE;
+
+		return BRASERO_BURN_OK;
+	}
+
+	if (matched)
+		*matched = TRUE;
+
+	rule = match.rule;
+	switch (rule->action) {
+	case BRASERO_PROCESS_ACTION_ERROR:
+		brasero_job_error (BRASERO_JOB (process),
+				   g_error_new (BRASERO_BURN_ERROR,
+						rule->value,
+						"%s",
+						_(rule->message)));
+		break;
+
+	case BRASERO_PROCESS_ACTION_DEFERRED_ERROR:
+		brasero_process_deferred_error (process,
+						g_error_new (BRASERO_BURN_ERROR,
+							     rule->value,
+							     "%s",
+							     _(rule->message)));
+		break;
+
+	case BRASERO_PROCESS_ACTION_CURRENT_ACTION:
+		brasero_job_set_current_action (BRASERO_JOB (process),
+						rule->value,
+						rule->message ? _(rule->message):NULL,
+						FALSE);
+		break;
+
+	case BRASERO_PROCESS_ACTION_DANGEROUS:
+		brasero_job_set_dangerous (BRASERO_JOB (process), rule->value);
+		break;
+
+	case BRASERO_PROCESS_ACTION_PROGRESS:
+		if (match.num >= 2 && match.captures [1].real > 0.0)
+			brasero_job_set_progress (BRASERO_JOB (process),
+						  match.captures [0].real / match.captures [1].real);
+		else if (match.num == 1)
+			brasero_job_set_progress (BRASERO_JOB (process),
+						  match.captures [0].real / 100.0);
+		else
+			break;
+
+		brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+		break;
+
+	case BRASERO_PROCESS_ACTION_RATE:
+		if (match.num >= 1)
+			brasero_process_parser_set_rate (process, match.captures [match.num - 1].real);
+		break;
+
+	default:
+		break;
+	}
+
+	if (rule->callback)
+		return rule->callback (process, &match);
+
+	return BRASERO_BURN_OK;
+}
@@ -0,0 +1,146 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _BURN_PROCESS_PARSER_H_
+#define _BURN_PROCESS_PARSER_H_
+
+#include <glib.h>
+
+#include "burn-process.h"
+
+G_BEGIN_DECLS
+
+/**
+ * Table driven parser for the output of the external tools run by
+ * BraseroProcess plugins.
+ *
+ * A plugin declares a table of rules. Each rule has a pattern and an action.
+ * Patterns are written like scanf () formats:
+ * - a run of blanks matches any run of blanks (even an empty one)
+ * - %d, %u and %f capture a signed integer, an unsigned integer and a decimal
+ *   number; leading blanks are skipped
+ * - %s captures a run of non blank characters; leading blanks are skipped
+ * - %[^c] captures a run of characters up to (but not including) c; nothing
+ *   is skipped and the run may contain blanks
+ * - a '*' after '%' (%*d, %*s, ...) matches without capturing
+ * - a field width (%2u) is accepted and ignored; %% matches '%'
+ * - any other character matches itself
+ * A pattern must match entirely but the rest of the line is ignored.
+ *
+ * All patterns are compiled once in an automaton built on the literal text
+ * each pattern starts with, so that dispatching a line costs one pass over it
+ * whatever the number of rules. When several rules match a line, the first
+ * one in the table wins.
+ */
+
+typedef enum {
+	BRASERO_PROCESS_RULE_PREFIX		= 0,
+	BRASERO_PROCESS_RULE_ANYWHERE		= 1
+} BraseroProcessRuleFlags;
+
+typedef enum {
+	BRASERO_PROCESS_ACTION_NONE,
+	BRASERO_PROCESS_ACTION_CALLBACK,
+	BRASERO_PROCESS_ACTION_ERROR,
+	BRASERO_PROCESS_ACTION_DEFERRED_ERROR,
+	BRASERO_PROCESS_ACTION_CURRENT_ACTION,
+	BRASERO_PROCESS_ACTION_DANGEROUS,
+	BRASERO_PROCESS_ACTION_PROGRESS,
+	BRASERO_PROCESS_ACTION_RATE
+} BraseroProcessActionType;
+
+#define BRASERO_PROCESS_MAX_CAPTURES	8
+
+typedef struct _BraseroProcessRule BraseroProcessRule;
+typedef struct _BraseroProcessMatch BraseroProcessMatch;
+typedef struct _BraseroProcessParser BraseroProcessParser;
+
+struct _BraseroProcessCapture {
+	const gchar *start;
+	gint len;
+
+	gint64 integer;
+	gdouble real;
+};
+typedef struct _BraseroProcessCapture BraseroProcessCapture;
+
+struct _BraseroProcessMatch {
+	const BraseroProcessRule *rule;
+	const gchar *line;
+
+	guint num;
+	BraseroProcessCapture captures [BRASERO_PROCESS_MAX_CAPTURES];
+};
+
+typedef BraseroBurnResult	(*BraseroProcessMatchFunc)	(BraseroProcess *process,
+								 const BraseroProcessMatch *match);
+
+/**
+ * @value is the error code for (DEFERRED_)ERROR, the BraseroBurnAction for
+ * CURRENT_ACTION and the value for DANGEROUS.
+ * @message is an untranslated (N_()) string for (DEFERRED_)ERROR and
+ * CURRENT_ACTION.
+ * PROGRESS uses the first capture divided by the second one or by 100 when
+ * there is only one capture; RATE uses the last capture as a speed (2.4 for
+ * "2.4x") since tools print it at the end of their progress lines.
+ * @callback is called for CALLBACK and after any other action when set.
+ */
+struct _BraseroProcessRule {
+	const gchar *pattern;
+	BraseroProcessRuleFlags flags;
+
+	BraseroProcessActionType action;
+	gint value;
+	const gchar *message;
+
+	BraseroProcessMatchFunc callback;
+};
+
+BraseroProcessParser *
+brasero_process_parser_new (const BraseroProcessRule *rules,
+			    guint num);
+
+void
+brasero_process_parser_free (BraseroProcessParser *parser);
+
+gboolean
+brasero_process_parser_match (BraseroProcessParser *parser,
+			      const gchar *line,
+			      BraseroProcessMatch *match);
+
+BraseroBurnResult
+brasero_process_parser_dispatch (BraseroProcessParser *parser,
+				 BraseroProcess *process,
+				 const gchar *line,
+				 gboolean *matched);
+
+G_END_DECLS
+
+#endif /* _BURN_PROCESS_PARSER_H_ */
@@ -83,6 +83,13 @@ struct _BraseroTaskCtxPrivate
 	/* used for rates that certain jobs are able to report */
 	guint64 rate;
 
+	/* average rate of the last recording */
+	guint64 average_rate;
+
+	/* lowest fill levels (in %) of the buffers reported while recording */
+	gint fifo_min;
+	gint drive_min;
+
 	/* the current action */
 	BraseroBurnAction current_action;
 	gchar *action_string;
@@ -182,6 +189,10 @@ brasero_task_ctx_reset (BraseroTaskCtx *self)
 	priv->last_written = 0;
 	priv->last_elapsed = 0;
 	priv->last_progress = 0;
+	priv->average_rate = 0;
+
+	priv->fifo_min = -1;
+	priv->drive_min = -1;
 
 	if (priv->times) {
 		g_slist_free (priv->times);
@@ -568,6 +579,26 @@ brasero_task_ctx_set_rate (BraseroTaskCtx *self,
 	return BRASERO_BURN_OK;
 }
 
+BraseroBurnResult
+brasero_task_ctx_set_buffer_fill (BraseroTaskCtx *self,
+				  gint fifo,
+				  gint drive)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (fifo >= 0 && (priv->fifo_min < 0 || fifo < priv->fifo_min))
+		priv->fifo_min = fifo;
+
+	if (drive >= 0 && (priv->drive_min < 0 || drive < priv->drive_min))
+		priv->drive_min = drive;
+
+	return BRASERO_BURN_OK;
+}
+
 /**
  * This is used by jobs that are imaging to tell what's going to be the output 
  * size for a particular track
@@ -727,6 +758,32 @@ brasero_task_ctx_reset_progress (BraseroTaskCtx *self)
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_task_ctx_save_average_rate (BraseroTaskCtx *self)
+{
+	BraseroTaskCtxPrivate *priv;
+	gdouble average = 0.0;
+	gdouble elapsed;
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (priv->current_action != BRASERO_BURN_ACTION_RECORDING
+	|| !priv->timer)
+		return;
+
+	elapsed = g_timer_elapsed (priv->timer, NULL);
+	if (elapsed <= 0.0)
+		return;
+
+	if ((priv->session_bytes + priv->track_bytes) > 0)
+		average = (gdouble) ((priv->session_bytes + priv->track_bytes) - priv->first_written) / elapsed;
+	else if (priv->progress > 0.0)
+		average = (gdouble) (priv->progress - priv->first_progress) * priv->size / elapsed;
+
+	if (average > 0.0)
+		priv->average_rate = average;
+}
+
 BraseroBurnResult
 brasero_task_ctx_set_current_action (BraseroTaskCtx *self,
 				     BraseroBurnAction action,
@@ -748,6 +805,8 @@ brasero_task_ctx_set_current_action (BraseroTaskCtx *self,
 		priv->update_action_string = 1;
 	}
 	else {
+		brasero_task_ctx_save_average_rate (self);
+
 		g_mutex_lock (priv->lock);
 
 		priv->current_action = action;
@@ -840,6 +899,24 @@ brasero_task_ctx_get_rate (BraseroTaskCtx *self,
 	return BRASERO_BURN_OK;
 }
 
+BraseroBurnResult
+brasero_task_ctx_get_average_rate (BraseroTaskCtx *self,
+				   guint64 *rate)
+{
+	BraseroTaskCtxPrivate *priv;
+
+	g_return_val_if_fail (BRASERO_IS_TASK_CTX (self), BRASERO_BURN_ERR);
+	g_return_val_if_fail (rate != NULL, BRASERO_BURN_ERR);
+
+	priv = BRASERO_TASK_CTX_PRIVATE (self);
+
+	if (!priv->average_rate)
+		return BRASERO_BURN_NOT_READY;
+
+	*rate = priv->average_rate;
+	return BRASERO_BURN_OK;
+}
+
 BraseroBurnResult
 brasero_task_ctx_get_remaining_time (BraseroTaskCtx *self,
 				     long *remaining)
@@ -1018,6 +1095,17 @@ brasero_task_ctx_stop_progress (BraseroTaskCtx *self)
 		       brasero_task_ctx_signals [PROGRESS_CHANGED_SIGNAL],
 		       0);
 
+	brasero_task_ctx_save_average_rate (self);
+
+	/* A low level tells a buffer underrun was close (or happened) */
+	if (priv->fifo_min >= 0)
+		BRASERO_BURN_LOG ("Lowest fifo fill level %i%%", priv->fifo_min);
+	if (priv->drive_min >= 0)
+		BRASERO_BURN_LOG ("Lowest drive buffer fill level %i%%", priv->drive_min);
+
+	priv->fifo_min = -1;
+	priv->drive_min = -1;
+
 	priv->current_action = BRASERO_BURN_ACTION_NONE;
 	priv->action_changed = 0;
 	priv->update_action_string = 0;
@@ -1051,6 +1139,9 @@ brasero_task_ctx_init (BraseroTaskCtx *object)
 
 	priv = BRASERO_TASK_CTX_PRIVATE (object);
 	priv->lock = g_mutex_new ();
+
+	priv->fifo_min = -1;
+	priv->drive_min = -1;
 }
 
 static void
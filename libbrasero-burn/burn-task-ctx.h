@@ -151,6 +151,10 @@ brasero_task_ctx_stop_progress (BraseroTaskCtx *ctx);
 BraseroBurnResult
 brasero_task_ctx_set_rate (BraseroTaskCtx *ctx,
 			   gint64 rate);
+BraseroBurnResult
+brasero_task_ctx_set_buffer_fill (BraseroTaskCtx *ctx,
+				  gint fifo,
+				  gint drive);
 
 BraseroBurnResult
 brasero_task_ctx_set_written_session (BraseroTaskCtx *ctx,
@@ -184,6 +188,9 @@ BraseroBurnResult
 brasero_task_ctx_get_rate (BraseroTaskCtx *ctx,
 			   guint64 *rate);
 BraseroBurnResult
+brasero_task_ctx_get_average_rate (BraseroTaskCtx *ctx,
+				   guint64 *rate);
+BraseroBurnResult
 brasero_task_ctx_get_remaining_time (BraseroTaskCtx *ctx,
 				     long *remaining);
 BraseroBurnResult
@@ -67,6 +67,13 @@ struct _BraseroTaskPrivate {
 	/* result of the task */
 	BraseroBurnResult retval;
 	GError *error;
+
+	/* set when the task runs without a loop of its own */
+	BraseroTaskDoneFunc done_func;
+	gpointer done_data;
+	guint done_id;
+
+	guint running:1;
 };
 
 #define BRASERO_TASK_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_TASK, BraseroTaskPrivate))
@@ -276,6 +283,59 @@ brasero_task_sleep (BraseroTask *self, guint sec)
 	return priv->retval;
 }
 
+static BraseroBurnResult
+brasero_task_end_loop (BraseroTask *self,
+		       GError **error)
+{
+	BraseroTaskPrivate *priv;
+
+	priv = BRASERO_TASK_PRIVATE (self);
+
+	if (priv->error) {
+		g_propagate_error (error, priv->error);
+		priv->error = NULL;
+	}
+
+	/* stop all progress reporting thing */
+	if (priv->clock_id) {
+		g_source_remove (priv->clock_id);
+		priv->clock_id = 0;
+	}
+
+	if (priv->retval == BRASERO_BURN_OK
+	&&  brasero_task_ctx_get_progress (BRASERO_TASK_CTX (self), NULL) == BRASERO_BURN_OK) {
+		brasero_task_ctx_set_progress (BRASERO_TASK_CTX (self), 1.0);
+		brasero_task_ctx_report_progress (BRASERO_TASK_CTX (self));
+	}
+
+	brasero_task_ctx_stop_progress (BRASERO_TASK_CTX (self));
+	return priv->retval;	
+}
+
+static gboolean
+brasero_task_done_cb (gpointer data)
+{
+	BraseroTask *self = BRASERO_TASK (data);
+	BraseroTaskPrivate *priv;
+	BraseroTaskDoneFunc func;
+	BraseroBurnResult result;
+	GError *error = NULL;
+	gpointer user_data;
+
+	priv = BRASERO_TASK_PRIVATE (self);
+	priv->done_id = 0;
+
+	func = priv->done_func;
+	user_data = priv->done_data;
+	priv->done_func = NULL;
+	priv->done_data = NULL;
+
+	BRASERO_BURN_LOG ("asynchronous run finished");
+	result = brasero_task_end_loop (self, &error);
+	func (self, result, error, user_data);
+	return FALSE;
+}
+
 static BraseroBurnResult
 brasero_task_start_item (BraseroTask *task,
 			 BraseroTaskItem *item,
@@ -359,6 +419,11 @@ brasero_task_stop (BraseroTask *task,
 
 	if (priv->loop && g_main_loop_is_running (priv->loop))
 		g_main_loop_quit (priv->loop);
+	else if (priv->running) {
+		/* Report from the main loop like a nested loop would return */
+		priv->running = FALSE;
+		priv->done_id = g_idle_add (brasero_task_done_cb, task);
+	}
 	else
 		BRASERO_BURN_LOG ("task was asked to stop (%i/%i) during ::init or ::start",
 				  result, retval);
@@ -381,7 +446,7 @@ brasero_task_is_running (BraseroTask *task)
 	BraseroTaskPrivate *priv;
 
 	priv = BRASERO_TASK_PRIVATE (task);
-	return (priv->loop && g_main_loop_is_running (priv->loop));
+	return priv->running || (priv->loop && g_main_loop_is_running (priv->loop));
 }
 
 static void
@@ -434,6 +499,12 @@ brasero_task_run_loop (BraseroTask *self,
 					brasero_task_clock_tick,
 					self);
 
+	if (priv->done_func) {
+		BRASERO_BURN_LOG ("running asynchronously");
+		priv->running = TRUE;
+		return BRASERO_BURN_RUNNING;
+	}
+
 	priv->loop = g_main_loop_new (NULL, FALSE);
 
 	BRASERO_BURN_LOG ("entering loop");
@@ -446,25 +517,7 @@ brasero_task_run_loop (BraseroTask *self,
 	g_main_loop_unref (priv->loop);
 	priv->loop = NULL;
 
-	if (priv->error) {
-		g_propagate_error (error, priv->error);
-		priv->error = NULL;
-	}
-
-	/* stop all progress reporting thing */
-	if (priv->clock_id) {
-		g_source_remove (priv->clock_id);
-		priv->clock_id = 0;
-	}
-
-	if (priv->retval == BRASERO_BURN_OK
-	&&  brasero_task_ctx_get_progress (BRASERO_TASK_CTX (self), NULL) == BRASERO_BURN_OK) {
-		brasero_task_ctx_set_progress (BRASERO_TASK_CTX (self), 1.0);
-		brasero_task_ctx_report_progress (BRASERO_TASK_CTX (self));
-	}
-
-	brasero_task_ctx_stop_progress (BRASERO_TASK_CTX (self));
-	return priv->retval;	
+	return brasero_task_end_loop (self, error);
 }
 
 static BraseroBurnResult
@@ -635,7 +688,7 @@ brasero_task_start (BraseroTask *self,
 		result = brasero_task_start_items (self, error);
 	}
 
-	if (result != BRASERO_BURN_OK)
+	if (result != BRASERO_BURN_OK && result != BRASERO_BURN_RUNNING)
 		brasero_task_send_stop_signal (self, result, NULL);
 
 	return result;
@@ -682,6 +735,41 @@ brasero_task_run (BraseroTask *self,
 	return brasero_task_start (self, FALSE, error);
 }
 
+/**
+ * Same as brasero_task_run () except that it doesn't wait for the task to
+ * finish in a loop of its own. BRASERO_BURN_RUNNING is returned once the
+ * task is running and @func is then called from the main loop with the
+ * result; any other value is the result of the task and @func is not called.
+ * @func takes ownership of the error.
+ */
+BraseroBurnResult
+brasero_task_run_async (BraseroTask *self,
+			BraseroTaskDoneFunc func,
+			gpointer user_data,
+			GError **error)
+{
+	BraseroTaskPrivate *priv;
+	BraseroBurnResult result;
+
+	g_return_val_if_fail (BRASERO_IS_TASK (self), BRASERO_BURN_ERR);
+	g_return_val_if_fail (func != NULL, BRASERO_BURN_ERR);
+
+	priv = BRASERO_TASK_PRIVATE (self);
+	if (priv->done_func)
+		return BRASERO_BURN_RUNNING;
+
+	priv->done_func = func;
+	priv->done_data = user_data;
+
+	result = brasero_task_start (self, FALSE, error);
+	if (result != BRASERO_BURN_RUNNING) {
+		priv->done_func = NULL;
+		priv->done_data = NULL;
+	}
+
+	return result;
+}
+
 static void
 brasero_task_class_init (BraseroTaskClass *klass)
 {
@@ -709,6 +797,16 @@ brasero_task_finalize (GObject *object)
 	cobj = BRASERO_TASK (object);
 	priv = BRASERO_TASK_PRIVATE (cobj);
 
+	if (priv->done_id) {
+		g_source_remove (priv->done_id);
+		priv->done_id = 0;
+	}
+
+	if (priv->clock_id) {
+		g_source_remove (priv->clock_id);
+		priv->clock_id = 0;
+	}
+
 	if (priv->leader) {
 		g_object_unref (priv->leader);
 		priv->leader = NULL;
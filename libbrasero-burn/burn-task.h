@@ -59,6 +59,11 @@ struct _BraseroTaskClass {
 	BraseroTaskCtxClass parent_class;
 };
 
+typedef void (*BraseroTaskDoneFunc) (BraseroTask *task,
+				     BraseroBurnResult result,
+				     GError *error,
+				     gpointer user_data);
+
 GType brasero_task_get_type (void);
 
 BraseroTask *brasero_task_new (void);
@@ -73,6 +78,12 @@ BraseroBurnResult
 brasero_task_run (BraseroTask *task,
 		  GError **error);
 
+BraseroBurnResult
+brasero_task_run_async (BraseroTask *task,
+			BraseroTaskDoneFunc func,
+			gpointer user_data,
+			GError **error);
+
 BraseroBurnResult
 brasero_task_check (BraseroTask *task,
 		    GError **error);
@@ -38,6 +38,9 @@ G_BEGIN_DECLS
 gboolean
 brasero_drive_probing (BraseroDrive *drive);
 
+gint64
+brasero_drive_get_time_to_ready (BraseroDrive *drive);
+
 gboolean
 brasero_medium_probing (BraseroMedium *medium);
 
@@ -65,15 +65,16 @@
 #include "scsi-mode-pages.h"
 #include "scsi-sbc.h"
 
+#include "brasero-probe-scheduler.h"
+
 typedef struct _BraseroDrivePrivate BraseroDrivePrivate;
 struct _BraseroDrivePrivate
 {
 	GDrive *gdrive;
 
-	GThread *probe;
+	gboolean probe;
 	GMutex *mutex;
 	GCond *cond;
-	GCond *cond_probe;
 	gint probe_id;
 
 	BraseroMedium *medium;
@@ -117,7 +118,8 @@ enum {
 
 G_DEFINE_TYPE (BraseroDrive, brasero_drive, G_TYPE_OBJECT);
 
-#define BRASERO_DRIVE_OPEN_ATTEMPTS			5
+/* How long we keep on trying to open a busy drive (in microseconds) */
+#define BRASERO_DRIVE_OPEN_TIMEOUT			6000000
 
 static void
 brasero_drive_probe_inside (BraseroDrive *drive);
@@ -216,7 +218,7 @@ brasero_drive_cancel_probing (BraseroDrive *drive)
 		/* This is to wake up the thread if it
 		 * was asleep waiting to retry to get
 		 * hold of a handle to probe the drive */
-		g_cond_signal (priv->cond_probe);
+		brasero_probe_scheduler_wakeup (priv->device);
 
 		g_cond_wait (priv->cond, priv->mutex);
 	}
@@ -240,7 +242,7 @@ brasero_drive_wait_probing_thread (BraseroDrive *drive)
 		/* This is to wake up the thread if it
 		 * was asleep waiting to retry to get
 		 * hold of a handle to probe the drive */
-		g_cond_signal (priv->cond_probe);
+		brasero_probe_scheduler_wakeup (priv->device);
 		g_cond_wait (priv->cond, priv->mutex);
 	}
 	g_mutex_unlock (priv->mutex);
@@ -853,6 +855,24 @@ brasero_drive_medium_probed (BraseroMedium *medium,
 		       priv->medium);
 }
 
+/**
+ * This is not public API. Defined in brasero-drive-priv.h.
+ */
+gint64
+brasero_drive_get_time_to_ready (BraseroDrive *drive)
+{
+	BraseroDrivePrivate *priv;
+
+	g_return_val_if_fail (drive != NULL, -1);
+	g_return_val_if_fail (BRASERO_IS_DRIVE (drive), -1);
+
+	priv = BRASERO_DRIVE_PRIVATE (drive);
+	if (!priv->device)
+		return -1;
+
+	return brasero_probe_scheduler_get_time_to_ready (priv->device);
+}
+
 /**
  * This is not public API. Defined in brasero-drive-priv.h.
  */
@@ -865,7 +885,7 @@ brasero_drive_probing (BraseroDrive *drive)
 	g_return_val_if_fail (BRASERO_IS_DRIVE (drive), FALSE);
 
 	priv = BRASERO_DRIVE_PRIVATE (drive);
-	if (priv->probe != NULL)
+	if (priv->probe)
 		return TRUE;
 
 	if (priv->medium)
@@ -933,11 +953,10 @@ brasero_drive_probed_inside (gpointer data)
 	return FALSE;
 }
 
-static gpointer
+static void
 brasero_drive_probe_inside_thread (gpointer data)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	BraseroProbeTimer timer;
 	const gchar *device;
 	BraseroScsiErrCode code;
 	BraseroDrivePrivate *priv;
@@ -947,22 +966,20 @@ brasero_drive_probe_inside_thread (gpointer data)
 	priv = BRASERO_DRIVE_PRIVATE (drive);
 
 	/* the drive might be busy (a burning is going on) so we don't block
-	 * but we re-try to open it every second */
+	 * but we re-try to open it until the scheduler tells us to give up */
 	device = brasero_drive_get_device (drive);
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
 	priv->has_medium = FALSE;
 
+	brasero_probe_scheduler_start (&timer, device);
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_DRIVE_OPEN_ATTEMPTS) {
-		sleep (1);
-
+	while (!handle && brasero_probe_scheduler_wait (&timer, BRASERO_DRIVE_OPEN_TIMEOUT)) {
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Open () cancelled");
 			goto end;
 		}
 
-		counter ++;
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -993,14 +1010,7 @@ brasero_drive_probe_inside_thread (gpointer data)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		brasero_probe_scheduler_wait (&timer, -1);
 
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Device probing cancelled");
@@ -1011,6 +1021,7 @@ brasero_drive_probe_inside_thread (gpointer data)
 	}
 
 	BRASERO_MEDIA_LOG ("Medium inserted");
+	brasero_probe_scheduler_ready (&timer);
 	brasero_device_handle_close (handle);
 
 	priv->has_medium = TRUE;
@@ -1022,13 +1033,9 @@ end:
 	if (!priv->probe_cancelled)
 		priv->probe_id = g_idle_add (brasero_drive_probed_inside, drive);
 
-	priv->probe = NULL;
+	priv->probe = FALSE;
 	g_cond_broadcast (priv->cond);
 	g_mutex_unlock (priv->mutex);
-
-	g_thread_exit (0);
-
-	return NULL;
 }
 
 static void
@@ -1056,10 +1063,8 @@ brasero_drive_probe_inside (BraseroDrive *drive)
 	priv->probe_waiting = FALSE;
 	priv->probe_cancelled = FALSE;
 
-	priv->probe = g_thread_create (brasero_drive_probe_inside_thread,
-	                               drive,
-				       FALSE,
-				       NULL);
+	priv->probe = TRUE;
+	brasero_probe_scheduler_push (brasero_drive_probe_inside_thread, drive);
 
 	g_mutex_unlock (priv->mutex);
 }
@@ -1306,11 +1311,10 @@ brasero_drive_get_caps_2A (BraseroDrive *self,
 	g_free (data);
 }
 
-static gpointer
+static void
 brasero_drive_probe_thread (gpointer data)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	BraseroProbeTimer timer;
 	const gchar *device;
 	BraseroScsiResult res;
 	BraseroScsiInquiry hdr;
@@ -1322,20 +1326,18 @@ brasero_drive_probe_thread (gpointer data)
 	priv = BRASERO_DRIVE_PRIVATE (drive);
 
 	/* the drive might be busy (a burning is going on) so we don't block
-	 * but we re-try to open it every second */
+	 * but we re-try to open it until the scheduler tells us to give up */
 	device = brasero_drive_get_device (drive);
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
+	brasero_probe_scheduler_start (&timer, device);
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_DRIVE_OPEN_ATTEMPTS) {
-		sleep (1);
-
+	while (!handle && brasero_probe_scheduler_wait (&timer, BRASERO_DRIVE_OPEN_TIMEOUT)) {
 		if (priv->initial_probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Open () cancelled");
 			goto end;
 		}
 
-		counter ++;
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -1361,14 +1363,7 @@ brasero_drive_probe_thread (gpointer data)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		brasero_probe_scheduler_wait (&timer, -1);
 
 		if (priv->initial_probe_cancelled) {
 			brasero_device_handle_close (handle);
@@ -1378,6 +1373,7 @@ brasero_drive_probe_thread (gpointer data)
 	}
 
 	BRASERO_MEDIA_LOG ("Device ready");
+	brasero_probe_scheduler_ready (&timer);
 	priv->has_medium = TRUE;
 
 capabilities:
@@ -1424,15 +1420,11 @@ end:
 
 	brasero_drive_update_medium (drive);
 
-	priv->probe = NULL;
+	priv->probe = FALSE;
 	priv->initial_probe = FALSE;
 
 	g_cond_broadcast (priv->cond);
 	g_mutex_unlock (priv->mutex);
-
-	g_thread_exit (0);
-
-	return NULL;
 }
 
 static void
@@ -1463,10 +1455,8 @@ brasero_drive_init_real_device (BraseroDrive *drive,
 	g_mutex_lock (priv->mutex);
 
 	priv->initial_probe = TRUE;
-	priv->probe = g_thread_create (brasero_drive_probe_thread,
-				       drive,
-				       FALSE,
-				       NULL);
+	priv->probe = TRUE;
+	brasero_probe_scheduler_push (brasero_drive_probe_thread, drive);
 
 	g_mutex_unlock (priv->mutex);
 }
@@ -1548,7 +1538,6 @@ brasero_drive_init (BraseroDrive *object)
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
-	priv->cond_probe = g_cond_new ();
 }
 
 static void
@@ -1572,11 +1561,6 @@ brasero_drive_finalize (GObject *object)
 		priv->cond = NULL;
 	}
 
-	if (priv->cond_probe) {
-		g_cond_free (priv->cond_probe);
-		priv->cond_probe = NULL;
-	}
-
 	if (priv->medium) {
 		g_signal_emit (object,
 			       drive_signals [MEDIUM_REMOVED],
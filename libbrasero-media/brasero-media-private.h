@@ -52,6 +52,9 @@ brasero_media_get_all_list (BraseroMedia type);
 void
 brasero_media_library_set_debug (gboolean value);
 
+const gchar * const *
+brasero_media_library_get_emulated_drives (void);
+
 void
 brasero_media_to_string (BraseroMedia media,
 			 gchar *string);
@@ -42,6 +42,7 @@
 #include "brasero-media-private.h"
 
 static gboolean debug = 0;
+static gchar **emulated_drives = NULL;
 
 #define BRASERO_MEDIUM_TRUE_RANDOM_WRITABLE(media)				\
 	(BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_DVDRW_RESTRICTED) ||		\
@@ -53,6 +54,9 @@ static const GOptionEntry options [] = {
 	{ "brasero-media-debug", 0, 0, G_OPTION_ARG_NONE, &debug,
 	  N_("Display debug statements on stdout for Brasero media library"),
 	  NULL },
+	{ "brasero-media-emulated-drive", 0, 0, G_OPTION_ARG_STRING_ARRAY, &emulated_drives,
+	  N_("Add an emulated drive (emulator:PROFILE[,image=FILE][,latency=µs][,seek=µs][,rate=kB/s][,spinup=ms])"),
+	  NULL },
 	{ NULL }
 };
 
@@ -62,6 +66,12 @@ brasero_media_library_set_debug (gboolean value)
 	debug = value;
 }
 
+const gchar * const *
+brasero_media_library_get_emulated_drives (void)
+{
+	return (const gchar * const *) emulated_drives;
+}
+
 static GSList *
 brasero_media_add_to_list (GSList *retval,
 			   BraseroMedia media)
@@ -0,0 +1,302 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "brasero-media-private.h"
+#include "brasero-medium-cache.h"
+
+#include "scsi-device.h"
+#include "scsi-mmc1.h"
+#include "scsi-mmc2.h"
+#include "scsi-spc1.h"
+#include "scsi-sbc.h"
+#include "scsi-utils.h"
+#include "scsi-q-subchannel.h"
+
+#define BRASERO_MEDIUM_CACHE_FILE		"media-cache"
+#define BRASERO_MEDIUM_CACHE_MAX_ENTRIES	256
+
+static GKeyFile *cache = NULL;
+G_LOCK_DEFINE_STATIC (cache);
+
+/**
+ * The fingerprint is a digest of everything that identifies a closed disc
+ * for a given drive: the INQUIRY data of the drive (speeds and capabilities
+ * depend on it), the current profile, the disc information, the TOC, the ATIP
+ * or the DVD media id when available and the volume descriptor of the last
+ * data track. Blank and appendable discs are not fingerprinted since their
+ * contents can change without their TOC telling.
+ */
+
+static void
+brasero_medium_cache_add_volume_descriptor (GChecksum *checksum,
+					    BraseroDeviceHandle *handle,
+					    BraseroScsiFormattedTocData *toc,
+					    int size)
+{
+	int i, num;
+	gint start = -1;
+	BraseroScsiTocDesc *desc;
+	unsigned char buffer [2048];
+
+	num = (size - sizeof (BraseroScsiFormattedTocData)) /
+	       sizeof (BraseroScsiTocDesc);
+
+	desc = toc->desc;
+	for (i = 0; i < num; i ++, desc ++) {
+		if (desc->track_num == BRASERO_SCSI_TRACK_LEADOUT_START)
+			break;
+
+		if (desc->control & BRASERO_SCSI_TRACK_DATA)
+			start = BRASERO_GET_32 (desc->track_start);
+	}
+
+	if (start < 0)
+		return;
+
+	/* The primary volume descriptor holds the volume label as well as the
+	 * creation and modification dates which tell apart two discs with the
+	 * same layout (pressed DVDs and BDs have a synthetic TOC). */
+	if (brasero_sbc_read10_block (handle,
+				      start + 16,
+				      1,
+				      buffer,
+				      sizeof (buffer),
+				      NULL) == BRASERO_SCSI_OK)
+		g_checksum_update (checksum, buffer, sizeof (buffer));
+}
+
+gchar *
+brasero_medium_cache_get_fingerprint (BraseroDeviceHandle *handle,
+				      BraseroScsiErrCode *code)
+{
+	int size;
+	gchar *fingerprint;
+	GChecksum *checksum;
+	BraseroScsiResult result;
+	BraseroScsiInquiry inquiry;
+	BraseroScsiProfile profile;
+	BraseroScsiAtipData *atip = NULL;
+	BraseroScsiDiscInfoStd *info = NULL;
+	BraseroScsiFormattedTocData *toc = NULL;
+	BraseroScsiReadDiscStructureHdr *hdr = NULL;
+
+	result = brasero_spc1_inquiry (handle, &inquiry, code);
+	if (result != BRASERO_SCSI_OK)
+		return NULL;
+
+	result = brasero_mmc2_get_profile (handle, &profile, code);
+	if (result != BRASERO_SCSI_OK)
+		return NULL;
+
+	result = brasero_mmc1_read_disc_information_std (handle,
+							 &info,
+							 &size,
+							 code);
+	if (result != BRASERO_SCSI_OK)
+		return NULL;
+
+	if (info->status != BRASERO_SCSI_DISC_FINALIZED || info->erasable) {
+		BRASERO_MEDIA_LOG ("Medium can't be cached");
+		g_free (info);
+		return NULL;
+	}
+
+	checksum = g_checksum_new (G_CHECKSUM_SHA256);
+	g_checksum_update (checksum, inquiry.vendor, sizeof (inquiry.vendor));
+	g_checksum_update (checksum, inquiry.name, sizeof (inquiry.name));
+	g_checksum_update (checksum, inquiry.revision, sizeof (inquiry.revision));
+	g_checksum_update (checksum, (guchar *) &profile, sizeof (profile));
+	g_checksum_update (checksum, (guchar *) info, size);
+	g_free (info);
+
+	result = brasero_mmc1_read_toc_formatted (handle,
+						  0,
+						  &toc,
+						  &size,
+						  code);
+	if (result != BRASERO_SCSI_OK
+	||  size < sizeof (BraseroScsiFormattedTocData)) {
+		BRASERO_MEDIA_LOG ("READ TOC failed");
+		g_checksum_free (checksum);
+		g_free (toc);
+		return NULL;
+	}
+
+	g_checksum_update (checksum, (guchar *) toc, size);
+	brasero_medium_cache_add_volume_descriptor (checksum, handle, toc, size);
+	g_free (toc);
+
+	/* These are optional: ATIP only exists for CD-R(W) and the media id
+	 * only for DVD-R(W). Don't let an error there ruin the fingerprint. */
+	if (profile == BRASERO_SCSI_PROF_CDR) {
+		if (brasero_mmc1_read_atip (handle, &atip, &size, NULL) == BRASERO_SCSI_OK) {
+			g_checksum_update (checksum, (guchar *) atip, size);
+			g_free (atip);
+		}
+	}
+	else if (profile == BRASERO_SCSI_PROF_DVD_R
+	     ||  profile == BRASERO_SCSI_PROF_DVD_R_DL_SEQUENTIAL
+	     ||  profile == BRASERO_SCSI_PROF_DVD_R_DL_JUMP) {
+		if (brasero_mmc2_read_generic_structure (handle,
+							 BRASERO_SCSI_FORMAT_LESS_MEDIA_ID_DVD,
+							 &hdr,
+							 &size,
+							 NULL) == BRASERO_SCSI_OK) {
+			g_checksum_update (checksum, (guchar *) hdr, size);
+			g_free (hdr);
+		}
+	}
+
+	fingerprint = g_strdup (g_checksum_get_string (checksum));
+	g_checksum_free (checksum);
+
+	BRASERO_MEDIA_LOG ("Medium fingerprint %s", fingerprint);
+	return fingerprint;
+}
+
+static gchar *
+brasero_medium_cache_get_path (void)
+{
+	return g_build_filename (g_get_user_cache_dir (),
+				 "brasero",
+				 BRASERO_MEDIUM_CACHE_FILE,
+				 NULL);
+}
+
+static void
+brasero_medium_cache_prune (GKeyFile *key_file)
+{
+	gchar **groups;
+	gchar *oldest = NULL;
+	gint64 oldest_time = G_MAXINT64;
+	gsize num, i;
+
+	groups = g_key_file_get_groups (key_file, &num);
+	if (num <= BRASERO_MEDIUM_CACHE_MAX_ENTRIES) {
+		g_strfreev (groups);
+		return;
+	}
+
+	/* Only one entry at a time is added so removing the least recently
+	 * used is enough to keep the file size bounded. */
+	for (i = 0; i < num; i ++) {
+		gint64 used;
+
+		used = g_key_file_get_int64 (key_file, groups [i], "Used", NULL);
+		if (used < oldest_time) {
+			oldest_time = used;
+			oldest = groups [i];
+		}
+	}
+
+	if (oldest)
+		g_key_file_remove_group (key_file, oldest, NULL);
+
+	g_strfreev (groups);
+}
+
+static void
+brasero_medium_cache_save (GKeyFile *key_file)
+{
+	gchar *directory;
+	GError *error = NULL;
+	gchar *path;
+	gchar *data;
+	gsize size;
+
+	brasero_medium_cache_prune (key_file);
+
+	path = brasero_medium_cache_get_path ();
+	directory = g_path_get_dirname (path);
+	g_mkdir_with_parents (directory, S_IRWXU);
+	g_free (directory);
+
+	data = g_key_file_to_data (key_file, &size, NULL);
+	if (!g_file_set_contents (path, data, size, &error)) {
+		BRASERO_MEDIA_LOG ("Medium cache could not be saved: %s",
+				   error->message);
+		g_error_free (error);
+	}
+
+	g_free (data);
+	g_free (path);
+}
+
+/**
+ * brasero_medium_cache_lock:
+ *
+ * Returns the cache (loading it if need be) and prevents any other thread
+ * from accessing it until brasero_medium_cache_unlock () is called.
+ *
+ * Return value: a #GKeyFile. Do not free.
+ **/
+GKeyFile *
+brasero_medium_cache_lock (void)
+{
+	G_LOCK (cache);
+
+	if (!cache) {
+		gchar *path;
+
+		cache = g_key_file_new ();
+		path = brasero_medium_cache_get_path ();
+		if (!g_key_file_load_from_file (cache, path, G_KEY_FILE_NONE, NULL))
+			BRASERO_MEDIA_LOG ("No medium cache at %s", path);
+
+		g_free (path);
+	}
+
+	return cache;
+}
+
+/**
+ * brasero_medium_cache_unlock:
+ * @modified: whether the cache was changed and should be written to disk
+ *
+ * Releases the lock taken with brasero_medium_cache_lock ().
+ **/
+void
+brasero_medium_cache_unlock (gboolean modified)
+{
+	if (modified)
+		brasero_medium_cache_save (cache);
+
+	G_UNLOCK (cache);
+}
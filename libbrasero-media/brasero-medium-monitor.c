@@ -42,6 +42,7 @@
 #include "brasero-media-private.h"
 
 #include "brasero-drive-priv.h"
+#include "brasero-probe-scheduler.h"
 
 #include "scsi-device.h"
 #include "scsi-utils.h"
@@ -478,6 +479,22 @@ brasero_medium_monitor_connected_cb (GVolumeMonitor *monitor,
 	g_free (device);
 }
 
+static void
+brasero_medium_monitor_changed_cb (GVolumeMonitor *monitor,
+                                   GDrive *gdrive,
+                                   BraseroMediumMonitor *self)
+{
+	gchar *device;
+
+	device = g_drive_get_identifier (gdrive, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
+	if (!device)
+		return;
+
+	/* Probes waiting for this drive to be ready should retry at once */
+	brasero_probe_scheduler_wakeup (device);
+	g_free (device);
+}
+
 static void
 brasero_medium_monitor_volume_added_cb (GVolumeMonitor *monitor,
                                         GVolume *gvolume,
@@ -488,6 +505,12 @@ brasero_medium_monitor_volume_added_cb (GVolumeMonitor *monitor,
 
 	BRASERO_MEDIA_LOG ("GVolume addition signal");
 
+	device = g_volume_get_identifier (gvolume, G_VOLUME_IDENTIFIER_KIND_UNIX_DEVICE);
+	if (device) {
+		brasero_probe_scheduler_wakeup (device);
+		g_free (device);
+	}
+
 	/* No need to signal that addition if the GVolume
 	 * object has an associated GDrive as this is just
 	 * meant to trap blank discs which have no GDrive
@@ -643,6 +666,7 @@ brasero_medium_monitor_disconnected_cb (GVolumeMonitor *monitor,
 static void
 brasero_medium_monitor_init (BraseroMediumMonitor *object)
 {
+	const gchar * const *emulated;
 	GList *iter;
 	GList *drives;
 	GList *volumes;
@@ -713,6 +737,10 @@ brasero_medium_monitor_init (BraseroMediumMonitor *object)
 			  "drive-disconnected",
 			  G_CALLBACK (brasero_medium_monitor_disconnected_cb),
 			  object);
+	g_signal_connect (priv->gmonitor,
+			  "drive-changed",
+			  G_CALLBACK (brasero_medium_monitor_changed_cb),
+			  object);
 
 	/* add fake/file drive */
 	drive = g_object_new (BRASERO_TYPE_DRIVE,
@@ -720,6 +748,11 @@ brasero_medium_monitor_init (BraseroMediumMonitor *object)
 	                      NULL);
 	priv->drives = g_slist_prepend (priv->drives, drive);
 
+	/* add emulated drives */
+	emulated = brasero_media_library_get_emulated_drives ();
+	for (; emulated && *emulated; emulated ++)
+		brasero_medium_monitor_drive_new (object, *emulated, NULL);
+
 	return;
 }
 
@@ -759,6 +792,9 @@ brasero_medium_monitor_finalize (GObject *object)
 		g_signal_handlers_disconnect_by_func (priv->gmonitor,
 		                                      brasero_medium_monitor_disconnected_cb,
 		                                      object);
+		g_signal_handlers_disconnect_by_func (priv->gmonitor,
+		                                      brasero_medium_monitor_changed_cb,
+		                                      object);
 		g_object_unref (priv->gmonitor);
 		priv->gmonitor = NULL;
 	}
@@ -47,6 +47,9 @@
 
 #include "brasero-medium.h"
 #include "brasero-drive.h"
+#include "brasero-medium-cache.h"
+#include "brasero-speed-profile.h"
+#include "brasero-probe-scheduler.h"
 
 #include "scsi-device.h"
 #include "scsi-mmc1.h"
@@ -59,6 +62,7 @@
 #include "scsi-write-page.h"
 #include "scsi-q-subchannel.h"
 #include "scsi-dvd-structures.h"
+#include "scsi-get-performance.h"
 #include "burn-volume.h"
 
 
@@ -85,10 +89,9 @@ const gchar *types [] = {	N_("File"),
 typedef struct _BraseroMediumPrivate BraseroMediumPrivate;
 struct _BraseroMediumPrivate
 {
-	GThread *probe;
+	gboolean probe;
 	GMutex *mutex;
 	GCond *cond;
-	GCond *cond_probe;
 
 	gint probe_id;
 
@@ -104,6 +107,8 @@ struct _BraseroMediumPrivate
 	guint *rd_speeds;
 	guint *wr_speeds;
 
+	gchar *speed_profile;
+
 	goffset block_num;
 	goffset block_size;
 
@@ -171,7 +176,8 @@ enum {
 };
 static gulong medium_signals [LAST_SIGNAL] = {0, };
 
-#define BRASERO_MEDIUM_OPEN_ATTEMPTS			5
+/* How long we keep on trying to open a busy drive (in microseconds) */
+#define BRASERO_MEDIUM_OPEN_TIMEOUT			6000000
 
 static GObjectClass* parent_class = NULL;
 
@@ -579,6 +585,27 @@ brasero_medium_get_next_writable_address (BraseroMedium *medium)
 	return priv->next_wr_add;
 }
 
+/**
+ * brasero_medium_get_speed_profile:
+ * @medium: #BraseroMedium
+ *
+ * Gets the id of the speed profile (see brasero-speed-profile.c) for the
+ * drive and the kind of @medium. Only writable media have one.
+ *
+ * Return value: a #gchar * or NULL. Do not free.
+ **/
+const gchar *
+brasero_medium_get_speed_profile (BraseroMedium *medium)
+{
+	BraseroMediumPrivate *priv;
+
+	g_return_val_if_fail (medium != NULL, NULL);
+	g_return_val_if_fail (BRASERO_IS_MEDIUM (medium), NULL);
+
+	priv = BRASERO_MEDIUM_PRIVATE (medium);
+	return priv->speed_profile;
+}
+
 /**
  * brasero_medium_get_max_write_speed:
  * @medium: #BraseroMedium
@@ -1495,6 +1522,84 @@ brasero_medium_get_page_2A_write_speed_desc (BraseroMedium *self,
 	return TRUE;
 }
 
+/**
+ * The nominal performance (GET PERFORMANCE type 0) is what the drive really
+ * expects to sustain with the inserted medium over its whole surface whereas
+ * write speed descriptors only list the speeds it accepts.
+ */
+
+static void
+brasero_medium_init_speed_profile (BraseroMedium *self,
+				   BraseroDeviceHandle *handle,
+				   BraseroScsiErrCode *code)
+{
+	int size = 0;
+	int num_desc, i;
+	guint min_perf, max_perf;
+	BraseroScsiResult result;
+	BraseroMediumPrivate *priv;
+	BraseroScsiPerfDesc *desc;
+	BraseroScsiGetPerfData *perf = NULL;
+
+	priv = BRASERO_MEDIUM_PRIVATE (self);
+
+	priv->speed_profile = brasero_speed_profile_get_id (handle, code);
+	if (!priv->speed_profile)
+		return;
+
+	BRASERO_MEDIA_LOG ("Retrieving nominal write performance (Get Performance)");
+
+	result = brasero_mmc3_get_performance_perf_desc (handle,
+							 &perf,
+							 &size,
+							 code);
+	if (result != BRASERO_SCSI_OK) {
+		BRASERO_MEDIA_LOG ("GET PERFORMANCE failed");
+		return;
+	}
+
+	size = MIN (size, BRASERO_GET_32 (perf->hdr.len) + sizeof (perf->hdr.len));
+	if (size < (int) (sizeof (BraseroScsiGetPerfHdr) + sizeof (BraseroScsiPerfDesc))) {
+		BRASERO_MEDIA_LOG ("No descriptors");
+		g_free (perf);
+		return;
+	}
+
+	num_desc = (size - sizeof (BraseroScsiGetPerfHdr)) / sizeof (BraseroScsiPerfDesc);
+	desc = (BraseroScsiPerfDesc *) &perf->data;
+
+	min_perf = G_MAXUINT;
+	max_perf = 0;
+	for (i = 0; i < num_desc; i ++) {
+		guint start_perf, end_perf;
+
+		start_perf = BRASERO_GET_32 (desc [i].start_perf);
+		end_perf = BRASERO_GET_32 (desc [i].end_perf);
+
+		BRASERO_MEDIA_LOG ("LBA %u - %u: %u - %u kB/s",
+				   BRASERO_GET_32 (desc [i].start_lba),
+				   BRASERO_GET_32 (desc [i].end_lba),
+				   start_perf,
+				   end_perf);
+
+		if (start_perf)
+			min_perf = MIN (min_perf, start_perf);
+		if (end_perf)
+			min_perf = MIN (min_perf, end_perf);
+
+		max_perf = MAX (max_perf, MAX (start_perf, end_perf));
+	}
+
+	g_free (perf);
+
+	if (!max_perf)
+		return;
+
+	brasero_speed_profile_set_performance (priv->speed_profile,
+					       (guint64) min_perf * 1000,
+					       (guint64) max_perf * 1000);
+}
+
 static gboolean
 brasero_medium_get_speed (BraseroMedium *self,
 			  BraseroDeviceHandle *handle,
@@ -2879,7 +2984,7 @@ brasero_medium_read_CD_TEXT (BraseroMedium *self,
 	g_free (cd_text);
 }
 
-static void
+static gboolean
 brasero_medium_init_real (BraseroMedium *object,
 			  BraseroDeviceHandle *handle)
 {
@@ -2897,35 +3002,41 @@ brasero_medium_init_real (BraseroMedium *object,
 	g_free (name);
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	result = brasero_medium_get_medium_type (object, handle, &code);
 	if (result != TRUE)
-		return;
+		return FALSE;
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	result = brasero_medium_get_speed (object, handle, &code);
 	if (result != TRUE)
-		return;
+		return FALSE;
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	brasero_medium_get_capacity_by_type (object, handle, &code);
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	brasero_medium_init_caps (object, handle, &code);
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	if (!brasero_medium_get_contents (object, handle, &code))
-		return;
+		return FALSE;
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
+
+	if (priv->info & (BRASERO_MEDIUM_BLANK|BRASERO_MEDIUM_APPENDABLE|BRASERO_MEDIUM_REWRITABLE))
+		brasero_medium_init_speed_profile (object, handle, &code);
+
+	if (priv->probe_cancelled)
+		return FALSE;
 
 	/* assume that css feature is only for DVD-ROM which might be wrong but
 	 * some drives wrongly reports that css is enabled for blank DVD+R/W */
@@ -2933,20 +3044,20 @@ brasero_medium_init_real (BraseroMedium *object,
 		brasero_medium_get_css_feature (object, handle, &code);
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	/* read CD-TEXT title */
 	if (priv->info & BRASERO_MEDIUM_HAS_AUDIO)
 		brasero_medium_read_CD_TEXT (object, handle, &code);
 
 	if (priv->probe_cancelled)
-		return;
+		return FALSE;
 
 	brasero_media_to_string (priv->info, buffer);
 	BRASERO_MEDIA_LOG ("media is %s", buffer);
 
 	if (!priv->wr_speeds)
-		return;
+		return TRUE;
 
 	/* sort write speeds */
 	for (i = 0; priv->wr_speeds [i] != 0; i ++) {
@@ -2962,6 +3073,243 @@ brasero_medium_init_real (BraseroMedium *object,
 			}
 		}
 	}
+
+	return TRUE;
+}
+
+/**
+ * Probe results of closed media are cached (see brasero-medium-cache.c) so
+ * that a disc that was already seen in a drive doesn't need to go through the
+ * whole probe sequence again. Entries are refreshed by a full probe once they
+ * are older than BRASERO_MEDIUM_CACHE_MAX_AGE or were used more than
+ * BRASERO_MEDIUM_CACHE_MAX_HITS times.
+ */
+
+#define BRASERO_MEDIUM_CACHE_MAX_AGE		(7 * 24 * 60 * 60)
+#define BRASERO_MEDIUM_CACHE_MAX_HITS		32
+
+#define BRASERO_MEDIUM_CACHE_FLAG_DUMMY_SAO	1
+#define BRASERO_MEDIUM_CACHE_FLAG_DUMMY_TAO	(1 << 1)
+#define BRASERO_MEDIUM_CACHE_FLAG_BURNFREE	(1 << 2)
+#define BRASERO_MEDIUM_CACHE_FLAG_SAO		(1 << 3)
+#define BRASERO_MEDIUM_CACHE_FLAG_TAO		(1 << 4)
+#define BRASERO_MEDIUM_CACHE_FLAG_BLANK_CMD	(1 << 5)
+#define BRASERO_MEDIUM_CACHE_FLAG_WRITE_CMD	(1 << 6)
+
+static gint *
+brasero_medium_speeds_to_list (guint *speeds,
+			       gsize *num)
+{
+	*num = 0;
+	if (!speeds)
+		return NULL;
+
+	while (speeds [*num] != 0) (*num) ++;
+	return (gint *) speeds;
+}
+
+static guint *
+brasero_medium_speeds_from_list (GKeyFile *key_file,
+				 const gchar *group,
+				 const gchar *key)
+{
+	gint *list;
+	guint *speeds;
+	gsize num = 0;
+	gsize i;
+
+	list = g_key_file_get_integer_list (key_file, group, key, &num, NULL);
+	if (!list || !num) {
+		g_free (list);
+		return NULL;
+	}
+
+	speeds = g_new0 (guint, num + 1);
+	for (i = 0; i < num; i ++)
+		speeds [i] = list [i];
+
+	g_free (list);
+	return speeds;
+}
+
+static gboolean
+brasero_medium_load_from_cache (BraseroMedium *self,
+				const gchar *fingerprint)
+{
+	gint *tracks;
+	gint64 probed;
+	gint64 now;
+	guint flags;
+	gsize num = 0;
+	gint type;
+	gint hits;
+	gsize i;
+	GKeyFile *key_file;
+	BraseroMediumPrivate *priv;
+
+	priv = BRASERO_MEDIUM_PRIVATE (self);
+
+	key_file = brasero_medium_cache_lock ();
+	if (!g_key_file_has_group (key_file, fingerprint)) {
+		brasero_medium_cache_unlock (FALSE);
+		return FALSE;
+	}
+
+	now = g_get_real_time () / G_USEC_PER_SEC;
+	probed = g_key_file_get_int64 (key_file, fingerprint, "Probed", NULL);
+	hits = g_key_file_get_integer (key_file, fingerprint, "Hits", NULL);
+	type = g_key_file_get_integer (key_file, fingerprint, "Type", NULL);
+
+	if (now - probed > BRASERO_MEDIUM_CACHE_MAX_AGE
+	||  hits >= BRASERO_MEDIUM_CACHE_MAX_HITS
+	||  type < 0 || type >= (gint) G_N_ELEMENTS (types) - 1) {
+		BRASERO_MEDIA_LOG ("Cached probe results are stale");
+		brasero_medium_cache_unlock (FALSE);
+		return FALSE;
+	}
+
+	tracks = g_key_file_get_integer_list (key_file, fingerprint, "Tracks", &num, NULL);
+	if (!tracks || (num % 4) != 0) {
+		g_free (tracks);
+		brasero_medium_cache_unlock (FALSE);
+		return FALSE;
+	}
+
+	BRASERO_MEDIA_LOG ("Using cached probe results");
+
+	priv->type = types [type];
+	priv->info = g_key_file_get_integer (key_file, fingerprint, "Info", NULL);
+	priv->id = g_key_file_get_string (key_file, fingerprint, "Id", NULL);
+	priv->CD_TEXT_title = g_key_file_get_string (key_file, fingerprint, "Title", NULL);
+
+	priv->max_rd = g_key_file_get_integer (key_file, fingerprint, "MaxReadSpeed", NULL);
+	priv->max_wrt = g_key_file_get_integer (key_file, fingerprint, "MaxWriteSpeed", NULL);
+	priv->rd_speeds = brasero_medium_speeds_from_list (key_file, fingerprint, "ReadSpeeds");
+	priv->wr_speeds = brasero_medium_speeds_from_list (key_file, fingerprint, "WriteSpeeds");
+
+	priv->block_num = g_key_file_get_int64 (key_file, fingerprint, "BlockNum", NULL);
+	priv->block_size = g_key_file_get_int64 (key_file, fingerprint, "BlockSize", NULL);
+	priv->first_open_track = g_key_file_get_integer (key_file, fingerprint, "FirstOpenTrack", NULL);
+	priv->next_wr_add = g_key_file_get_int64 (key_file, fingerprint, "NextWritableAddress", NULL);
+
+	flags = g_key_file_get_integer (key_file, fingerprint, "Flags", NULL);
+	priv->dummy_sao = (flags & BRASERO_MEDIUM_CACHE_FLAG_DUMMY_SAO) != 0;
+	priv->dummy_tao = (flags & BRASERO_MEDIUM_CACHE_FLAG_DUMMY_TAO) != 0;
+	priv->burnfree = (flags & BRASERO_MEDIUM_CACHE_FLAG_BURNFREE) != 0;
+	priv->sao = (flags & BRASERO_MEDIUM_CACHE_FLAG_SAO) != 0;
+	priv->tao = (flags & BRASERO_MEDIUM_CACHE_FLAG_TAO) != 0;
+	priv->blank_command = (flags & BRASERO_MEDIUM_CACHE_FLAG_BLANK_CMD) != 0;
+	priv->write_command = (flags & BRASERO_MEDIUM_CACHE_FLAG_WRITE_CMD) != 0;
+
+	for (i = 0; i < num; i += 4) {
+		BraseroMediumTrack *track;
+
+		track = g_new0 (BraseroMediumTrack, 1);
+		track->session = tracks [i];
+		track->type = tracks [i + 1];
+		track->start = tracks [i + 2];
+		track->blocks_num = tracks [i + 3];
+		priv->tracks = g_slist_prepend (priv->tracks, track);
+	}
+	priv->tracks = g_slist_reverse (priv->tracks);
+	g_free (tracks);
+
+	g_key_file_set_integer (key_file, fingerprint, "Hits", hits + 1);
+	g_key_file_set_int64 (key_file, fingerprint, "Used", now);
+	brasero_medium_cache_unlock (TRUE);
+
+	return TRUE;
+}
+
+static void
+brasero_medium_save_to_cache (BraseroMedium *self,
+			      const gchar *fingerprint)
+{
+	gint *speeds;
+	gint *tracks;
+	gint64 now;
+	guint flags;
+	gsize num;
+	gint type;
+	GSList *iter;
+	GKeyFile *key_file;
+	BraseroMediumPrivate *priv;
+
+	priv = BRASERO_MEDIUM_PRIVATE (self);
+
+	/* Only cache media that were fully identified and whose state can't
+	 * change from one insertion to another */
+	if (!(priv->info & BRASERO_MEDIUM_CLOSED)
+	||   (priv->info & BRASERO_MEDIUM_REWRITABLE)
+	||  !priv->type)
+		return;
+
+	for (type = 0; types [type]; type ++) {
+		if (types [type] == priv->type)
+			break;
+	}
+
+	if (!types [type])
+		return;
+
+	key_file = brasero_medium_cache_lock ();
+
+	g_key_file_remove_group (key_file, fingerprint, NULL);
+
+	now = g_get_real_time () / G_USEC_PER_SEC;
+	g_key_file_set_int64 (key_file, fingerprint, "Probed", now);
+	g_key_file_set_int64 (key_file, fingerprint, "Used", now);
+	g_key_file_set_integer (key_file, fingerprint, "Hits", 0);
+
+	g_key_file_set_integer (key_file, fingerprint, "Type", type);
+	g_key_file_set_integer (key_file, fingerprint, "Info", priv->info);
+	if (priv->id)
+		g_key_file_set_string (key_file, fingerprint, "Id", priv->id);
+	if (priv->CD_TEXT_title)
+		g_key_file_set_string (key_file, fingerprint, "Title", priv->CD_TEXT_title);
+
+	g_key_file_set_integer (key_file, fingerprint, "MaxReadSpeed", priv->max_rd);
+	g_key_file_set_integer (key_file, fingerprint, "MaxWriteSpeed", priv->max_wrt);
+
+	speeds = brasero_medium_speeds_to_list (priv->rd_speeds, &num);
+	if (num)
+		g_key_file_set_integer_list (key_file, fingerprint, "ReadSpeeds", speeds, num);
+
+	speeds = brasero_medium_speeds_to_list (priv->wr_speeds, &num);
+	if (num)
+		g_key_file_set_integer_list (key_file, fingerprint, "WriteSpeeds", speeds, num);
+
+	g_key_file_set_int64 (key_file, fingerprint, "BlockNum", priv->block_num);
+	g_key_file_set_int64 (key_file, fingerprint, "BlockSize", priv->block_size);
+	g_key_file_set_integer (key_file, fingerprint, "FirstOpenTrack", priv->first_open_track);
+	g_key_file_set_int64 (key_file, fingerprint, "NextWritableAddress", priv->next_wr_add);
+
+	flags = 0;
+	flags |= priv->dummy_sao? BRASERO_MEDIUM_CACHE_FLAG_DUMMY_SAO:0;
+	flags |= priv->dummy_tao? BRASERO_MEDIUM_CACHE_FLAG_DUMMY_TAO:0;
+	flags |= priv->burnfree? BRASERO_MEDIUM_CACHE_FLAG_BURNFREE:0;
+	flags |= priv->sao? BRASERO_MEDIUM_CACHE_FLAG_SAO:0;
+	flags |= priv->tao? BRASERO_MEDIUM_CACHE_FLAG_TAO:0;
+	flags |= priv->blank_command? BRASERO_MEDIUM_CACHE_FLAG_BLANK_CMD:0;
+	flags |= priv->write_command? BRASERO_MEDIUM_CACHE_FLAG_WRITE_CMD:0;
+	g_key_file_set_integer (key_file, fingerprint, "Flags", flags);
+
+	num = g_slist_length (priv->tracks) * 4;
+	tracks = g_new0 (gint, MAX (num, 1));
+	num = 0;
+	for (iter = priv->tracks; iter; iter = iter->next) {
+		BraseroMediumTrack *track;
+
+		track = iter->data;
+		tracks [num ++] = track->session;
+		tracks [num ++] = track->type;
+		tracks [num ++] = track->start;
+		tracks [num ++] = track->blocks_num;
+	}
+	g_key_file_set_integer_list (key_file, fingerprint, "Tracks", tracks, num);
+	g_free (tracks);
+
+	brasero_medium_cache_unlock (TRUE);
 }
 
 gboolean
@@ -2972,7 +3320,7 @@ brasero_medium_probing (BraseroMedium *medium)
 	g_return_val_if_fail (BRASERO_IS_MEDIUM (medium), FALSE);
 
 	priv = BRASERO_MEDIUM_PRIVATE (medium);
-	return priv->probe != NULL;
+	return priv->probe;
 }
 
 static gboolean
@@ -2996,12 +3344,12 @@ brasero_medium_probed (gpointer data)
 	return FALSE;
 }
 
-static gpointer
+static void
 brasero_medium_probe_thread (gpointer self)
 {
-	gint counter = 0;
-	GTimeVal wait_time;
+	BraseroProbeTimer timer;
 	const gchar *device;
+	gchar *fingerprint;
 	BraseroScsiErrCode code;
 	BraseroMediumPrivate *priv;
 	BraseroDeviceHandle *handle;
@@ -3011,18 +3359,16 @@ brasero_medium_probe_thread (gpointer self)
 	priv->info = BRASERO_MEDIUM_BUSY;
 
 	/* the drive might be busy (a burning is going on) so we don't block
-	 * but we re-try to open it every second */
+	 * but we re-try to open it until the scheduler tells us to give up */
 	device = brasero_drive_get_device (priv->drive);
 	BRASERO_MEDIA_LOG ("Trying to open device %s", device);
 
+	brasero_probe_scheduler_start (&timer, device);
 	handle = brasero_device_handle_open (device, FALSE, &code);
-	while (!handle && counter <= BRASERO_MEDIUM_OPEN_ATTEMPTS) {
-		sleep (1);
-
+	while (!handle && brasero_probe_scheduler_wait (&timer, BRASERO_MEDIUM_OPEN_TIMEOUT)) {
 		if (priv->probe_cancelled)
 			goto end;
 
-		counter ++;
 		handle = brasero_device_handle_open (device, FALSE, &code);
 	}
 
@@ -3055,14 +3401,7 @@ brasero_medium_probe_thread (gpointer self)
 			goto end;
 		}
 
-		g_get_current_time (&wait_time);
-		g_time_val_add (&wait_time, 2000000);
-
-		g_mutex_lock (priv->mutex);
-		g_cond_timed_wait (priv->cond_probe,
-		                   priv->mutex,
-		                   &wait_time);
-		g_mutex_unlock (priv->mutex);
+		brasero_probe_scheduler_wait (&timer, -1);
 
 		if (priv->probe_cancelled) {
 			BRASERO_MEDIA_LOG ("Device probing cancelled");
@@ -3073,24 +3412,30 @@ brasero_medium_probe_thread (gpointer self)
 	}
 
 	BRASERO_MEDIA_LOG ("Device ready");
+	brasero_probe_scheduler_ready (&timer);
 
-	brasero_medium_init_real (BRASERO_MEDIUM (self), handle);
+	fingerprint = brasero_medium_cache_get_fingerprint (handle, &code);
+	if (!fingerprint
+	||  !brasero_medium_load_from_cache (BRASERO_MEDIUM (self), fingerprint)) {
+		if (brasero_medium_init_real (BRASERO_MEDIUM (self), handle)
+		&&  fingerprint
+		&& !priv->probe_cancelled)
+			brasero_medium_save_to_cache (BRASERO_MEDIUM (self), fingerprint);
+	}
+
+	g_free (fingerprint);
 	brasero_device_handle_close (handle);
 
 end:
 
 	g_mutex_lock (priv->mutex);
 
-	priv->probe = NULL;
+	priv->probe = FALSE;
 	if (!priv->probe_cancelled)
 		priv->probe_id = g_idle_add (brasero_medium_probed, self);
 
 	g_cond_broadcast (priv->cond);
 	g_mutex_unlock (priv->mutex);
-
-	g_thread_exit (0);
-
-	return NULL;
 }
 
 static void
@@ -3106,10 +3451,8 @@ brasero_medium_probe (BraseroMedium *self)
 	 * BraseroDrive that exported until it returns PROBED signal.
 	 * One (good) side effect is that it also improves start time. */
 	g_mutex_lock (priv->mutex);
-	priv->probe = g_thread_create (brasero_medium_probe_thread,
-				       self,
-				       FALSE,
-				       NULL);
+	priv->probe = TRUE;
+	brasero_probe_scheduler_push (brasero_medium_probe_thread, self);
 	g_mutex_unlock (priv->mutex);
 }
 
@@ -3134,7 +3477,6 @@ brasero_medium_init (BraseroMedium *object)
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
-	priv->cond_probe = g_cond_new ();
 
 	/* we can't do anything here since properties haven't been set yet */
 }
@@ -3156,7 +3498,7 @@ brasero_medium_finalize (GObject *object)
 		/* This is to wake up the thread if it
 		 * was asleep waiting to retry to get
 		 * hold of a handle to probe the drive */
-		g_cond_signal (priv->cond_probe);
+		brasero_probe_scheduler_wakeup (brasero_drive_get_device (priv->drive));
 
 		/* Wait for the end of the thread */
 		g_cond_wait (priv->cond, priv->mutex);
@@ -3178,11 +3520,6 @@ brasero_medium_finalize (GObject *object)
 		priv->cond = NULL;
 	}
 
-	if (priv->cond_probe) {
-		g_cond_free (priv->cond_probe);
-		priv->cond_probe = NULL;
-	}
-
 	if (priv->id) {
 		g_free (priv->id);
 		priv->id = NULL;
@@ -3199,6 +3536,9 @@ brasero_medium_finalize (GObject *object)
 	g_free (priv->wr_speeds);
 	priv->wr_speeds = NULL;
 
+	g_free (priv->speed_profile);
+	priv->speed_profile = NULL;
+
 	g_slist_foreach (priv->tracks, (GFunc) g_free, NULL);
 	g_slist_free (priv->tracks);
 	priv->tracks = NULL;
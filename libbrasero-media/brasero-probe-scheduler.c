@@ -0,0 +1,299 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <glib.h>
+
+#include "brasero-media-private.h"
+#include "brasero-probe-scheduler.h"
+
+/**
+ * All drive and medium probes go through here. They are run concurrently by
+ * a shared pool of threads. When a drive is busy or not ready yet, probes
+ * don't sleep for a fixed time but back off exponentially starting with a
+ * short delay. Any media change event reported for a device (GIO signals
+ * forwarded by BraseroMediumMonitor or a cancellation) wakes up at once all
+ * the probes waiting on that device.
+ */
+
+#define BRASERO_PROBE_BACKOFF_MIN	50000		/* 50 ms */
+#define BRASERO_PROBE_BACKOFF_MAX	2000000		/* 2 s */
+
+typedef struct _BraseroProbeDevice BraseroProbeDevice;
+struct _BraseroProbeDevice {
+	guint events;
+	gint64 time_to_ready;
+};
+
+typedef struct _BraseroProbeJob BraseroProbeJob;
+struct _BraseroProbeJob {
+	BraseroProbeFunc func;
+	gpointer data;
+};
+
+static GThreadPool *pool = NULL;
+static GHashTable *devices = NULL;
+static GMutex *mutex = NULL;
+static GCond *cond = NULL;
+G_LOCK_DEFINE_STATIC (scheduler);
+
+static void
+brasero_probe_scheduler_init (void)
+{
+	G_LOCK (scheduler);
+	if (!mutex) {
+		mutex = g_mutex_new ();
+		cond = g_cond_new ();
+		devices = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 g_free,
+						 g_free);
+	}
+	G_UNLOCK (scheduler);
+}
+
+/* Must be called with mutex held */
+static BraseroProbeDevice *
+brasero_probe_scheduler_get_device (const gchar *device)
+{
+	BraseroProbeDevice *probe_device;
+
+	probe_device = g_hash_table_lookup (devices, device);
+	if (!probe_device) {
+		probe_device = g_new0 (BraseroProbeDevice, 1);
+		probe_device->time_to_ready = -1;
+		g_hash_table_insert (devices, g_strdup (device), probe_device);
+	}
+
+	return probe_device;
+}
+
+static void
+brasero_probe_scheduler_thread (gpointer data,
+				gpointer user_data)
+{
+	BraseroProbeJob *job = data;
+
+	job->func (job->data);
+	g_free (job);
+}
+
+/**
+ * brasero_probe_scheduler_push:
+ * @func: the function doing the probe
+ * @data: the data passed to @func
+ *
+ * Runs @func in a thread of the probe pool. Probes are never queued behind
+ * one another: each runs as soon as it is pushed.
+ **/
+void
+brasero_probe_scheduler_push (BraseroProbeFunc func,
+			      gpointer data)
+{
+	BraseroProbeJob *job;
+
+	brasero_probe_scheduler_init ();
+
+	G_LOCK (scheduler);
+	if (!pool)
+		pool = g_thread_pool_new (brasero_probe_scheduler_thread,
+					  NULL,
+					  -1,
+					  FALSE,
+					  NULL);
+	G_UNLOCK (scheduler);
+
+	job = g_new0 (BraseroProbeJob, 1);
+	job->func = func;
+	job->data = data;
+	g_thread_pool_push (pool, job, NULL);
+}
+
+/**
+ * brasero_probe_scheduler_start:
+ * @timer: a #BraseroProbeTimer
+ * @device: the path of the device probed
+ *
+ * Initializes @timer at the start of a probe. @device must stay valid as long
+ * as @timer is used.
+ **/
+void
+brasero_probe_scheduler_start (BraseroProbeTimer *timer,
+			       const gchar *device)
+{
+	BraseroProbeDevice *probe_device;
+
+	brasero_probe_scheduler_init ();
+
+	timer->device = device;
+	timer->start = g_get_monotonic_time ();
+	timer->attempt = 0;
+
+	g_mutex_lock (mutex);
+	probe_device = brasero_probe_scheduler_get_device (device);
+	timer->events = probe_device->events;
+	g_mutex_unlock (mutex);
+}
+
+/**
+ * brasero_probe_scheduler_wait:
+ * @timer: a #BraseroProbeTimer
+ * @timeout: time in microseconds after the start of the probe past which
+ * waiting is pointless or -1
+ *
+ * Waits before a new attempt. The delay doubles with each attempt unless an
+ * event was reported for the device, in which case it returns at once and
+ * starts over with the shortest delay.
+ *
+ * Return value: FALSE if @timeout was reached, TRUE otherwise.
+ **/
+gboolean
+brasero_probe_scheduler_wait (BraseroProbeTimer *timer,
+			      gint64 timeout)
+{
+	BraseroProbeDevice *probe_device;
+	GTimeVal wait_time;
+	gint64 deadline;
+	gint64 delay;
+	gint64 now;
+
+	now = g_get_monotonic_time ();
+	if (timeout >= 0 && now - timer->start >= timeout)
+		return FALSE;
+
+	delay = MIN ((gint64) BRASERO_PROBE_BACKOFF_MIN << MIN (timer->attempt, 16), BRASERO_PROBE_BACKOFF_MAX);
+	if (timeout >= 0)
+		delay = MIN (delay, timer->start + timeout - now);
+
+	deadline = now + delay;
+	timer->attempt ++;
+
+	g_get_current_time (&wait_time);
+	g_time_val_add (&wait_time, delay);
+
+	g_mutex_lock (mutex);
+	probe_device = brasero_probe_scheduler_get_device (timer->device);
+	while (probe_device->events == timer->events
+	&&     g_get_monotonic_time () < deadline) {
+		if (!g_cond_timed_wait (cond, mutex, &wait_time))
+			break;
+	}
+
+	if (probe_device->events != timer->events) {
+		BRASERO_MEDIA_LOG ("Event on %s: retrying at once", timer->device);
+		timer->events = probe_device->events;
+		timer->attempt = 0;
+	}
+	g_mutex_unlock (mutex);
+
+	return TRUE;
+}
+
+/**
+ * brasero_probe_scheduler_ready:
+ * @timer: a #BraseroProbeTimer
+ *
+ * Records how long it took for the device to be ready since the start of the
+ * probe.
+ **/
+void
+brasero_probe_scheduler_ready (BraseroProbeTimer *timer)
+{
+	BraseroProbeDevice *probe_device;
+	gint64 elapsed;
+
+	elapsed = g_get_monotonic_time () - timer->start;
+
+	g_mutex_lock (mutex);
+	probe_device = brasero_probe_scheduler_get_device (timer->device);
+	probe_device->time_to_ready = elapsed;
+	g_mutex_unlock (mutex);
+
+	BRASERO_MEDIA_LOG ("%s ready after %" G_GINT64_FORMAT " ms (%i retries)",
+			   timer->device,
+			   elapsed / 1000,
+			   timer->attempt);
+}
+
+/**
+ * brasero_probe_scheduler_wakeup:
+ * @device: the path of a device or NULL for all devices
+ *
+ * Wakes up all the probes waiting on @device.
+ **/
+void
+brasero_probe_scheduler_wakeup (const gchar *device)
+{
+	BraseroProbeDevice *probe_device;
+
+	brasero_probe_scheduler_init ();
+
+	g_mutex_lock (mutex);
+	if (device) {
+		probe_device = brasero_probe_scheduler_get_device (device);
+		probe_device->events ++;
+	}
+	else {
+		GHashTableIter iter;
+
+		g_hash_table_iter_init (&iter, devices);
+		while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &probe_device))
+			probe_device->events ++;
+	}
+
+	g_cond_broadcast (cond);
+	g_mutex_unlock (mutex);
+}
+
+/**
+ * brasero_probe_scheduler_get_time_to_ready:
+ * @device: the path of a device
+ *
+ * Return value: the time in microseconds the last probe of @device took
+ * until the device was ready or -1 if it never was.
+ **/
+gint64
+brasero_probe_scheduler_get_time_to_ready (const gchar *device)
+{
+	BraseroProbeDevice *probe_device;
+	gint64 time_to_ready;
+
+	brasero_probe_scheduler_init ();
+
+	g_mutex_lock (mutex);
+	probe_device = brasero_probe_scheduler_get_device (device);
+	time_to_ready = probe_device->time_to_ready;
+	g_mutex_unlock (mutex);
+
+	return time_to_ready;
+}
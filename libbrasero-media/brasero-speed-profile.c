@@ -0,0 +1,540 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "brasero-media-private.h"
+#include "brasero-speed-profile.h"
+
+#include "scsi-device.h"
+#include "scsi-mmc1.h"
+#include "scsi-mmc2.h"
+#include "scsi-spc1.h"
+#include "scsi-get-configuration.h"
+#include "scsi-read-disc-structure.h"
+#include "scsi-read-toc-pma-atip.h"
+
+#define BRASERO_SPEED_PROFILE_FILE		"speed-profiles"
+#define BRASERO_SPEED_PROFILE_MAX_ENTRIES	64
+
+/* A speed is not trusted any more once it failed more than once every
+ * BRASERO_SPEED_PROFILE_FAILURE_RATIO successful burns */
+#define BRASERO_SPEED_PROFILE_FAILURE_RATIO	5
+
+static GKeyFile *profiles = NULL;
+G_LOCK_DEFINE_STATIC (profiles);
+
+/**
+ * The medium id is the manufacturer id written on blank discs: the lead-in
+ * start time of the ATIP for CDs, the pre-pit data for DVD-R(W), the ADIP for
+ * DVD+R(W) and the disc information for BDs.
+ */
+
+static gchar *
+brasero_speed_profile_get_string (const uchar *data,
+				  gint size)
+{
+	gchar *string;
+	gint i;
+
+	string = g_strndup ((gchar *) data, size);
+	for (i = 0; string [i]; i ++) {
+		if (!g_ascii_isalnum (string [i]) && string [i] != '-')
+			string [i] = ' ';
+	}
+
+	g_strstrip (string);
+	if (string [0] == '\0') {
+		g_free (string);
+		return NULL;
+	}
+
+	return string;
+}
+
+static gchar *
+brasero_speed_profile_get_structure_id (BraseroDeviceHandle *handle,
+					BraseroScsiGenericFormatType type,
+					gint manufacturer,
+					gint manufacturer_len,
+					gint medium,
+					gint medium_len)
+{
+	BraseroScsiReadDiscStructureHdr *hdr = NULL;
+	gchar *manufacturer_id;
+	gchar *medium_id;
+	gchar *id = NULL;
+	int size = 0;
+
+	if (brasero_mmc2_read_generic_structure (handle,
+						 type,
+						 &hdr,
+						 &size,
+						 NULL) != BRASERO_SCSI_OK)
+		return NULL;
+
+	if (size < sizeof (BraseroScsiReadDiscStructureHdr) + medium + medium_len) {
+		BRASERO_MEDIA_LOG ("Disc structure too small (%i)", size);
+		g_free (hdr);
+		return NULL;
+	}
+
+	manufacturer_id = brasero_speed_profile_get_string (hdr->data + manufacturer,
+							    manufacturer_len);
+	medium_id = medium_len ? brasero_speed_profile_get_string (hdr->data + medium, medium_len):NULL;
+	g_free (hdr);
+
+	if (manufacturer_id)
+		id = g_strdup_printf ("%s %s", manufacturer_id, medium_id ? medium_id:"");
+
+	g_free (manufacturer_id);
+	g_free (medium_id);
+	return id;
+}
+
+static gchar *
+brasero_speed_profile_get_atip_id (BraseroDeviceHandle *handle)
+{
+	BraseroScsiAtipData *atip = NULL;
+	gchar *id;
+	int size = 0;
+
+	if (brasero_mmc1_read_atip (handle, &atip, &size, NULL) != BRASERO_SCSI_OK)
+		return NULL;
+
+	if (size < sizeof (BraseroScsiAtipData)) {
+		g_free (atip);
+		return NULL;
+	}
+
+	/* The last digit of the frame is not significant */
+	id = g_strdup_printf ("%02i:%02i:%02i",
+			      atip->desc->leadin_start_time_mn,
+			      atip->desc->leadin_start_time_sec,
+			      atip->desc->leadin_start_time_frame / 10 * 10);
+	g_free (atip);
+	return id;
+}
+
+gchar *
+brasero_speed_profile_get_id (BraseroDeviceHandle *handle,
+			      BraseroScsiErrCode *code)
+{
+	gchar *id;
+	gchar *drive;
+	gchar *medium_id;
+	BraseroScsiResult result;
+	BraseroScsiInquiry inquiry;
+	BraseroScsiProfile profile;
+
+	result = brasero_spc1_inquiry (handle, &inquiry, code);
+	if (result != BRASERO_SCSI_OK)
+		return NULL;
+
+	result = brasero_mmc2_get_profile (handle, &profile, code);
+	if (result != BRASERO_SCSI_OK)
+		return NULL;
+
+	switch (profile) {
+	case BRASERO_SCSI_PROF_CDR:
+	case BRASERO_SCSI_PROF_CDRW:
+		medium_id = brasero_speed_profile_get_atip_id (handle);
+		break;
+
+	case BRASERO_SCSI_PROF_DVD_R:
+	case BRASERO_SCSI_PROF_DVD_RW_RESTRICTED:
+	case BRASERO_SCSI_PROF_DVD_RW_SEQUENTIAL:
+	case BRASERO_SCSI_PROF_DVD_R_DL_SEQUENTIAL:
+	case BRASERO_SCSI_PROF_DVD_R_DL_JUMP:
+		/* The manufacturer id is split between field 2 and 3 */
+		medium_id = brasero_speed_profile_get_structure_id (handle,
+								    BRASERO_SCSI_FORMAT_LESS_PRE_PIT_INFO,
+								    17, 6,
+								    25, 6);
+		break;
+
+	case BRASERO_SCSI_PROF_DVD_RW_PLUS:
+	case BRASERO_SCSI_PROF_DVD_R_PLUS:
+	case BRASERO_SCSI_PROF_DVD_RW_PLUS_DL:
+	case BRASERO_SCSI_PROF_DVD_R_PLUS_DL:
+		medium_id = brasero_speed_profile_get_structure_id (handle,
+								    BRASERO_SCSI_FORMAT_PLUS_ADIP,
+								    19, 8,
+								    27, 3);
+		break;
+
+	case BRASERO_SCSI_PROF_BR_R_SEQUENTIAL:
+	case BRASERO_SCSI_PROF_BR_R_RANDOM:
+	case BRASERO_SCSI_PROF_BD_RW:
+		medium_id = brasero_speed_profile_get_structure_id (handle,
+								    BRASERO_SCSI_FORMAT_BD_DISC_INFO,
+								    100, 6,
+								    106, 3);
+		break;
+
+	default:
+		medium_id = NULL;
+		break;
+	}
+
+	if (!medium_id) {
+		BRASERO_MEDIA_LOG ("No manufacturer id for medium");
+		return NULL;
+	}
+
+	drive = g_strdup_printf ("%.8s %.16s %.4s",
+				 (gchar *) inquiry.vendor,
+				 (gchar *) inquiry.name,
+				 (gchar *) inquiry.revision);
+
+	/* Group names can't hold brackets or control characters */
+	g_strdelimit (drive, "[]\n\r", ' ');
+	id = g_strdup_printf ("%s|%04X|%s", drive, profile, medium_id);
+	g_free (medium_id);
+	g_free (drive);
+
+	BRASERO_MEDIA_LOG ("Speed profile %s", id);
+	return id;
+}
+
+static gchar *
+brasero_speed_profile_get_path (void)
+{
+	return g_build_filename (g_get_user_data_dir (),
+				 "brasero",
+				 BRASERO_SPEED_PROFILE_FILE,
+				 NULL);
+}
+
+static GKeyFile *
+brasero_speed_profile_lock (void)
+{
+	G_LOCK (profiles);
+
+	if (!profiles) {
+		gchar *path;
+
+		profiles = g_key_file_new ();
+		path = brasero_speed_profile_get_path ();
+		if (!g_key_file_load_from_file (profiles, path, G_KEY_FILE_NONE, NULL))
+			BRASERO_MEDIA_LOG ("No speed profiles at %s", path);
+
+		g_free (path);
+	}
+
+	return profiles;
+}
+
+static void
+brasero_speed_profile_prune (GKeyFile *key_file)
+{
+	gchar **groups;
+	gchar *oldest = NULL;
+	gint64 oldest_time = G_MAXINT64;
+	gsize num, i;
+
+	groups = g_key_file_get_groups (key_file, &num);
+	if (num <= BRASERO_SPEED_PROFILE_MAX_ENTRIES) {
+		g_strfreev (groups);
+		return;
+	}
+
+	for (i = 0; i < num; i ++) {
+		gint64 used;
+
+		used = g_key_file_get_int64 (key_file, groups [i], "Used", NULL);
+		if (used < oldest_time) {
+			oldest_time = used;
+			oldest = groups [i];
+		}
+	}
+
+	if (oldest)
+		g_key_file_remove_group (key_file, oldest, NULL);
+
+	g_strfreev (groups);
+}
+
+static void
+brasero_speed_profile_unlock (gboolean modified)
+{
+	gchar *directory;
+	GError *error = NULL;
+	gchar *path;
+	gchar *data;
+	gsize size;
+
+	if (!modified) {
+		G_UNLOCK (profiles);
+		return;
+	}
+
+	brasero_speed_profile_prune (profiles);
+
+	path = brasero_speed_profile_get_path ();
+	directory = g_path_get_dirname (path);
+	g_mkdir_with_parents (directory, S_IRWXU);
+	g_free (directory);
+
+	data = g_key_file_to_data (profiles, &size, NULL);
+	if (!g_file_set_contents (path, data, size, &error)) {
+		BRASERO_MEDIA_LOG ("Speed profiles could not be saved: %s",
+				   error->message);
+		g_error_free (error);
+	}
+
+	g_free (data);
+	g_free (path);
+
+	G_UNLOCK (profiles);
+}
+
+/**
+ * Each speed is stored in kB/s as a key holding the number of successful
+ * burns, the number of failed burns and the average rate measured during the
+ * successful ones.
+ */
+
+static void
+brasero_speed_profile_get_stats (GKeyFile *key_file,
+				 const gchar *id,
+				 guint64 rate,
+				 gint *successes,
+				 gint *failures,
+				 guint64 *measured)
+{
+	gchar key [32];
+	gint *values;
+	gsize num = 0;
+
+	g_snprintf (key, sizeof (key), "Rate%" G_GUINT64_FORMAT, rate / 1000);
+	values = g_key_file_get_integer_list (key_file, id, key, &num, NULL);
+	if (!values || num < 3) {
+		*successes = 0;
+		*failures = 0;
+		*measured = 0;
+	}
+	else {
+		*successes = values [0];
+		*failures = values [1];
+		*measured = (guint64) values [2] * 1000;
+	}
+
+	g_free (values);
+}
+
+/**
+ * brasero_speed_profile_set_performance:
+ * @id: a speed profile id
+ * @min_rate: the lowest nominal write rate
+ * @max_rate: the highest nominal write rate
+ *
+ * Records the write performance the drive reported for the medium.
+ **/
+void
+brasero_speed_profile_set_performance (const gchar *id,
+				       guint64 min_rate,
+				       guint64 max_rate)
+{
+	GKeyFile *key_file;
+	gboolean modified;
+
+	if (!id || !max_rate)
+		return;
+
+	key_file = brasero_speed_profile_lock ();
+
+	modified = (g_key_file_get_uint64 (key_file, id, "MinPerformance", NULL) != min_rate
+		 || g_key_file_get_uint64 (key_file, id, "MaxPerformance", NULL) != max_rate);
+
+	if (modified) {
+		g_key_file_set_uint64 (key_file, id, "MinPerformance", min_rate);
+		g_key_file_set_uint64 (key_file, id, "MaxPerformance", max_rate);
+		g_key_file_set_int64 (key_file, id, "Used", g_get_real_time () / G_USEC_PER_SEC);
+	}
+
+	brasero_speed_profile_unlock (modified);
+}
+
+/**
+ * brasero_speed_profile_add_burn:
+ * @id: a speed profile id
+ * @rate: the rate that was requested
+ * @measured: the average rate measured while recording or 0
+ * @success: whether the burn succeeded
+ *
+ * Records the outcome of a burn at @rate.
+ **/
+void
+brasero_speed_profile_add_burn (const gchar *id,
+				guint64 rate,
+				guint64 measured,
+				gboolean success)
+{
+	gint values [3];
+	gint successes;
+	gint failures;
+	guint64 average;
+	GKeyFile *key_file;
+	gchar key [32];
+
+	if (!id || !rate)
+		return;
+
+	key_file = brasero_speed_profile_lock ();
+	brasero_speed_profile_get_stats (key_file,
+					 id,
+					 rate,
+					 &successes,
+					 &failures,
+					 &average);
+
+	if (success) {
+		if (measured)
+			average = (average * successes + measured) / (successes + 1);
+
+		successes ++;
+	}
+	else
+		failures ++;
+
+	BRASERO_MEDIA_LOG ("Speed profile %s at %" G_GUINT64_FORMAT " B/s: %i success(es), %i failure(s), %" G_GUINT64_FORMAT " B/s measured",
+			   id,
+			   rate,
+			   successes,
+			   failures,
+			   average);
+
+	values [0] = successes;
+	values [1] = failures;
+	values [2] = average / 1000;
+
+	g_snprintf (key, sizeof (key), "Rate%" G_GUINT64_FORMAT, rate / 1000);
+	g_key_file_set_integer_list (key_file, id, key, values, G_N_ELEMENTS (values));
+	g_key_file_set_int64 (key_file, id, "Used", g_get_real_time () / G_USEC_PER_SEC);
+
+	brasero_speed_profile_unlock (TRUE);
+}
+
+/**
+ * brasero_speed_profile_get_rate:
+ * @id: a speed profile id
+ * @rates: a 0 terminated array of the write rates supported by the medium
+ *
+ * Chooses the fastest rate of @rates that is reliable according to the
+ * history of the profile:
+ * - rates above the nominal performance of the drive are never sustained
+ * - rates that failed too often are not used any more, nor are untested rates
+ *   above them
+ * The average rate measured while recording is not used: with CAV it is
+ * always well below the requested rate (which is only reached at the end of
+ * the disc) so it tells nothing about throttling.
+ *
+ * Return value: a rate or 0 when there is no history for @id.
+ **/
+guint64
+brasero_speed_profile_get_rate (const gchar *id,
+				const guint64 *rates)
+{
+	guint64 max_performance;
+	GKeyFile *key_file;
+	guint64 ceiling;
+	guint64 best;
+	gint i;
+
+	if (!id || !rates)
+		return 0;
+
+	key_file = brasero_speed_profile_lock ();
+	if (!g_key_file_has_group (key_file, id)) {
+		brasero_speed_profile_unlock (FALSE);
+		return 0;
+	}
+
+	max_performance = g_key_file_get_uint64 (key_file, id, "MaxPerformance", NULL);
+
+	/* Find the lowest unreliable rate */
+	ceiling = G_MAXUINT64;
+	for (i = 0; rates [i]; i ++) {
+		gint successes, failures;
+		guint64 measured;
+
+		brasero_speed_profile_get_stats (key_file,
+						 id,
+						 rates [i],
+						 &successes,
+						 &failures,
+						 &measured);
+
+		if (failures && failures * BRASERO_SPEED_PROFILE_FAILURE_RATIO > successes)
+			ceiling = MIN (ceiling, rates [i]);
+	}
+
+	best = 0;
+	for (i = 0; rates [i]; i ++) {
+		gint successes, failures;
+		guint64 measured;
+
+		if (rates [i] <= best)
+			continue;
+
+		/* 5 % tolerance on the reported performance */
+		if (max_performance && rates [i] > max_performance + max_performance / 20)
+			continue;
+
+		brasero_speed_profile_get_stats (key_file,
+						 id,
+						 rates [i],
+						 &successes,
+						 &failures,
+						 &measured);
+
+		if (failures && failures * BRASERO_SPEED_PROFILE_FAILURE_RATIO > successes)
+			continue;
+
+		if (rates [i] > ceiling && !successes)
+			continue;
+
+		best = rates [i];
+	}
+
+	brasero_speed_profile_unlock (FALSE);
+
+	BRASERO_MEDIA_LOG ("Speed profile %s: best rate %" G_GUINT64_FORMAT " B/s", id, best);
+	return best;
+}
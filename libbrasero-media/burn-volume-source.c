@@ -34,6 +34,7 @@
 
 #include <errno.h>
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "burn-volume-source.h"
@@ -45,6 +46,33 @@
 #include "scsi-mmc2.h"
 #include "scsi-sbc.h"
 
+/* Number of READ10 commands kept queued on the drive when reading
+ * sequentially and the number of blocks each of them reads */
+#define BRASERO_VOL_SRC_READAHEAD_NUM		4
+#define BRASERO_VOL_SRC_READAHEAD_BLOCKS	32
+
+struct _BraseroVolSrcChunk {
+	guint64 start;
+	BraseroScsiResult result;
+
+	guint valid:1;
+	guint pending:1;
+
+	uchar buffer [BRASERO_VOL_SRC_READAHEAD_BLOCKS * ISO9660_BLOCK_SIZE];
+};
+typedef struct _BraseroVolSrcChunk BraseroVolSrcChunk;
+
+struct _BraseroVolSrcReadAhead {
+	BraseroVolSrcChunk chunks [BRASERO_VOL_SRC_READAHEAD_NUM];
+
+	/* Next block to queue */
+	guint64 next;
+
+	/* Block following the last one read */
+	guint64 last;
+};
+typedef struct _BraseroVolSrcReadAhead BraseroVolSrcReadAhead;
+
 static gint64
 brasero_volume_source_seek_device_handle (BraseroVolSrc *src,
 					  guint block,
@@ -184,10 +212,10 @@ brasero_volume_source_readcd_device_handle (BraseroVolSrc *src,
 }
 
 static gboolean
-brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
-					    gchar *buffer,
-					    guint blocks,
-					    GError **error)
+brasero_volume_source_read10_direct (BraseroVolSrc *src,
+				     gchar *buffer,
+				     guint blocks,
+				     GError **error)
 {
 	BraseroScsiResult result;
 	BraseroScsiErrCode code;
@@ -216,6 +244,160 @@ brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
 	return FALSE;
 }
 
+static void
+brasero_volume_source_readahead_cb (BraseroScsiResult result,
+				    BraseroScsiErrCode code,
+				    gpointer user_data)
+{
+	BraseroVolSrcChunk *chunk = user_data;
+
+	chunk->result = result;
+	chunk->pending = FALSE;
+}
+
+static BraseroVolSrcChunk *
+brasero_volume_source_readahead_find (BraseroVolSrcReadAhead *readahead,
+				      guint64 block)
+{
+	int i;
+
+	for (i = 0; i < BRASERO_VOL_SRC_READAHEAD_NUM; i ++) {
+		BraseroVolSrcChunk *chunk;
+
+		chunk = readahead->chunks + i;
+		if (chunk->valid
+		&&  block >= chunk->start
+		&&  block < chunk->start + BRASERO_VOL_SRC_READAHEAD_BLOCKS)
+			return chunk;
+	}
+
+	return NULL;
+}
+
+static void
+brasero_volume_source_readahead_queue (BraseroVolSrc *src)
+{
+	BraseroVolSrcReadAhead *readahead;
+	int i;
+
+	readahead = src->readahead;
+	for (i = 0; i < BRASERO_VOL_SRC_READAHEAD_NUM; i ++) {
+		BraseroScsiResult result;
+		BraseroVolSrcChunk *chunk;
+
+		chunk = readahead->chunks + i;
+		if (chunk->valid)
+			continue;
+
+		chunk->start = readahead->next;
+		chunk->valid = TRUE;
+		chunk->pending = TRUE;
+
+		result = brasero_sbc_read10_block_async (src->data,
+							 chunk->start,
+							 BRASERO_VOL_SRC_READAHEAD_BLOCKS,
+							 chunk->buffer,
+							 sizeof (chunk->buffer),
+							 brasero_volume_source_readahead_cb,
+							 chunk,
+							 NULL);
+		if (result != BRASERO_SCSI_OK) {
+			chunk->valid = FALSE;
+			chunk->pending = FALSE;
+			return;
+		}
+
+		readahead->next += BRASERO_VOL_SRC_READAHEAD_BLOCKS;
+	}
+}
+
+static void
+brasero_volume_source_readahead_reset (BraseroVolSrc *src)
+{
+	BraseroVolSrcReadAhead *readahead;
+	int i;
+
+	/* Wait for the chunks still queued since they write to our buffers */
+	brasero_device_handle_flush (src->data, NULL);
+
+	readahead = src->readahead;
+	for (i = 0; i < BRASERO_VOL_SRC_READAHEAD_NUM; i ++)
+		readahead->chunks [i].valid = FALSE;
+}
+
+/**
+ * When reads are sequential, keep a few READ10 queued ahead of the current
+ * position so the drive never waits for us between two commands. Anything
+ * that cannot be served from these chunks (errors included) is read with a
+ * plain READ10 so errors are reported as before.
+ */
+
+static gboolean
+brasero_volume_source_read10_device_handle (BraseroVolSrc *src,
+					    gchar *buffer,
+					    guint blocks,
+					    GError **error)
+{
+	BraseroVolSrcReadAhead *readahead;
+	gboolean success;
+
+	readahead = src->readahead;
+	if (src->position != readahead->last) {
+		success = brasero_volume_source_read10_direct (src, buffer, blocks, error);
+		readahead->last = src->position;
+		return success;
+	}
+
+	while (blocks > 0) {
+		BraseroVolSrcChunk *chunk;
+		guint offset;
+		guint num;
+
+		chunk = brasero_volume_source_readahead_find (readahead, src->position);
+		if (!chunk) {
+			brasero_volume_source_readahead_reset (src);
+			readahead->next = src->position;
+			brasero_volume_source_readahead_queue (src);
+
+			chunk = brasero_volume_source_readahead_find (readahead, src->position);
+			if (!chunk)
+				break;
+		}
+
+		/* If waiting fails, all queued commands are completed with an error */
+		while (chunk->pending)
+			brasero_device_handle_wait (src->data, NULL);
+
+		if (chunk->result != BRASERO_SCSI_OK) {
+			BRASERO_MEDIA_LOG ("Read ahead failed at %lli", chunk->start);
+			brasero_volume_source_readahead_reset (src);
+			break;
+		}
+
+		offset = src->position - chunk->start;
+		num = MIN (blocks, BRASERO_VOL_SRC_READAHEAD_BLOCKS - offset);
+		memcpy (buffer,
+			chunk->buffer + offset * ISO9660_BLOCK_SIZE,
+			num * ISO9660_BLOCK_SIZE);
+
+		buffer += num * ISO9660_BLOCK_SIZE;
+		blocks -= num;
+		src->position += num;
+
+		if (offset + num >= BRASERO_VOL_SRC_READAHEAD_BLOCKS) {
+			chunk->valid = FALSE;
+			brasero_volume_source_readahead_queue (src);
+		}
+	}
+
+	success = TRUE;
+	if (blocks > 0)
+		success = brasero_volume_source_read10_direct (src, buffer, blocks, error);
+
+	readahead->last = src->position;
+	return success;
+}
+
 void
 brasero_volume_source_close (BraseroVolSrc *src)
 {
@@ -226,6 +408,11 @@ brasero_volume_source_close (BraseroVolSrc *src)
 	if (src->seek == brasero_volume_source_seek_fd)
 		fclose (src->data);
 
+	if (src->readahead) {
+		brasero_volume_source_readahead_reset (src);
+		g_free (src->readahead);
+	}
+
 	g_free (src);
 }
 
@@ -340,8 +527,14 @@ brasero_volume_source_open_device_handle (BraseroDeviceHandle *handle,
 							 &size,
 							 NULL);
 	if (result == BRASERO_SCSI_OK && hdr->desc->current) {
+		BraseroVolSrcReadAhead *readahead;
+
 		BRASERO_MEDIA_LOG ("READ DVD current. Using READ10");
 		src->read = brasero_volume_source_read10_device_handle;
+
+		readahead = g_new0 (BraseroVolSrcReadAhead, 1);
+		readahead->last = G_MAXUINT64;
+		src->readahead = readahead;
 		g_free (hdr);
 	}
 	else {
@@ -54,6 +54,9 @@ struct _BraseroVolSrc {
 	gpointer data;
 	guint data_mode;
 	guint ref;
+
+	/* Chunks queued ahead when reading sequentially from a drive */
+	gpointer readahead;
 };
 
 #define BRASERO_VOL_SRC_SEEK(vol_MACRO, block_MACRO, whence_MACRO, error_MACRO)	\
@@ -132,6 +132,43 @@ brasero_scsi_command_issue_sync (gpointer command,
 	return BRASERO_SCSI_OK;
 }
 
+/**
+ * Commands cannot be queued with this backend: they are executed right away
+ * and @callback is called before returning.
+ */
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  BraseroScsiCallback callback,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+	BraseroScsiResult result;
+
+	result = brasero_scsi_command_issue_sync (command, buffer, size, &code);
+	if (callback)
+		callback (result, code, user_data);
+
+	return BRASERO_SCSI_OK;
+}
+
+BraseroScsiResult
+brasero_device_handle_wait (BraseroDeviceHandle *handle,
+			    BraseroScsiErrCode *error)
+{
+	return BRASERO_SCSI_OK;
+}
+
+BraseroScsiResult
+brasero_device_handle_flush (BraseroDeviceHandle *handle,
+			     BraseroScsiErrCode *error)
+{
+	return BRASERO_SCSI_OK;
+}
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle)
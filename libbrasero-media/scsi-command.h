@@ -63,6 +63,10 @@ static const BraseroScsiCmdInfo info =						\
 	direction								\
 }
 
+typedef void	(*BraseroScsiCallback)	(BraseroScsiResult result,
+					 BraseroScsiErrCode code,
+					 gpointer user_data);
+
 gpointer
 brasero_scsi_command_new (const BraseroScsiCmdInfo *info,
 			  BraseroDeviceHandle *handle);
@@ -75,6 +79,14 @@ brasero_scsi_command_issue_sync (gpointer command,
 				 gpointer buffer,
 				 int size,
 				 BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  BraseroScsiCallback callback,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error);
 G_END_DECLS
 
 #endif /* _BURN_SCSI_COMMAND_H */
@@ -47,6 +47,14 @@ brasero_device_handle_open (const gchar *path,
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle);
 
+BraseroScsiResult
+brasero_device_handle_wait (BraseroDeviceHandle *handle,
+			    BraseroScsiErrCode *error);
+
+BraseroScsiResult
+brasero_device_handle_flush (BraseroDeviceHandle *handle,
+			     BraseroScsiErrCode *error);
+
 char *
 brasero_device_get_bus_target_lun (const gchar *device);
 
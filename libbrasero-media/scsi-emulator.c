@@ -0,0 +1,1073 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <errno.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <glib.h>
+
+#include "brasero-media-private.h"
+
+#include "scsi-base.h"
+#include "scsi-error.h"
+#include "scsi-utils.h"
+#include "scsi-opcodes.h"
+#include "scsi-sense-data.h"
+#include "scsi-get-configuration.h"
+#include "scsi-emulator.h"
+
+/**
+ * This is a software MMC target used to exercise BraseroDrive, BraseroMedium
+ * and the SCSI command layer without real hardware. It only answers commands
+ * libbrasero-media issues. Answers are built byte by byte following MMC5 so
+ * that they go through the very same parsing code as real drive answers.
+ */
+
+typedef enum {
+	BRASERO_SCSI_EMULATOR_CD,
+	BRASERO_SCSI_EMULATOR_DVD,
+	BRASERO_SCSI_EMULATOR_BD
+} BraseroScsiEmulatorFamily;
+
+typedef struct _BraseroScsiEmulatorProfile BraseroScsiEmulatorProfile;
+struct _BraseroScsiEmulatorProfile {
+	const gchar *name;
+	BraseroScsiProfile profile;
+	BraseroScsiEmulatorFamily family;
+
+	guint writable:1;
+	guint rewritable:1;
+
+	/* Capacity of a blank medium in blocks */
+	gint64 capacity;
+
+	/* Speeds in kB/s; the write speeds list is 0 terminated */
+	guint rd_speed;
+	guint wr_speeds [4];
+};
+
+static const BraseroScsiEmulatorProfile profiles [] = {
+	{ "cd-rom", BRASERO_SCSI_PROF_CDROM, BRASERO_SCSI_EMULATOR_CD, FALSE, FALSE, 0, 7056, { 0 } },
+	{ "cd-r", BRASERO_SCSI_PROF_CDR, BRASERO_SCSI_EMULATOR_CD, TRUE, FALSE, 359849, 7056, { 8467, 7056, 4234, 0 } },
+	{ "cd-rw", BRASERO_SCSI_PROF_CDRW, BRASERO_SCSI_EMULATOR_CD, TRUE, TRUE, 359849, 7056, { 4234, 1764, 0 } },
+	{ "dvd-rom", BRASERO_SCSI_PROF_DVD_ROM, BRASERO_SCSI_EMULATOR_DVD, FALSE, FALSE, 0, 22160, { 0 } },
+	{ "dvd-r", BRASERO_SCSI_PROF_DVD_R, BRASERO_SCSI_EMULATOR_DVD, TRUE, FALSE, 2298496, 22160, { 22160, 11080, 5540, 0 } },
+	{ "dvd-rw", BRASERO_SCSI_PROF_DVD_RW_SEQUENTIAL, BRASERO_SCSI_EMULATOR_DVD, TRUE, TRUE, 2298496, 11080, { 8310, 5540, 0 } },
+	{ "dvd+r", BRASERO_SCSI_PROF_DVD_R_PLUS, BRASERO_SCSI_EMULATOR_DVD, TRUE, FALSE, 2295104, 22160, { 22160, 11080, 5540, 0 } },
+	{ "dvd+rw", BRASERO_SCSI_PROF_DVD_RW_PLUS, BRASERO_SCSI_EMULATOR_DVD, TRUE, TRUE, 2295104, 11080, { 11080, 5540, 0 } },
+	{ "bd-rom", BRASERO_SCSI_PROF_BD_ROM, BRASERO_SCSI_EMULATOR_BD, FALSE, FALSE, 0, 35964, { 0 } },
+	{ "bd-r", BRASERO_SCSI_PROF_BR_R_SEQUENTIAL, BRASERO_SCSI_EMULATOR_BD, TRUE, FALSE, 12219392, 35964, { 53946, 26973, 8991, 0 } },
+	{ NULL, }
+};
+
+struct _BraseroScsiEmulator {
+	GMutex *mutex;
+
+	const BraseroScsiEmulatorProfile *profile;
+
+	/* Image backing a closed medium */
+	int fd;
+	gint64 blocks;
+
+	/* Latency/throughput model */
+	gulong latency;
+	gulong seek;
+	guint rate;
+	gint64 ready_time;
+
+	gint64 next_lba;
+
+	/* Handles opened on the drive. Like O_EXCL with sr/sg an exclusive
+	 * handle can only be opened if there is no other one and prevents
+	 * any other from being opened. */
+	guint handles;
+	guint exclusive:1;
+};
+
+#define BRASERO_SCSI_EMULATOR_BLOCK_SIZE	2048
+
+#define BRASERO_SCSI_EMULATOR_HAS_MEDIUM(emulator)	((emulator)->fd >= 0 || (emulator)->profile->writable)
+#define BRASERO_SCSI_EMULATOR_IS_BLANK(emulator)	((emulator)->fd < 0 && (emulator)->profile->writable)
+
+/* Emulated drives are kept for the whole life of the process like real ones
+ * so that the state of their medium survives the opening and closing of
+ * handles. */
+static GHashTable *emulators = NULL;
+G_LOCK_DEFINE_STATIC (emulators);
+
+/**
+ * Sense data
+ */
+
+#define SENSE_KEY_NOT_READY		0x02
+#define SENSE_KEY_ILLEGAL_REQUEST	0x05
+
+static BraseroScsiResult
+brasero_scsi_emulator_sense (uchar key,
+			     uchar asc,
+			     uchar ascq,
+			     BraseroScsiErrCode *error)
+{
+	uchar sense [BRASERO_SENSE_DATA_SIZE];
+	BraseroScsiErrCode code = BRASERO_SCSI_ERR_UNKNOWN;
+	BraseroScsiResult result;
+
+	memset (sense, 0, sizeof (sense));
+	sense [0] = 0x70;
+	sense [2] = key;
+	sense [7] = sizeof (sense) - 8;
+	sense [12] = asc;
+	sense [13] = ascq;
+
+	result = brasero_sense_data_process (sense, &code);
+	if (error)
+		*error = code;
+
+	return result;
+}
+
+#define BRASERO_SCSI_EMULATOR_INVALID_FIELD(error)		\
+	brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x24, 0x00, error)
+
+static BraseroScsiResult
+brasero_scsi_emulator_reply (GByteArray *reply,
+			     uchar *buffer,
+			     int size)
+{
+	if (buffer && size > 0) {
+		memset (buffer, 0, size);
+		memcpy (buffer, reply->data, MIN (size, reply->len));
+	}
+
+	g_byte_array_free (reply, TRUE);
+	return BRASERO_SCSI_OK;
+}
+
+static uchar *
+brasero_scsi_emulator_append (GByteArray *reply,
+			      guint len)
+{
+	guint offset;
+
+	offset = reply->len;
+	g_byte_array_set_size (reply, offset + len);
+	memset (reply->data + offset, 0, len);
+	return reply->data + offset;
+}
+
+/**
+ * Timing model
+ */
+
+static void
+brasero_scsi_emulator_transfer_wait (BraseroScsiEmulator *emulator,
+				     gint64 lba,
+				     gint64 bytes)
+{
+	gulong wait = 0;
+
+	if (lba >= 0) {
+		if (lba != emulator->next_lba)
+			wait += emulator->seek;
+
+		emulator->next_lba = lba + bytes / BRASERO_SCSI_EMULATOR_BLOCK_SIZE;
+	}
+
+	/* rate is in kB/s so bytes * 1000 / rate gives microseconds */
+	if (emulator->rate)
+		wait += bytes * 1000 / emulator->rate;
+
+	if (wait)
+		g_usleep (wait);
+}
+
+/**
+ * Commands
+ */
+
+static BraseroScsiResult
+brasero_scsi_emulator_test_unit_ready (BraseroScsiEmulator *emulator,
+				       BraseroScsiErrCode *error)
+{
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	if (g_get_monotonic_time () < emulator->ready_time)
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x04, 0x01, error);
+
+	return BRASERO_SCSI_OK;
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_inquiry (BraseroScsiEmulator *emulator,
+			       uchar *buffer,
+			       int size)
+{
+	GByteArray *reply;
+	uchar *data;
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 36);
+
+	data [0] = 0x05;	/* CD/DVD device */
+	data [1] = 0x80;	/* removable */
+	data [2] = 0x05;
+	data [3] = 0x02;
+	data [4] = 31;
+	memcpy (data + 8, "BRASERO ", 8);
+	memcpy (data + 16, "MMC EMULATOR    ", 16);
+	memcpy (data + 32, "1.0 ", 4);
+
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static void
+brasero_scsi_emulator_add_feature (GByteArray *reply,
+				   const uchar *cdb,
+				   BraseroScsiFeatureType code,
+				   gboolean current,
+				   const uchar *feature_data,
+				   guint len)
+{
+	uchar *data;
+	guint start;
+	guint rt;
+
+	rt = cdb [1] & 0x03;
+	start = BRASERO_GET_16 (cdb + 2);
+
+	if (code < start)
+		return;
+
+	if (rt == 0x01 && !current)
+		return;
+
+	if (rt == 0x02 && code != start)
+		return;
+
+	data = brasero_scsi_emulator_append (reply, 4 + len);
+	BRASERO_SET_16 (data, code);
+	data [2] = current? 0x01:0x00;
+	data [3] = len;
+	if (len)
+		memcpy (data + 4, feature_data, len);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_get_configuration (BraseroScsiEmulator *emulator,
+					 const uchar *cdb,
+					 uchar *buffer,
+					 int size)
+{
+	const BraseroScsiEmulatorProfile *profile;
+	gboolean has_medium, blank, cd_write, dvd_write;
+	uchar feature [64];
+	GByteArray *reply;
+	uchar *data;
+	gint i;
+
+	profile = emulator->profile;
+	has_medium = BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator);
+	blank = BRASERO_SCSI_EMULATOR_IS_BLANK (emulator);
+
+	cd_write = blank && (profile->profile == BRASERO_SCSI_PROF_CDR
+			 ||  profile->profile == BRASERO_SCSI_PROF_CDRW);
+	dvd_write = blank && (profile->profile == BRASERO_SCSI_PROF_DVD_R
+			  ||  profile->profile == BRASERO_SCSI_PROF_DVD_RW_SEQUENTIAL);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 8);
+	if (has_medium) {
+		BRASERO_SET_16 (data + 6, profile->profile);
+	}
+
+	/* Profile list: the emulated drive can handle all profiles */
+	memset (feature, 0, sizeof (feature));
+	for (i = 0; profiles [i].name && i < 16; i ++) {
+		BRASERO_SET_16 (feature + i * 4, profiles [i].profile);
+		feature [i * 4 + 2] = (has_medium && profiles [i].profile == profile->profile);
+	}
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_PROFILES, TRUE, feature, i * 4);
+
+	/* Core: ATAPI interface, DBE */
+	memset (feature, 0, sizeof (feature));
+	BRASERO_SET_32 (feature, 0x02);
+	feature [4] = 0x01;
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_CORE, TRUE, feature, 8);
+
+	/* Random readable */
+	memset (feature, 0, sizeof (feature));
+	BRASERO_SET_32 (feature, BRASERO_SCSI_EMULATOR_BLOCK_SIZE);
+	BRASERO_SET_16 (feature + 4, profile->family == BRASERO_SCSI_EMULATOR_CD? 1:16);
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_RD_RANDOM, has_medium && !blank, feature, 8);
+
+	memset (feature, 0, sizeof (feature));
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_RD_CD,
+					   has_medium && profile->family == BRASERO_SCSI_EMULATOR_CD,
+					   feature, 4);
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_RD_DVD,
+					   has_medium && profile->family == BRASERO_SCSI_EMULATOR_DVD,
+					   feature, 4);
+
+	/* Incremental streaming writable: one link size of 16 blocks */
+	memset (feature, 0, sizeof (feature));
+	BRASERO_SET_16 (feature, 0x0001);
+	feature [3] = 1;
+	feature [4] = 16;
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_WRT_INCREMENT, cd_write || dvd_write, feature, 8);
+
+	/* CD TAO: BUF, test write and CD-RW */
+	memset (feature, 0, sizeof (feature));
+	feature [0] = 0x40 | 0x04 | (profile->rewritable? 0x02:0x00);
+	BRASERO_SET_16 (feature + 2, 0xFFFF);
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_WRT_TAO, cd_write, feature, 4);
+
+	/* CD SAO: BUF, SAO, test write */
+	memset (feature, 0, sizeof (feature));
+	feature [0] = 0x40 | 0x20 | 0x04;
+	BRASERO_SET_24 (feature + 1, 0x10000);
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_WRT_SAO_RAW, cd_write, feature, 4);
+
+	/* DVD-R(W) write: BUF, test write and DVD-RW */
+	memset (feature, 0, sizeof (feature));
+	feature [0] = 0x40 | 0x04 | (profile->rewritable? 0x02:0x00);
+	brasero_scsi_emulator_add_feature (reply, cdb, BRASERO_SCSI_FEAT_WRT_DVD_LESS, dvd_write, feature, 4);
+
+	BRASERO_SET_32 (reply->data, reply->len - 4);
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_disc_information (BraseroScsiEmulator *emulator,
+					     uchar *buffer,
+					     int size,
+					     BraseroScsiErrCode *error)
+{
+	GByteArray *reply;
+	uchar *data;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 34);
+
+	BRASERO_SET_16 (data, 32);
+
+	/* erasable, last session state and disc status */
+	if (BRASERO_SCSI_EMULATOR_IS_BLANK (emulator))
+		data [2] = 0x00;
+	else
+		data [2] = (0x03 << 2) | 0x02;
+
+	if (emulator->profile->rewritable)
+		data [2] |= 0x10;
+
+	data [3] = 1;	/* first track */
+	data [4] = 1;	/* sessions */
+	data [5] = 1;	/* first track in last session */
+	data [6] = 1;	/* last track in last session */
+
+	BRASERO_SET_32 (data + 16, 0xFFFFFFFF);
+	BRASERO_SET_32 (data + 20, 0xFFFFFFFF);
+
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_toc_pma_atip (BraseroScsiEmulator *emulator,
+					 const uchar *cdb,
+					 uchar *buffer,
+					 int size,
+					 BraseroScsiErrCode *error)
+{
+	GByteArray *reply;
+	uchar *data;
+	gint64 leadout;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 4);
+
+	switch (cdb [2] & 0x0F) {
+	case 0x00:	/* formatted TOC */
+		if (BRASERO_SCSI_EMULATOR_IS_BLANK (emulator)) {
+			g_byte_array_free (reply, TRUE);
+			return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+		}
+
+		data [2] = 1;
+		data [3] = 1;
+
+		/* one data track (ADR 1, control 4) and the leadout */
+		data = brasero_scsi_emulator_append (reply, 8);
+		data [1] = 0x14;
+		data [2] = 1;
+
+		data = brasero_scsi_emulator_append (reply, 8);
+		data [1] = 0x14;
+		data [2] = 0xAA;
+		BRASERO_SET_32 (data + 4, emulator->blocks);
+		break;
+
+	case 0x04:	/* ATIP */
+		if (emulator->profile->profile != BRASERO_SCSI_PROF_CDR
+		&&  emulator->profile->profile != BRASERO_SCSI_PROF_CDRW) {
+			g_byte_array_free (reply, TRUE);
+			return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+		}
+
+		data = brasero_scsi_emulator_append (reply, 24);
+		data [0] = 0x50 | 0x04;
+		data [2] = emulator->profile->rewritable? 0x40:0x00;
+
+		/* lead-in start (97:26:66) and last possible lead-out */
+		data [4] = 97;
+		data [5] = 26;
+		data [6] = 66;
+
+		leadout = emulator->profile->capacity;
+		data [8] = leadout / (60 * 75);
+		data [9] = (leadout / 75) % 60;
+		data [10] = leadout % 75;
+		break;
+
+	default:
+		/* no raw TOC, PMA nor CD-TEXT */
+		g_byte_array_free (reply, TRUE);
+		return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+	}
+
+	BRASERO_SET_16 (reply->data, reply->len - 2);
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_track_information (BraseroScsiEmulator *emulator,
+					      const uchar *cdb,
+					      uchar *buffer,
+					      int size,
+					      BraseroScsiErrCode *error)
+{
+	GByteArray *reply;
+	guint32 address;
+	uchar *data;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	/* Only one track and one session */
+	address = BRASERO_GET_32 (cdb + 2);
+	switch (cdb [1] & 0x03) {
+	case 0x00:
+		if (address >= emulator->blocks && !BRASERO_SCSI_EMULATOR_IS_BLANK (emulator))
+			return brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x21, 0x00, error);
+		break;
+	case 0x01:
+		if (address != 1 && address != 0xFF)
+			return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+		break;
+	case 0x02:
+		if (address != 1)
+			return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+		break;
+	default:
+		return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+	}
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 48);
+
+	BRASERO_SET_16 (data, 46);
+	data [2] = 1;
+	data [3] = 1;
+	data [5] = 0x04;	/* data track */
+
+	if (BRASERO_SCSI_EMULATOR_IS_BLANK (emulator)) {
+		data [6] = 0x40 | 0x01;	/* blank, mode 1 */
+		data [7] = 0x01;	/* NWA valid */
+		BRASERO_SET_32 (data + 16, emulator->profile->capacity);
+		BRASERO_SET_32 (data + 24, emulator->profile->capacity);
+	}
+	else {
+		data [6] = 0x01;
+		BRASERO_SET_32 (data + 24, emulator->blocks);
+		BRASERO_SET_32 (data + 28, emulator->blocks - 1);
+	}
+
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_capacity (BraseroScsiEmulator *emulator,
+				     uchar *buffer,
+				     int size,
+				     BraseroScsiErrCode *error)
+{
+	GByteArray *reply;
+	uchar *data;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 8);
+	BRASERO_SET_32 (data, emulator->blocks? emulator->blocks - 1:0);
+	BRASERO_SET_32 (data + 4, BRASERO_SCSI_EMULATOR_BLOCK_SIZE);
+
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_format_capacities (BraseroScsiEmulator *emulator,
+					      uchar *buffer,
+					      int size,
+					      BraseroScsiErrCode *error)
+{
+	const BraseroScsiEmulatorProfile *profile;
+	GByteArray *reply;
+	uchar *data;
+
+	profile = emulator->profile;
+	if (!profile->writable)
+		return brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x20, 0x00, error);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 4);
+
+	/* current/maximum capacity: always formatted */
+	data = brasero_scsi_emulator_append (reply, 8);
+	BRASERO_SET_32 (data, profile->capacity);
+	data [4] = 0x02;
+	BRASERO_SET_24 (data + 5, BRASERO_SCSI_EMULATOR_BLOCK_SIZE);
+
+	data = brasero_scsi_emulator_append (reply, 8);
+	BRASERO_SET_32 (data, profile->capacity);
+	if (profile->profile == BRASERO_SCSI_PROF_DVD_RW_PLUS)
+		data [4] = 0x26 << 2;
+	else
+		data [4] = 0x10 << 2;
+	BRASERO_SET_24 (data + 5, BRASERO_SCSI_EMULATOR_BLOCK_SIZE);
+
+	reply->data [3] = reply->len - 4;
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_get_performance (BraseroScsiEmulator *emulator,
+				       const uchar *cdb,
+				       uchar *buffer,
+				       int size,
+				       BraseroScsiErrCode *error)
+{
+	const BraseroScsiEmulatorProfile *profile;
+	GByteArray *reply;
+	guint max_desc;
+	guint desc_num;
+	gint64 end;
+	uchar *data;
+	gint i;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	profile = emulator->profile;
+	end = BRASERO_SCSI_EMULATOR_IS_BLANK (emulator)? profile->capacity:emulator->blocks;
+	max_desc = BRASERO_GET_16 (cdb + 8);
+
+	reply = g_byte_array_new ();
+	data = brasero_scsi_emulator_append (reply, 8);
+
+	desc_num = 0;
+	switch (cdb [10]) {
+	case 0x00:	/* performance: one CAV like descriptor */
+		/* The write bit selects which performance is reported */
+		data [4] = (cdb [1] & 0x04)? 0x02:0;
+		data = brasero_scsi_emulator_append (reply, 16);
+		BRASERO_SET_32 (data + 4, (cdb [1] & 0x04)? profile->wr_speeds [0] / 2:profile->rd_speed / 2);
+		BRASERO_SET_32 (data + 8, end - 1);
+		BRASERO_SET_32 (data + 12, (cdb [1] & 0x04)? profile->wr_speeds [0]:profile->rd_speed);
+		desc_num = 1;
+		break;
+
+	case 0x03:	/* write speed descriptors */
+		for (i = 0; profile->wr_speeds [i]; i ++) {
+			data = brasero_scsi_emulator_append (reply, 16);
+			BRASERO_SET_32 (data + 4, end);
+			BRASERO_SET_32 (data + 8, profile->rd_speed);
+			BRASERO_SET_32 (data + 12, profile->wr_speeds [i]);
+			desc_num ++;
+		}
+		break;
+
+	default:
+		g_byte_array_free (reply, TRUE);
+		return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+	}
+
+	/* The header always gives the size of the whole answer even if fewer
+	 * descriptors were requested */
+	BRASERO_SET_32 (reply->data, reply->len - 4);
+	if (desc_num > max_desc)
+		g_byte_array_set_size (reply, 8 + max_desc * 16);
+
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static void
+brasero_scsi_emulator_status_page (BraseroScsiEmulator *emulator,
+				   GByteArray *reply)
+{
+	const BraseroScsiEmulatorProfile *profile;
+	guint desc_num;
+	uchar *data;
+	gint i;
+
+	profile = emulator->profile;
+	for (desc_num = 0; profile->wr_speeds [desc_num]; desc_num ++);
+
+	data = brasero_scsi_emulator_append (reply, 32 + desc_num * 4);
+	data [0] = 0x2A;
+	data [1] = 30 + desc_num * 4;
+
+	/* reads and writes everything but DVD-RAM; test write; BUF */
+	data [2] = 0x10 | 0x08 | 0x02 | 0x01;
+	data [3] = 0x10 | 0x04 | 0x02 | 0x01;
+	data [4] = 0x80;
+
+	BRASERO_SET_16 (data + 8, profile->rd_speed);
+	BRASERO_SET_16 (data + 12, 2048);
+	BRASERO_SET_16 (data + 18, profile->wr_speeds [0]);
+	BRASERO_SET_16 (data + 28, profile->wr_speeds [0]);
+	BRASERO_SET_16 (data + 30, desc_num);
+
+	for (i = 0; i < desc_num; i ++) {
+		BRASERO_SET_16 (data + 32 + i * 4 + 2, profile->wr_speeds [i]);
+	}
+}
+
+static void
+brasero_scsi_emulator_write_page (BraseroScsiEmulator *emulator,
+				  GByteArray *reply)
+{
+	uchar *data;
+
+	data = brasero_scsi_emulator_append (reply, 52);
+	data [0] = 0x05;
+	data [1] = 50;
+	data [2] = 0x01;	/* TAO */
+	data [3] = 0x04;	/* data track */
+	data [4] = 0x08;	/* mode 1 */
+	BRASERO_SET_16 (data + 14, 150);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_mode_sense (BraseroScsiEmulator *emulator,
+				  const uchar *cdb,
+				  uchar *buffer,
+				  int size,
+				  BraseroScsiErrCode *error)
+{
+	GByteArray *reply;
+
+	reply = g_byte_array_new ();
+	brasero_scsi_emulator_append (reply, 8);
+
+	switch (cdb [2] & 0x3F) {
+	case 0x2A:
+		brasero_scsi_emulator_status_page (emulator, reply);
+		break;
+	case 0x05:
+		brasero_scsi_emulator_write_page (emulator, reply);
+		break;
+	default:
+		g_byte_array_free (reply, TRUE);
+		return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+	}
+
+	BRASERO_SET_16 (reply->data, reply->len - 2);
+	return brasero_scsi_emulator_reply (reply, buffer, size);
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_blocks (BraseroScsiEmulator *emulator,
+				   gint64 lba,
+				   gint64 num,
+				   uchar *buffer,
+				   int size,
+				   BraseroScsiErrCode *error)
+{
+	gint64 bytes;
+
+	if (!BRASERO_SCSI_EMULATOR_HAS_MEDIUM (emulator))
+		return brasero_scsi_emulator_sense (SENSE_KEY_NOT_READY, 0x3A, 0x00, error);
+
+	if (lba < 0 || lba + num > emulator->blocks)
+		return brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x21, 0x00, error);
+
+	bytes = MIN (num * BRASERO_SCSI_EMULATOR_BLOCK_SIZE, size);
+	if (buffer && bytes > 0) {
+		gint64 offset = 0;
+
+		while (offset < bytes) {
+			ssize_t res;
+
+			res = pread (emulator->fd,
+				     buffer + offset,
+				     bytes - offset,
+				     lba * BRASERO_SCSI_EMULATOR_BLOCK_SIZE + offset);
+			if (res < 0 && errno == EINTR)
+				continue;
+
+			if (res < 0) {
+				BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+				return BRASERO_SCSI_FAILURE;
+			}
+
+			/* last block of the image may be incomplete */
+			if (res == 0) {
+				memset (buffer + offset, 0, bytes - offset);
+				break;
+			}
+
+			offset += res;
+		}
+	}
+
+	brasero_scsi_emulator_transfer_wait (emulator, lba, num * BRASERO_SCSI_EMULATOR_BLOCK_SIZE);
+	return BRASERO_SCSI_OK;
+}
+
+static BraseroScsiResult
+brasero_scsi_emulator_read_cd (BraseroScsiEmulator *emulator,
+			       const uchar *cdb,
+			       uchar *buffer,
+			       int size,
+			       BraseroScsiErrCode *error)
+{
+	uchar sector_type;
+
+	/* Only user data of mode 1 sectors can be returned since images
+	 * only hold 2048 bytes per block */
+	sector_type = (cdb [1] >> 2) & 0x07;
+	if (sector_type != 0 && sector_type != 2)
+		return brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x64, 0x00, error);
+
+	if ((cdb [9] & ~0x10) || cdb [10])
+		return BRASERO_SCSI_EMULATOR_INVALID_FIELD (error);
+
+	return brasero_scsi_emulator_read_blocks (emulator,
+						  BRASERO_GET_32 (cdb + 2),
+						  BRASERO_GET_24 (cdb + 6),
+						  (cdb [9] & 0x10)? buffer:NULL,
+						  size,
+						  error);
+}
+
+BraseroScsiResult
+brasero_scsi_emulator_issue (BraseroScsiEmulator *emulator,
+			     const uchar *cdb,
+			     int cdb_len,
+			     uchar *buffer,
+			     int size,
+			     BraseroScsiErrCode *error)
+{
+	BraseroScsiResult result;
+
+	g_return_val_if_fail (emulator != NULL, BRASERO_SCSI_FAILURE);
+
+	/* A drive processes one command at a time */
+	g_mutex_lock (emulator->mutex);
+
+	if (emulator->latency)
+		g_usleep (emulator->latency);
+
+	switch (cdb [0]) {
+	case BRASERO_TEST_UNIT_READY_OPCODE:
+		result = brasero_scsi_emulator_test_unit_ready (emulator, error);
+		break;
+	case BRASERO_INQUIRY_OPCODE:
+		result = brasero_scsi_emulator_inquiry (emulator, buffer, size);
+		break;
+	case BRASERO_GET_CONFIGURATION_OPCODE:
+		result = brasero_scsi_emulator_get_configuration (emulator, cdb, buffer, size);
+		break;
+	case BRASERO_READ_DISC_INFORMATION_OPCODE:
+		result = brasero_scsi_emulator_read_disc_information (emulator, buffer, size, error);
+		break;
+	case BRASERO_READ_TOC_PMA_ATIP_OPCODE:
+		result = brasero_scsi_emulator_read_toc_pma_atip (emulator, cdb, buffer, size, error);
+		break;
+	case BRASERO_READ_TRACK_INFORMATION_OPCODE:
+		result = brasero_scsi_emulator_read_track_information (emulator, cdb, buffer, size, error);
+		break;
+	case BRASERO_READ_CAPACITY_OPCODE:
+		result = brasero_scsi_emulator_read_capacity (emulator, buffer, size, error);
+		break;
+	case BRASERO_READ_FORMAT_CAPACITIES_OPCODE:
+		result = brasero_scsi_emulator_read_format_capacities (emulator, buffer, size, error);
+		break;
+	case BRASERO_GET_PERFORMANCE_OPCODE:
+		result = brasero_scsi_emulator_get_performance (emulator, cdb, buffer, size, error);
+		break;
+	case BRASERO_MODE_SENSE_OPCODE:
+		result = brasero_scsi_emulator_mode_sense (emulator, cdb, buffer, size, error);
+		break;
+	case BRASERO_READ10_OPCODE:
+		result = brasero_scsi_emulator_read_blocks (emulator,
+							    BRASERO_GET_32 (cdb + 2),
+							    BRASERO_GET_16 (cdb + 7),
+							    buffer,
+							    size,
+							    error);
+		break;
+	case BRASERO_READ_CD_OPCODE:
+		result = brasero_scsi_emulator_read_cd (emulator, cdb, buffer, size, error);
+		break;
+	case BRASERO_MECHANISM_STATUS_OPCODE:
+		if (buffer && size > 0)
+			memset (buffer, 0, size);
+		result = BRASERO_SCSI_OK;
+		break;
+	case BRASERO_MODE_SELECT_OPCODE:
+	case BRASERO_PREVENT_ALLOW_MEDIUM_REMOVAL_OPCODE:
+		result = BRASERO_SCSI_OK;
+		break;
+	default:
+		BRASERO_MEDIA_LOG ("Unsupported command 0x%02x", cdb [0]);
+		result = brasero_scsi_emulator_sense (SENSE_KEY_ILLEGAL_REQUEST, 0x20, 0x00, error);
+		break;
+	}
+
+	g_mutex_unlock (emulator->mutex);
+	return result;
+}
+
+/**
+ * Creation
+ */
+
+gboolean
+brasero_scsi_emulator_is_device (const gchar *path)
+{
+	return path && g_str_has_prefix (path, BRASERO_SCSI_EMULATOR_PREFIX);
+}
+
+static BraseroScsiEmulator *
+brasero_scsi_emulator_new (const gchar *path,
+			   BraseroScsiErrCode *error)
+{
+	const BraseroScsiEmulatorProfile *profile = NULL;
+	BraseroScsiEmulator *emulator;
+	gulong spinup = 0;
+	gchar **options;
+	gchar *image = NULL;
+	gint i;
+
+	options = g_strsplit (path + strlen (BRASERO_SCSI_EMULATOR_PREFIX), ",", -1);
+	if (!options [0]) {
+		g_strfreev (options);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return NULL;
+	}
+
+	for (i = 0; profiles [i].name; i ++) {
+		if (!strcmp (profiles [i].name, options [0])) {
+			profile = profiles + i;
+			break;
+		}
+	}
+
+	if (!profile) {
+		BRASERO_MEDIA_LOG ("Unknown emulated profile %s", options [0]);
+		g_strfreev (options);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_BAD_ARGUMENT);
+		return NULL;
+	}
+
+	emulator = g_new0 (BraseroScsiEmulator, 1);
+	emulator->profile = profile;
+	emulator->fd = -1;
+
+	for (i = 1; options [i]; i ++) {
+		gchar *value;
+
+		value = strchr (options [i], '=');
+		if (!value) {
+			BRASERO_MEDIA_LOG ("Ignoring emulator option %s", options [i]);
+			continue;
+		}
+
+		*value = '\0';
+		value ++;
+
+		if (!strcmp (options [i], "image"))
+			image = value;
+		else if (!strcmp (options [i], "latency"))
+			emulator->latency = strtoul (value, NULL, 10);
+		else if (!strcmp (options [i], "seek"))
+			emulator->seek = strtoul (value, NULL, 10);
+		else if (!strcmp (options [i], "rate"))
+			emulator->rate = strtoul (value, NULL, 10);
+		else if (!strcmp (options [i], "spinup"))
+			spinup = strtoul (value, NULL, 10);
+		else
+			BRASERO_MEDIA_LOG ("Ignoring emulator option %s", options [i]);
+	}
+
+	if (image) {
+		struct stat buf;
+
+		emulator->fd = open (image, O_RDONLY);
+		if (emulator->fd < 0 || fstat (emulator->fd, &buf)) {
+			BRASERO_MEDIA_LOG ("Emulated medium image %s can't be opened: %s",
+					   image,
+					   g_strerror (errno));
+			if (emulator->fd >= 0)
+				close (emulator->fd);
+
+			g_free (emulator);
+			g_strfreev (options);
+			BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+			return NULL;
+		}
+
+		emulator->blocks = (buf.st_size + BRASERO_SCSI_EMULATOR_BLOCK_SIZE - 1) /
+				   BRASERO_SCSI_EMULATOR_BLOCK_SIZE;
+	}
+
+	g_strfreev (options);
+
+	emulator->mutex = g_mutex_new ();
+	emulator->ready_time = g_get_monotonic_time () + spinup * 1000;
+
+	BRASERO_MEDIA_LOG ("Emulated %s drive created (%" G_GINT64_FORMAT " blocks)",
+			   profile->name,
+			   emulator->blocks);
+	return emulator;
+}
+
+/**
+ * brasero_scsi_emulator_get:
+ * @path: a device path starting with BRASERO_SCSI_EMULATOR_PREFIX
+ * @error: a #BraseroScsiErrCode or NULL
+ *
+ * Returns the emulated drive for @path creating it the first time.
+ *
+ * Return value: a #BraseroScsiEmulator or NULL if @path is not valid.
+ **/
+BraseroScsiEmulator *
+brasero_scsi_emulator_get (const gchar *path,
+			   BraseroScsiErrCode *error)
+{
+	BraseroScsiEmulator *emulator;
+
+	G_LOCK (emulators);
+
+	if (!emulators)
+		emulators = g_hash_table_new_full (g_str_hash,
+						   g_str_equal,
+						   g_free,
+						   NULL);
+
+	emulator = g_hash_table_lookup (emulators, path);
+	if (!emulator) {
+		emulator = brasero_scsi_emulator_new (path, error);
+		if (emulator)
+			g_hash_table_insert (emulators, g_strdup (path), emulator);
+	}
+
+	G_UNLOCK (emulators);
+	return emulator;
+}
+
+/**
+ * brasero_scsi_emulator_open:
+ * @emulator: a #BraseroScsiEmulator
+ * @exclusive: whether the handle should be the only one opened
+ * @error: a #BraseroScsiErrCode or NULL
+ *
+ * Registers a new handle on the emulated drive.
+ *
+ * Return value: FALSE if the drive is busy.
+ **/
+gboolean
+brasero_scsi_emulator_open (BraseroScsiEmulator *emulator,
+			    gboolean exclusive,
+			    BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (emulator != NULL, FALSE);
+
+	g_mutex_lock (emulator->mutex);
+
+	if (emulator->exclusive || (exclusive && emulator->handles)) {
+		g_mutex_unlock (emulator->mutex);
+		BRASERO_MEDIA_LOG ("Emulated drive busy");
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_NOT_READY);
+		return FALSE;
+	}
+
+	emulator->handles ++;
+	emulator->exclusive = (exclusive != FALSE);
+
+	g_mutex_unlock (emulator->mutex);
+	return TRUE;
+}
+
+/**
+ * brasero_scsi_emulator_close:
+ * @emulator: a #BraseroScsiEmulator
+ *
+ * Unregisters a handle opened with brasero_scsi_emulator_open ().
+ **/
+void
+brasero_scsi_emulator_close (BraseroScsiEmulator *emulator)
+{
+	g_return_if_fail (emulator != NULL);
+
+	g_mutex_lock (emulator->mutex);
+
+	if (emulator->handles)
+		emulator->handles --;
+	emulator->exclusive = FALSE;
+
+	g_mutex_unlock (emulator->mutex);
+}
@@ -0,0 +1,85 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-media
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-media is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-media authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-media. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-media is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-media is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#include <glib.h>
+
+#include "scsi-base.h"
+#include "scsi-error.h"
+
+#ifndef _SCSI_EMULATOR_H
+#define _SCSI_EMULATOR_H
+
+G_BEGIN_DECLS
+
+/**
+ * Software MMC target. Device paths of the form
+ *   emulator:PROFILE[,key=value[,key=value ...]]
+ * are handled by the emulator instead of the OS transport. PROFILE is one of
+ * cd-rom, cd-r, cd-rw, dvd-rom, dvd-r, dvd-rw, dvd+r, dvd+rw, bd-rom, bd-r.
+ * Recognized keys are:
+ * - image: path of an image file used as the contents of a closed medium
+ *   (without it writable profiles are blank and ROM profiles have no medium)
+ * - latency: time spent processing each command in microseconds
+ * - seek: extra time for non sequential reads in microseconds
+ * - rate: transfer rate of READ commands in kB/s (0 for unlimited)
+ * - spinup: time in milliseconds after the first open during which the
+ *   drive reports it is becoming ready
+ */
+
+#define BRASERO_SCSI_EMULATOR_PREFIX		"emulator:"
+
+typedef struct _BraseroScsiEmulator BraseroScsiEmulator;
+
+gboolean
+brasero_scsi_emulator_is_device (const gchar *path);
+
+BraseroScsiEmulator *
+brasero_scsi_emulator_get (const gchar *path,
+			   BraseroScsiErrCode *error);
+
+gboolean
+brasero_scsi_emulator_open (BraseroScsiEmulator *emulator,
+			    gboolean exclusive,
+			    BraseroScsiErrCode *error);
+
+void
+brasero_scsi_emulator_close (BraseroScsiEmulator *emulator);
+
+BraseroScsiResult
+brasero_scsi_emulator_issue (BraseroScsiEmulator *emulator,
+			     const uchar *cdb,
+			     int cdb_len,
+			     uchar *buffer,
+			     int size,
+			     BraseroScsiErrCode *error);
+
+G_END_DECLS
+
+#endif /* _SCSI_EMULATOR_H */
@@ -252,3 +252,28 @@ brasero_mmc3_get_performance_wrt_spd_desc (BraseroDeviceHandle *handle,
 	return res;
 }
 
+
+BraseroScsiResult
+brasero_mmc3_get_performance_perf_desc (BraseroDeviceHandle *handle,
+					BraseroScsiGetPerfData **data,
+					int *size,
+					BraseroScsiErrCode *error)
+{
+	BraseroGetPerformanceCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_scsi_command_new (&info, handle);
+	cdb->type = BRASERO_GET_PERFORMANCE_PERF_TYPE;
+
+	/* Nominal write performance over the whole medium; MMC asks for the
+	 * tolerance field to be 10b (10 %) */
+	cdb->write = 1;
+	cdb->except = 0;
+	cdb->tolerance = 0x02;
+
+	res = brasero_get_performance (cdb, sizeof (BraseroScsiPerfDesc), data, size, error);
+	brasero_scsi_command_free (cdb);
+	return res;
+}
@@ -91,8 +91,17 @@ struct _BraseroScsiWrtSpdDesc {
 
 #endif
 
+/* Nominal performance descriptor (type 0x00): performances are in kB/s */
+struct _BraseroScsiPerfDesc {
+	uchar start_lba	[4];
+	uchar start_perf	[4];
+	uchar end_lba	[4];
+	uchar end_perf	[4];
+};
+
 typedef struct _BraseroScsiGetPerfHdr BraseroScsiGetPerfHdr;
 typedef struct _BraseroScsiWrtSpdDesc BraseroScsiWrtSpdDesc;
+typedef struct _BraseroScsiPerfDesc BraseroScsiPerfDesc;
 
 struct _BraseroScsiGetPerfData {
 	BraseroScsiGetPerfHdr hdr;
@@ -87,6 +87,19 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 			 int buffer_len,
 			 BraseroScsiErrCode *error);
 BraseroScsiResult
+brasero_mmc1_read_block_c2 (BraseroDeviceHandle *handle,
+			    BraseroScsiBlockType type,
+			    int start,
+			    int size,
+			    unsigned char *buffer,
+			    int buffer_len,
+			    BraseroScsiErrCode *error);
+BraseroScsiResult
+brasero_mmc1_set_cd_speed (BraseroDeviceHandle *handle,
+			   int read_speed,
+			   int write_speed,
+			   BraseroScsiErrCode *error);
+BraseroScsiResult
 brasero_mmc1_mech_status (BraseroDeviceHandle *handle,
 			  BraseroScsiMechStatusHdr *hdr,
 			  BraseroScsiErrCode *error);
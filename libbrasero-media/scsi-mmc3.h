@@ -54,6 +54,12 @@ brasero_mmc3_get_performance_wrt_spd_desc (BraseroDeviceHandle *handle,
 					   int *data_size,
 					   BraseroScsiErrCode *error);
 
+BraseroScsiResult
+brasero_mmc3_get_performance_perf_desc (BraseroDeviceHandle *handle,
+					BraseroScsiGetPerfData **data,
+					int *data_size,
+					BraseroScsiErrCode *error);
+
 G_END_DECLS
 
 #endif /* _BURN_MMC3_H */
@@ -66,6 +66,7 @@ G_BEGIN_DECLS
 #define BRASERO_LOAD_CD_OPCODE				0xA6
 #define BRASERO_MECH_STATUS_OPCODE			0xBD
 #define BRASERO_READ_CD_OPCODE				0xBE
+#define BRASERO_SET_CD_SPEED_OPCODE			0xBB
 
 /**
  *	MMC2
@@ -155,3 +155,47 @@ brasero_mmc1_read_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Same as above but each block of user data is followed by its C2 error
+ * pointers (one bit per byte of the raw 2352 bytes sector, so 294 bytes).
+ */
+
+BraseroScsiResult
+brasero_mmc1_read_block_c2 (BraseroDeviceHandle *handle,
+			    BraseroScsiBlockType type,
+			    int start,
+			    int size,
+			    unsigned char *buffer,
+			    int buffer_len,
+			    BraseroScsiErrCode *error)
+{
+	BraseroReadCDCDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_scsi_command_new (&info, handle);
+	BRASERO_SET_32 (cdb->start_lba, start);
+	BRASERO_SET_24 (cdb->len, size);
+
+	cdb->sync = 0;
+	cdb->sec_type = type;
+	cdb->header = BRASERO_SCSI_BLOCK_HEADER_NONE;
+	cdb->user_data = 1;
+
+	/* C2 error pointers only (no block error byte) */
+	cdb->error = 1;
+
+	cdb->subchannel = BRASERO_SCSI_BLOCK_NO_SUBCHANNEL;
+
+	if (buffer)
+		memset (buffer, 0, buffer_len);
+
+	res = brasero_scsi_command_issue_sync (cdb,
+					       buffer,
+					       buffer_len,
+					       error);
+	brasero_scsi_command_free (cdb);
+	return res;
+}
@@ -57,6 +57,9 @@ typedef enum {
 	BRASERO_SCSI_BLOCK_SUB_R_W		= 4
 } BraseroScsiBlockSubChannel;
 
+/* Size of the C2 error pointers returned for each block */
+#define BRASERO_SCSI_C2_POINTERS_SIZE		294
+
 
 G_END_DECLS
 
@@ -124,3 +124,38 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 	brasero_scsi_command_free (cdb);
 	return res;
 }
+
+/**
+ * Queues a READ10; buffer must remain valid until callback is called.
+ */
+
+BraseroScsiResult
+brasero_sbc_read10_block_async (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks,
+				unsigned char *buffer,
+				int buffer_size,
+				BraseroScsiCallback callback,
+				gpointer user_data,
+				BraseroScsiErrCode *error)
+{
+	BraseroRead10CDB *cdb;
+	BraseroScsiResult res;
+
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	cdb = brasero_scsi_command_new (&info, handle);
+	BRASERO_SET_32 (cdb->start_address, start);
+	BRASERO_SET_16 (cdb->len, num_blocks);
+	cdb->FUA = 0;
+
+	memset (buffer, 0, buffer_size);
+	res = brasero_scsi_command_issue_async (cdb,
+						buffer,
+						buffer_size,
+						callback,
+						user_data,
+						error);
+	brasero_scsi_command_free (cdb);
+	return res;
+}
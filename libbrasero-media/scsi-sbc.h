@@ -33,6 +33,7 @@
 #include "scsi-base.h"
 #include "scsi-error.h"
 #include "scsi-device.h"
+#include "scsi-command.h"
 
 #ifndef _BURN_SBC_H
 #define _BURN_SBC_H
@@ -52,6 +53,16 @@ brasero_sbc_read10_block (BraseroDeviceHandle *handle,
 			  int buffer_size,
 			  BraseroScsiErrCode *error);
 
+BraseroScsiResult
+brasero_sbc_read10_block_async (BraseroDeviceHandle *handle,
+				int start,
+				int num_blocks,
+				unsigned char *buffer,
+				int buffer_size,
+				BraseroScsiCallback callback,
+				gpointer user_data,
+				BraseroScsiErrCode *error);
+
 G_END_DECLS
 
 #endif /* _BURN_SBC_H */
@@ -40,6 +40,8 @@
 #include <fcntl.h>
 #include <string.h>
 #include <sys/ioctl.h>
+#include <sys/sysmacros.h>
+#include <poll.h>
 
 #include <scsi/scsi.h>
 #include <scsi/sg.h>
@@ -50,9 +52,38 @@
 #include "scsi-utils.h"
 #include "scsi-error.h"
 #include "scsi-sense-data.h"
+#include "scsi-emulator.h"
+
+#ifndef SCSI_GENERIC_MAJOR
+#define SCSI_GENERIC_MAJOR		21
+#endif
+
+/* Maximum number of commands queued on the sg node at the same time */
+#define BRASERO_SG_QUEUE_DEPTH		8
+
+struct _BraseroSgRequest {
+	struct sg_io_hdr transport;
+	uchar sense_buffer [BRASERO_SENSE_DATA_SIZE];
+
+	BraseroScsiCallback callback;
+	gpointer user_data;
+
+	guint busy:1;
+};
+typedef struct _BraseroSgRequest BraseroSgRequest;
 
 struct _BraseroDeviceHandle {
 	int fd;
+
+	/* sg node used to queue commands with write ()/read ().
+	 * It is -1 when the device has no such node (commands
+	 * are then issued one by one with SG_IO ioctl) */
+	int queue_fd;
+	BraseroSgRequest requests [BRASERO_SG_QUEUE_DEPTH];
+	guint pending;
+
+	/* Set when the device is emulated */
+	BraseroScsiEmulator *emulator;
 };
 
 struct _BraseroScsiCmd {
@@ -97,22 +128,48 @@ brasero_sg_command_setup (struct sg_io_hdr *transport,
 		transport->dxfer_direction = SG_DXFER_FROM_DEV;
 	else if (cmd->info->direction & BRASERO_SCSI_WRITE)
 		transport->dxfer_direction = SG_DXFER_TO_DEV;
+	else
+		transport->dxfer_direction = SG_DXFER_NONE;
 }
 
-BraseroScsiResult
-brasero_scsi_command_issue_sync (gpointer command,
-				 gpointer buffer,
-				 int size,
-				 BraseroScsiErrCode *error)
+static BraseroScsiResult
+brasero_sg_command_result (struct sg_io_hdr *transport,
+			   uchar *sense_buffer,
+			   BraseroScsiErrCode *error)
+{
+	if ((transport->info & SG_INFO_OK_MASK) == SG_INFO_OK)
+		return BRASERO_SCSI_OK;
+
+	if ((transport->masked_status & CHECK_CONDITION) && transport->sb_len_wr)
+		return brasero_sense_data_process (sense_buffer, error);
+
+	return BRASERO_SCSI_FAILURE;
+}
+
+/**
+ * Issues the command with a blocking SG_IO ioctl. That is used for synchronous
+ * commands and when no sg node could be opened for the device (or for
+ * emulated devices).
+ */
+
+static BraseroScsiResult
+brasero_sg_command_issue_ioctl (BraseroScsiCmd *cmd,
+				gpointer buffer,
+				int size,
+				BraseroScsiErrCode *error)
 {
 	uchar sense_buffer [BRASERO_SENSE_DATA_SIZE];
 	struct sg_io_hdr transport;
-	BraseroScsiResult res;
-	BraseroScsiCmd *cmd;
+	int res;
 
-	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+	if (cmd->handle->emulator)
+		return brasero_scsi_emulator_issue (cmd->handle->emulator,
+						    cmd->cmd,
+						    cmd->info->size,
+						    buffer,
+						    size,
+						    error);
 
-	cmd = command;
 	brasero_sg_command_setup (&transport,
 				  sense_buffer,
 				  cmd,
@@ -127,13 +184,242 @@ brasero_scsi_command_issue_sync (gpointer command,
 		return BRASERO_SCSI_FAILURE;
 	}
 
-	if ((transport.info & SG_INFO_OK_MASK) == SG_INFO_OK)
+	return brasero_sg_command_result (&transport, sense_buffer, error);
+}
+
+/**
+ * Completes all queued commands with an error and stops queueing on this
+ * handle. The sg node is closed so the kernel drops whatever is left.
+ */
+
+static void
+brasero_sg_queue_abort (BraseroDeviceHandle *handle)
+{
+	int i;
+
+	close (handle->queue_fd);
+	handle->queue_fd = -1;
+
+	for (i = 0; i < BRASERO_SG_QUEUE_DEPTH; i ++) {
+		BraseroSgRequest *request;
+
+		request = handle->requests + i;
+		if (!request->busy)
+			continue;
+
+		request->busy = FALSE;
+		handle->pending --;
+
+		if (request->callback)
+			request->callback (BRASERO_SCSI_FAILURE,
+					   BRASERO_SCSI_ERRNO,
+					   request->user_data);
+	}
+}
+
+/**
+ * Waits for one queued command to complete and calls its callback.
+ */
+
+static BraseroScsiResult
+brasero_sg_queue_reap (BraseroDeviceHandle *handle,
+		       BraseroScsiErrCode *error)
+{
+	BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+	BraseroSgRequest *request;
+	struct sg_io_hdr transport;
+	BraseroScsiResult result;
+	struct pollfd fds;
+
+	fds.fd = handle->queue_fd;
+	fds.events = POLLIN;
+
+	while (1) {
+		memset (&transport, 0, sizeof (struct sg_io_hdr));
+		transport.interface_id = 'S';
+		transport.pack_id = -1;
+
+		if (read (handle->queue_fd, &transport, sizeof (struct sg_io_hdr)) >= 0)
+			break;
+
+		if (errno == EINTR)
+			continue;
+
+		if (errno == EAGAIN) {
+			/* The descriptor is non blocking */
+			if (poll (&fds, 1, -1) >= 0 || errno == EINTR)
+				continue;
+		}
+
+		BRASERO_MEDIA_LOG ("Reading sg completion failed: %s", strerror (errno));
+		brasero_sg_queue_abort (handle);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	request = transport.usr_ptr;
+	if (request < handle->requests
+	||  request >= handle->requests + BRASERO_SG_QUEUE_DEPTH
+	|| !request->busy) {
+		BRASERO_MEDIA_LOG ("Unknown sg completion (pack id %i)", transport.pack_id);
+		brasero_sg_queue_abort (handle);
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	request->busy = FALSE;
+	handle->pending --;
+
+	result = brasero_sg_command_result (&transport,
+					    request->sense_buffer,
+					    &code);
+	if (request->callback)
+		request->callback (result, code, request->user_data);
+
+	return BRASERO_SCSI_OK;
+}
+
+/**
+ * Queues the command on the device. The CDB is copied on submission so the
+ * command can be freed as soon as this returns; the buffer must stay valid
+ * until @callback is called.
+ * If the queue is full, this waits for the oldest commands to complete (and
+ * calls their callbacks) first. On devices which cannot queue commands, the
+ * command is executed right away and @callback is called before returning.
+ * The return value only tells whether the command could be submitted.
+ */
+
+BraseroScsiResult
+brasero_scsi_command_issue_async (gpointer command,
+				  gpointer buffer,
+				  int size,
+				  BraseroScsiCallback callback,
+				  gpointer user_data,
+				  BraseroScsiErrCode *error)
+{
+	BraseroDeviceHandle *handle;
+	BraseroSgRequest *request;
+	BraseroScsiCmd *cmd;
+	int i;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	handle = cmd->handle;
+
+	while (handle->queue_fd >= 0) {
+		if (handle->pending >= BRASERO_SG_QUEUE_DEPTH) {
+			if (brasero_sg_queue_reap (handle, error) != BRASERO_SCSI_OK)
+				return BRASERO_SCSI_FAILURE;
+
+			continue;
+		}
+
+		for (i = 0; i < BRASERO_SG_QUEUE_DEPTH; i ++) {
+			if (!handle->requests [i].busy)
+				break;
+		}
+
+		request = handle->requests + i;
+		brasero_sg_command_setup (&request->transport,
+					  request->sense_buffer,
+					  cmd,
+					  buffer,
+					  size);
+		request->transport.pack_id = i;
+		request->transport.usr_ptr = request;
+
+		if (write (handle->queue_fd, &request->transport, sizeof (struct sg_io_hdr)) >= 0) {
+			request->callback = callback;
+			request->user_data = user_data;
+			request->busy = TRUE;
+			handle->pending ++;
+			return BRASERO_SCSI_OK;
+		}
+
+		if (errno == EINTR)
+			continue;
+
+		/* The kernel queue is full */
+		if ((errno == EDOM || errno == EAGAIN) && handle->pending) {
+			if (brasero_sg_queue_reap (handle, error) != BRASERO_SCSI_OK)
+				return BRASERO_SCSI_FAILURE;
+
+			continue;
+		}
+
+		BRASERO_SCSI_SET_ERRCODE (error, BRASERO_SCSI_ERRNO);
+		return BRASERO_SCSI_FAILURE;
+	}
+
+	if (callback) {
+		BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+		BraseroScsiResult result;
+
+		result = brasero_sg_command_issue_ioctl (cmd, buffer, size, &code);
+		callback (result, code, user_data);
+	}
+	else
+		brasero_sg_command_issue_ioctl (cmd, buffer, size, NULL);
+
+	return BRASERO_SCSI_OK;
+}
+
+/**
+ * Synchronous commands are not queued: they go through the descriptor of the
+ * handle with a blocking SG_IO ioctl once the queued commands (if any)
+ * completed so that commands still reach the drive in order.
+ */
+
+BraseroScsiResult
+brasero_scsi_command_issue_sync (gpointer command,
+				 gpointer buffer,
+				 int size,
+				 BraseroScsiErrCode *error)
+{
+	BraseroScsiCmd *cmd;
+
+	g_return_val_if_fail (command != NULL, BRASERO_SCSI_FAILURE);
+
+	cmd = command;
+	if (brasero_device_handle_flush (cmd->handle, error) != BRASERO_SCSI_OK)
+		return BRASERO_SCSI_FAILURE;
+
+	return brasero_sg_command_issue_ioctl (cmd, buffer, size, error);
+}
+
+/**
+ * Waits for the next queued command to complete.
+ */
+
+BraseroScsiResult
+brasero_device_handle_wait (BraseroDeviceHandle *handle,
+			    BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	if (!handle->pending)
 		return BRASERO_SCSI_OK;
 
-	if ((transport.masked_status & CHECK_CONDITION) && transport.sb_len_wr)
-		return brasero_sense_data_process (sense_buffer, error);
+	return brasero_sg_queue_reap (handle, error);
+}
 
-	return BRASERO_SCSI_FAILURE;
+/**
+ * Waits for all queued commands to complete.
+ */
+
+BraseroScsiResult
+brasero_device_handle_flush (BraseroDeviceHandle *handle,
+			     BraseroScsiErrCode *error)
+{
+	g_return_val_if_fail (handle != NULL, BRASERO_SCSI_FAILURE);
+
+	while (handle->pending) {
+		if (brasero_sg_queue_reap (handle, error) != BRASERO_SCSI_OK)
+			return BRASERO_SCSI_FAILURE;
+	}
+
+	return BRASERO_SCSI_OK;
 }
 
 gpointer
@@ -166,6 +452,66 @@ brasero_scsi_command_free (gpointer cmd)
  * This is to open a device
  */
 
+/**
+ * Returns a descriptor on the sg node of the device so commands can be
+ * queued with write ()/read (). Block devices (like /dev/sr0) cannot be
+ * used for that and their sg node is looked up through sysfs; it is opened
+ * with the same @flags as the device so an exclusive handle stays exclusive.
+ */
+
+static int
+brasero_sg_queue_open (int fd,
+		       int flags)
+{
+	const gchar *name = NULL;
+	gchar *sysfs_path;
+	struct stat info;
+	gchar *path;
+	int queue_fd;
+	int enable;
+	GDir *dir;
+
+	if (fstat (fd, &info))
+		return -1;
+
+	if (S_ISCHR (info.st_mode) && major (info.st_rdev) == SCSI_GENERIC_MAJOR)
+		queue_fd = dup (fd);
+	else if (S_ISBLK (info.st_mode)) {
+		sysfs_path = g_strdup_printf ("/sys/dev/block/%u:%u/device/scsi_generic",
+					      major (info.st_rdev),
+					      minor (info.st_rdev));
+		dir = g_dir_open (sysfs_path, 0, NULL);
+		g_free (sysfs_path);
+		if (!dir)
+			return -1;
+
+		name = g_dir_read_name (dir);
+		if (!name) {
+			g_dir_close (dir);
+			return -1;
+		}
+
+		path = g_build_filename ("/dev", name, NULL);
+		g_dir_close (dir);
+
+		queue_fd = open (path, flags);
+		if (queue_fd < 0)
+			BRASERO_MEDIA_LOG ("No sg node (%s): %s", path, strerror (errno));
+
+		g_free (path);
+	}
+	else
+		return -1;
+
+	if (queue_fd < 0)
+		return -1;
+
+	/* That's automatic with sg_io_hdr but make sure of it */
+	enable = 1;
+	ioctl (queue_fd, SG_SET_COMMAND_Q, &enable);
+	return queue_fd;
+}
+
 BraseroDeviceHandle *
 brasero_device_handle_open (const gchar *path,
 			    gboolean exclusive,
@@ -178,6 +524,25 @@ brasero_device_handle_open (const gchar *path,
 	if (exclusive)
 		flags |= O_EXCL;
 
+	if (brasero_scsi_emulator_is_device (path)) {
+		BraseroScsiEmulator *emulator;
+
+		emulator = brasero_scsi_emulator_get (path, code);
+		if (!emulator)
+			return NULL;
+
+		if (!brasero_scsi_emulator_open (emulator, exclusive, code))
+			return NULL;
+
+		handle = g_new0 (BraseroDeviceHandle, 1);
+		handle->fd = -1;
+		handle->queue_fd = -1;
+		handle->emulator = emulator;
+
+		BRASERO_MEDIA_LOG ("Emulated handle ready");
+		return handle;
+	}
+
 	BRASERO_MEDIA_LOG ("Getting handle");
 	fd = open (path, flags);
 	if (fd < 0) {
@@ -194,17 +559,31 @@ brasero_device_handle_open (const gchar *path,
 		return NULL;
 	}
 
-	handle = g_new (BraseroDeviceHandle, 1);
+	handle = g_new0 (BraseroDeviceHandle, 1);
 	handle->fd = fd;
+	handle->queue_fd = brasero_sg_queue_open (fd, flags);
 
-	BRASERO_MEDIA_LOG ("Handle ready");
+	BRASERO_MEDIA_LOG ("Handle ready%s", handle->queue_fd >= 0 ? " (queued commands)":"");
 	return handle;
 }
 
 void
 brasero_device_handle_close (BraseroDeviceHandle *handle)
 {
-	close (handle->fd);
+	if (handle->queue_fd >= 0) {
+		brasero_device_handle_flush (handle, NULL);
+
+		/* flushing may have failed and closed it */
+		if (handle->queue_fd >= 0)
+			close (handle->queue_fd);
+	}
+
+	if (handle->fd >= 0)
+		close (handle->fd);
+
+	if (handle->emulator)
+		brasero_scsi_emulator_close (handle->emulator);
+
 	g_free (handle);
 }
 
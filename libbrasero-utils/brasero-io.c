@@ -120,6 +120,9 @@ struct _BraseroIOJobResult {
 	GFileInfo *info;
 	GError *error;
 	gchar *uri;
+
+	/* Several BraseroIOEntry returned at once */
+	GArray *entries;
 };
 typedef struct _BraseroIOJobResult BraseroIOJobResult;
 
@@ -309,6 +312,19 @@ brasero_io_job_result_free (BraseroIOJobResult *result)
 	if (result->uri)
 		g_free (result->uri);
 
+	if (result->entries) {
+		guint i;
+
+		for (i = 0; i < result->entries->len; i ++) {
+			BraseroIOEntry *entry;
+
+			entry = &g_array_index (result->entries, BraseroIOEntry, i);
+			g_object_unref (entry->info);
+			g_free (entry->uri);
+		}
+		g_array_free (result->entries, TRUE);
+	}
+
 	g_free (result);
 }
 
@@ -376,7 +392,12 @@ brasero_io_return_result_idle (gpointer callback_data)
 
 		data = result->callback_data;
 
-		if (result->uri || result->info || result->error)
+		if (result->entries)
+			base->methods->batch (base->object,
+					      (BraseroIOEntry *) result->entries->data,
+					      result->entries->len,
+					      data? data->callback_data:NULL);
+		else if (result->uri || result->info || result->error)
 			base->methods->callback (base->object,
 			                          result->error,
 			                          result->uri,
@@ -455,6 +476,27 @@ brasero_io_return_result (const BraseroIOJobBase *base,
 	g_object_unref (self);
 }
 
+static void
+brasero_io_return_entries (const BraseroIOJobBase *base,
+			   GArray *entries,
+			   BraseroIOResultCallbackData *callback_data)
+{
+	BraseroIO *self = brasero_io_get_default ();
+	BraseroIOJobResult *result;
+
+	result = g_new0 (BraseroIOJobResult, 1);
+	result->base = base;
+	result->entries = entries;
+
+	if (callback_data) {
+		g_atomic_int_inc (&callback_data->ref);
+		result->callback_data = callback_data;
+	}
+
+	brasero_io_queue_result (self, result);
+	g_object_unref (self);
+}
+
 /**
  * Used to push a job
  */
@@ -1134,6 +1176,8 @@ brasero_io_get_file_info_thread_real (BraseroAsyncTaskManager *manager,
 		strcat (attributes, "," G_FILE_ATTRIBUTE_ACCESS_CAN_READ);
 	if (options & BRASERO_IO_INFO_MIME)
 		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+	else if (options & BRASERO_IO_INFO_MIME_FAST)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
 	if (options & BRASERO_IO_INFO_ICON)
 		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_ICON);
 	if (options & BRASERO_IO_INFO_METADATA_THUMBNAIL)
@@ -1970,6 +2014,161 @@ brasero_io_load_directory_playlist (BraseroIO *self,
 
 #endif
 
+#define BRASERO_IO_ENUMERATE_BATCH	64
+
+/**
+ * Gathers up to num entries so they can be returned together. GIO only has
+ * an asynchronous g_file_enumerator_next_files () so each entry is still
+ * queried on its own.
+ */
+
+static GList *
+brasero_io_enumerator_next_files (GFileEnumerator *enumerator,
+				  guint num,
+				  GCancellable *cancel)
+{
+	GList *infos = NULL;
+	GFileInfo *info;
+
+	while (num > 0 && (info = g_file_enumerator_next_file (enumerator, cancel, NULL))) {
+		infos = g_list_prepend (infos, info);
+		num --;
+	}
+
+	return g_list_reverse (infos);
+}
+
+static void
+brasero_io_load_directory_return (BraseroIOContentsData *data,
+				  GArray *entries,
+				  gchar *child_uri,
+				  GFileInfo *info)
+{
+	BraseroIOEntry entry;
+
+	if (!entries) {
+		brasero_io_return_result (data->job.base,
+					  child_uri,
+					  info,
+					  NULL,
+					  data->job.callback_data);
+		g_free (child_uri);
+		return;
+	}
+
+	/* The array owns both */
+	entry.uri = child_uri;
+	entry.info = info;
+	g_array_append_val (entries, entry);
+}
+
+static void
+brasero_io_load_directory_entry (BraseroIO *self,
+				 GCancellable *cancel,
+				 BraseroIOContentsData *data,
+				 GFile *file,
+				 GFileInfo *info,
+				 const gchar *attributes,
+				 GArray *entries)
+{
+	const gchar *name;
+	gchar *child_uri;
+	GFile *child;
+
+	name = g_file_info_get_name (info);
+	if (name [0] == '.'
+	&& (name [1] == '\0'
+	|| (name [1] == '.' && name [2] == '\0'))) {
+		g_object_unref (info);
+		return;
+	}
+
+	child = g_file_get_child (file, name);
+	if (!child) {
+		g_object_unref (info);
+		return;
+	}
+
+	child_uri = g_file_get_uri (child);
+
+	/* special case for symlinks */
+	if (g_file_info_get_is_symlink (info)) {
+		if (!brasero_io_check_symlink_target (file, info)) {
+			GError *error;
+
+			error = g_error_new (BRASERO_UTILS_ERROR,
+					     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
+					     _("Recursive symbolic link"));
+
+			/* since we checked for the existence of the file
+			 * an error means a looping symbolic link */
+			brasero_io_return_result (data->job.base,
+						  child_uri,
+						  NULL,
+						  error,
+						  data->job.callback_data);
+
+			g_free (child_uri);
+			g_object_unref (info);
+			g_object_unref (child);
+			return;
+		}
+	}
+
+	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+		brasero_io_load_directory_return (data, entries, child_uri, info);
+
+		if (data->job.options & BRASERO_IO_INFO_RECURSIVE)
+			data->children = g_slist_prepend (data->children, child);
+		else
+			g_object_unref (child);
+
+		return;
+	}
+
+	if (data->job.options & BRASERO_IO_INFO_METADATA) {
+		BraseroMetadataInfo metadata = {NULL, };
+		gboolean result;
+
+		/* add metadata information to this file */
+		result = brasero_io_get_metadata_info (self,
+						       cancel,
+						       child_uri,
+						       info,
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
+						       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
+						       &metadata);
+
+		if (result)
+			brasero_io_set_metadata_attributes (info, &metadata);
+
+#ifdef BUILD_PLAYLIST
+
+		else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
+			const gchar *mime;
+
+			mime = g_file_info_get_content_type (info);
+			if (mime
+			&& (!strcmp (mime, "audio/x-scpls")
+			||  !strcmp (mime, "audio/x-ms-asx")
+			||  !strcmp (mime, "audio/x-mp3-playlist")
+			||  !strcmp (mime, "audio/x-mpegurl")))
+				brasero_io_load_directory_playlist (self,
+								    cancel,
+								    data,
+								    child_uri,
+								    attributes);
+		}
+
+#endif
+
+		brasero_metadata_info_clear (&metadata);
+	}
+
+	brasero_io_load_directory_return (data, entries, child_uri, info);
+	g_object_unref (child);
+}
+
 static BraseroAsyncTaskResult
 brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 				  GCancellable *cancel,
@@ -1984,6 +2183,7 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 	GFileEnumerator *enumerator;
 	GError *error = NULL;
 	GFileInfo *info;
+	GList *infos;
 	GFile *file;
 
 	if (data->job.options & BRASERO_IO_INFO_PERM)
@@ -1994,6 +2194,8 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 	else if ((data->job.options & BRASERO_IO_INFO_METADATA)
 	     &&  (data->job.options & BRASERO_IO_INFO_RECURSIVE))
 		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);
+	else if (data->job.options & BRASERO_IO_INFO_MIME_FAST)
+		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_FAST_CONTENT_TYPE);
 
 	if (data->job.options & BRASERO_IO_INFO_ICON)
 		strcat (attributes, "," G_FILE_ATTRIBUTE_STANDARD_ICON);
@@ -2029,114 +2231,49 @@ brasero_io_load_directory_thread (BraseroAsyncTaskManager *manager,
 		return BRASERO_ASYNC_TASK_FINISHED;
 	}
 
-	while ((info = g_file_enumerator_next_file (enumerator, cancel, NULL))) {
-		const gchar *name;
-		gchar *child_uri;
-		GFile *child;
+	/* Return entries by batches: one result to queue and dispatch in the
+	 * main loop for a whole batch instead of one per entry. */
+	while ((infos = brasero_io_enumerator_next_files (enumerator,
+							  BRASERO_IO_ENUMERATE_BATCH,
+							  cancel))) {
+		GArray *entries = NULL;
+		GList *iter;
 
-		name = g_file_info_get_name (info);
-		if (g_cancellable_is_cancelled (cancel)) {
-			g_object_unref (info);
-			break;
-		}
+		if (data->job.base->methods->batch)
+			entries = g_array_sized_new (FALSE,
+						     FALSE,
+						     sizeof (BraseroIOEntry),
+						     BRASERO_IO_ENUMERATE_BATCH);
 
-		if (name [0] == '.'
-		&& (name [1] == '\0'
-		|| (name [1] == '.' && name [2] == '\0'))) {
-			g_object_unref (info);
-			continue;
-		}
+		for (iter = infos; iter; iter = iter->next) {
+			info = iter->data;
 
-		child = g_file_get_child (file, name);
-		if (!child)
-			continue;
-
-		child_uri = g_file_get_uri (child);
-
-		/* special case for symlinks */
-		if (g_file_info_get_is_symlink (info)) {
-			if (!brasero_io_check_symlink_target (file, info)) {
-				error = g_error_new (BRASERO_UTILS_ERROR,
-						     BRASERO_UTILS_ERROR_SYMLINK_LOOP,
-						     _("Recursive symbolic link"));
-
-				/* since we checked for the existence of the file
-				 * an error means a looping symbolic link */
-				brasero_io_return_result (data->job.base,
-							  child_uri,
-							  NULL,
-							  error,
-							  data->job.callback_data);
-
-				g_free (child_uri);
+			if (g_cancellable_is_cancelled (cancel)) {
 				g_object_unref (info);
-				g_object_unref (child);
 				continue;
 			}
-		}
 
-		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
-			brasero_io_return_result (data->job.base,
-						  child_uri,
-						  info,
-						  NULL,
-						  data->job.callback_data);
-
-			if (data->job.options & BRASERO_IO_INFO_RECURSIVE)
-				data->children = g_slist_prepend (data->children, child);
-			else
-				g_object_unref (child);
-
-			g_free (child_uri);
-			continue;
+			brasero_io_load_directory_entry (BRASERO_IO (manager),
+							 cancel,
+							 data,
+							 file,
+							 info,
+							 attributes,
+							 entries);
 		}
+		g_list_free (infos);
 
-		if (data->job.options & BRASERO_IO_INFO_METADATA) {
-			BraseroMetadataInfo metadata = {NULL, };
-			gboolean result;
-
-			/* add metadata information to this file */
-			result = brasero_io_get_metadata_info (BRASERO_IO (manager),
-							       cancel,
-							       child_uri,
-							       info,
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_MISSING_CODEC) ? BRASERO_METADATA_FLAG_MISSING : 0) |
-							       ((data->job.options & BRASERO_IO_INFO_METADATA_THUMBNAIL) ? BRASERO_METADATA_FLAG_THUMBNAIL : 0),
-							       &metadata);
-
-			if (result)
-				brasero_io_set_metadata_attributes (info, &metadata);
-
-#ifdef BUILD_PLAYLIST
-
-			else if (data->job.options & BRASERO_IO_INFO_RECURSIVE) {
-				const gchar *mime;
-
-				mime = g_file_info_get_content_type (info);
-				if (mime
-				&& (!strcmp (mime, "audio/x-scpls")
-				||  !strcmp (mime, "audio/x-ms-asx")
-				||  !strcmp (mime, "audio/x-mp3-playlist")
-				||  !strcmp (mime, "audio/x-mpegurl")))
-					brasero_io_load_directory_playlist (BRASERO_IO (manager),
-									    cancel,
-									    data,
-									    child_uri,
-									    attributes);
-			}
-
-#endif
-
-			brasero_metadata_info_clear (&metadata);
+		if (entries) {
+			if (entries->len)
+				brasero_io_return_entries (data->job.base,
+							   entries,
+							   data->job.callback_data);
+			else
+				g_array_free (entries, TRUE);
 		}
 
-		brasero_io_return_result (data->job.base,
-					  child_uri,
-					  info,
-					  NULL,
-					  data->job.callback_data);
-		g_free (child_uri);
-		g_object_unref (child);
+		if (g_cancellable_is_cancelled (cancel))
+			break;
 	}
 
 	g_file_enumerator_close (enumerator, NULL, NULL);
@@ -2330,6 +2467,18 @@ brasero_io_register (GObject *object,
 	return brasero_io_register_with_methods (object, brasero_io_register_job_methods (callback, destroy, progress));
 }
 
+/**
+ * Once set, brasero_io_load_directory () returns the contents of a directory
+ * through @batch several entries at a time instead of one by one.
+ */
+
+void
+brasero_io_job_base_set_batch (BraseroIOJobBase *base,
+			       BraseroIOBatchCallback batch)
+{
+	base->methods->batch = batch;
+}
+
 void
 brasero_io_job_base_free (BraseroIOJobBase *base)
 {
@@ -52,7 +52,10 @@ typedef enum {
 	BRASERO_IO_INFO_FOLLOW_SYMLINK		= 1 << 7,
 
 	BRASERO_IO_INFO_URGENT			= 1 << 9,
-	BRASERO_IO_INFO_IDLE			= 1 << 10
+	BRASERO_IO_INFO_IDLE			= 1 << 10,
+
+	/* Mime type guessed from the name only (no file is read) */
+	BRASERO_IO_INFO_MIME_FAST		= 1 << 11
 } BraseroIOFlags;
 
 
@@ -100,6 +103,22 @@ typedef void		(*BraseroIOResultCallback)	(GObject *object,
 							 GFileInfo *info,
 							 gpointer callback_data);
 
+/**
+ * One of the entries of a directory returned at once through the
+ * BraseroIOBatchCallback.
+ */
+
+struct _BraseroIOEntry {
+	gchar *uri;
+	GFileInfo *info;
+};
+typedef struct _BraseroIOEntry BraseroIOEntry;
+
+typedef void		(*BraseroIOBatchCallback)	(GObject *object,
+							 BraseroIOEntry *entries,
+							 guint num,
+							 gpointer callback_data);
+
 typedef void		(*BraseroIOProgressCallback)	(GObject *object,
 							 BraseroIOJobProgress *info,
 							 gpointer callback_data);
@@ -116,6 +135,7 @@ struct _BraseroIOJobCallbacks {
 	BraseroIOResultCallback callback;
 	BraseroIODestroyCallback destroy;
 	BraseroIOProgressCallback progress;
+	BraseroIOBatchCallback batch;
 
 	guint ref;
 
@@ -203,6 +223,10 @@ brasero_io_register_job_methods (BraseroIOResultCallback callback,
 void
 brasero_io_job_base_free (BraseroIOJobBase *base);
 
+void
+brasero_io_job_base_set_batch (BraseroIOJobBase *base,
+			       BraseroIOBatchCallback batch);
+
 void
 brasero_io_cancel_by_base (BraseroIOJobBase *base);
 
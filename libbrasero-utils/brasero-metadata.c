@@ -48,8 +48,11 @@
 
 #include "brasero-misc.h"
 #include "brasero-metadata.h"
+#include "brasero-silence-analyser.h"
 
-#define BRASERO_METADATA_SILENCE_INTERVAL		100000000LL
+#define BRASERO_METADATA_SILENCE_THRESHOLD		-50.0
+#define BRASERO_METADATA_SILENCE_MIN_GAP		100000000LL
+#define BRASERO_METADATA_SILENCE_RESOLUTION		20000000LL
 #define BRASERO_METADATA_INITIAL_STATE			GST_STATE_PAUSED
 
 struct BraseroMetadataPrivate {
@@ -57,7 +60,6 @@ struct BraseroMetadataPrivate {
 	GstElement *source;
 	GstElement *decode;
 	GstElement *convert;
-	GstElement *level;
 	GstElement *sink;
 
 	GstElement *pipeline_mp3;
@@ -71,7 +73,12 @@ struct BraseroMetadataPrivate {
 	guint watch;
 	guint watch_mp3;
 
-	BraseroMetadataSilence *silence;
+	BraseroSilenceAnalyser *analyser;
+	gulong silence_probe;
+	gdouble silence_threshold;
+	gint64 silence_min_gap;
+	gint64 silence_resolution;
+	gboolean silence_format;	/* set in the streaming thread */
 
 	BraseroMetadataFlag flags;
 	BraseroMetadataInfo *info;
@@ -90,7 +97,6 @@ struct BraseroMetadataPrivate {
 
 	guint started:1;
 	guint moved_forward:1;
-	guint prev_level_mes:1;
 	guint video_linked:1;
 	guint audio_linked:1;
 	guint snapshot_started:1;
@@ -146,6 +152,28 @@ brasero_metadata_set_get_xid_callback (BraseroMetadata *metadata,
 	priv->xid_user_data = user_data;
 }
 
+/**
+ * Sets how silences are detected with BRASERO_METADATA_FLAG_SILENCES:
+ * @threshold is the level (in dB) under which a window is silent, @min_gap
+ * the shortest silence reported and @resolution the length of a window (both
+ * in nanoseconds). A negative value or 0 keeps the default.
+ */
+
+void
+brasero_metadata_set_silence_parameters (BraseroMetadata *metadata,
+					 gdouble threshold,
+					 gint64 min_gap,
+					 gint64 resolution)
+{
+	BraseroMetadataPrivate *priv;
+
+	priv = BRASERO_METADATA_PRIVATE (metadata);
+
+	priv->silence_threshold = threshold < 0.0? threshold:BRASERO_METADATA_SILENCE_THRESHOLD;
+	priv->silence_min_gap = min_gap > 0? min_gap:BRASERO_METADATA_SILENCE_MIN_GAP;
+	priv->silence_resolution = resolution > 0? resolution:BRASERO_METADATA_SILENCE_RESOLUTION;
+}
+
 struct _BraseroMetadataGstDownload {
 	gchar *detail;
 
@@ -190,8 +218,7 @@ brasero_metadata_info_clear (BraseroMetadataInfo *info)
 		g_free (info->isrc);
 
 	if (info->silences) {
-		g_slist_foreach (info->silences, (GFunc) g_free, NULL);
-		g_slist_free (info->silences);
+		g_array_free (info->silences, TRUE);
 		info->silences = NULL;
 	}
 }
@@ -211,8 +238,6 @@ void
 brasero_metadata_info_copy (BraseroMetadataInfo *dest,
 			    BraseroMetadataInfo *src)
 {
-	GSList *iter;
-
 	if (!dest || !src)
 		return;
 
@@ -253,16 +278,14 @@ brasero_metadata_info_copy (BraseroMetadataInfo *dest,
 		g_object_ref (dest->snapshot);
 	}
 
-	for (iter = src->silences; iter; iter = iter->next) {
-		BraseroMetadataSilence *silence, *copy;
-
-		silence = iter->data;
-
-		copy = g_new0 (BraseroMetadataSilence, 1);
-		copy->start = silence->start;
-		copy->end = silence->end;
-
-		dest->silences = g_slist_append (dest->silences, copy);
+	if (src->silences) {
+		dest->silences = g_array_sized_new (FALSE,
+						    FALSE,
+						    sizeof (BraseroMetadataSilence),
+						    src->silences->len);
+		g_array_append_vals (dest->silences,
+				     src->silences->data,
+				     src->silences->len);
 	}
 }
 
@@ -297,6 +320,28 @@ brasero_metadata_stop_pipeline (GstElement *pipeline)
 
 }
 
+static void
+brasero_metadata_free_analyser (BraseroMetadata *self)
+{
+	BraseroMetadataPrivate *priv;
+
+	priv = BRASERO_METADATA_PRIVATE (self);
+
+	if (priv->silence_probe) {
+		GstPad *pad;
+
+		pad = gst_element_get_static_pad (priv->sink, "sink");
+		gst_pad_remove_probe (pad, priv->silence_probe);
+		gst_object_unref (pad);
+		priv->silence_probe = 0;
+	}
+
+	if (priv->analyser) {
+		brasero_silence_analyser_free (priv->analyser);
+		priv->analyser = NULL;
+	}
+}
+
 static void
 brasero_metadata_destroy_pipeline (BraseroMetadata *self)
 {
@@ -321,6 +366,7 @@ brasero_metadata_destroy_pipeline (BraseroMetadata *self)
 		return;
 
 	brasero_metadata_stop_pipeline (priv->pipeline);
+	brasero_metadata_free_analyser (self);
 
 	if (priv->audio) {
 		gst_bin_remove (GST_BIN (priv->pipeline), priv->audio);
@@ -336,11 +382,6 @@ brasero_metadata_destroy_pipeline (BraseroMetadata *self)
 	gst_object_unref (GST_OBJECT (priv->pipeline));
 	priv->pipeline = NULL;
 
-	if (priv->level) {
-		gst_object_unref (GST_OBJECT (priv->level));
-		priv->level = NULL;
-	}
-
 	if (priv->sink) {
 		gst_object_unref (GST_OBJECT (priv->sink));
 		priv->sink = NULL;
@@ -989,55 +1030,6 @@ brasero_metadata_process_element_messages (BraseroMetadata *self,
 	&&   gst_is_missing_plugin_message (msg)) {
 		priv->missing_plugins = g_slist_prepend (priv->missing_plugins, gst_message_ref (msg));
 	}
-	else if (gst_message_has_name (msg, "level")
-	&&   gst_structure_has_field (s, "peak")) {
-		const GValue *value;
-		const GValue *list;
-		gdouble peak;
-
-		/* FIXME: this might still be changed to GValueArray before 1.0 release */
-		list = gst_structure_get_value (s, "peak");
-		value = gst_value_list_get_value (list, 0);
-		peak = g_value_get_double (value);
-
-		/* detection of silence */
-		if (peak < -50.0) {
-			gint64 pos = -1;
-
-			/* was there a silence last time we check ?
-			 * NOTE: if that's the first signal we receive
-			 * then consider that silence started from 0 */
-			gst_element_query_position (priv->pipeline, GST_FORMAT_TIME, &pos);
-			if (pos == -1) {
-				BRASERO_UTILS_LOG ("impossible to retrieve position");
-				return TRUE;
-			}
-
-			if (!priv->silence) {
-				priv->silence = g_new0 (BraseroMetadataSilence, 1);
-				if (priv->prev_level_mes) {
-					priv->silence->start = pos;
-					priv->silence->end = pos;
-				}
-				else {
-					priv->silence->start = 0;
-					priv->silence->end = pos;
-				}
-			}				
-			else
-				priv->silence->end = pos;
-
-			BRASERO_UTILS_LOG ("silence detected at %lli", pos);
-		}
-		else if (priv->silence) {
-			BRASERO_UTILS_LOG ("silence finished");
-
-			priv->info->silences = g_slist_append (priv->info->silences,
-							       priv->silence);
-			priv->silence = NULL;
-		}
-		priv->prev_level_mes = 1;
-	}
 
 	return TRUE;
 }
@@ -1081,10 +1073,11 @@ brasero_metadata_success (BraseroMetadata *self)
 	/* check if that's a seekable one */
 	brasero_metadata_is_seekable (self);
 
-	if (priv->silence) {
-		priv->silence->end = priv->info->len;
-		priv->info->silences = g_slist_append (priv->info->silences, priv->silence);
-		priv->silence = NULL;
+	/* The stream was entirely decoded; all levels are known */
+	if (priv->analyser) {
+		priv->info->silences = brasero_silence_analyser_finish (priv->analyser,
+									priv->info->len);
+		brasero_metadata_free_analyser (self);
 	}
 
 	/* before leaving, check if we need a snapshot */
@@ -1340,6 +1333,52 @@ brasero_metadata_bus_messages (GstBus *bus,
 	return TRUE;
 }
 
+static GstPadProbeReturn
+brasero_metadata_silence_probe (GstPad *pad,
+				GstPadProbeInfo *info,
+				gpointer user_data)
+{
+	BraseroMetadataPrivate *priv;
+	GstBuffer *buffer;
+	GstMapInfo map;
+
+	/* NOTE: this is called from the streaming thread */
+	priv = BRASERO_METADATA_PRIVATE (user_data);
+
+	if (!priv->silence_format) {
+		GstStructure *structure;
+		gint channels = 0;
+		gint rate = 0;
+		GstCaps *caps;
+
+		caps = gst_pad_get_current_caps (pad);
+		if (!caps)
+			return GST_PAD_PROBE_OK;
+
+		structure = gst_caps_get_structure (caps, 0);
+		gst_structure_get_int (structure, "rate", &rate);
+		gst_structure_get_int (structure, "channels", &channels);
+		gst_caps_unref (caps);
+
+		if (rate <= 0 || channels <= 0)
+			return GST_PAD_PROBE_OK;
+
+		brasero_silence_analyser_set_format (priv->analyser, rate, channels);
+		priv->silence_format = TRUE;
+	}
+
+	buffer = GST_PAD_PROBE_INFO_BUFFER (info);
+	if (!gst_buffer_map (buffer, &map, GST_MAP_READ))
+		return GST_PAD_PROBE_OK;
+
+	brasero_silence_analyser_push (priv->analyser,
+				       (const gfloat *) map.data,
+				       map.size / sizeof (gfloat));
+	gst_buffer_unmap (buffer, &map);
+
+	return GST_PAD_PROBE_OK;
+}
+
 static gboolean
 brasero_metadata_create_audio_pipeline (BraseroMetadata *self)
 {
@@ -1352,41 +1391,45 @@ brasero_metadata_create_audio_pipeline (BraseroMetadata *self)
 
 	/* set up the pipeline according to flags */
 	if (priv->flags & BRASERO_METADATA_FLAG_SILENCES) {
-		priv->prev_level_mes = 0;
+		GstElement *filter;
+		GstCaps *caps;
+		GstPad *pad;
+
+		/* The decoded PCM is analysed directly as it reaches the sink
+		 * so make sure we get native floats */
+		filter = gst_element_factory_make ("capsfilter", NULL);
+		if (!filter) {
+			priv->error = g_error_new (BRASERO_UTILS_ERROR,
+						   BRASERO_UTILS_ERROR_GENERAL,
+						   _("%s element could not be created"),
+						   "\"Capsfilter\"");
+			gst_object_unref (priv->audio);
+			priv->audio = NULL;
+			return FALSE;
+		}
+
+		caps = gst_caps_new_simple ("audio/x-raw",
+					    "format", G_TYPE_STRING, G_BYTE_ORDER == G_LITTLE_ENDIAN? "F32LE":"F32BE",
+					    "layout", G_TYPE_STRING, "interleaved",
+					    NULL);
+		g_object_set (filter, "caps", caps, NULL);
+		gst_caps_unref (caps);
 
 		/* Add a reference to these objects as we want to keep them
 		 * around after the bin they've been added to is destroyed
 		 * NOTE: now we destroy the pipeline every time which means
 		 * that it doesn't really matter. */
-		if (!priv->level) {
-			priv->level = gst_element_factory_make ("level", NULL);
-			if (!priv->level) {
-				priv->error = g_error_new (BRASERO_UTILS_ERROR,
-							   BRASERO_UTILS_ERROR_GENERAL,
-							   _("%s element could not be created"),
-							   "\"Level\"");
-				gst_object_unref (priv->audio);
-				priv->audio = NULL;
-				return FALSE;
-			}
-			g_object_set (priv->level,
-				      "message", TRUE,
-				      "interval", (guint64) BRASERO_METADATA_SILENCE_INTERVAL,
-				      NULL);
-		}
-
 		gst_object_ref (priv->convert);
-		gst_object_ref (priv->level);
 		gst_object_ref (priv->sink);
 
 		gst_bin_add_many (GST_BIN (priv->audio),
 				  priv->convert,
-				  priv->level,
+				  filter,
 				  priv->sink,
 				  NULL);
 
 		if (!gst_element_link_many (priv->convert,
-		                            priv->level,
+		                            filter,
 		                            priv->sink,
 		                            NULL)) {
 			BRASERO_UTILS_LOG ("Impossible to link elements");
@@ -1395,6 +1438,25 @@ brasero_metadata_create_audio_pipeline (BraseroMetadata *self)
 			return FALSE;
 		}
 
+		brasero_metadata_free_analyser (self);
+		priv->silence_format = FALSE;
+		priv->analyser = brasero_silence_analyser_new (priv->silence_threshold,
+							       priv->silence_min_gap,
+							       priv->silence_resolution);
+		if (!priv->analyser) {
+			gst_object_unref (priv->audio);
+			priv->audio = NULL;
+			return FALSE;
+		}
+
+		pad = gst_element_get_static_pad (priv->sink, "sink");
+		priv->silence_probe = gst_pad_add_probe (pad,
+							 GST_PAD_PROBE_TYPE_BUFFER,
+							 brasero_metadata_silence_probe,
+							 self,
+							 NULL);
+		gst_object_unref (pad);
+
 		audio_pad = gst_element_get_static_pad (priv->convert, "sink");
 	}
 	else if (priv->flags & BRASERO_METADATA_FLAG_THUMBNAIL) {
@@ -1786,11 +1848,6 @@ brasero_metadata_set_new_uri (BraseroMetadata *self,
 	brasero_metadata_info_free (priv->info);
 	priv->info = NULL;
 
-	if (priv->silence) {
-		g_free (priv->silence);
-		priv->silence = NULL;
-	}
-
 	priv->info = g_new0 (BraseroMetadataInfo, 1);
 	priv->info->uri = g_strdup (uri);
 
@@ -2044,6 +2101,10 @@ brasero_metadata_init (BraseroMetadata *obj)
 	priv = BRASERO_METADATA_PRIVATE (obj);
 
 	priv->mutex = g_mutex_new ();
+
+	priv->silence_threshold = BRASERO_METADATA_SILENCE_THRESHOLD;
+	priv->silence_min_gap = BRASERO_METADATA_SILENCE_MIN_GAP;
+	priv->silence_resolution = BRASERO_METADATA_SILENCE_RESOLUTION;
 }
 
 static void
@@ -2056,11 +2117,6 @@ brasero_metadata_finalize (GObject *object)
 
 	brasero_metadata_destroy_pipeline (BRASERO_METADATA (object));
 
-	if (priv->silence) {
-		g_free (priv->silence);
-		priv->silence = NULL;
-	}
-
 	if (priv->error) {
 		g_error_free (priv->error);
 		priv->error = NULL;
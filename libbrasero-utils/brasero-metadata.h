@@ -75,7 +75,8 @@ typedef struct {
 	gint channels;
 	gint rate;
 
-	GSList *silences;
+	/* Array of BraseroMetadataSilence sorted by position */
+	GArray *silences;
 
 	GdkPixbuf *snapshot;
 
@@ -154,6 +155,12 @@ void
 brasero_metadata_set_get_xid_callback (BraseroMetadata *metadata,
                                        BraseroMetadataGetXidCb callback,
                                        gpointer user_data);
+
+void
+brasero_metadata_set_silence_parameters (BraseroMetadata *metadata,
+					 gdouble threshold,
+					 gint64 min_gap,
+					 gint64 resolution);
 G_END_DECLS
 
 #endif				/* METADATA_H */
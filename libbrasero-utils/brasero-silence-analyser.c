@@ -0,0 +1,401 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-misc
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-misc is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-misc authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-misc. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-misc is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <math.h>
+
+#include <glib.h>
+
+#include "brasero-misc.h"
+#include "brasero-silence-analyser.h"
+
+/**
+ * Decoded PCM (interleaved 32 bits floats) is cut into windows whose length
+ * is the resolution. The streaming thread only copies samples into chunks of
+ * windows; the peak and RMS of each window are computed by a pool of threads
+ * and silences are only built at the end from these levels.
+ */
+
+/* Number of windows handed to a thread at once */
+#define BRASERO_SILENCE_CHUNK_WINDOWS	512
+
+#define BRASERO_SILENCE_THREADS		4
+
+/* A window whose RMS is below the threshold is still considered as sound if
+ * its peak is above the threshold by more than 10 dB, unless such windows
+ * last less than BRASERO_SILENCE_CLICK_MAX (in ns). Clicks and crackles of
+ * vinyl rips are short and loud and don't raise the RMS much; they must not
+ * break a silence while a quiet but peaky passage should. */
+#define BRASERO_SILENCE_PEAK_MARGIN	3.16227766
+#define BRASERO_SILENCE_CLICK_MAX	40000000LL
+
+struct _BraseroSilenceLevel {
+	gfloat peak;
+	gfloat rms;
+};
+typedef struct _BraseroSilenceLevel BraseroSilenceLevel;
+
+struct _BraseroSilenceChunk {
+	guint first;		/* index of the first window */
+	guint num;		/* number of windows */
+	gsize size;		/* number of samples */
+	gfloat *samples;
+};
+typedef struct _BraseroSilenceChunk BraseroSilenceChunk;
+
+struct _BraseroSilenceAnalyser {
+	gdouble threshold;	/* linear */
+	gint64 min_gap;
+	gint64 resolution;
+
+	gint rate;
+	gint channels;
+	gsize window;		/* number of samples per window */
+
+	/* Filled by the streaming thread */
+	BraseroSilenceChunk *chunk;
+	guint windows;
+
+	GThreadPool *pool;
+
+	/* Protects levels */
+	GMutex *mutex;
+	GArray *levels;
+};
+
+/**
+ * Four independent accumulators and no branch so that the compiler can
+ * vectorise that loop.
+ */
+
+static void
+brasero_silence_analyser_window (const gfloat *samples,
+				 gsize num,
+				 BraseroSilenceLevel *level)
+{
+	gfloat sum [4] = { 0.0, 0.0, 0.0, 0.0 };
+	gfloat peak [4] = { 0.0, 0.0, 0.0, 0.0 };
+	gsize i, j;
+
+	for (i = 0; i + 4 <= num; i += 4) {
+		for (j = 0; j < 4; j ++) {
+			gfloat sample;
+
+			sample = samples [i + j];
+			sum [j] += sample * sample;
+			peak [j] = MAX (peak [j], fabsf (sample));
+		}
+	}
+
+	for (; i < num; i ++) {
+		sum [0] += samples [i] * samples [i];
+		peak [0] = MAX (peak [0], fabsf (samples [i]));
+	}
+
+	level->peak = MAX (MAX (peak [0], peak [1]), MAX (peak [2], peak [3]));
+	level->rms = num? sqrtf ((sum [0] + sum [1] + sum [2] + sum [3]) / num):0.0;
+}
+
+static void
+brasero_silence_analyser_chunk (gpointer data,
+				gpointer user_data)
+{
+	BraseroSilenceAnalyser *analyser = user_data;
+	BraseroSilenceChunk *chunk = data;
+	BraseroSilenceLevel *levels;
+	guint i;
+
+	levels = g_new (BraseroSilenceLevel, chunk->num);
+	for (i = 0; i < chunk->num; i ++) {
+		gsize start;
+
+		start = i * analyser->window;
+		brasero_silence_analyser_window (chunk->samples + start,
+						 MIN (analyser->window, chunk->size - start),
+						 levels + i);
+	}
+
+	/* chunks can be finished in any order */
+	g_mutex_lock (analyser->mutex);
+	if (analyser->levels->len < chunk->first + chunk->num)
+		g_array_set_size (analyser->levels, chunk->first + chunk->num);
+
+	memcpy (&g_array_index (analyser->levels, BraseroSilenceLevel, chunk->first),
+		levels,
+		sizeof (BraseroSilenceLevel) * chunk->num);
+	g_mutex_unlock (analyser->mutex);
+
+	g_free (levels);
+	g_free (chunk->samples);
+	g_free (chunk);
+}
+
+BraseroSilenceAnalyser *
+brasero_silence_analyser_new (gdouble threshold,
+			      gint64 min_gap,
+			      gint64 resolution)
+{
+	BraseroSilenceAnalyser *analyser;
+
+	analyser = g_new0 (BraseroSilenceAnalyser, 1);
+	analyser->pool = g_thread_pool_new (brasero_silence_analyser_chunk,
+					    analyser,
+					    BRASERO_SILENCE_THREADS,
+					    FALSE,
+					    NULL);
+	if (!analyser->pool) {
+		g_free (analyser);
+		return NULL;
+	}
+
+	/* threshold is given in dB */
+	analyser->threshold = pow (10.0, threshold / 20.0);
+	analyser->min_gap = min_gap;
+	analyser->resolution = MAX (resolution, 1000000LL);
+
+	analyser->mutex = g_mutex_new ();
+	analyser->levels = g_array_new (FALSE, TRUE, sizeof (BraseroSilenceLevel));
+
+	return analyser;
+}
+
+void
+brasero_silence_analyser_set_format (BraseroSilenceAnalyser *analyser,
+				     gint rate,
+				     gint channels)
+{
+	gint64 frames;
+
+	/* the format can't change once samples were pushed */
+	if (analyser->window)
+		return;
+
+	analyser->rate = rate;
+	analyser->channels = channels;
+
+	frames = (gint64) rate * analyser->resolution / 1000000000LL;
+	analyser->window = MAX (frames, 1) * channels;
+
+	BRASERO_UTILS_LOG ("Silence analysis with %" G_GSIZE_FORMAT " samples per window", analyser->window);
+}
+
+static void
+brasero_silence_analyser_flush (BraseroSilenceAnalyser *analyser)
+{
+	BraseroSilenceChunk *chunk;
+
+	chunk = analyser->chunk;
+	analyser->chunk = NULL;
+
+	chunk->num = (chunk->size + analyser->window - 1) / analyser->window;
+	analyser->windows += chunk->num;
+
+	g_thread_pool_push (analyser->pool, chunk, NULL);
+}
+
+void
+brasero_silence_analyser_push (BraseroSilenceAnalyser *analyser,
+			       const gfloat *samples,
+			       gsize num)
+{
+	gsize capacity;
+
+	if (!analyser->window)
+		return;
+
+	capacity = analyser->window * BRASERO_SILENCE_CHUNK_WINDOWS;
+	while (num > 0) {
+		BraseroSilenceChunk *chunk;
+		gsize copy;
+
+		if (!analyser->chunk) {
+			chunk = g_new0 (BraseroSilenceChunk, 1);
+			chunk->first = analyser->windows;
+			chunk->samples = g_new (gfloat, capacity);
+			analyser->chunk = chunk;
+		}
+		else
+			chunk = analyser->chunk;
+
+		copy = MIN (num, capacity - chunk->size);
+		memcpy (chunk->samples + chunk->size, samples, copy * sizeof (gfloat));
+		chunk->size += copy;
+		samples += copy;
+		num -= copy;
+
+		if (chunk->size == capacity)
+			brasero_silence_analyser_flush (analyser);
+	}
+}
+
+/* Position of the start of a window in ns: windows are a whole number of
+ * frames long so they don't last exactly the resolution */
+static gint64
+brasero_silence_analyser_position (BraseroSilenceAnalyser *analyser,
+				   guint window)
+{
+	gint64 frames;
+
+	frames = analyser->window / analyser->channels;
+	return (gint64) window * frames * 1000000000LL / analyser->rate;
+}
+
+static gboolean
+brasero_silence_analyser_is_peak (BraseroSilenceAnalyser *analyser,
+				  BraseroSilenceLevel *level)
+{
+	return level->peak >= analyser->threshold * BRASERO_SILENCE_PEAK_MARGIN;
+}
+
+/**
+ * Returns whether window @i is silent. A run of quiet windows with high
+ * peaks is tolerated as a click if it is short enough.
+ */
+
+static gboolean
+brasero_silence_analyser_is_silent (BraseroSilenceAnalyser *analyser,
+				    guint i)
+{
+	BraseroSilenceLevel *level;
+	guint first, last;
+	guint max;
+
+	level = &g_array_index (analyser->levels, BraseroSilenceLevel, i);
+	if (level->rms >= analyser->threshold)
+		return FALSE;
+
+	if (!brasero_silence_analyser_is_peak (analyser, level))
+		return TRUE;
+
+	/* Look for the whole run of quiet windows with a high peak but no
+	 * further than the longest click (always at least one window) */
+	max = BRASERO_SILENCE_CLICK_MAX * analyser->rate / (1000000000LL * (gint64) (analyser->window / analyser->channels));
+	max = MAX (max, 1);
+
+	for (first = i; first > 0 && i - first <= max; first --) {
+		level = &g_array_index (analyser->levels, BraseroSilenceLevel, first - 1);
+		if (level->rms >= analyser->threshold
+		|| !brasero_silence_analyser_is_peak (analyser, level))
+			break;
+	}
+
+	for (last = i + 1; last < analyser->levels->len && last - first <= max; last ++) {
+		level = &g_array_index (analyser->levels, BraseroSilenceLevel, last);
+		if (level->rms >= analyser->threshold
+		|| !brasero_silence_analyser_is_peak (analyser, level))
+			break;
+	}
+
+	return last - first <= max;
+}
+
+static void
+brasero_silence_analyser_add (BraseroSilenceAnalyser *analyser,
+			      GArray *silences,
+			      gint64 start,
+			      gint64 end)
+{
+	BraseroMetadataSilence silence;
+
+	if (end - start < analyser->min_gap)
+		return;
+
+	silence.start = start;
+	silence.end = end;
+	g_array_append_val (silences, silence);
+
+	BRASERO_UTILS_LOG ("Silence from %lli to %lli", start, end);
+}
+
+/**
+ * Waits for all levels to be computed and returns the silences found as an
+ * array of BraseroMetadataSilence sorted by position. @duration is used as
+ * the end of a silence running until the end of the stream.
+ */
+
+GArray *
+brasero_silence_analyser_finish (BraseroSilenceAnalyser *analyser,
+				 gint64 duration)
+{
+	GArray *silences;
+	gint64 start = -1;
+	guint i;
+
+	if (analyser->chunk)
+		brasero_silence_analyser_flush (analyser);
+
+	if (analyser->pool) {
+		g_thread_pool_free (analyser->pool, FALSE, TRUE);
+		analyser->pool = NULL;
+	}
+
+	silences = g_array_new (FALSE, FALSE, sizeof (BraseroMetadataSilence));
+	for (i = 0; i < analyser->levels->len; i ++) {
+		if (brasero_silence_analyser_is_silent (analyser, i)) {
+			if (start < 0)
+				start = brasero_silence_analyser_position (analyser, i);
+		}
+		else if (start >= 0) {
+			brasero_silence_analyser_add (analyser,
+						      silences,
+						      start,
+						      brasero_silence_analyser_position (analyser, i));
+			start = -1;
+		}
+	}
+
+	if (start >= 0)
+		brasero_silence_analyser_add (analyser,
+					      silences,
+					      start,
+					      duration > 0? duration:brasero_silence_analyser_position (analyser, i));
+
+	return silences;
+}
+
+void
+brasero_silence_analyser_free (BraseroSilenceAnalyser *analyser)
+{
+	if (analyser->pool)
+		g_thread_pool_free (analyser->pool, FALSE, TRUE);
+
+	if (analyser->chunk) {
+		g_free (analyser->chunk->samples);
+		g_free (analyser->chunk);
+	}
+
+	g_array_free (analyser->levels, TRUE);
+	g_mutex_free (analyser->mutex);
+	g_free (analyser);
+}
@@ -47,6 +47,7 @@
 #include "brasero-plugin-registration.h"
 #include "burn-job.h"
 #include "burn-process.h"
+#include "burn-process-parser.h"
 #include "brasero-track-disc.h"
 #include "brasero-track-image.h"
 #include "brasero-drive.h"
@@ -65,6 +66,11 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroCdrdao, brasero_cdrdao, BRASERO_TYPE_PROCESS,
 
 struct _BraseroCdrdaoPrivate {
  	gchar *tmp_toc_path;
+
+	BraseroProcessParser *record_parser;
+	BraseroProcessParser *image_parser;
+	BraseroProcessParser *common_parser;
+
 	guint use_raw:1;
 };
 typedef struct _BraseroCdrdaoPrivate BraseroCdrdaoPrivate;
@@ -75,181 +81,229 @@ static GObjectClass *parent_class = NULL;
 #define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
 #define BRASERO_KEY_RAW_FLAG		"raw-flag"
 
-static gboolean
-brasero_cdrdao_read_stderr_image (BraseroCdrdao *cdrdao, const gchar *line)
+static BraseroBurnResult
+brasero_cdrdao_image_progress (BraseroProcess *process,
+			       const BraseroProcessMatch *match)
 {
-	int min, sec, sub, s1;
+	guint64 secs;
 
-	if (sscanf (line, "%d:%d:%d", &min, &sec, &sub) == 3) {
-		guint64 secs = min * 60 + sec;
+	secs = match->captures [0].integer * 60 + match->captures [1].integer;
+	brasero_job_set_written_track (BRASERO_JOB (process), secs * 75 * 2352);
+	if (secs > 2)
+		brasero_job_start_progress (BRASERO_JOB (process), FALSE);
 
-		brasero_job_set_written_track (BRASERO_JOB (cdrdao), secs * 75 * 2352);
-		if (secs > 2)
-			brasero_job_start_progress (BRASERO_JOB (cdrdao), FALSE);
-	}
-	else if (sscanf (line, "Leadout %*s %*d %d:%d:%*d(%i)", &min, &sec, &s1) == 3) {
-		BraseroJobAction action;
-
-		brasero_job_get_action (BRASERO_JOB (cdrdao), &action);
-		if (action == BRASERO_JOB_ACTION_SIZE) {
-			/* get the number of sectors. As we added -raw sector = 2352 bytes */
-			brasero_job_set_output_size_for_current_track (BRASERO_JOB (cdrdao), s1, (gint64) s1 * 2352ULL);
-			brasero_job_finished_session (BRASERO_JOB (cdrdao));
-		}
-	}
-	else if (strstr (line, "Copying audio tracks")) {
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_DRIVE_COPY,
-						_("Copying audio track"),
-						FALSE);
-	}
-	else if (strstr (line, "Copying data track")) {
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_DRIVE_COPY,
-						_("Copying data track"),
-						FALSE);
-	}
-	else
-		return FALSE;
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_cdrdao_image_leadout (BraseroProcess *process,
+			      const BraseroProcessMatch *match)
+{
+	BraseroJobAction action;
+	gint64 sectors;
+
+	brasero_job_get_action (BRASERO_JOB (process), &action);
+	if (action != BRASERO_JOB_ACTION_SIZE)
+		return BRASERO_BURN_OK;
 
-	return TRUE;
+	/* get the number of sectors. As we added -raw sector = 2352 bytes */
+	sectors = match->captures [2].integer;
+	brasero_job_set_output_size_for_current_track (BRASERO_JOB (process), sectors, sectors * 2352ULL);
+	brasero_job_finished_session (BRASERO_JOB (process));
+	return BRASERO_BURN_OK;
 }
 
-static gboolean
-brasero_cdrdao_read_stderr_record (BraseroCdrdao *cdrdao, const gchar *line)
+static const BraseroProcessRule brasero_cdrdao_image_rules [] = {
+	{ "%d:%d:%d", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_image_progress },
+	{ "Leadout %*s %*d %d:%d:%*d(%d)", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_image_leadout },
+	{ "Copying audio tracks", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CURRENT_ACTION, BRASERO_BURN_ACTION_DRIVE_COPY,
+	  N_("Copying audio track") },
+	{ "Copying data track", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CURRENT_ACTION, BRASERO_BURN_ACTION_DRIVE_COPY,
+	  N_("Copying data track") },
+};
+
+static BraseroBurnResult
+brasero_cdrdao_record_wrote (BraseroProcess *process,
+			     const BraseroProcessMatch *match)
 {
-	int fifo, track, min, sec;
-	guint written, total;
+	brasero_job_set_dangerous (BRASERO_JOB (process), TRUE);
 
-	if (sscanf (line, "Wrote %u of %u (Buffers %d%%  %*s", &written, &total, &fifo) >= 2) {
-		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), TRUE);
+	brasero_job_set_written_session (BRASERO_JOB (process), match->captures [0].integer * 1048576);
+	brasero_job_set_current_action (BRASERO_JOB (process),
+					BRASERO_BURN_ACTION_RECORDING,
+					NULL,
+					FALSE);
 
-		brasero_job_set_written_session (BRASERO_JOB (cdrdao), written * 1048576);
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_RECORDING,
-						NULL,
-						FALSE);
+	/* cdrdao's own ring buffer then the drive buffer */
+	if (match->num >= 4)
+		brasero_job_set_buffer_fill (BRASERO_JOB (process),
+					     match->captures [2].integer,
+					     match->captures [3].integer);
 
-		brasero_job_start_progress (BRASERO_JOB (cdrdao), FALSE);
-	}
-	else if (sscanf (line, "Wrote %*s blocks. Buffer fill min") == 1) {
-		/* this is for fixating phase */
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_FIXATING,
-						NULL,
-						FALSE);
-	}
-	else if (sscanf (line, "Analyzing track %d %*s start %d:%d:%*d, length %*d:%*d:%*d", &track, &min, &sec) == 3) {
-		gchar *string;
+	brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+	return BRASERO_BURN_OK;
+}
 
-		string = g_strdup_printf (_("Analysing track %02i"), track);
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_ANALYSING,
-						string,
-						TRUE);
-		g_free (string);
-	}
-	else if (sscanf (line, "%d:%d:%*d", &min, &sec) == 2) {
-		gint64 written;
-		guint64 secs = min * 60 + sec;
+static BraseroBurnResult
+brasero_cdrdao_record_analysing (BraseroProcess *process,
+				 const BraseroProcessMatch *match)
+{
+	gchar *string;
 
-		if (secs > 2)
-			brasero_job_start_progress (BRASERO_JOB (cdrdao), FALSE);
+	string = g_strdup_printf (_("Analysing track %02i"), (gint) match->captures [0].integer);
+	brasero_job_set_current_action (BRASERO_JOB (process),
+					BRASERO_BURN_ACTION_ANALYSING,
+					string,
+					TRUE);
+	g_free (string);
+	return BRASERO_BURN_OK;
+}
 
-		written = secs * 75 * 2352;
-		brasero_job_set_written_session (BRASERO_JOB (cdrdao), written);
-	}
-	else if (strstr (line, "Writing track")) {
-		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), TRUE);
-	}
-	else if (strstr (line, "Writing finished successfully")
-	     ||  strstr (line, "On-the-fly CD copying finished successfully")) {
-		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), FALSE);
-	}
-	else if (strstr (line, "Blanking disk...")) {
-		brasero_job_set_current_action (BRASERO_JOB (cdrdao),
-						BRASERO_BURN_ACTION_BLANKING,
-						NULL,
-						FALSE);
-		brasero_job_start_progress (BRASERO_JOB (cdrdao), FALSE);
-		brasero_job_set_dangerous (BRASERO_JOB (cdrdao), TRUE);
-	}
-	else {
-		gchar *name = NULL;
-		gchar *cuepath = NULL;
-		BraseroTrack *track = NULL;
-		BraseroJobAction action;
+static BraseroBurnResult
+brasero_cdrdao_record_progress (BraseroProcess *process,
+				const BraseroProcessMatch *match)
+{
+	gint64 written;
+	guint64 secs;
 
-		/* Try to catch error could not find cue file */
+	secs = match->captures [0].integer * 60 + match->captures [1].integer;
+	if (secs > 2)
+		brasero_job_start_progress (BRASERO_JOB (process), FALSE);
 
-		/* Track could be NULL here if we're simply blanking a medium */
-		brasero_job_get_action (BRASERO_JOB (cdrdao), &action);
-		if (action == BRASERO_JOB_ACTION_ERASE)
-			return TRUE;
+	written = secs * 75 * 2352;
+	brasero_job_set_written_session (BRASERO_JOB (process), written);
+	return BRASERO_BURN_OK;
+}
 
-		brasero_job_get_current_track (BRASERO_JOB (cdrdao), &track);
-		if (!track)
-			return FALSE;
+static BraseroBurnResult
+brasero_cdrdao_record_blanking (BraseroProcess *process,
+				const BraseroProcessMatch *match)
+{
+	brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+	brasero_job_set_dangerous (BRASERO_JOB (process), TRUE);
+	return BRASERO_BURN_OK;
+}
 
-		cuepath = brasero_track_image_get_toc_source (BRASERO_TRACK_IMAGE (track), FALSE);
+static BraseroBurnResult
+brasero_cdrdao_record_missing_input (BraseroProcess *process,
+				     const BraseroProcessMatch *match)
+{
+	gchar *name = NULL;
+	gchar *cuepath = NULL;
+	BraseroTrack *track = NULL;
+	BraseroJobAction action;
 
-		if (!cuepath)
-			return FALSE;
+	/* Track could be NULL here if we're simply blanking a medium */
+	brasero_job_get_action (BRASERO_JOB (process), &action);
+	if (action == BRASERO_JOB_ACTION_ERASE)
+		return BRASERO_BURN_OK;
 
-		if (!strstr (line, "ERROR: Could not find input file")) {
-			g_free (cuepath);
-			return FALSE;
-		}
+	brasero_job_get_current_track (BRASERO_JOB (process), &track);
+	if (!track)
+		return BRASERO_BURN_OK;
 
-		name = g_path_get_basename (cuepath);
-		g_free (cuepath);
+	cuepath = brasero_track_image_get_toc_source (BRASERO_TRACK_IMAGE (track), FALSE);
+	if (!cuepath)
+		return BRASERO_BURN_OK;
 
-		brasero_job_error (BRASERO_JOB (cdrdao),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_FILE_NOT_FOUND,
-						/* Translators: %s is a filename */
-						_("\"%s\" could not be found"),
-						name));
-		g_free (name);
-	}
+	name = g_path_get_basename (cuepath);
+	g_free (cuepath);
 
-	return FALSE;
+	brasero_job_error (BRASERO_JOB (process),
+			   g_error_new (BRASERO_BURN_ERROR,
+					BRASERO_BURN_ERROR_FILE_NOT_FOUND,
+					/* Translators: %s is a filename */
+					_("\"%s\" could not be found"),
+					name));
+	g_free (name);
+	return BRASERO_BURN_OK;
 }
 
+static const BraseroProcessRule brasero_cdrdao_record_rules [] = {
+	{ "Wrote %u of %u MB (Buffers %u%% %u%%)", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_record_wrote },
+	{ "Wrote %u of %u", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_record_wrote },
+
+	/* this is for fixating phase */
+	{ "Wrote %*u blocks. Buffer fill min", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CURRENT_ACTION, BRASERO_BURN_ACTION_FIXATING },
+
+	{ "Analyzing track %d %*s start %d:%d:%*d, length %*d:%*d:%*d", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_record_analysing },
+	{ "%d:%d:%*d", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_record_progress },
+	{ "Writing track", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_DANGEROUS, TRUE },
+	{ "Writing finished successfully", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_DANGEROUS, FALSE },
+	{ "On-the-fly CD copying finished successfully", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_DANGEROUS, FALSE },
+	{ "Blanking disk...", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CURRENT_ACTION, BRASERO_BURN_ACTION_BLANKING,
+	  NULL,
+	  brasero_cdrdao_record_blanking },
+
+	/* Try to catch error could not find cue file */
+	{ "ERROR: Could not find input file", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_cdrdao_record_missing_input },
+};
+
+static const BraseroProcessRule brasero_cdrdao_common_rules [] = {
+	{ "Cannot setup device", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_DRIVE_BUSY,
+	  N_("The drive is busy") },
+	{ "Operation not permitted. Cannot send SCSI", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_PERMISSION,
+	  N_("You do not have the required permissions to use this drive") },
+};
+
 static BraseroBurnResult
 brasero_cdrdao_read_stderr (BraseroProcess *process, const gchar *line)
 {
-	BraseroCdrdao *cdrdao;
-	gboolean result = FALSE;
+	BraseroCdrdaoPrivate *priv;
+	gboolean matched = FALSE;
 	BraseroJobAction action;
 
-	cdrdao = BRASERO_CDRDAO (process);
+	priv = BRASERO_CDRDAO_PRIVATE (process);
 
-	brasero_job_get_action (BRASERO_JOB (cdrdao), &action);
+	brasero_job_get_action (BRASERO_JOB (process), &action);
 	if (action == BRASERO_JOB_ACTION_RECORD
-	||  action == BRASERO_JOB_ACTION_ERASE)
-		result = brasero_cdrdao_read_stderr_record (cdrdao, line);
-	else if (action == BRASERO_JOB_ACTION_IMAGE
-	     ||  action == BRASERO_JOB_ACTION_SIZE)
-		result = brasero_cdrdao_read_stderr_image (cdrdao, line);
-
-	if (result)
-		return BRASERO_BURN_OK;
-
-	if (strstr (line, "Cannot setup device")) {
-		brasero_job_error (BRASERO_JOB (cdrdao),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_DRIVE_BUSY,
-						_("The drive is busy")));
+	||  action == BRASERO_JOB_ACTION_ERASE) {
+		brasero_process_parser_dispatch (priv->record_parser,
+						 process,
+						 line,
+						 &matched);
+
+		/* When blanking, only the lines above are of interest */
+		if (!matched && action == BRASERO_JOB_ACTION_ERASE)
+			return BRASERO_BURN_OK;
 	}
-	else if (strstr (line, "Operation not permitted. Cannot send SCSI")) {
-		brasero_job_error (BRASERO_JOB (cdrdao),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_PERMISSION,
-						_("You do not have the required permissions to use this drive")));
+	else if (action == BRASERO_JOB_ACTION_IMAGE
+	     ||  action == BRASERO_JOB_ACTION_SIZE) {
+		brasero_process_parser_dispatch (priv->image_parser,
+						 process,
+						 line,
+						 &matched);
+		if (matched)
+			return BRASERO_BURN_OK;
 	}
 
-	return BRASERO_BURN_OK;
+	return brasero_process_parser_dispatch (priv->common_parser,
+						process,
+						line,
+						NULL);
 }
 
 static void
@@ -657,6 +711,13 @@ brasero_cdrdao_init (BraseroCdrdao *obj)
 	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
 	priv->use_raw = g_settings_get_boolean (settings, BRASERO_KEY_RAW_FLAG);
 	g_object_unref (settings);
+
+	priv->record_parser = brasero_process_parser_new (brasero_cdrdao_record_rules,
+							  G_N_ELEMENTS (brasero_cdrdao_record_rules));
+	priv->image_parser = brasero_process_parser_new (brasero_cdrdao_image_rules,
+							 G_N_ELEMENTS (brasero_cdrdao_image_rules));
+	priv->common_parser = brasero_process_parser_new (brasero_cdrdao_common_rules,
+							  G_N_ELEMENTS (brasero_cdrdao_common_rules));
 }
 
 static void
@@ -670,6 +731,21 @@ brasero_cdrdao_finalize (GObject *object)
 		priv->tmp_toc_path = NULL;
 	}
 
+	if (priv->record_parser) {
+		brasero_process_parser_free (priv->record_parser);
+		priv->record_parser = NULL;
+	}
+
+	if (priv->image_parser) {
+		brasero_process_parser_free (priv->image_parser);
+		priv->image_parser = NULL;
+	}
+
+	if (priv->common_parser) {
+		brasero_process_parser_free (priv->common_parser);
+		priv->common_parser = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
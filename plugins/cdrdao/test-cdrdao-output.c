@@ -0,0 +1,55 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+/* Checks the rules of the plugin against what cdrdao prints. The plugin source
+ * is included to reach its (static) tables. */
+#include "burn-cdrdao.c"
+
+#include "burn-process-parser-check.h"
+
+static const BraseroProcessCheckTable tables [] = {
+	{ "record", brasero_cdrdao_record_rules,
+	  G_N_ELEMENTS (brasero_cdrdao_record_rules) },
+	{ "image", brasero_cdrdao_image_rules,
+	  G_N_ELEMENTS (brasero_cdrdao_image_rules) },
+	{ "common", brasero_cdrdao_common_rules,
+	  G_N_ELEMENTS (brasero_cdrdao_common_rules) },
+};
+
+int
+main (int argc, char **argv)
+{
+	if (brasero_process_parser_check (BRASERO_TRANSCRIPT_DIR "/cdrdao-output.transcript",
+					  tables,
+					  G_N_ELEMENTS (tables)))
+		return 1;
+
+	return 0;
+}
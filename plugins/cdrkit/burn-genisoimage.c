@@ -49,6 +49,7 @@
 #include "brasero-plugin-registration.h"
 #include "burn-cdrkit.h"
 #include "brasero-track-data.h"
+#include "burn-mkisofs-base.h"
 
 
 #define BRASERO_TYPE_GENISOIMAGE         (brasero_genisoimage_get_type ())
@@ -61,6 +62,10 @@
 BRASERO_PLUGIN_BOILERPLATE (BraseroGenisoimage, brasero_genisoimage, BRASERO_TYPE_PROCESS, BraseroProcess);
 
 struct _BraseroGenisoimagePrivate {
+	/* lists fed to mkisofs by threads */
+	gchar *grafts_path;
+	gchar *excluded_path;
+
 	guint use_utf8:1;
 };
 typedef struct _BraseroGenisoimagePrivate BraseroGenisoimagePrivate;
@@ -68,6 +73,34 @@ typedef struct _BraseroGenisoimagePrivate BraseroGenisoimagePrivate;
 #define BRASERO_GENISOIMAGE_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_GENISOIMAGE, BraseroGenisoimagePrivate))
 static GObjectClass *parent_class = NULL;
 
+static void
+brasero_genisoimage_check_image_size (BraseroGenisoimage *genisoimage,
+				      gint64 sectors)
+{
+	BraseroTrack *track = NULL;
+	BraseroBurnFlag flags;
+	goffset blocks = 0;
+
+	/* The size of a merged or appended session depends on the previous
+	 * sessions so the tree layout does not apply */
+	brasero_job_get_flags (BRASERO_JOB (genisoimage), &flags);
+	if (flags & (BRASERO_BURN_FLAG_APPEND|BRASERO_BURN_FLAG_MERGE))
+		return;
+
+	brasero_job_get_current_track (BRASERO_JOB (genisoimage), &track);
+	if (!track
+	||  brasero_track_data_get_image_size (BRASERO_TRACK_DATA (track), &blocks) != BRASERO_BURN_OK)
+		return;
+
+	/* The layout is only an estimate used for display; what genisoimage
+	 * reports is what counts but a gap is worth knowing about */
+	if (blocks != sectors)
+		BRASERO_JOB_LOG (genisoimage,
+				 "Image size computed from the tree (%"G_GOFFSET_FORMAT" sectors) differs from the actual one (%"G_GINT64_FORMAT" sectors)",
+				 blocks,
+				 sectors);
+}
+
 static BraseroBurnResult
 brasero_genisoimage_read_isosize (BraseroProcess *process, const gchar *line)
 {
@@ -77,6 +110,8 @@ brasero_genisoimage_read_isosize (BraseroProcess *process, const gchar *line)
 	if (!sectors)
 		return BRASERO_BURN_OK;
 
+	brasero_genisoimage_check_image_size (BRASERO_GENISOIMAGE (process), sectors);
+
 	/* genisoimage reports blocks of 2048 bytes */
 	brasero_job_set_output_size_for_current_track (BRASERO_JOB (process),
 						       sectors,
@@ -226,6 +261,43 @@ brasero_genisoimage_read_stderr (BraseroProcess *process, const gchar *line)
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_genisoimage_forget_lists (BraseroGenisoimage *genisoimage)
+{
+	BraseroGenisoimagePrivate *priv;
+
+	priv = BRASERO_GENISOIMAGE_PRIVATE (genisoimage);
+
+	brasero_mkisofs_base_check_list (priv->grafts_path, NULL);
+	g_free (priv->grafts_path);
+	priv->grafts_path = NULL;
+
+	brasero_mkisofs_base_check_list (priv->excluded_path, NULL);
+	g_free (priv->excluded_path);
+	priv->excluded_path = NULL;
+}
+
+static BraseroBurnResult
+brasero_genisoimage_post (BraseroJob *job)
+{
+	BraseroGenisoimagePrivate *priv;
+	GError *error = NULL;
+
+	priv = BRASERO_GENISOIMAGE_PRIVATE (job);
+
+	/* Make sure mkisofs was given the whole lists; otherwise files or
+	 * exclusions would be silently missing from the image */
+	if (brasero_mkisofs_base_check_list (priv->grafts_path, &error) != BRASERO_BURN_OK
+	||  brasero_mkisofs_base_check_list (priv->excluded_path, &error) != BRASERO_BURN_OK) {
+		brasero_genisoimage_forget_lists (BRASERO_GENISOIMAGE (job));
+		brasero_job_error (job, error);
+		return BRASERO_BURN_OK;
+	}
+
+	brasero_genisoimage_forget_lists (BRASERO_GENISOIMAGE (job));
+	return brasero_job_finished_track (job);
+}
+
 static BraseroBurnResult
 brasero_genisoimage_set_argv_image (BraseroGenisoimage *genisoimage,
 				    GPtrArray *argv,
@@ -325,6 +397,10 @@ brasero_genisoimage_set_argv_image (BraseroGenisoimage *genisoimage,
 		return result;
 	}
 
+	brasero_genisoimage_forget_lists (genisoimage);
+	priv->grafts_path = g_strdup (grafts_path);
+	priv->excluded_path = g_strdup (excluded_path);
+
 	g_ptr_array_add (argv, g_strdup ("-path-list"));
 	g_ptr_array_add (argv, grafts_path);
 
@@ -483,6 +559,7 @@ brasero_genisoimage_class_init (BraseroGenisoimageClass *klass)
 	process_class->stdout_func = brasero_genisoimage_read_stdout;
 	process_class->stderr_func = brasero_genisoimage_read_stderr;
 	process_class->set_argv = brasero_genisoimage_set_argv;
+	process_class->post = brasero_genisoimage_post;
 }
 
 static void
@@ -512,6 +589,8 @@ brasero_genisoimage_init (BraseroGenisoimage *obj)
 static void
 brasero_genisoimage_finalize (GObject *object)
 {
+	brasero_genisoimage_forget_lists (BRASERO_GENISOIMAGE (object));
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
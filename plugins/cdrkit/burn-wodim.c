@@ -51,6 +51,7 @@
 
 #include "burn-job.h"
 #include "burn-process.h"
+#include "burn-process-parser.h"
 #include "brasero-plugin-registration.h"
 #include "burn-cdrkit.h"
 
@@ -79,6 +80,9 @@ struct _BraseroWodimPrivate {
 
 	GSList *infs;
 
+	BraseroProcessParser *stderr_parser;
+	BraseroProcessParser *stdout_parser;
+
 	guint immediate:1;
 };
 typedef struct _BraseroWodimPrivate BraseroWodimPrivate;
@@ -91,65 +95,75 @@ static GObjectClass *parent_class = NULL;
 #define BRASERO_KEY_MINBUF_VALUE	"minbuf-value"
 
 static BraseroBurnResult
-brasero_wodim_stderr_read (BraseroProcess *process, const gchar *line)
+brasero_wodim_data_may_not_fit (BraseroProcess *process,
+                                const BraseroProcessMatch *match)
 {
 	BraseroBurnFlag flags;
 
+	/* we don't error out if overburn was chosen */
 	brasero_job_get_flags (BRASERO_JOB (process), &flags);
-
-	if (strstr (line, "Cannot open SCSI driver.")
-	||  strstr (line, "Operation not permitted. Cannot send SCSI cmd via ioctl")
-	||  strstr (line, "Cannot open or use SCSI driver")) {
-		brasero_job_error (BRASERO_JOB (process),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_PERMISSION,
-						_("You do not have the required permissions to use this drive")));
-	}
-	else if (!(flags & BRASERO_BURN_FLAG_OVERBURN)
-	     &&  strstr (line, "Data may not fit on current disk")) {
-		/* we don't error out if overburn was chosen */
+	if (!(flags & BRASERO_BURN_FLAG_OVERBURN))
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_MEDIUM_SPACE,
 						_("Not enough space available on the disc")));
-	}
-	else if (strstr (line ,"cdrecord: A write error occurred")
-	     ||  strstr (line, "Could not write Lead-in")
-	     ||  strstr (line, "Cannot fixate disk")) {
-		brasero_job_error (BRASERO_JOB (process),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_WRITE_MEDIUM,
-						_("An error occurred while writing to disc")));
-	}
-	else if (strstr (line, "DMA speed too slow") != NULL) {
-		brasero_job_error (BRASERO_JOB (process),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_SLOW_DMA,
-						_("The system is too slow to write the disc at this speed. Try a lower speed")));
-	}
-	else if (strstr (line, "Device or resource busy")) {
-		if (!strstr (line, "retrying in")) {
-			brasero_job_error (BRASERO_JOB (process),
-					   g_error_new (BRASERO_BURN_ERROR,
-							BRASERO_BURN_ERROR_DRIVE_BUSY,
-							_("The drive is busy")));
-		}
-	}
-	else if (strstr (line, "Illegal write mode for this drive")) {
-		/* NOTE : when it happened I had to unlock the
-		 * drive with cdrdao and eject it. Should we ? */
+
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_wodim_device_busy (BraseroProcess *process,
+                           const BraseroProcessMatch *match)
+{
+	if (!strstr (match->line, "retrying in"))
 		brasero_job_error (BRASERO_JOB (process),
 				   g_error_new (BRASERO_BURN_ERROR,
 						BRASERO_BURN_ERROR_DRIVE_BUSY,
 						_("The drive is busy")));
-	}
-	else if (strstr (line, "Probably trying to use ultra high speed+ medium on improper writer")) {
-		/* Set a deferred error as this message tends to indicate a failure */
-		brasero_process_deferred_error (process,
-						g_error_new (BRASERO_BURN_ERROR,
-							     BRASERO_BURN_ERROR_MEDIUM_INVALID,
-							     _("The disc is not supported")));
-	}
+
+	return BRASERO_BURN_OK;
+}
+
+static const BraseroProcessRule brasero_wodim_stderr_rules [] = {
+	{ "Cannot open SCSI driver.", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_PERMISSION,
+	  N_("You do not have the required permissions to use this drive") },
+	{ "Operation not permitted. Cannot send SCSI cmd via ioctl", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_PERMISSION,
+	  N_("You do not have the required permissions to use this drive") },
+	{ "Cannot open or use SCSI driver", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_PERMISSION,
+	  N_("You do not have the required permissions to use this drive") },
+	{ "Data may not fit on current disk", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_data_may_not_fit },
+	{ "A write error occurred", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_WRITE_MEDIUM,
+	  N_("An error occurred while writing to disc") },
+	{ "Could not write Lead-in", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_WRITE_MEDIUM,
+	  N_("An error occurred while writing to disc") },
+	{ "Cannot fixate disk", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_WRITE_MEDIUM,
+	  N_("An error occurred while writing to disc") },
+	{ "DMA speed too slow", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_SLOW_DMA,
+	  N_("The system is too slow to write the disc at this speed. Try a lower speed") },
+	{ "Device or resource busy", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_device_busy },
+
+	/* NOTE : when it happened I had to unlock the
+	 * drive with cdrdao and eject it. Should we ? */
+	{ "Illegal write mode for this drive", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_ERROR, BRASERO_BURN_ERROR_DRIVE_BUSY,
+	  N_("The drive is busy") },
+
+	/* Set a deferred error as this message tends to indicate a failure */
+	{ "Probably trying to use ultra high speed+ medium on improper writer", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_DEFERRED_ERROR, BRASERO_BURN_ERROR_MEDIUM_INVALID,
+	  N_("The disc is not supported") },
+
 	/* REMINDER: these should not be necessary as we checked that already */
 	/**
 	else if (strstr (line, "cannot write medium - incompatible format") != NULL) {
@@ -211,8 +225,18 @@ brasero_wodim_stderr_read (BraseroProcess *process, const gchar *line)
 	}
 
 	**/
+};
 
-	return BRASERO_BURN_OK;
+static BraseroBurnResult
+brasero_wodim_stderr_read (BraseroProcess *process, const gchar *line)
+{
+	BraseroWodimPrivate *priv;
+
+	priv = BRASERO_WODIM_PRIVATE (process);
+	return brasero_process_parser_dispatch (priv->stderr_parser,
+						process,
+						line,
+						NULL);
 }
 
 static void
@@ -270,160 +294,197 @@ brasero_wodim_compute (BraseroWodim *wodim,
 	}
 }
 
-static void
-brasero_wodim_set_rate (BraseroProcess *process,
-                        int speed_1,
-                        int speed_2)
+static BraseroBurnResult
+brasero_wodim_track_progress (BraseroProcess *process,
+                              const BraseroProcessMatch *match)
 {
-	gdouble current_rate = -1.0;
-	BraseroMedia media;
+	BraseroWodimPrivate *priv;
+	gint64 mb_written;
+	gint64 mb_total;
+	gint64 track;
 
-	if (brasero_job_get_media (BRASERO_JOB (process), &media) != BRASERO_BURN_OK)
-		return;
+	priv = BRASERO_WODIM_PRIVATE (process);
+
+	track = match->captures [0].integer;
+	mb_written = match->captures [1].integer;
+	mb_total = match->captures [2].integer;
+
+	priv->current_track_written = (goffset) mb_written * (goffset) 1048576LL;
+	brasero_wodim_compute (BRASERO_WODIM (process),
+			       mb_written,
+			       mb_total,
+			       track);
+
+	brasero_job_set_buffer_fill (BRASERO_JOB (process),
+				     match->captures [3].integer,
+				     match->captures [4].integer);
 
-	if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_CD))
-		current_rate = (gdouble) ((gdouble) speed_1 +
-			       (gdouble) speed_2 / 10.0) *
-			       (gdouble) CD_RATE;
-	else if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_DVD))
-		current_rate = (gdouble) ((gdouble) speed_1 +
-			       (gdouble) speed_2 / 10.0) *
-			       (gdouble) DVD_RATE;
-	else if (BRASERO_MEDIUM_IS (media, BRASERO_MEDIUM_BD))
-		current_rate = (gdouble) ((gdouble) speed_1 +
-			       (gdouble) speed_2 / 10.0) *
-			       (gdouble) BD_RATE;
-
-	brasero_job_set_rate (BRASERO_JOB (process), current_rate);
+	brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+	return BRASERO_BURN_OK;
 }
 
 static BraseroBurnResult
-brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
+brasero_wodim_track_written (BraseroProcess *process,
+                             const BraseroProcessMatch *match)
 {
-	guint track;
-	guint speed_1, speed_2;
-	BraseroWodim *wodim;
 	BraseroWodimPrivate *priv;
-	int mb_written = 0, mb_total = 0, fifo = 0, buf = 0;
+	gint64 mb_written;
+	gint64 track;
 
-	wodim = BRASERO_WODIM (process);
-	priv = BRASERO_WODIM_PRIVATE (wodim);
+	priv = BRASERO_WODIM_PRIVATE (process);
+
+	track = match->captures [0].integer;
+	mb_written = match->captures [1].integer;
+
+	priv->current_track_written = (goffset) mb_written * (goffset) 1048576LL;
+	if (brasero_job_get_fd_in (BRASERO_JOB (process), NULL) == BRASERO_BURN_OK) {
+		goffset bytes = 0;
 
-	if (sscanf (line, "Track %2u: %d of %d MB written (fifo %d%%) [buf %d%%] %d.%dx.",
-		    &track, &mb_written, &mb_total, &fifo, &buf, &speed_1, &speed_2) == 7 ||
-	    /* This is for DVD+R */
-	    sscanf (line, "Track %2u:    %d of %d MB written (fifo  %d%%) [buf  %d%%] |%*s  %*s|   %d.%dx.",
-	            &track, &mb_written, &mb_total, &fifo, &buf, &speed_1, &speed_2) == 7) {
-		brasero_wodim_set_rate (process, speed_1, speed_2);
-		priv->current_track_written = (goffset) mb_written * (goffset) 1048576LL;
-		brasero_wodim_compute (wodim,
+		/* we must ask the imager what is the total size */
+		brasero_job_get_session_output_size (BRASERO_JOB (process),
+						     NULL,
+						     &bytes);
+		brasero_wodim_compute (BRASERO_WODIM (process),
 				       mb_written,
-				       mb_total,
+				       bytes / (goffset) 1048576LL,
 				       track);
+	}
 
-		brasero_job_start_progress (BRASERO_JOB (wodim), FALSE);
-	} 
-	else if (sscanf (line, "Track %2u:    %d MB written (fifo %d%%) [buf  %d%%]  %d.%dx.",
-			 &track, &mb_written, &fifo, &buf, &speed_1, &speed_2) == 6 ||
-	         sscanf (line, "Track %2u:    %d MB written (fifo %d%%) [buf  %d%%] |%*s  %*s|   %d.%dx.",
-			 &track, &mb_written, &fifo, &buf, &speed_1, &speed_2) == 6) {
-		/* this line is printed when wodim writes on the fly */
-		brasero_wodim_set_rate (process, speed_1, speed_2);
-		priv->current_track_written = (goffset) mb_written * (goffset) 1048576LL;
-		if (brasero_job_get_fd_in (BRASERO_JOB (wodim), NULL) == BRASERO_BURN_OK) {
-			goffset bytes = 0;
-
-			/* we must ask the imager what is the total size */
-			brasero_job_get_session_output_size (BRASERO_JOB (wodim),
-							     NULL,
-							     &bytes);
-			mb_total = bytes / (goffset) 1048576LL;
-			brasero_wodim_compute (wodim,
-					       mb_written,
-					       mb_total,
-					       track);
-		}
+	brasero_job_set_buffer_fill (BRASERO_JOB (process),
+				     match->captures [2].integer,
+				     match->captures [3].integer);
 
-		brasero_job_start_progress (BRASERO_JOB (wodim), FALSE);
-	}
-	else if (sscanf (line, "Formating in progress: %d.%d %% done", &mb_written, &mb_total) == 2) {
-		brasero_job_set_current_action (BRASERO_JOB (process),
-						BRASERO_BURN_ACTION_BLANKING,
-						_("Formatting disc"),
-						FALSE);
+	brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_wodim_formatting (BraseroProcess *process,
+                          const BraseroProcessMatch *match)
+{
+	brasero_job_start_progress (BRASERO_JOB (process), FALSE);
+	brasero_job_set_progress (BRASERO_JOB (process),
+				  match->captures [0].real / 100.0);
+	return BRASERO_BURN_OK;
+}
 
-		brasero_job_start_progress (BRASERO_JOB (wodim), FALSE);
-		brasero_job_set_progress (BRASERO_JOB (wodim),
-					  (gdouble) ((gdouble) mb_written + ((gdouble) mb_total) / 10.0) / 100.0);
+static BraseroBurnResult
+brasero_wodim_cue_sheet (BraseroProcess *process,
+                         const BraseroProcessMatch *match)
+{
+	BraseroTrackType *type = NULL;
+
+	/* See if we are in an audio case which would mean we're writing
+	 * CD-TEXT */
+	type = brasero_track_type_new ();
+	brasero_job_get_input_type (BRASERO_JOB (process), type);
+	brasero_job_set_current_action (BRASERO_JOB (process),
+					BRASERO_BURN_ACTION_RECORDING_CD_TEXT,
+					brasero_track_type_get_has_stream (type) ? NULL:_("Writing cue sheet"),
+					FALSE);
+	brasero_track_type_free (type);
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_wodim_reload (BraseroProcess *process,
+                      const BraseroProcessMatch *match)
+{
+	BraseroBurnAction action = BRASERO_BURN_ACTION_NONE;
+
+	brasero_job_get_current_action (BRASERO_JOB (process), &action);
+
+	/* NOTE: There seems to be a BUG somewhere when writing raw images
+	 * with clone mode. After disc has been written and fixated wodim
+	 * asks the media to be reloaded. So we simply ignore this message
+	 * and returns that everything went well. Which is indeed the case */
+	if (action == BRASERO_BURN_ACTION_FIXATING) {
+		brasero_job_finished_session (BRASERO_JOB (process));
+		return BRASERO_BURN_OK;
 	}
-	else if (sscanf (line, "Track %*d: %*s %d MB ", &mb_total) == 1) {
-/*		if (mb_total > 0)
-			priv->tracks_total_bytes += mb_total * 1048576;
-*/	}
-	else if (strstr (line, "Sending CUE sheet")) {
-		BraseroTrackType *type = NULL;
-
-		/* See if we are in an audio case which would mean we're writing
-		 * CD-TEXT */
-		type = brasero_track_type_new ();
-		brasero_job_get_input_type (BRASERO_JOB (wodim), type);
+
+	brasero_job_error (BRASERO_JOB (process),
+			   g_error_new (BRASERO_BURN_ERROR,
+					BRASERO_BURN_ERROR_MEDIUM_NEED_RELOADING,
+					_("The disc needs to be reloaded before being recorded")));
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_wodim_fixating (BraseroProcess *process,
+                        const BraseroProcessMatch *match)
+{
+	BraseroJobAction action;
+
+	/* Do this to avoid strange things to appear when erasing */
+	brasero_job_get_action (BRASERO_JOB (process), &action);
+	if (action == BRASERO_JOB_ACTION_RECORD)
 		brasero_job_set_current_action (BRASERO_JOB (process),
-						BRASERO_BURN_ACTION_RECORDING_CD_TEXT,
-						brasero_track_type_get_has_stream (type) ? NULL:_("Writing cue sheet"),
+						BRASERO_BURN_ACTION_FIXATING,
+						NULL,
 						FALSE);
-		brasero_track_type_free (type);
-	}
-	else if (g_str_has_prefix (line, "Re-load disk and hit <CR>")
-	     ||  g_str_has_prefix (line, "send SIGUSR1 to continue")) {
-		BraseroBurnAction action = BRASERO_BURN_ACTION_NONE;
-
-		brasero_job_get_current_action (BRASERO_JOB (process), &action);
-
-		/* NOTE: There seems to be a BUG somewhere when writing raw images
-		 * with clone mode. After disc has been written and fixated wodim
-		 * asks the media to be reloaded. So we simply ignore this message
-		 * and returns that everything went well. Which is indeed the case */
-		if (action == BRASERO_BURN_ACTION_FIXATING) {
-			brasero_job_finished_session (BRASERO_JOB (process));
-			return BRASERO_BURN_OK;
-		}
-
-		brasero_job_error (BRASERO_JOB (process),
-				   g_error_new (BRASERO_BURN_ERROR,
-						BRASERO_BURN_ERROR_MEDIUM_NEED_RELOADING,
-						_("The disc needs to be reloaded before being recorded")));
-	}
-	else if (g_str_has_prefix (line, "Fixating...")
-	     ||  g_str_has_prefix (line, "Writing Leadout...")) {
-		BraseroJobAction action;
-
-		/* Do this to avoid strange things to appear when erasing */
-		brasero_job_get_action (BRASERO_JOB (wodim), &action);
-		if (action == BRASERO_JOB_ACTION_RECORD)
-			brasero_job_set_current_action (BRASERO_JOB (process),
-							BRASERO_BURN_ACTION_FIXATING,
-							NULL,
-							FALSE);
-	}
-	else if (g_str_has_prefix (line, "Last chance to quit, ")) {
-		brasero_job_set_dangerous (BRASERO_JOB (process), TRUE);
-	}
-/*	else if (g_str_has_prefix (line, "Blanking PMA, TOC, pregap")
-	     ||  strstr (line, "Blanking entire disk")) {
+	return BRASERO_BURN_OK;
+}
 
-	}
+/**
+ * The speed ends every progress line ("16.3x."), the RATE action turns it into
+ * a rate. The callbacks report the fifo and drive buffer levels. The "|...|"
+ * variants are for DVD+R.
  */
-	else if (strstr (line, "Disk sub type: Ultra High speed+")) {
-		/* Set a deferred error as this message tends to indicate a failure */
-		brasero_process_deferred_error (process,
-						g_error_new (BRASERO_BURN_ERROR,
-							     BRASERO_BURN_ERROR_MEDIUM_INVALID,
-							     _("The disc is not supported")));
-	}
+static const BraseroProcessRule brasero_wodim_stdout_rules [] = {
+	{ "Track %2u: %d of %d MB written (fifo %d%%) [buf %d%%] %f", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_RATE, 0, NULL,
+	  brasero_wodim_track_progress },
+	{ "Track %2u: %d of %d MB written (fifo %d%%) [buf %d%%] |%*[^|]| %f", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_RATE, 0, NULL,
+	  brasero_wodim_track_progress },
+	{ "Track %2u: %d MB written (fifo %d%%) [buf %d%%] %f", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_RATE, 0, NULL,
+	  brasero_wodim_track_written },
+	{ "Track %2u: %d MB written (fifo %d%%) [buf %d%%] |%*[^|]| %f", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_RATE, 0, NULL,
+	  brasero_wodim_track_written },
+	{ "Formating in progress: %f %% done", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CURRENT_ACTION, BRASERO_BURN_ACTION_BLANKING,
+	  N_("Formatting disc"),
+	  brasero_wodim_formatting },
+	{ "Sending CUE sheet", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_cue_sheet },
+	{ "Re-load disk and hit <CR>", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_reload },
+	{ "send SIGUSR1 to continue", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_reload },
+	{ "Fixating...", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_fixating },
+	{ "Writing Leadout...", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_CALLBACK, 0, NULL,
+	  brasero_wodim_fixating },
+	{ "Last chance to quit,", BRASERO_PROCESS_RULE_PREFIX,
+	  BRASERO_PROCESS_ACTION_DANGEROUS, TRUE },
+
+	/* Set a deferred error as this message tends to indicate a failure */
+	{ "Disk sub type: Ultra High speed+", BRASERO_PROCESS_RULE_ANYWHERE,
+	  BRASERO_PROCESS_ACTION_DEFERRED_ERROR, BRASERO_BURN_ERROR_MEDIUM_INVALID,
+	  N_("The disc is not supported") },
+
 	/* This should not happen */
-	/* else if (strstr (line, "Use tsize= option in SAO mode to specify track size")) */
+	/* "Use tsize= option in SAO mode to specify track size" */
+};
 
-	return BRASERO_BURN_OK;
+static BraseroBurnResult
+brasero_wodim_stdout_read (BraseroProcess *process, const gchar *line)
+{
+	BraseroWodimPrivate *priv;
+
+	priv = BRASERO_WODIM_PRIVATE (process);
+	return brasero_process_parser_dispatch (priv->stdout_parser,
+						process,
+						line,
+						NULL);
 }
 
 static gboolean
@@ -1207,6 +1268,11 @@ brasero_wodim_init (BraseroWodim *obj)
 		priv->minbuf = 30;
 
 	g_object_unref (settings);
+
+	priv->stderr_parser = brasero_process_parser_new (brasero_wodim_stderr_rules,
+							  G_N_ELEMENTS (brasero_wodim_stderr_rules));
+	priv->stdout_parser = brasero_process_parser_new (brasero_wodim_stdout_rules,
+							  G_N_ELEMENTS (brasero_wodim_stdout_rules));
 }
 
 static void
@@ -1228,6 +1294,16 @@ brasero_wodim_finalize (GObject *object)
 	g_slist_free (priv->infs);
 	priv->infs = NULL;
 
+	if (priv->stderr_parser) {
+		brasero_process_parser_free (priv->stderr_parser);
+		priv->stderr_parser = NULL;
+	}
+
+	if (priv->stdout_parser) {
+		brasero_process_parser_free (priv->stdout_parser);
+		priv->stdout_parser = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
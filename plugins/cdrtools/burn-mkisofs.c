@@ -50,6 +50,7 @@
 #include "brasero-plugin-registration.h"
 #include "burn-cdrtools.h"
 #include "brasero-track-data.h"
+#include "burn-mkisofs-base.h"
 
 
 #define BRASERO_TYPE_MKISOFS         (brasero_mkisofs_get_type ())
@@ -62,6 +63,10 @@
 BRASERO_PLUGIN_BOILERPLATE (BraseroMkisofs, brasero_mkisofs, BRASERO_TYPE_PROCESS, BraseroProcess);
 
 struct _BraseroMkisofsPrivate {
+	/* lists fed to mkisofs by threads */
+	gchar *grafts_path;
+	gchar *excluded_path;
+
 	guint use_utf8:1;
 };
 typedef struct _BraseroMkisofsPrivate BraseroMkisofsPrivate;
@@ -69,6 +74,34 @@ typedef struct _BraseroMkisofsPrivate BraseroMkisofsPrivate;
 #define BRASERO_MKISOFS_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_MKISOFS, BraseroMkisofsPrivate))
 static GObjectClass *parent_class = NULL;
 
+static void
+brasero_mkisofs_check_image_size (BraseroMkisofs *mkisofs,
+				  gint64 sectors)
+{
+	BraseroTrack *track = NULL;
+	BraseroBurnFlag flags;
+	goffset blocks = 0;
+
+	/* The size of a merged or appended session depends on the previous
+	 * sessions so the tree layout does not apply */
+	brasero_job_get_flags (BRASERO_JOB (mkisofs), &flags);
+	if (flags & (BRASERO_BURN_FLAG_APPEND|BRASERO_BURN_FLAG_MERGE))
+		return;
+
+	brasero_job_get_current_track (BRASERO_JOB (mkisofs), &track);
+	if (!track
+	||  brasero_track_data_get_image_size (BRASERO_TRACK_DATA (track), &blocks) != BRASERO_BURN_OK)
+		return;
+
+	/* The layout is only an estimate used for display; what mkisofs
+	 * reports is what counts but a gap is worth knowing about */
+	if (blocks != sectors)
+		BRASERO_JOB_LOG (mkisofs,
+				 "Image size computed from the tree (%"G_GOFFSET_FORMAT" sectors) differs from the actual one (%"G_GINT64_FORMAT" sectors)",
+				 blocks,
+				 sectors);
+}
+
 static BraseroBurnResult
 brasero_mkisofs_read_isosize (BraseroProcess *process, const gchar *line)
 {
@@ -78,6 +111,8 @@ brasero_mkisofs_read_isosize (BraseroProcess *process, const gchar *line)
 	if (!sectors)
 		return BRASERO_BURN_OK;
 
+	brasero_mkisofs_check_image_size (BRASERO_MKISOFS (process), sectors);
+
 	/* mkisofs reports blocks of 2048 bytes */
 	brasero_job_set_output_size_for_current_track (BRASERO_JOB (process),
 						       sectors,
@@ -226,6 +261,43 @@ brasero_mkisofs_read_stderr (BraseroProcess *process, const gchar *line)
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_mkisofs_forget_lists (BraseroMkisofs *mkisofs)
+{
+	BraseroMkisofsPrivate *priv;
+
+	priv = BRASERO_MKISOFS_PRIVATE (mkisofs);
+
+	brasero_mkisofs_base_check_list (priv->grafts_path, NULL);
+	g_free (priv->grafts_path);
+	priv->grafts_path = NULL;
+
+	brasero_mkisofs_base_check_list (priv->excluded_path, NULL);
+	g_free (priv->excluded_path);
+	priv->excluded_path = NULL;
+}
+
+static BraseroBurnResult
+brasero_mkisofs_post (BraseroJob *job)
+{
+	BraseroMkisofsPrivate *priv;
+	GError *error = NULL;
+
+	priv = BRASERO_MKISOFS_PRIVATE (job);
+
+	/* Make sure mkisofs was given the whole lists; otherwise files or
+	 * exclusions would be silently missing from the image */
+	if (brasero_mkisofs_base_check_list (priv->grafts_path, &error) != BRASERO_BURN_OK
+	||  brasero_mkisofs_base_check_list (priv->excluded_path, &error) != BRASERO_BURN_OK) {
+		brasero_mkisofs_forget_lists (BRASERO_MKISOFS (job));
+		brasero_job_error (job, error);
+		return BRASERO_BURN_OK;
+	}
+
+	brasero_mkisofs_forget_lists (BRASERO_MKISOFS (job));
+	return brasero_job_finished_track (job);
+}
+
 static BraseroBurnResult
 brasero_mkisofs_set_argv_image (BraseroMkisofs *mkisofs,
 				GPtrArray *argv,
@@ -321,6 +393,10 @@ brasero_mkisofs_set_argv_image (BraseroMkisofs *mkisofs,
 		return result;
 	}
 
+	brasero_mkisofs_forget_lists (mkisofs);
+	priv->grafts_path = g_strdup (grafts_path);
+	priv->excluded_path = g_strdup (excluded_path);
+
 	g_ptr_array_add (argv, g_strdup ("-path-list"));
 	g_ptr_array_add (argv, grafts_path);
 
@@ -487,6 +563,7 @@ brasero_mkisofs_class_init (BraseroMkisofsClass *klass)
 	process_class->stdout_func = brasero_mkisofs_read_stdout;
 	process_class->stderr_func = brasero_mkisofs_read_stderr;
 	process_class->set_argv = brasero_mkisofs_set_argv;
+	process_class->post = brasero_mkisofs_post;
 }
 
 static void
@@ -516,6 +593,8 @@ brasero_mkisofs_init (BraseroMkisofs *obj)
 static void
 brasero_mkisofs_finalize (GObject *object)
 {
+	brasero_mkisofs_forget_lists (BRASERO_MKISOFS (object));
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
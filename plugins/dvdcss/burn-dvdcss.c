@@ -71,13 +71,23 @@ struct _BraseroDvdcssPrivate {
 	GCond *cond;
 	guint thread_id;
 
+	gint block_size;
+
 	guint cancel:1;
 };
 typedef struct _BraseroDvdcssPrivate BraseroDvdcssPrivate;
 
 #define BRASERO_DVDCSS_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_DVDCSS, BraseroDvdcssPrivate))
 
-#define BRASERO_DVDCSS_I_BLOCKS	16ULL
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_DVDCSS_BLOCKS	"dvdcss-block-size"
+
+/* Number of sectors read at once (default, min, max) */
+#define BRASERO_DVDCSS_I_BLOCKS		256
+#define BRASERO_DVDCSS_MIN_BLOCKS	16
+#define BRASERO_DVDCSS_MAX_BLOCKS	2048
+
+#define BRASERO_DVDCSS_RING_SLOTS	8
 
 static GObjectClass *parent_class = NULL;
 
@@ -187,7 +197,8 @@ brasero_dvdcss_thread_finished (gpointer data)
 static BraseroBurnResult
 brasero_dvdcss_write_sector_to_fd (BraseroDvdcss *self,
 				   gpointer buffer,
-				   gint bytes_remaining)
+				   gint bytes_remaining,
+				   GError **error)
 {
 	int fd;
 	gint bytes_written = 0;
@@ -211,10 +222,11 @@ brasero_dvdcss_write_sector_to_fd (BraseroDvdcss *self,
                                 int errsv = errno;
 
 				/* unrecoverable error */
-				priv->error = g_error_new (BRASERO_BURN_ERROR,
-							   BRASERO_BURN_ERROR_GENERAL,
-							   _("Data could not be written (%s)"),
-							   g_strerror (errsv));
+				g_set_error (error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Data could not be written (%s)"),
+					     g_strerror (errsv));
 				return BRASERO_BURN_ERR;
 			}
 
@@ -230,34 +242,167 @@ brasero_dvdcss_write_sector_to_fd (BraseroDvdcss *self,
 	return BRASERO_BURN_OK;
 }
 
+/**
+ * Reading (and decrypting) and writing run in two threads exchanging blocks
+ * through a ring of slots so that the drive is never idle while we write.
+ */
+
+struct _BraseroDvdcssRing {
+	BraseroDvdcss *self;
+	FILE *output;
+
+	GMutex *mutex;
+	GCond *cond;
+
+	guchar *data;
+	gint *sectors;
+	gsize slot_size;
+	guint slots;
+
+	guint head;
+	guint tail;
+	guint filled;
+
+	/* Statistics (in microseconds for times) */
+	guint64 read_sectors;
+	guint64 written_sectors;
+	gint64 read_time;
+	gint64 write_time;
+	gint64 reader_stall;
+	gint64 writer_stall;
+
+	GError *error;
+
+	/* Set when the reader is done or when either stage failed */
+	guint eof:1;
+	guint failed:1;
+};
+typedef struct _BraseroDvdcssRing BraseroDvdcssRing;
+
+/* The mutex must be held */
+static void
+brasero_dvdcss_ring_wait (BraseroDvdcssRing *ring,
+			  gint64 *stall)
+{
+	GTimeVal timeout;
+	gint64 start;
+
+	/* Don't wait forever to be able to check for cancellation */
+	start = g_get_monotonic_time ();
+	g_get_current_time (&timeout);
+	g_time_val_add (&timeout, G_USEC_PER_SEC / 10);
+	g_cond_timed_wait (ring->cond, ring->mutex, &timeout);
+	*stall += g_get_monotonic_time () - start;
+}
+
+static gpointer
+brasero_dvdcss_writer_thread (gpointer data)
+{
+	BraseroDvdcssRing *ring = data;
+	BraseroDvdcssPrivate *priv;
+
+	priv = BRASERO_DVDCSS_PRIVATE (ring->self);
+
+	while (1) {
+		GError *error = NULL;
+		gsize data_size;
+		guchar *slot;
+		gint64 start;
+
+		g_mutex_lock (ring->mutex);
+		while (!ring->filled && !ring->eof && !priv->cancel)
+			brasero_dvdcss_ring_wait (ring, &ring->writer_stall);
+
+		if (priv->cancel || ring->failed || !ring->filled) {
+			g_mutex_unlock (ring->mutex);
+			break;
+		}
+
+		slot = ring->data + ring->tail * ring->slot_size;
+		data_size = ring->sectors [ring->tail] * DVDCSS_BLOCK_SIZE;
+		g_mutex_unlock (ring->mutex);
+
+		start = g_get_monotonic_time ();
+		if (ring->output) {
+			if (fwrite (slot, 1, data_size, ring->output) != data_size) {
+                                int errsv = errno;
+
+				g_set_error (&error,
+					     BRASERO_BURN_ERROR,
+					     BRASERO_BURN_ERROR_GENERAL,
+					     _("Data could not be written (%s)"),
+					     g_strerror (errsv));
+			}
+		}
+		else
+			brasero_dvdcss_write_sector_to_fd (ring->self,
+							   slot,
+							   data_size,
+							   &error);
+
+		g_mutex_lock (ring->mutex);
+		ring->write_time += g_get_monotonic_time () - start;
+
+		if (error) {
+			ring->error = error;
+			ring->failed = TRUE;
+			g_cond_signal (ring->cond);
+			g_mutex_unlock (ring->mutex);
+			break;
+		}
+
+		ring->written_sectors += ring->sectors [ring->tail];
+		ring->tail = (ring->tail + 1) % ring->slots;
+		ring->filled --;
+		g_cond_signal (ring->cond);
+		g_mutex_unlock (ring->mutex);
+
+		brasero_job_set_written_track (BRASERO_JOB (ring->self),
+					       ring->written_sectors * DVDCSS_BLOCK_SIZE);
+	}
+
+	return NULL;
+}
+
 struct _BraseroScrambledSectorRange {
 	gint start;
 	gint end;
+
+	/* Ranges sharing the same title key */
+	gint key_group;
 };
 typedef struct _BraseroScrambledSectorRange BraseroScrambledSectorRange;
 
+static gint
+brasero_dvdcss_get_key_group (const gchar *name)
+{
+	gint title = 0;
+	gint part = 0;
+
+	/* VIDEO_TS.VOB is the menu of the video manager (group 0), then each
+	 * VTS_XX_0.VOB is a title set menu and VTS_XX_[1-9].VOB the title
+	 * set itself; all the parts of a title set share their key. */
+	if (sscanf (name, "VTS_%2d_%1d", &title, &part) != 2)
+		return 0;
+
+	return title * 2 + (part ? 1 : 0);
+}
+
 static gboolean
 brasero_dvdcss_create_scrambled_sectors_map (BraseroDvdcss *self,
-					     BraseroDrive *drive,
                                              GQueue *map,
-					     dvdcss_handle *handle,
-					     BraseroVolFile *parent,
-					     GError **error)
+					     BraseroVolFile *parent)
 {
 	GList *iter;
 
-	/* this allows to cache keys for encrypted files */
 	for (iter = parent->specific.dir.children; iter; iter = iter->next) {
 		BraseroVolFile *file;
 
 		file = iter->data;
 		if (!file->isdir) {
 			if (!strncmp (file->name + strlen (file->name) - 6, ".VOB", 4)) {
-				BraseroScrambledSectorRange *range;
-				gsize current_extent;
 				GSList *extents;
-
-				BRASERO_JOB_LOG (self, "Retrieving keys for %s", file->name);
+				gint key_group;
 
 				/* take the first address for each extent of the file */
 				if (!file->specific.file.extents) {
@@ -265,40 +410,28 @@ brasero_dvdcss_create_scrambled_sectors_map (BraseroDvdcss *self,
 					return FALSE;
 				}
 
-				range = g_new0 (BraseroScrambledSectorRange, 1);
+				key_group = brasero_dvdcss_get_key_group (file->name);
 				for (extents = file->specific.file.extents; extents; extents = extents->next) {
+					BraseroScrambledSectorRange *range;
 					BraseroVolFileExtent *extent;
 
 					extent = extents->data;
-
-					range->start = extent->block;
-					range->end = extent->block + BRASERO_BYTES_TO_SECTORS (extent->size, DVDCSS_BLOCK_SIZE);
-
-					BRASERO_JOB_LOG (self, "From 0x%llx to 0x%llx", range->start, range->end);
-					g_queue_push_head (map, range);
-
 					if (extent->size == 0) {
 						BRASERO_JOB_LOG (self, "0 size extent");
 						continue;
 					}
 
-					current_extent = dvdcss_seek (handle, range->start, DVDCSS_SEEK_KEY);
-					if (current_extent != range->start) {
-						BRASERO_JOB_LOG (self, "Problem: could not retrieve key");
-						g_set_error (error,
-							     BRASERO_BURN_ERROR,
-							     BRASERO_BURN_ERROR_GENERAL,
-							     /* Translators: %s is the path to a drive. "regionset %s"
-							      * should be left as is just like "DVDCSS_METHOD=title
-							      * brasero --no-existing-session" */
-							     _("Error while retrieving a key used for encryption. You may solve such a problem with one of the following methods: in a terminal either set the proper DVD region code for your CD/DVD player with the \"regionset %s\" command or run the \"DVDCSS_METHOD=title brasero --no-existing-session\" command"),
-							     brasero_drive_get_device (drive));
-						return FALSE;
-					}
+					range = g_new0 (BraseroScrambledSectorRange, 1);
+					range->start = extent->block;
+					range->end = extent->block + BRASERO_BYTES_TO_SECTORS (extent->size, DVDCSS_BLOCK_SIZE);
+					range->key_group = key_group;
+
+					BRASERO_JOB_LOG (self, "%s from 0x%x to 0x%x", file->name, range->start, range->end);
+					g_queue_push_head (map, range);
 				}
 			}
 		}
-		else if (!brasero_dvdcss_create_scrambled_sectors_map (self, drive, map, handle, file, error))
+		else if (!brasero_dvdcss_create_scrambled_sectors_map (self, map, file))
 			return FALSE;
 	}
 
@@ -314,21 +447,84 @@ brasero_dvdcss_sort_ranges (gconstpointer a, gconstpointer b, gpointer user_data
 	return range_a->start - range_b->start;
 }
 
+/**
+ * Sort the ranges and merge the contiguous ones using the same key so that a
+ * key is only looked up once per title set and not for every VOB extent.
+ * The keys are cached by libdvdcss while at it.
+ */
+
+static gboolean
+brasero_dvdcss_schedule_keys (BraseroDvdcss *self,
+			      BraseroDrive *drive,
+			      GQueue *map,
+			      dvdcss_handle *handle,
+			      GError **error)
+{
+	GList *iter;
+	GList *next;
+
+	g_queue_sort (map, brasero_dvdcss_sort_ranges, NULL);
+
+	for (iter = map->head; iter; iter = next) {
+		BraseroScrambledSectorRange *range;
+		BraseroScrambledSectorRange *following;
+
+		range = iter->data;
+		next = iter->next;
+		if (!next)
+			break;
+
+		following = next->data;
+		if (following->key_group != range->key_group
+		||  following->start > range->end)
+			continue;
+
+		range->end = MAX (range->end, following->end);
+		g_free (following);
+		g_queue_delete_link (map, next);
+		next = iter;
+	}
+
+	for (iter = map->head; iter; iter = iter->next) {
+		BraseroScrambledSectorRange *range;
+		gint current_extent;
+
+		range = iter->data;
+		BRASERO_JOB_LOG (self, "Retrieving key for 0x%x - 0x%x", range->start, range->end);
+
+		current_extent = dvdcss_seek (handle, range->start, DVDCSS_SEEK_KEY);
+		if (current_extent != range->start) {
+			BRASERO_JOB_LOG (self, "Problem: could not retrieve key");
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     /* Translators: %s is the path to a drive. "regionset %s"
+				      * should be left as is just like "DVDCSS_METHOD=title
+				      * brasero --no-existing-session" */
+				     _("Error while retrieving a key used for encryption. You may solve such a problem with one of the following methods: in a terminal either set the proper DVD region code for your CD/DVD player with the \"regionset %s\" command or run the \"DVDCSS_METHOD=title brasero --no-existing-session\" command"),
+				     brasero_drive_get_device (drive));
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
 static gpointer
 brasero_dvdcss_write_image_thread (gpointer data)
 {
-	guchar buf [DVDCSS_BLOCK_SIZE * BRASERO_DVDCSS_I_BLOCKS];
 	BraseroScrambledSectorRange *range = NULL;
 	BraseroMedium *medium = NULL;
 	BraseroVolFile *files = NULL;
 	dvdcss_handle *handle = NULL;
 	BraseroDrive *drive = NULL;
+	BraseroDvdcssRing ring = { NULL, };
+	GThread *writer = NULL;
 	BraseroDvdcssPrivate *priv;
-	gint64 written_sectors = 0;
+	gint64 read_sectors = 0;
 	BraseroDvdcss *self = data;
 	BraseroTrack *track = NULL;
 	guint64 remaining_sectors;
-	FILE *output_fd = NULL;
 	BraseroVolSrc *vol;
 	gint64 volume_size;
 	GQueue *map = NULL;
@@ -376,18 +572,24 @@ brasero_dvdcss_write_image_thread (gpointer data)
 	}
 
 	/* look through the files to get the ranges of encrypted sectors
-	 * and cache the CSS keys while at it. */
+	 * and cache the CSS keys afterwards. */
 	map = g_queue_new ();
-	if (!brasero_dvdcss_create_scrambled_sectors_map (self, drive, map, handle, files, &priv->error))
+	if (!brasero_dvdcss_create_scrambled_sectors_map (self, map, files)) {
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("Error while reading video DVD (%s)"),
+					   _("a file has no extent"));
 		goto end;
-
-	BRASERO_JOB_LOG (self, "DVD map created (keys retrieved)");
-
-	g_queue_sort (map, brasero_dvdcss_sort_ranges, NULL);
+	}
 
 	brasero_volume_file_free (files);
 	files = NULL;
 
+	if (!brasero_dvdcss_schedule_keys (self, drive, map, handle, &priv->error))
+		goto end;
+
+	BRASERO_JOB_LOG (self, "DVD map created (%u key ranges)", g_queue_get_length (map));
+
 	if (dvdcss_seek (handle, 0, DVDCSS_NOFLAGS) < 0) {
 		BRASERO_JOB_LOG (self, "Error initial seeking");
 		priv->error = g_error_new (BRASERO_BURN_ERROR,
@@ -411,8 +613,8 @@ brasero_dvdcss_write_image_thread (gpointer data)
 		gchar *output = NULL;
 
 		brasero_job_get_image_output (BRASERO_JOB (self), &output, NULL);
-		output_fd = fopen (output, "w");
-		if (!output_fd) {
+		ring.output = fopen (output, "w");
+		if (!ring.output) {
 			priv->error = g_error_new_literal (BRASERO_BURN_ERROR,
 							   BRASERO_BURN_ERROR_GENERAL,
 							   g_strerror (errno));
@@ -422,37 +624,73 @@ brasero_dvdcss_write_image_thread (gpointer data)
 		g_free (output);
 	}
 
+	ring.self = self;
+	ring.slots = BRASERO_DVDCSS_RING_SLOTS;
+	ring.slot_size = priv->block_size * DVDCSS_BLOCK_SIZE;
+	ring.data = g_try_malloc (ring.slots * ring.slot_size);
+	if (!ring.data) {
+		priv->error = g_error_new_literal (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_GENERAL,
+						   g_strerror (ENOMEM));
+		goto end;
+	}
+
+	ring.sectors = g_new0 (gint, ring.slots);
+	ring.mutex = g_mutex_new ();
+	ring.cond = g_cond_new ();
+
+	BRASERO_JOB_LOG (self, "Reading by blocks of %i sectors", priv->block_size);
+
+	writer = g_thread_create (brasero_dvdcss_writer_thread,
+				  &ring,
+				  TRUE,
+				  &priv->error);
+	if (!writer)
+		goto end;
+
 	while (remaining_sectors) {
 		gint flag;
-		guint64 num_blocks, data_size;
+		guint64 num_blocks;
+		gint read_blocks;
+		guchar *slot;
+		gint64 start;
 
-		if (priv->cancel)
+		g_mutex_lock (ring.mutex);
+		while (ring.filled == ring.slots && !ring.failed && !priv->cancel)
+			brasero_dvdcss_ring_wait (&ring, &ring.reader_stall);
+
+		if (ring.failed || priv->cancel) {
+			g_mutex_unlock (ring.mutex);
 			break;
+		}
+
+		slot = ring.data + ring.head * ring.slot_size;
+		g_mutex_unlock (ring.mutex);
 
-		num_blocks = BRASERO_DVDCSS_I_BLOCKS;
+		num_blocks = priv->block_size;
 
 		/* see if we are approaching the end of the dvd */
 		if (num_blocks > remaining_sectors)
 			num_blocks = remaining_sectors;
 
 		/* see if we need to update the key */
-		if (!range || written_sectors < range->start) {
+		if (!range || read_sectors < range->start) {
 			/* this is in a non scrambled sectors range */
 			flag = DVDCSS_NOFLAGS;
 	
 			/* we don't want to mix scrambled and non scrambled sectors */
-			if (range && written_sectors + num_blocks > range->start)
-				num_blocks = range->start - written_sectors;
+			if (range && read_sectors + num_blocks > range->start)
+				num_blocks = range->start - read_sectors;
 		}
 		else {
 			/* this is in a scrambled sectors range */
 			flag = DVDCSS_READ_DECRYPT;
 
-			/* see if we need to update the key */
-			if (written_sectors == range->start) {
+			/* see if we need to update the key (it is cached) */
+			if (read_sectors == range->start) {
 				int pos;
 
-				pos = dvdcss_seek (handle, written_sectors, DVDCSS_SEEK_KEY);
+				pos = dvdcss_seek (handle, read_sectors, DVDCSS_SEEK_KEY);
 				if (pos < 0) {
 					BRASERO_JOB_LOG (self, "Error seeking");
 					priv->error = g_error_new (BRASERO_BURN_ERROR,
@@ -465,18 +703,19 @@ brasero_dvdcss_write_image_thread (gpointer data)
 
 			/* we don't want to mix scrambled and non scrambled sectors
 			 * NOTE: range->end address is the next non scrambled sector */
-			if (written_sectors + num_blocks > range->end)
-				num_blocks = range->end - written_sectors;
+			if (read_sectors + num_blocks > range->end)
+				num_blocks = range->end - read_sectors;
 
-			if (written_sectors + num_blocks == range->end) {
+			if (read_sectors + num_blocks == range->end) {
 				/* update to get the next range of scrambled sectors */
 				g_free (range);
 				range = g_queue_pop_head (map);
 			}
 		}
 
-		num_blocks = dvdcss_read (handle, buf, num_blocks, flag);
-		if (num_blocks < 0) {
+		start = g_get_monotonic_time ();
+		read_blocks = dvdcss_read (handle, slot, num_blocks, flag);
+		if (read_blocks < 0) {
 			BRASERO_JOB_LOG (self, "Error reading");
 			priv->error = g_error_new (BRASERO_BURN_ERROR,
 						   BRASERO_BURN_ERROR_GENERAL,
@@ -485,34 +724,57 @@ brasero_dvdcss_write_image_thread (gpointer data)
 			break;
 		}
 
-		data_size = num_blocks * DVDCSS_BLOCK_SIZE;
-		if (output_fd) {
-			if (fwrite (buf, 1, data_size, output_fd) != data_size) {
-                                int errsv = errno;
+		g_mutex_lock (ring.mutex);
+		ring.read_time += g_get_monotonic_time () - start;
+		ring.read_sectors += read_blocks;
+		ring.sectors [ring.head] = read_blocks;
+		ring.head = (ring.head + 1) % ring.slots;
+		ring.filled ++;
+		g_cond_signal (ring.cond);
+		g_mutex_unlock (ring.mutex);
+
+		read_sectors += read_blocks;
+		remaining_sectors -= read_blocks;
+	}
 
-				priv->error = g_error_new (BRASERO_BURN_ERROR,
-							   BRASERO_BURN_ERROR_GENERAL,
-							   _("Data could not be written (%s)"),
-							   g_strerror (errsv));
-				break;
-			}
-		}
-		else {
-			BraseroBurnResult result;
+end:
 
-			result = brasero_dvdcss_write_sector_to_fd (self,
-								    buf,
-								    data_size);
-			if (result != BRASERO_BURN_OK)
-				break;
+	if (writer) {
+		/* Let the writer empty the ring (unless we failed) */
+		g_mutex_lock (ring.mutex);
+		ring.eof = TRUE;
+		if (priv->error)
+			ring.failed = TRUE;
+		g_cond_signal (ring.cond);
+		g_mutex_unlock (ring.mutex);
+
+		g_thread_join (writer);
+
+		if (ring.error) {
+			if (!priv->error)
+				priv->error = ring.error;
+			else
+				g_error_free (ring.error);
 		}
 
-		written_sectors += num_blocks;
-		remaining_sectors -= num_blocks;
-		brasero_job_set_written_track (BRASERO_JOB (self), written_sectors * DVDCSS_BLOCK_SIZE);
+		BRASERO_JOB_LOG (self,
+				 "Read %" G_GUINT64_FORMAT " sectors in %.2f s (%.2f s waiting for the writer), wrote %" G_GUINT64_FORMAT " sectors in %.2f s (%.2f s waiting for the reader)",
+				 ring.read_sectors,
+				 (gdouble) ring.read_time / G_USEC_PER_SEC,
+				 (gdouble) ring.reader_stall / G_USEC_PER_SEC,
+				 ring.written_sectors,
+				 (gdouble) ring.write_time / G_USEC_PER_SEC,
+				 (gdouble) ring.writer_stall / G_USEC_PER_SEC);
 	}
 
-end:
+	if (ring.mutex)
+		g_mutex_free (ring.mutex);
+
+	if (ring.cond)
+		g_cond_free (ring.cond);
+
+	g_free (ring.sectors);
+	g_free (ring.data);
 
 	if (range)
 		g_free (range);
@@ -523,8 +785,8 @@ end:
 	if (files)
 		brasero_volume_file_free (files);
 
-	if (output_fd)
-		fclose (output_fd);
+	if (ring.output)
+		fclose (ring.output);
 
 	if (map) {
 		g_queue_foreach (map, (GFunc) g_free, NULL);
@@ -654,11 +916,19 @@ static void
 brasero_dvdcss_init (BraseroDvdcss *obj)
 {
 	BraseroDvdcssPrivate *priv;
+	GSettings *settings;
 
 	priv = BRASERO_DVDCSS_PRIVATE (obj);
 
 	priv->mutex = g_mutex_new ();
 	priv->cond = g_cond_new ();
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->block_size = g_settings_get_int (settings, BRASERO_KEY_DVDCSS_BLOCKS);
+	if (priv->block_size < BRASERO_DVDCSS_MIN_BLOCKS || priv->block_size > BRASERO_DVDCSS_MAX_BLOCKS)
+		priv->block_size = BRASERO_DVDCSS_I_BLOCKS;
+
+	g_object_unref (settings);
 }
 
 static void
@@ -686,6 +956,7 @@ brasero_dvdcss_finalize (GObject *object)
 static void
 brasero_dvdcss_export_caps (BraseroPlugin *plugin)
 {
+	BraseroPluginConfOption *block_size;
 	GSList *output;
 	GSList *input;
 
@@ -712,6 +983,14 @@ brasero_dvdcss_export_caps (BraseroPlugin *plugin)
 
 	g_slist_free (input);
 	g_slist_free (output);
+
+	block_size = brasero_plugin_conf_option_new (BRASERO_KEY_DVDCSS_BLOCKS,
+						     _("Number of sectors read at once:"),
+						     BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (block_size,
+						  BRASERO_DVDCSS_MIN_BLOCKS,
+						  BRASERO_DVDCSS_MAX_BLOCKS);
+	brasero_plugin_add_conf_option (plugin, block_size);
 }
 
 G_MODULE_EXPORT void
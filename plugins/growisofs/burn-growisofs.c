@@ -51,6 +51,7 @@
 #include "brasero-drive.h"
 #include "burn-growisofs-common.h"
 #include "brasero-track-data.h"
+#include "burn-mkisofs-base.h"
 #include "brasero-track-image.h"
 
 
@@ -64,6 +65,10 @@
 BRASERO_PLUGIN_BOILERPLATE (BraseroGrowisofs, brasero_growisofs, BRASERO_TYPE_PROCESS, BraseroProcess);
 
 struct BraseroGrowisofsPrivate {
+	/* lists fed to mkisofs by threads */
+	gchar *grafts_path;
+	gchar *excluded_path;
+
 	guint use_utf8:1;
 	guint use_genisoimage:1;
   	guint use_dao:1;
@@ -243,6 +248,43 @@ brasero_growisofs_read_stderr (BraseroProcess *process, const gchar *line)
 	return BRASERO_BURN_OK;
 }
 
+static void
+brasero_growisofs_forget_lists (BraseroGrowisofs *growisofs)
+{
+	BraseroGrowisofsPrivate *priv;
+
+	priv = BRASERO_GROWISOFS_PRIVATE (growisofs);
+
+	brasero_mkisofs_base_check_list (priv->grafts_path, NULL);
+	g_free (priv->grafts_path);
+	priv->grafts_path = NULL;
+
+	brasero_mkisofs_base_check_list (priv->excluded_path, NULL);
+	g_free (priv->excluded_path);
+	priv->excluded_path = NULL;
+}
+
+static BraseroBurnResult
+brasero_growisofs_post (BraseroJob *job)
+{
+	BraseroGrowisofsPrivate *priv;
+	GError *error = NULL;
+
+	priv = BRASERO_GROWISOFS_PRIVATE (job);
+
+	/* Make sure mkisofs was given the whole lists; otherwise files or
+	 * exclusions would be silently missing from the image */
+	if (brasero_mkisofs_base_check_list (priv->grafts_path, &error) != BRASERO_BURN_OK
+	||  brasero_mkisofs_base_check_list (priv->excluded_path, &error) != BRASERO_BURN_OK) {
+		brasero_growisofs_forget_lists (BRASERO_GROWISOFS (job));
+		brasero_job_error (job, error);
+		return BRASERO_BURN_OK;
+	}
+
+	brasero_growisofs_forget_lists (BRASERO_GROWISOFS (job));
+	return brasero_job_finished_session (job);
+}
+
 static BraseroBurnResult
 brasero_growisofs_set_mkisofs_argv (BraseroGrowisofs *growisofs,
 				    GPtrArray *argv,
@@ -356,6 +398,10 @@ brasero_growisofs_set_mkisofs_argv (BraseroGrowisofs *growisofs,
 		return result;
 	}
 
+	brasero_growisofs_forget_lists (growisofs);
+	priv->grafts_path = g_strdup (grafts_path);
+	priv->excluded_path = g_strdup (excluded_path);
+
 	g_ptr_array_add (argv, g_strdup ("-path-list"));
 	g_ptr_array_add (argv, grafts_path);
 
@@ -667,7 +713,7 @@ brasero_growisofs_class_init (BraseroGrowisofsClass *klass)
 	process_class->stdout_func = brasero_growisofs_read_stdout;
 	process_class->stderr_func = brasero_growisofs_read_stderr;
 	process_class->set_argv = brasero_growisofs_set_argv;
-	process_class->post = brasero_job_finished_session;
+	process_class->post = brasero_growisofs_post;
 }
 
 static void
@@ -733,6 +779,8 @@ brasero_growisofs_init (BraseroGrowisofs *obj)
 static void
 brasero_growisofs_finalize (GObject *object)
 {
+	brasero_growisofs_forget_lists (BRASERO_GROWISOFS (object));
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
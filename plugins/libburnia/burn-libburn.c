@@ -38,6 +38,7 @@
 #include <string.h>
 #include <unistd.h>
 #include <errno.h>
+#include <poll.h>
 
 #include <glib.h>
 #include <glib-object.h>
@@ -67,6 +68,14 @@ BRASERO_PLUGIN_BOILERPLATE (BraseroLibburn, brasero_libburn, BRASERO_TYPE_JOB, B
 
 #define BRASERO_PVD_SIZE	32ULL * 2048ULL
 
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_FIFO_SIZE		"libburn-fifo-size"
+#define BRASERO_KEY_FIFO_PREFILL	"libburn-fifo-prefill"
+
+#define BRASERO_LIBBURN_FIFO_MAX	1024		/* MiB */
+#define BRASERO_LIBBURN_FIFO_I_SIZE	64		/* MiB */
+#define BRASERO_LIBBURN_FIFO_I_PREFILL	50		/* percent */
+
 struct _BraseroLibburnPrivate {
 	BraseroLibburnCtx *ctx;
 
@@ -74,6 +83,21 @@ struct _BraseroLibburnPrivate {
 	 * for overwrite media so as to "grow" the latter. */
 	unsigned char *pvd;
 
+	/* When data come through a pipe they are buffered in a fifo source
+	 * whose thread reads ahead of the drive. Writing only starts once
+	 * the fifo has been prefilled (opts are kept around until then). */
+	struct burn_source *src;
+	struct burn_source *fifo;
+	struct burn_write_opts *opts;
+	GThread *prefill_thread;
+	gint prefill_result;
+	gint prefilled;
+
+	gint fifo_size;
+	gint fifo_prefill;
+	gint fifo_level;
+	gint fifo_min;
+
 	guint sig_handler:1;
 };
 typedef struct _BraseroLibburnPrivate BraseroLibburnPrivate;
@@ -96,9 +120,12 @@ struct _BraseroLibburnSrcData {
 	off_t size;
 
 	/* That's for the primary volume descriptor used for overwrite media */
-	int pvd_size;						/* in blocks */
+	int pvd_size;						/* in bytes */
 	unsigned char *pvd;
 
+	/* set from the main thread to stop the reading thread of the fifo */
+	gint cancel;
+
 	int read_pvd:1;
 };
 typedef struct _BraseroLibburnSrcData BraseroLibburnSrcData;
@@ -144,6 +171,44 @@ struct _BraseroVolDesc {
 };
 typedef struct _BraseroVolDesc BraseroVolDesc;
 
+/**
+ * Copies the volume descriptors at the start of the data until we reach
+ * either the end of the buffer or the volume descriptor set end. This only
+ * runs for the first blocks read and never again afterwards.
+ */
+
+static void
+brasero_libburn_src_capture_pvd (BraseroLibburnSrcData *data,
+				 unsigned char *buffer,
+				 int size)
+{
+	unsigned char *current_pvd;
+	int i;
+
+	current_pvd = data->pvd + data->pvd_size;
+
+	for (i = 0; (i << 11) < size && data->pvd_size + (i << 11) < BRASERO_PVD_SIZE; i ++) {
+		BraseroVolDesc *desc;
+
+		/* No need to check the first 16 blocks */
+		if ((data->pvd_size >> 11) + i < 16)
+			continue;
+
+		desc = (BraseroVolDesc *) (buffer + (i << 11));
+		if (desc->type == 255) {
+			data->read_pvd = 1;
+			BRASERO_BURN_LOG ("found volume descriptor set end");
+
+			/* keep the terminator too */
+			i ++;
+			break;
+		}
+	}
+
+	memcpy (current_pvd, buffer, i << 11);
+	data->pvd_size += i << 11;
+}
+
 static int
 brasero_libburn_src_read_xt (struct burn_source *src,
 			     unsigned char *buffer,
@@ -156,11 +221,36 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 
 	total = 0;
 	while (total < size) {
+		struct pollfd fds;
 		int bytes;
+		int res;
+
+		if (g_atomic_int_get (&data->cancel))
+			return -1;
+
+		/* Don't block forever on the pipe so that a cancellation is
+		 * noticed even if the imager stalls. */
+		fds.fd = data->fd;
+		fds.events = POLLIN;
+		fds.revents = 0;
+		res = poll (&fds, 1, 500);
+		if (res < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+
+			return -1;
+		}
+
+		if (!res)
+			continue;
 
 		bytes = read (data->fd, buffer + total, size - total);
-		if (bytes < 0)
+		if (bytes < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+
 			return -1;
+		}
 
 		if (!bytes)
 			break;
@@ -171,32 +261,8 @@ brasero_libburn_src_read_xt (struct burn_source *src,
 	/* copy the primary volume descriptor if a buffer is provided */
 	if (data->pvd
 	&& !data->read_pvd
-	&&  data->pvd_size < BRASERO_PVD_SIZE) {
-		unsigned char *current_pvd;
-		int i;
-
-		current_pvd = data->pvd + data->pvd_size;
-
-		/* read volume descriptors until we reach the end of the
-		 * buffer or find a volume descriptor set end. */
-		for (i = 0; (i << 11) < size && data->pvd_size + (i << 11) < BRASERO_PVD_SIZE; i ++) {
-			BraseroVolDesc *desc;
-
-			/* No need to check the first 16 blocks */
-			if ((data->pvd_size >> 11) + i < 16)
-				continue;
-
-			desc = (BraseroVolDesc *) (buffer + sizeof (BraseroVolDesc) * i);
-			if (desc->type == 255) {
-				data->read_pvd = 1;
-				BRASERO_BURN_LOG ("found volume descriptor set end");
-				break;
-			}
-		}
-
-		memcpy (current_pvd, buffer, i << 11);
-		data->pvd_size += i << 11;
-	}
+	&&  data->pvd_size < BRASERO_PVD_SIZE)
+		brasero_libburn_src_capture_pvd (data, buffer, total);
 
 	return total;
 }
@@ -214,8 +280,6 @@ brasero_libburn_create_fd_source (int fd,
 	data->size = size;
 	data->pvd = pvd;
 
-	/* FIXME: this could be wrapped into a fifo source to get a smoother
-	 * data delivery. But that means another thread ... */
 	src = g_new0 (struct burn_source, 1);
 	src->version = 1;
 	src->refcount = 1;
@@ -301,6 +365,64 @@ brasero_libburn_add_file_track (struct burn_session *session,
 	return brasero_libburn_add_fd_track (session, fd, mode, size, pvd, error);
 }
 
+/**
+ * Data coming from a pipe are wrapped in a fifo source so that the drive is
+ * fed from memory while the imager keeps on producing data in its own thread.
+ */
+
+static BraseroBurnResult
+brasero_libburn_add_fifo_track (BraseroLibburn *self,
+				struct burn_session *session,
+				int fd,
+				gint mode,
+				gint64 size,
+				GError **error)
+{
+	int chunk;
+	gint64 chunks;
+	struct burn_track *track;
+	BraseroBurnResult result;
+	BraseroLibburnPrivate *priv;
+
+	priv = BRASERO_LIBBURN_PRIVATE (self);
+
+	/* The chunk size must be a multiple of the sector size */
+	if (mode & BURN_MODE_RAW)
+		chunk = 2448;
+	else
+		chunk = 2048;
+
+	/* Use chunks of 32 sectors */
+	chunk *= 32;
+	chunks = ((gint64) priv->fifo_size << 20) / chunk;
+	if (chunks < 2)
+		chunks = 2;
+
+	priv->src = brasero_libburn_create_fd_source (fd, size, priv->pvd);
+	priv->fifo = burn_fifo_source_new (priv->src, chunk, chunks, 0);
+	if (!priv->fifo) {
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("libburn track could not be created"));
+		return BRASERO_BURN_ERR;
+	}
+
+	BRASERO_JOB_LOG (self,
+			 "Using a fifo of %lli bytes (%lli chunks of %i bytes)",
+			 chunks * chunk,
+			 chunks,
+			 chunk);
+
+	track = burn_track_create ();
+	burn_track_define_data (track, 0, 0, 0, mode);
+
+	result = brasero_libburn_add_track (session, track, priv->fifo, mode, error);
+	burn_track_free (track);
+
+	return result;
+}
+
 static BraseroBurnResult
 brasero_libburn_setup_session_fd (BraseroLibburn *self,
 			          struct burn_session *session,
@@ -335,12 +457,20 @@ brasero_libburn_setup_session_fd (BraseroLibburn *self,
 						     NULL,
 						     &bytes);
 
-		result = brasero_libburn_add_fd_track (session,
-						       fd,
-						       mode,
-						       bytes,
-						       priv->pvd,
-						       error);
+		if (priv->fifo_size > 0)
+			result = brasero_libburn_add_fifo_track (self,
+								 session,
+								 fd,
+								 mode,
+								 bytes,
+								 error);
+		else
+			result = brasero_libburn_add_fd_track (session,
+							       fd,
+							       mode,
+							       bytes,
+							       priv->pvd,
+							       error);
 	}
 	else if (brasero_track_type_get_has_stream (type)) {
 		GSList *tracks;
@@ -482,6 +612,65 @@ brasero_libburn_create_disc (BraseroLibburn *self,
 	return result;
 }
 
+static gpointer
+brasero_libburn_prefill_thread (gpointer data)
+{
+	BraseroLibburnPrivate *priv;
+	gint64 bytes;
+
+	priv = BRASERO_LIBBURN_PRIVATE (data);
+
+	bytes = ((gint64) priv->fifo_size << 20) * priv->fifo_prefill / 100;
+
+	/* This returns once the fifo holds that many bytes or once the input
+	 * reached its end (or failed). Its own thread then keeps on reading. */
+	priv->prefill_result = burn_fifo_fill (priv->fifo, MIN (bytes, G_MAXINT), 0);
+	g_atomic_int_set (&priv->prefilled, 1);
+
+	g_thread_exit (NULL);
+	return NULL;
+}
+
+static void
+brasero_libburn_report_fifo (BraseroLibburn *self)
+{
+	BraseroLibburnPrivate *priv;
+	char *status_text = NULL;
+	int free_bytes = 0;
+	int status;
+	off_t size = 0;
+	gint level;
+
+	priv = BRASERO_LIBBURN_PRIVATE (self);
+
+	status = burn_fifo_inquire_status (priv->fifo, &size, &free_bytes, &status_text);
+
+	/* Only an active fifo (not one whose input ended) is meaningful */
+	if (status != 1 || size <= 0)
+		return;
+
+	level = (size - free_bytes) * 100 / size;
+	if (priv->fifo_min < 0 || level < priv->fifo_min)
+		priv->fifo_min = level;
+
+	if (ABS (level - priv->fifo_level) >= 10) {
+		BRASERO_JOB_LOG (self, "Fifo filled at %i%%", level);
+		priv->fifo_level = level;
+	}
+}
+
+static void
+brasero_libburn_write (BraseroLibburn *self)
+{
+	BraseroLibburnPrivate *priv;
+
+	priv = BRASERO_LIBBURN_PRIVATE (self);
+
+	burn_disc_write (priv->opts, priv->ctx->disc);
+	burn_write_opts_free (priv->opts);
+	priv->opts = NULL;
+}
+
 static BraseroBurnResult
 brasero_libburn_start_record (BraseroLibburn *self,
 			      GError **error)
@@ -582,8 +771,24 @@ brasero_libburn_start_record (BraseroLibburn *self,
 		priv->sig_handler = 1;
 	}
 
-	burn_disc_write (opts, priv->ctx->disc);
-	burn_write_opts_free (opts);
+	priv->opts = opts;
+	if (!priv->fifo) {
+		brasero_libburn_write (self);
+		return BRASERO_BURN_OK;
+	}
+
+	/* Let the fifo fill up before the drive starts to be fed; writing
+	 * starts from clock_tick once it's done. */
+	BRASERO_JOB_LOG (self, "Prefilling fifo up to %i%%", priv->fifo_prefill);
+	priv->fifo_level = 0;
+	priv->fifo_min = -1;
+	g_atomic_int_set (&priv->prefilled, 0);
+	priv->prefill_thread = g_thread_create (brasero_libburn_prefill_thread,
+						self,
+						TRUE,
+						error);
+	if (!priv->prefill_thread)
+		return BRASERO_BURN_ERR;
 
 	return BRASERO_BURN_OK;
 }
@@ -818,11 +1023,43 @@ brasero_libburn_stop (BraseroJob *job,
 		burn_set_signal_handling (NULL, NULL, 1);
 	}
 
+	/* Stop the reading thread of the fifo in case it is still waiting
+	 * for data from the imager */
+	if (priv->src) {
+		BraseroLibburnSrcData *data;
+
+		data = priv->src->data;
+		g_atomic_int_set (&data->cancel, 1);
+	}
+
+	if (priv->prefill_thread) {
+		g_thread_join (priv->prefill_thread);
+		priv->prefill_thread = NULL;
+	}
+
+	if (priv->opts) {
+		burn_write_opts_free (priv->opts);
+		priv->opts = NULL;
+	}
+
 	if (priv->ctx) {
 		brasero_libburn_common_ctx_free (priv->ctx);
 		priv->ctx = NULL;
 	}
 
+	if (priv->fifo) {
+		if (priv->fifo_min >= 0)
+			BRASERO_JOB_LOG (self, "Fifo was never filled under %i%%", priv->fifo_min);
+
+		burn_source_free (priv->fifo);
+		priv->fifo = NULL;
+	}
+
+	if (priv->src) {
+		burn_source_free (priv->src);
+		priv->src = NULL;
+	}
+
 	if (priv->pvd) {
 		g_free (priv->pvd);
 		priv->pvd = NULL;
@@ -842,6 +1079,34 @@ brasero_libburn_clock_tick (BraseroJob *job)
 	int ret;
 
 	priv = BRASERO_LIBBURN_PRIVATE (job);
+
+	/* Still waiting for the fifo to be prefilled */
+	if (priv->opts) {
+		if (!g_atomic_int_get (&priv->prefilled))
+			return BRASERO_BURN_OK;
+
+		if (priv->prefill_thread) {
+			g_thread_join (priv->prefill_thread);
+			priv->prefill_thread = NULL;
+		}
+
+		if (priv->prefill_result < 0) {
+			BRASERO_JOB_LOG (job, "Fifo could not be filled");
+			brasero_job_error (job,
+					   g_error_new (BRASERO_BURN_ERROR,
+							BRASERO_BURN_ERROR_GENERAL,
+							_("Data could not be read")));
+			return BRASERO_BURN_OK;
+		}
+
+		BRASERO_JOB_LOG (job, "Fifo prefilled; starting to write");
+		brasero_libburn_write (BRASERO_LIBBURN (job));
+		return BRASERO_BURN_OK;
+	}
+
+	if (priv->fifo)
+		brasero_libburn_report_fifo (BRASERO_LIBBURN (job));
+
 	result = brasero_libburn_common_status (job, priv->ctx);
 
 	if (result != BRASERO_BURN_OK)
@@ -913,7 +1178,22 @@ brasero_libburn_class_init (BraseroLibburnClass *klass)
 static void
 brasero_libburn_init (BraseroLibburn *obj)
 {
+	BraseroLibburnPrivate *priv;
+	GSettings *settings;
+
+	priv = BRASERO_LIBBURN_PRIVATE (obj);
 
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+
+	priv->fifo_size = g_settings_get_int (settings, BRASERO_KEY_FIFO_SIZE);
+	if (priv->fifo_size < 0 || priv->fifo_size > BRASERO_LIBBURN_FIFO_MAX)
+		priv->fifo_size = BRASERO_LIBBURN_FIFO_I_SIZE;
+
+	priv->fifo_prefill = g_settings_get_int (settings, BRASERO_KEY_FIFO_PREFILL);
+	if (priv->fifo_prefill < 1 || priv->fifo_prefill > 100)
+		priv->fifo_prefill = BRASERO_LIBBURN_FIFO_I_PREFILL;
+
+	g_object_unref (settings);
 }
 
 static void
@@ -966,6 +1246,7 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					       BRASERO_MEDIUM_APPENDABLE|
 					       BRASERO_MEDIUM_CLOSED|
 					       BRASERO_MEDIUM_HAS_DATA;
+	BraseroPluginConfOption *fifo_size, *fifo_prefill;
 	GSList *output;
 	GSList *input;
 
@@ -1088,4 +1369,16 @@ brasero_libburn_export_caps (BraseroPlugin *plugin)
 					BRASERO_BURN_FLAG_NONE);
 
 	brasero_plugin_register_group (plugin, _(LIBBURNIA_DESCRIPTION));
+
+	fifo_size = brasero_plugin_conf_option_new (BRASERO_KEY_FIFO_SIZE,
+						    _("Size of the buffer in MiB (0 to disable it):"),
+						    BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (fifo_size, 0, BRASERO_LIBBURN_FIFO_MAX);
+	brasero_plugin_add_conf_option (plugin, fifo_size);
+
+	fifo_prefill = brasero_plugin_conf_option_new (BRASERO_KEY_FIFO_PREFILL,
+						       _("Percentage of the buffer to fill before writing:"),
+						       BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (fifo_prefill, 1, 100);
+	brasero_plugin_add_conf_option (plugin, fifo_prefill);
 }
@@ -71,6 +71,11 @@ struct _BraseroLibisofsPrivate {
 	/* that's for multisession */
 	BraseroLibburnCtx *ctx;
 
+	/* copy of the tree of the track taken in the main loop since the
+	 * tree can change while the thread runs */
+	GArray *nodes;
+	BraseroBurnResult nodes_result;
+
 	GError *error;
 	GThread *thread;
 	GMutex *mutex;
@@ -81,6 +86,22 @@ struct _BraseroLibisofsPrivate {
 };
 typedef struct _BraseroLibisofsPrivate BraseroLibisofsPrivate;
 
+typedef enum {
+	BRASERO_LIBISOFS_NODE_DIRECTORY,
+	BRASERO_LIBISOFS_NODE_FILE,
+	BRASERO_LIBISOFS_NODE_END
+} BraseroLibisofsNodeType;
+
+typedef struct _BraseroLibisofsNode BraseroLibisofsNode;
+struct _BraseroLibisofsNode {
+	gchar *name;
+	gchar *uri;
+
+	guint type:2;
+	guint grafted:1;
+	guint imported:1;
+};
+
 #define BRASERO_LIBISOFS_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_LIBISOFS, BraseroLibisofsPrivate))
 
 static GObjectClass *parent_class = NULL;
@@ -539,6 +560,345 @@ brasero_libisofs_import_last_session (BraseroLibisofs *self,
 	return BRASERO_BURN_OK;
 }
 
+typedef struct _BraseroLibisofsExport BraseroLibisofsExport;
+struct _BraseroLibisofsExport {
+	BraseroLibisofs *self;
+	IsoImage *image;
+
+	/* directories that come from the imported session */
+	GHashTable *imported;
+
+	/* number of nodes added to the image */
+	guint nodes;
+};
+
+static gchar *
+brasero_libisofs_get_local_path (const gchar *uri)
+{
+	/* uri can be a path or a URI */
+	if (uri [0] == '/')
+		return g_strdup (uri);
+
+	if (g_str_has_prefix (uri, "file://"))
+		return g_filename_from_uri (uri, NULL, NULL);
+
+	return NULL;
+}
+
+static void
+brasero_libisofs_export_remove_imported (BraseroLibisofsExport *export,
+					 IsoDir *parent,
+					 const gchar *name)
+{
+	IsoNode *node = NULL;
+
+	/* A new node replaces the node of the previous session with the
+	 * same name */
+	if (!g_hash_table_lookup (export->imported, parent))
+		return;
+
+	if (iso_dir_get_node (parent, name, &node) == 1 && node)
+		iso_node_remove (node);
+}
+
+static BraseroBurnResult
+brasero_libisofs_export_add_directory (gpointer parent,
+				       const gchar *name,
+				       const gchar *uri,
+				       gboolean grafted,
+				       gboolean imported,
+				       gpointer *handle,
+				       gpointer user_data)
+{
+	BraseroLibisofsExport *export = user_data;
+	BraseroLibisofsPrivate *priv;
+	IsoNode *node = NULL;
+	int result;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (export->self);
+	if (priv->cancel)
+		return BRASERO_BURN_CANCEL;
+
+	if (imported) {
+		if (iso_dir_get_node (ISO_DIR (parent), name, &node) != 1
+		||  !node
+		||  iso_node_get_type (node) != LIBISO_DIR) {
+			BRASERO_JOB_LOG (export->self, "No imported directory %s", name);
+			priv->error = g_error_new (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_GENERAL,
+						   /* Translators: %s is the path */
+						   _("No parent could be found in the tree for the path \"%s\""),
+						   name);
+			return BRASERO_BURN_ERR;
+		}
+
+		g_hash_table_insert (export->imported, node, node);
+		*handle = node;
+		return BRASERO_BURN_OK;
+	}
+
+	brasero_libisofs_export_remove_imported (export, ISO_DIR (parent), name);
+
+	/* Like with graft points, directories added by the user get the
+	 * default attributes and their subdirectories those of the local
+	 * ones (as iso_tree_add_dir_rec () would do). */
+	if (uri && !grafted) {
+		gchar *local_path;
+
+		local_path = brasero_libisofs_get_local_path (uri);
+		if (!local_path) {
+			priv->error = g_error_new (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_FILE_NOT_LOCAL,
+						   _("The file is not stored locally"));
+			return BRASERO_BURN_ERR;
+		}
+
+		/* This only creates the directory (with the attributes of
+		 * the local one) not its contents. */
+		result = iso_tree_add_new_node (export->image,
+						ISO_DIR (parent),
+						name,
+						local_path,
+						&node);
+		g_free (local_path);
+	}
+	else {
+		IsoDir *directory = NULL;
+
+		result = iso_tree_add_new_dir (ISO_DIR (parent), name, &directory);
+		node = ISO_NODE (directory);
+	}
+
+	if (result < 0) {
+		BRASERO_JOB_LOG (export->self, "ERROR %s %x", name, result);
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("libisofs reported an error while creating directory \"%s\""),
+					   name);
+		return BRASERO_BURN_ERR;
+	}
+
+	export->nodes ++;
+	*handle = node;
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_libisofs_export_add_file (gpointer parent,
+				  const gchar *name,
+				  const gchar *uri,
+				  gpointer user_data)
+{
+	BraseroLibisofsExport *export = user_data;
+	BraseroLibisofsPrivate *priv;
+	gchar *local_path;
+	IsoNode *node;
+	int result;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (export->self);
+	if (priv->cancel)
+		return BRASERO_BURN_CANCEL;
+
+	local_path = brasero_libisofs_get_local_path (uri);
+	if (!local_path) {
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_FILE_NOT_LOCAL,
+					   _("The file is not stored locally"));
+		return BRASERO_BURN_ERR;
+	}
+
+	brasero_libisofs_export_remove_imported (export, ISO_DIR (parent), name);
+
+	result = iso_tree_add_new_node (export->image,
+					ISO_DIR (parent),
+					name,
+					local_path,
+					&node);
+	g_free (local_path);
+
+	if (result < 0) {
+		BRASERO_JOB_LOG (export->self, "ERROR %s %x", name, result);
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("libisofs reported an error while adding file at path \"%s\""),
+					   name);
+		return BRASERO_BURN_ERR;
+	}
+
+	export->nodes ++;
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_libisofs_snapshot_add_directory (gpointer parent,
+					 const gchar *name,
+					 const gchar *uri,
+					 gboolean grafted,
+					 gboolean imported,
+					 gpointer *handle,
+					 gpointer user_data)
+{
+	BraseroLibisofsNode node;
+	GArray *nodes = user_data;
+
+	node.type = BRASERO_LIBISOFS_NODE_DIRECTORY;
+	node.name = g_strdup (name);
+	node.uri = g_strdup (uri);
+	node.grafted = grafted;
+	node.imported = imported;
+	g_array_append_val (nodes, node);
+
+	/* Only the order of the nodes matters */
+	*handle = nodes;
+	return BRASERO_BURN_OK;
+}
+
+static BraseroBurnResult
+brasero_libisofs_snapshot_add_file (gpointer parent,
+				    const gchar *name,
+				    const gchar *uri,
+				    gpointer user_data)
+{
+	BraseroLibisofsNode node = { NULL, };
+	GArray *nodes = user_data;
+
+	node.type = BRASERO_LIBISOFS_NODE_FILE;
+	node.name = g_strdup (name);
+	node.uri = g_strdup (uri);
+	g_array_append_val (nodes, node);
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_libisofs_snapshot_end_directory (gpointer handle,
+					 gpointer user_data)
+{
+	BraseroLibisofsNode node = { NULL, };
+	GArray *nodes = user_data;
+
+	node.type = BRASERO_LIBISOFS_NODE_END;
+	g_array_append_val (nodes, node);
+}
+
+static void
+brasero_libisofs_free_nodes (BraseroLibisofs *self)
+{
+	BraseroLibisofsPrivate *priv;
+	guint i;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+	if (!priv->nodes)
+		return;
+
+	for (i = 0; i < priv->nodes->len; i ++) {
+		BraseroLibisofsNode *node;
+
+		node = &g_array_index (priv->nodes, BraseroLibisofsNode, i);
+		g_free (node->name);
+		g_free (node->uri);
+	}
+
+	g_array_free (priv->nodes, TRUE);
+	priv->nodes = NULL;
+}
+
+/**
+ * The tree of the track belongs to the main loop so it is copied there
+ * before the thread starts; the thread then adds the nodes from the copy.
+ */
+
+static void
+brasero_libisofs_snapshot_track (BraseroLibisofs *self)
+{
+	BraseroTrackDataVisitor visitor = { NULL, };
+	BraseroLibisofsPrivate *priv;
+	BraseroTrack *track = NULL;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+	brasero_libisofs_free_nodes (self);
+
+	visitor.add_directory = brasero_libisofs_snapshot_add_directory;
+	visitor.add_file = brasero_libisofs_snapshot_add_file;
+	visitor.end_directory = brasero_libisofs_snapshot_end_directory;
+
+	priv->nodes = g_array_new (FALSE, FALSE, sizeof (BraseroLibisofsNode));
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	priv->nodes_result = brasero_track_data_export (BRASERO_TRACK_DATA (track),
+							&visitor,
+							NULL,
+							priv->nodes);
+
+	if (priv->nodes_result != BRASERO_BURN_OK)
+		brasero_libisofs_free_nodes (self);
+}
+
+static BraseroBurnResult
+brasero_libisofs_export_track (BraseroLibisofs *self,
+			       IsoImage *image)
+{
+	BraseroLibisofsExport export;
+	BraseroLibisofsPrivate *priv;
+	BraseroBurnResult result;
+	BraseroBurnFlag flags;
+	GSList *parents;
+	guint i;
+
+	priv = BRASERO_LIBISOFS_PRIVATE (self);
+	if (!priv->nodes)
+		return priv->nodes_result;
+
+	export.self = self;
+	export.image = image;
+	export.nodes = 0;
+	export.imported = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+	/* The root of a merged image comes from the previous session */
+	brasero_job_get_flags (BRASERO_JOB (self), &flags);
+	if (flags & BRASERO_BURN_FLAG_MERGE)
+		g_hash_table_insert (export.imported,
+				     iso_image_get_root (image),
+				     iso_image_get_root (image));
+
+	result = BRASERO_BURN_OK;
+	parents = g_slist_prepend (NULL, iso_image_get_root (image));
+	for (i = 0; i < priv->nodes->len && result == BRASERO_BURN_OK; i ++) {
+		BraseroLibisofsNode *node;
+		gpointer handle = NULL;
+
+		node = &g_array_index (priv->nodes, BraseroLibisofsNode, i);
+		if (node->type == BRASERO_LIBISOFS_NODE_END) {
+			parents = g_slist_delete_link (parents, parents);
+			continue;
+		}
+
+		if (node->type == BRASERO_LIBISOFS_NODE_FILE) {
+			result = brasero_libisofs_export_add_file (parents->data,
+								   node->name,
+								   node->uri,
+								   &export);
+			continue;
+		}
+
+		result = brasero_libisofs_export_add_directory (parents->data,
+								node->name,
+								node->uri,
+								node->grafted,
+								node->imported,
+								&handle,
+								&export);
+		if (result == BRASERO_BURN_OK)
+			parents = g_slist_prepend (parents, handle);
+	}
+
+	g_slist_free (parents);
+	g_hash_table_destroy (export.imported);
+
+	BRASERO_JOB_LOG (self, "%i nodes added", export.nodes);
+	return result;
+}
+
 static gpointer
 brasero_libisofs_create_volume_thread (gpointer data)
 {
@@ -546,7 +906,9 @@ brasero_libisofs_create_volume_thread (gpointer data)
 	BraseroLibisofsPrivate *priv;
 	BraseroTrack *track = NULL;
 	IsoWriteOpts *opts = NULL;
+	BraseroBurnResult result;
 	IsoImage *image = NULL;
+	GTimer *timer = NULL;
 	BraseroBurnFlag flags;
 	GSList *grafts = NULL;
 	gchar *label = NULL;
@@ -578,8 +940,6 @@ brasero_libisofs_create_volume_thread (gpointer data)
 
 	brasero_job_get_flags (BRASERO_JOB (self), &flags);
 	if (flags & BRASERO_BURN_FLAG_MERGE) {
-		BraseroBurnResult result;
-
 		result = brasero_libisofs_import_last_session (self,
 							       image,
 							       opts,
@@ -614,8 +974,27 @@ brasero_libisofs_create_volume_thread (gpointer data)
 
 	brasero_job_start_progress (BRASERO_JOB (self), FALSE);
 
-	/* copy the list as we're going to reorder it */
 	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+
+	/* Add the nodes from the tree of the track directly when possible;
+	 * otherwise use the graft points and let libisofs explore them. */
+	timer = g_timer_new ();
+	result = brasero_libisofs_export_track (self, image);
+	if (result == BRASERO_BURN_OK) {
+		BRASERO_JOB_LOG (self, "Tree exported in %f seconds", g_timer_elapsed (timer, NULL));
+		goto end;
+	}
+
+	if (result != BRASERO_BURN_NOT_SUPPORTED && result != BRASERO_BURN_NOT_READY) {
+		if (!priv->error && !priv->cancel)
+			priv->error = g_error_new (BRASERO_BURN_ERROR,
+						   BRASERO_BURN_ERROR_GENERAL,
+						   "%s",
+						   _("Volume could not be created"));
+		goto end;
+	}
+
+	/* copy the list as we're going to reorder it */
 	grafts = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (track));
 	grafts = g_slist_copy (grafts);
 	grafts = g_slist_sort (grafts, brasero_libisofs_sort_graft_points);
@@ -693,14 +1072,7 @@ brasero_libisofs_create_volume_thread (gpointer data)
 			gchar *local_path;
 			IsoDirIter *sibling;
 
-			/* graft->uri can be a path or a URI */
-			if (graft->uri [0] == '/')
-				local_path = g_strdup (graft->uri);
-			else if (g_str_has_prefix (graft->uri, "file://"))
-				local_path = g_filename_from_uri (graft->uri, NULL, NULL);
-			else
-				local_path = NULL;
-
+			local_path = brasero_libisofs_get_local_path (graft->uri);
 			if (!local_path){
 				priv->error = g_error_new (BRASERO_BURN_ERROR,
 							   BRASERO_BURN_ERROR_FILE_NOT_LOCAL,
@@ -821,8 +1193,13 @@ brasero_libisofs_create_volume_thread (gpointer data)
 
 end:
 
-	if (grafts)
+	if (grafts) {
+		BRASERO_JOB_LOG (self, "Graft points added in %f seconds", g_timer_elapsed (timer, NULL));
 		g_slist_free (grafts);
+	}
+
+	if (timer)
+		g_timer_destroy (timer);
 
 	if (!priv->error && !priv->cancel) {
 		gint64 size;
@@ -854,6 +1231,8 @@ end:
 	if (image)
 		iso_image_unref (image);
 
+	brasero_libisofs_free_nodes (self);
+
 	/* End thread */
 	g_mutex_lock (priv->mutex);
 
@@ -895,6 +1274,9 @@ brasero_libisofs_create_volume (BraseroLibisofs *self, GError **error)
 	}
 
 	iso_set_msgs_severities ("NEVER", "ALL", "brasero (libisofs)");
+
+	brasero_libisofs_snapshot_track (self);
+
 	g_mutex_lock (priv->mutex);
 	priv->thread = g_thread_create (brasero_libisofs_create_volume_thread,
 					self,
@@ -906,6 +1288,7 @@ brasero_libisofs_create_volume (BraseroLibisofs *self, GError **error)
 	//if (!priv->thread)
 	//	return BRASERO_BURN_ERR;
 	if (thread_error) {
+		brasero_libisofs_free_nodes (self);
 		g_propagate_error (error, thread_error);
 		return BRASERO_BURN_ERR;
 	}
@@ -929,6 +1312,8 @@ brasero_libisofs_clean_output (BraseroLibisofs *self)
 		g_error_free (priv->error);
 		priv->error = NULL;
 	}
+
+	brasero_libisofs_free_nodes (self);
 }
 
 static BraseroBurnResult
@@ -109,136 +109,336 @@ brasero_burn_uri_thread_finished (BraseroBurnURI *self)
 	return FALSE;
 }
 
-static gint
-brasero_burn_uri_find_graft (gconstpointer A, gconstpointer B)
+/* Number of threads walking subdirectories at the same time */
+#define BRASERO_BURN_URI_WALKERS	4
+
+/* Number of entries asked at once to an enumerator */
+#define BRASERO_BURN_URI_BATCH		64
+
+struct _BraseroBurnURIWalk {
+	BraseroBurnURI *self;
+	GCancellable *cancel;
+
+	/* Disc paths of the original grafts; read-only once walking */
+	GHashTable *graft_paths;
+
+	GThreadPool *pool;
+	GMutex *mutex;
+	GCond *cond;
+
+	/* Everything below is protected by the mutex */
+	guint pending;
+	GSList *grafts;
+	GError *error;
+};
+typedef struct _BraseroBurnURIWalk BraseroBurnURIWalk;
+
+struct _BraseroBurnURIDirectory {
+	GFile *file;
+	gchar *path;
+};
+typedef struct _BraseroBurnURIDirectory BraseroBurnURIDirectory;
+
+static void
+brasero_burn_uri_walk_push (BraseroBurnURIWalk *walk,
+			    GFile *file,
+			    const gchar *path)
 {
-	const BraseroGraftPt *graft = A;
+	BraseroBurnURIDirectory *directory;
+
+	directory = g_new0 (BraseroBurnURIDirectory, 1);
+	directory->file = g_object_ref (file);
+	directory->path = g_strdup (path);
 
-	if (graft && graft->path)
-		return strcmp (graft->path, B);
+	g_mutex_lock (walk->mutex);
+	walk->pending ++;
+	g_mutex_unlock (walk->mutex);
 
-	return 1;
+	g_thread_pool_push (walk->pool, directory, NULL);
 }
 
-static GSList *
-brasero_burn_uri_explore_directory (BraseroBurnURI *self,
-				    GSList *grafts,
+static gboolean
+brasero_burn_uri_walk_stopped (BraseroBurnURIWalk *walk)
+{
+	gboolean stopped;
+
+	if (g_cancellable_is_cancelled (walk->cancel))
+		return TRUE;
+
+	g_mutex_lock (walk->mutex);
+	stopped = (walk->error != NULL);
+	g_mutex_unlock (walk->mutex);
+
+	return stopped;
+}
+
+static void
+brasero_burn_uri_walk_error (BraseroBurnURIWalk *walk,
+			     GError *error)
+{
+	g_mutex_lock (walk->mutex);
+	if (!walk->error)
+		walk->error = error;
+	else
+		g_error_free (error);
+	g_mutex_unlock (walk->mutex);
+}
+
+/**
+ * NOTE: GIO has no synchronous way to get several entries at once so the
+ * batch is gathered here. That at least limits the number of times the
+ * walk has to check for cancellation and merge its results.
+ */
+
+static GList *
+brasero_burn_uri_next_files (GFileEnumerator *enumerator,
+			     GCancellable *cancel,
+			     GError **error)
+{
+	GList *infos = NULL;
+	GFileInfo *info;
+	guint num = 0;
+
+	while (num < BRASERO_BURN_URI_BATCH
+	&&    (info = g_file_enumerator_next_file (enumerator, cancel, error))) {
+		infos = g_list_prepend (infos, info);
+		num ++;
+	}
+
+	return g_list_reverse (infos);
+}
+
+static gboolean
+brasero_burn_uri_explore_info (BraseroBurnURIWalk *walk,
+			       GFile *file,
+			       const gchar *path,
+			       GFileInfo *info,
+			       GSList **grafts,
+			       GError **error)
+{
+	BraseroBurnURI *self = walk->self;
+
+	if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
+		gchar *disc_path;
+		GFile *directory;
+		BraseroGraftPt *graft;
+
+		/* Make sure it's not one of the original grafts */
+		/* we need to know if that's a directory or not since if
+		 * it is then mkisofs (but not genisoimage) requires the
+		 * disc path to end with '/'; if there isn't '/' at the 
+		 * end then only the directory contents are added. */
+		disc_path = g_build_filename (path, g_file_info_get_name (info), G_DIR_SEPARATOR_S, NULL);
+		if (g_hash_table_lookup (walk->graft_paths, disc_path)) {
+			BRASERO_JOB_LOG (self, "Graft already in list %s", disc_path);
+			g_free (disc_path);
+			return TRUE;
+		}
+
+		/* we need a dummy directory */
+		graft = g_new0 (BraseroGraftPt, 1);
+		graft->uri = NULL;
+		graft->path = disc_path;
+		*grafts = g_slist_prepend (*grafts, graft);
+
+		BRASERO_JOB_LOG (self, "Adding directory %s at %s", graft->uri, graft->path);
+
+		/* Its contents are independent from the rest of the tree */
+		directory = g_file_get_child (file, g_file_info_get_name (info));
+		brasero_burn_uri_walk_push (walk, directory, graft->path);
+		g_object_unref (directory);
+	}
+	else if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
+	     /* NOTE: burn:// URI allows symlink */
+	     ||  g_file_info_get_file_type (info) == G_FILE_TYPE_SYMBOLIC_LINK) {
+		const gchar *real_path;
+		BraseroGraftPt *graft;
+		gchar *disc_path;
+
+		real_path = g_file_info_get_attribute_byte_string (info, "burn::backing-file");
+		if (!real_path) {
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Impossible to retrieve local file path"));
+			return FALSE;
+		}
+
+		/* Make sure it's not one of the original grafts */
+		disc_path = g_build_filename (path, g_file_info_get_name (info), NULL);
+		if (g_hash_table_lookup (walk->graft_paths, disc_path)) {
+			BRASERO_JOB_LOG (self, "Graft already in list %s", disc_path);
+			g_free (disc_path);
+			return TRUE;
+		}
+
+		graft = g_new0 (BraseroGraftPt, 1);
+		graft->path = disc_path;
+		graft->uri = g_strdup (real_path);
+		/* FIXME: maybe one day, graft->uri will always be an URI */
+		/* graft->uri = g_filename_to_uri (real_path, NULL, NULL); */
+
+		*grafts = g_slist_prepend (*grafts, graft);
+
+		BRASERO_JOB_LOG (self, "Added file %s at %s", graft->uri, graft->path);
+	}
+
+	return TRUE;
+}
+
+static void
+brasero_burn_uri_explore_directory (BraseroBurnURIWalk *walk,
 				    GFile *file,
-				    const gchar *path,
-				    GCancellable *cancel,
-				    GError **error)
+				    const gchar *path)
 {
-	BraseroTrack *current = NULL;
 	GFileEnumerator *enumerator;
-	GSList *current_grafts;
-	GFileInfo *info;
+	GSList *grafts = NULL;
+	GError *error = NULL;
+	GList *infos;
 
 	enumerator = g_file_enumerate_children (file,
 						G_FILE_ATTRIBUTE_STANDARD_NAME ","
 						G_FILE_ATTRIBUTE_STANDARD_TYPE ","
 						"burn::backing-file",
 						G_FILE_QUERY_INFO_NONE,
-						cancel,
-						error);
-
+						walk->cancel,
+						&error);
 	if (!enumerator) {
-		g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
-		g_slist_free (grafts);
-		return NULL;
+		brasero_burn_uri_walk_error (walk, error);
+		return;
 	}
 
-	brasero_job_get_current_track (BRASERO_JOB (self), &current);
-	current_grafts = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (current));
+	while ((infos = brasero_burn_uri_next_files (enumerator, walk->cancel, &error))) {
+		GList *iter;
 
-	while ((info = g_file_enumerator_next_file (enumerator, cancel, error))) {
-		if (g_file_info_get_file_type (info) == G_FILE_TYPE_DIRECTORY) {
-			gchar *disc_path;
-			GFile *directory;
-			BraseroGraftPt *graft;
+		for (iter = infos; iter; iter = iter->next) {
+			GFileInfo *info;
 
-			/* Make sure it's not one of the original grafts */
-			/* we need to know if that's a directory or not since if
-			 * it is then mkisofs (but not genisoimage) requires the
-			 * disc path to end with '/'; if there isn't '/' at the 
-			 * end then only the directory contents are added. */
-			disc_path = g_build_filename (path, g_file_info_get_name (info), G_DIR_SEPARATOR_S, NULL);
-			if (g_slist_find_custom (current_grafts, disc_path, (GCompareFunc) brasero_burn_uri_find_graft)) {
-				BRASERO_JOB_LOG (self, "Graft already in list %s", disc_path);
-				g_object_unref (info);
-				g_free (disc_path);
-				continue;
-			}
+			info = iter->data;
+			if (!error)
+				brasero_burn_uri_explore_info (walk,
+							       file,
+							       path,
+							       info,
+							       &grafts,
+							       &error);
+			g_object_unref (info);
+		}
+		g_list_free (infos);
 
-			/* we need a dummy directory */
-			graft = g_new0 (BraseroGraftPt, 1);
-			graft->uri = NULL;
-			graft->path = disc_path;
-			grafts = g_slist_prepend (grafts, graft);
+		if (error || brasero_burn_uri_walk_stopped (walk))
+			break;
+	}
+	g_object_unref (enumerator);
 
-			BRASERO_JOB_LOG (self, "Adding directory %s at %s", graft->uri, graft->path);
+	g_mutex_lock (walk->mutex);
+	walk->grafts = g_slist_concat (grafts, walk->grafts);
+	g_mutex_unlock (walk->mutex);
 
-			directory = g_file_get_child (file, g_file_info_get_name (info));
-			grafts = brasero_burn_uri_explore_directory (self,
-								     grafts,
-								     directory,
-								     graft->path,
-								     cancel,
-								     error);
-			g_object_unref (directory);
+	if (error)
+		brasero_burn_uri_walk_error (walk, error);
+}
 
-			if (!grafts) {
-				g_object_unref (info);
-				g_object_unref (enumerator);
-				return NULL;
-			}
-		}
-		else if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
-		     /* NOTE: burn:// URI allows symlink */
-		     ||  g_file_info_get_file_type (info) == G_FILE_TYPE_SYMBOLIC_LINK) {
-			const gchar *real_path;
-			BraseroGraftPt *graft;
-			gchar *disc_path;
+static void
+brasero_burn_uri_walk_thread (gpointer data,
+			      gpointer user_data)
+{
+	BraseroBurnURIDirectory *directory = data;
+	BraseroBurnURIWalk *walk = user_data;
+
+	if (!brasero_burn_uri_walk_stopped (walk))
+		brasero_burn_uri_explore_directory (walk,
+						    directory->file,
+						    directory->path);
+
+	g_object_unref (directory->file);
+	g_free (directory->path);
+	g_free (directory);
+
+	g_mutex_lock (walk->mutex);
+	walk->pending --;
+	if (!walk->pending)
+		g_cond_signal (walk->cond);
+	g_mutex_unlock (walk->mutex);
+}
 
-			real_path = g_file_info_get_attribute_byte_string (info, "burn::backing-file");
-			if (!real_path) {
-				g_set_error (error,
-					     BRASERO_BURN_ERROR,
-					     BRASERO_BURN_ERROR_GENERAL,
-					     _("Impossible to retrieve local file path"));
+static BraseroBurnURIWalk *
+brasero_burn_uri_walk_new (BraseroBurnURI *self,
+			   GSList *current_grafts,
+			   GCancellable *cancel,
+			   GError **error)
+{
+	BraseroBurnURIWalk *walk;
 
-				g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
-				g_slist_free (grafts);
-				g_object_unref (info);
-				g_object_unref (file);
-				return NULL;
-			}
+	walk = g_new0 (BraseroBurnURIWalk, 1);
+	walk->pool = g_thread_pool_new (brasero_burn_uri_walk_thread,
+					walk,
+					BRASERO_BURN_URI_WALKERS,
+					FALSE,
+					error);
+	if (!walk->pool) {
+		g_free (walk);
+		return NULL;
+	}
 
-			/* Make sure it's not one of the original grafts */
-			disc_path = g_build_filename (path, g_file_info_get_name (info), NULL);
-			if (g_slist_find_custom (current_grafts, disc_path, (GCompareFunc) brasero_burn_uri_find_graft)) {
-				BRASERO_JOB_LOG (self, "Graft already in list %s", disc_path);
-				g_object_unref (info);
-				g_free (disc_path);
-				continue;
-			}
+	walk->self = self;
+	walk->cancel = cancel;
+	walk->mutex = g_mutex_new ();
+	walk->cond = g_cond_new ();
 
-			graft = g_new0 (BraseroGraftPt, 1);
-			graft->path = disc_path;
-			graft->uri = g_strdup (real_path);
-			/* FIXME: maybe one day, graft->uri will always be an URI */
-			/* graft->uri = g_filename_to_uri (real_path, NULL, NULL); */
+	/* Index the original grafts once so that looking one up while
+	 * walking the tree doesn't depend on their number */
+	walk->graft_paths = g_hash_table_new (g_str_hash, g_str_equal);
+	for (; current_grafts; current_grafts = current_grafts->next) {
+		BraseroGraftPt *graft;
 
-			/* Make sure it's not one of the original grafts */
-			
-			grafts = g_slist_prepend (grafts, graft);
+		graft = current_grafts->data;
+		if (graft && graft->path)
+			g_hash_table_insert (walk->graft_paths, graft->path, graft);
+	}
 
-			BRASERO_JOB_LOG (self, "Added file %s at %s", graft->uri, graft->path);
-		}
+	return walk;
+}
 
-		g_object_unref (info);
+static gint
+brasero_burn_uri_sort_graft (gconstpointer A, gconstpointer B)
+{
+	const BraseroGraftPt *graft_a = A;
+	const BraseroGraftPt *graft_b = B;
+
+	return strcmp (graft_a->path, graft_b->path);
+}
+
+/**
+ * Waits for all the subtrees to be walked and returns the grafts found
+ * sorted by path, so that a directory always comes before its contents.
+ */
+
+static GSList *
+brasero_burn_uri_walk_finish (BraseroBurnURIWalk *walk,
+			      GError **error)
+{
+	GSList *grafts;
+
+	g_mutex_lock (walk->mutex);
+	while (walk->pending)
+		g_cond_wait (walk->cond, walk->mutex);
+	g_mutex_unlock (walk->mutex);
+
+	g_thread_pool_free (walk->pool, FALSE, TRUE);
+	g_hash_table_destroy (walk->graft_paths);
+	g_mutex_free (walk->mutex);
+	g_cond_free (walk->cond);
+
+	grafts = g_slist_sort (walk->grafts, brasero_burn_uri_sort_graft);
+	if (walk->error) {
+		g_propagate_error (error, walk->error);
+		g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
+		g_slist_free (grafts);
+		grafts = NULL;
 	}
-	g_object_unref (enumerator);
 
+	g_free (walk);
 	return grafts;
 }
 
@@ -315,8 +515,11 @@ brasero_burn_uri_thread (gpointer data)
 	BraseroTrack *current = NULL;
 	BraseroBurnURIPrivate *priv;
 	BraseroTrackData *track;
+	BraseroBurnURIWalk *walk;
+	GSList *explored = NULL;
 	GSList *excluded = NULL;
 	GSList *grafts = NULL;
+	GTimer *timer;
 	guint64 num = 0;
 	GSList *src;
 
@@ -374,6 +577,15 @@ brasero_burn_uri_thread (gpointer data)
 	}
 
 	/* This is for DATA tracks */
+	walk = brasero_burn_uri_walk_new (self,
+					  brasero_track_data_get_grafts (BRASERO_TRACK_DATA (current)),
+					  priv->cancel,
+					  &priv->error);
+	if (!walk)
+		goto end;
+
+	timer = g_timer_new ();
+
 	for (src = brasero_track_data_get_grafts (BRASERO_TRACK_DATA (current)); src; src = src->next) {
 		GFile *file;
 		GFileInfo *info;
@@ -402,21 +614,12 @@ brasero_burn_uri_thread (gpointer data)
 					  priv->cancel,
 					  &priv->error);
 
-		if (priv->error) {
-			g_object_unref (file);
-			goto end;
-		}
-
-		if (g_cancellable_is_cancelled (priv->cancel)) {
-			g_object_unref (file);
-			goto end;
-		}
+		if (!info || g_cancellable_is_cancelled (priv->cancel)) {
+			if (info)
+				g_object_unref (info);
 
-		if (!info) {
-			/* Error */
 			g_object_unref (file);
-			g_object_unref (info);
-			goto end;
+			break;
 		}
 
 		/* See if we were passed the burn:/// uri itself (the root).
@@ -436,27 +639,11 @@ brasero_burn_uri_thread (gpointer data)
 						 "Adding directory %s at %s",
 						 newgraft->uri,
 						 newgraft->path);
-				grafts = brasero_burn_uri_explore_directory (self,
-									     grafts,
-									     file,
-									     newgraft->path,
-									     priv->cancel,
-									     &priv->error);
+				brasero_burn_uri_walk_push (walk, file, newgraft->path);
 			}
 			else {
 				BRASERO_JOB_LOG (self, "Directory is root");
-				grafts = brasero_burn_uri_explore_directory (self,
-									     grafts,
-									     file,
-									     "/",
-									     priv->cancel,
-									     &priv->error);
-			}
-
-			if (!grafts) {
-				g_object_unref (info);
-				g_object_unref (file);
-				goto end;
+				brasero_burn_uri_walk_push (walk, file, "/");
 			}
 		}
 		else if (g_file_info_get_file_type (info) == G_FILE_TYPE_REGULAR
@@ -471,11 +658,9 @@ brasero_burn_uri_thread (gpointer data)
 							   BRASERO_BURN_ERROR_GENERAL,
 							   _("Impossible to retrieve local file path"));
 
-				g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
-				g_slist_free (grafts);
 				g_object_unref (info);
 				g_object_unref (file);
-				goto end;
+				break;
 			}
 
 			newgraft = brasero_graft_point_copy (graft);
@@ -495,7 +680,27 @@ brasero_burn_uri_thread (gpointer data)
 		g_object_unref (info);
 		g_object_unref (file);
 	}
+
+	/* Subtrees are walked in parallel while the grafts are checked */
+	explored = brasero_burn_uri_walk_finish (walk, priv->error? NULL:&priv->error);
+
+	if (priv->error || g_cancellable_is_cancelled (priv->cancel)) {
+		g_slist_foreach (explored, (GFunc) brasero_graft_point_free, NULL);
+		g_slist_free (explored);
+		g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
+		g_slist_free (grafts);
+		g_timer_destroy (timer);
+		goto end;
+	}
+
+	BRASERO_JOB_LOG (self,
+			 "%i grafts found in burn:// directories in %lf seconds",
+			 g_slist_length (explored),
+			 g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+
 	grafts = g_slist_reverse (grafts);
+	grafts = g_slist_concat (grafts, explored);
 
 	/* remove all excluded starting by burn:// from the list */
 	for (src = brasero_track_data_get_excluded_list (BRASERO_TRACK_DATA (current)); src; src = src->next) {
@@ -0,0 +1,373 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+
+#include <glib.h>
+#include <glib/gi18n-lib.h>
+
+#include "brasero-error.h"
+#include "burn-rescue-map.h"
+
+/* Map files store positions in bytes like ddrescue does */
+#define BRASERO_RESCUE_SECTOR_SIZE	2048ULL
+
+struct _BraseroRescueRange {
+	guint64 start;
+	guint64 size;
+	BraseroRescueStatus status;
+};
+typedef struct _BraseroRescueRange BraseroRescueRange;
+
+/**
+ * The ranges are sorted, contiguous and cover all the sectors. Two adjacent
+ * ranges never have the same status.
+ */
+
+struct _BraseroRescueMap {
+	GArray *ranges;
+	guint64 sectors;
+};
+
+static void
+brasero_rescue_map_append (GArray *ranges,
+			   guint64 start,
+			   guint64 size,
+			   BraseroRescueStatus status)
+{
+	BraseroRescueRange range;
+
+	if (!size)
+		return;
+
+	if (ranges->len) {
+		BraseroRescueRange *last;
+
+		last = &g_array_index (ranges, BraseroRescueRange, ranges->len - 1);
+		if (last->status == status) {
+			last->size += size;
+			return;
+		}
+	}
+
+	range.start = start;
+	range.size = size;
+	range.status = status;
+	g_array_append_val (ranges, range);
+}
+
+BraseroRescueMap *
+brasero_rescue_map_new (guint64 sectors)
+{
+	BraseroRescueMap *map;
+
+	map = g_new0 (BraseroRescueMap, 1);
+	map->sectors = sectors;
+	map->ranges = g_array_new (FALSE, FALSE, sizeof (BraseroRescueRange));
+	brasero_rescue_map_append (map->ranges, 0, sectors, BRASERO_RESCUE_NON_TRIED);
+	return map;
+}
+
+void
+brasero_rescue_map_free (BraseroRescueMap *map)
+{
+	g_array_free (map->ranges, TRUE);
+	g_free (map);
+}
+
+void
+brasero_rescue_map_set (BraseroRescueMap *map,
+			guint64 start,
+			guint64 size,
+			BraseroRescueStatus status)
+{
+	gboolean inserted = FALSE;
+	GArray *ranges;
+	guint64 end;
+	guint i;
+
+	end = MIN (start + size, map->sectors);
+	if (start >= end)
+		return;
+
+	ranges = g_array_sized_new (FALSE,
+				    FALSE,
+				    sizeof (BraseroRescueRange),
+				    map->ranges->len + 2);
+
+	for (i = 0; i < map->ranges->len; i ++) {
+		BraseroRescueRange *range;
+		guint64 range_end;
+
+		range = &g_array_index (map->ranges, BraseroRescueRange, i);
+		range_end = range->start + range->size;
+
+		if (range_end <= start || range->start >= end) {
+			brasero_rescue_map_append (ranges,
+						   range->start,
+						   range->size,
+						   range->status);
+			continue;
+		}
+
+		if (range->start < start)
+			brasero_rescue_map_append (ranges,
+						   range->start,
+						   start - range->start,
+						   range->status);
+
+		if (!inserted) {
+			brasero_rescue_map_append (ranges, start, end - start, status);
+			inserted = TRUE;
+		}
+
+		if (range_end > end)
+			brasero_rescue_map_append (ranges,
+						   end,
+						   range_end - end,
+						   range->status);
+	}
+
+	g_array_free (map->ranges, TRUE);
+	map->ranges = ranges;
+}
+
+/**
+ * Finds the first range with @status ending after @from. The range returned
+ * is clipped so that it doesn't start before @from.
+ */
+
+gboolean
+brasero_rescue_map_find (BraseroRescueMap *map,
+			 BraseroRescueStatus status,
+			 guint64 from,
+			 guint64 *start,
+			 guint64 *size)
+{
+	guint i;
+
+	for (i = 0; i < map->ranges->len; i ++) {
+		BraseroRescueRange *range;
+		guint64 range_end;
+
+		range = &g_array_index (map->ranges, BraseroRescueRange, i);
+		range_end = range->start + range->size;
+		if (range->status != status || range_end <= from)
+			continue;
+
+		*start = MAX (range->start, from);
+		*size = range_end - *start;
+		return TRUE;
+	}
+
+	return FALSE;
+}
+
+guint64
+brasero_rescue_map_count (BraseroRescueMap *map,
+			  BraseroRescueStatus status)
+{
+	guint64 count = 0;
+	guint i;
+
+	for (i = 0; i < map->ranges->len; i ++) {
+		BraseroRescueRange *range;
+
+		range = &g_array_index (map->ranges, BraseroRescueRange, i);
+		if (range->status == status)
+			count += range->size;
+	}
+
+	return count;
+}
+
+gchar *
+brasero_rescue_map_to_string (BraseroRescueMap *map,
+			      BraseroRescueStatus pass)
+{
+	guint64 position = map->sectors;
+	GString *string;
+	guint i;
+
+	/* The current position is the first sector not read yet */
+	for (i = 0; i < map->ranges->len; i ++) {
+		BraseroRescueRange *range;
+
+		range = &g_array_index (map->ranges, BraseroRescueRange, i);
+		if (range->status != BRASERO_RESCUE_FINISHED) {
+			position = range->start;
+			break;
+		}
+	}
+
+	string = g_string_new ("# Rescue map file created by Brasero\n");
+	g_string_append (string, "# current_pos  current_status\n");
+	g_string_append_printf (string,
+				"0x%08" G_GINT64_MODIFIER "X     %c\n",
+				position * BRASERO_RESCUE_SECTOR_SIZE,
+				pass);
+
+	g_string_append (string, "#      pos        size  status\n");
+	for (i = 0; i < map->ranges->len; i ++) {
+		BraseroRescueRange *range;
+
+		range = &g_array_index (map->ranges, BraseroRescueRange, i);
+		g_string_append_printf (string,
+					"0x%08" G_GINT64_MODIFIER "X  0x%08" G_GINT64_MODIFIER "X  %c\n",
+					range->start * BRASERO_RESCUE_SECTOR_SIZE,
+					range->size * BRASERO_RESCUE_SECTOR_SIZE,
+					range->status);
+	}
+
+	return g_string_free (string, FALSE);
+}
+
+gboolean
+brasero_rescue_map_save (BraseroRescueMap *map,
+			 const gchar *path,
+			 BraseroRescueStatus pass,
+			 GError **error)
+{
+	gboolean success;
+	gchar *contents;
+
+	contents = brasero_rescue_map_to_string (map, pass);
+	success = g_file_set_contents (path, contents, -1, error);
+	g_free (contents);
+
+	return success;
+}
+
+/**
+ * Loads a map written by a previous run. The map must cover exactly the
+ * same number of sectors.
+ */
+
+BraseroRescueMap *
+brasero_rescue_map_load (const gchar *path,
+			 guint64 sectors,
+			 GError **error)
+{
+	gboolean current_line = TRUE;
+	BraseroRescueMap *map;
+	gchar *contents;
+	guint64 next = 0;
+	gchar **lines;
+	guint i;
+
+	if (!g_file_get_contents (path, &contents, NULL, error))
+		return NULL;
+
+	map = g_new0 (BraseroRescueMap, 1);
+	map->sectors = sectors;
+	map->ranges = g_array_new (FALSE, FALSE, sizeof (BraseroRescueRange));
+
+	lines = g_strsplit (contents, "\n", -1);
+	g_free (contents);
+
+	for (i = 0; lines [i]; i ++) {
+		BraseroRescueStatus status;
+		guint64 start, size;
+		gchar *line;
+		gchar *end;
+
+		line = g_strstrip (lines [i]);
+		if (line [0] == '\0' || line [0] == '#')
+			continue;
+
+		/* The first line is the position/status of the last run */
+		if (current_line) {
+			current_line = FALSE;
+			continue;
+		}
+
+		start = g_ascii_strtoull (line, &end, 0);
+		if (end == line)
+			goto error;
+
+		line = end;
+		size = g_ascii_strtoull (line, &end, 0);
+		if (end == line)
+			goto error;
+
+		line = g_strchug (end);
+		switch (line [0]) {
+			case '?':
+				status = BRASERO_RESCUE_NON_TRIED;
+				break;
+			/* ddrescue uses '/' for sectors it has not scraped yet */
+			case '*':
+			case '/':
+				status = BRASERO_RESCUE_NON_TRIMMED;
+				break;
+			case '-':
+				status = BRASERO_RESCUE_BAD_SECTOR;
+				break;
+			case '+':
+				status = BRASERO_RESCUE_FINISHED;
+				break;
+			default:
+				goto error;
+		}
+
+		if (start % BRASERO_RESCUE_SECTOR_SIZE
+		||  size % BRASERO_RESCUE_SECTOR_SIZE
+		||  start / BRASERO_RESCUE_SECTOR_SIZE != next)
+			goto error;
+
+		brasero_rescue_map_append (map->ranges,
+					   next,
+					   size / BRASERO_RESCUE_SECTOR_SIZE,
+					   status);
+		next += size / BRASERO_RESCUE_SECTOR_SIZE;
+	}
+
+	if (next != sectors)
+		goto error;
+
+	g_strfreev (lines);
+	return map;
+
+error:
+
+	g_strfreev (lines);
+	brasero_rescue_map_free (map);
+
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_GENERAL,
+		     _("\"%s\" is not a valid map for this disc"),
+		     path);
+	return NULL;
+}
@@ -0,0 +1,88 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+ 
+#ifndef _BURN_RESCUE_MAP_H
+#define _BURN_RESCUE_MAP_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* Same characters as the ones used by ddrescue in its map files */
+typedef enum {
+	BRASERO_RESCUE_NON_TRIED	= '?',
+	BRASERO_RESCUE_NON_TRIMMED	= '*',
+	BRASERO_RESCUE_BAD_SECTOR	= '-',
+	BRASERO_RESCUE_FINISHED		= '+'
+} BraseroRescueStatus;
+
+typedef struct _BraseroRescueMap BraseroRescueMap;
+
+BraseroRescueMap *
+brasero_rescue_map_new (guint64 sectors);
+
+BraseroRescueMap *
+brasero_rescue_map_load (const gchar *path,
+			 guint64 sectors,
+			 GError **error);
+
+gboolean
+brasero_rescue_map_save (BraseroRescueMap *map,
+			 const gchar *path,
+			 BraseroRescueStatus pass,
+			 GError **error);
+
+void
+brasero_rescue_map_free (BraseroRescueMap *map);
+
+void
+brasero_rescue_map_set (BraseroRescueMap *map,
+			guint64 start,
+			guint64 size,
+			BraseroRescueStatus status);
+
+gboolean
+brasero_rescue_map_find (BraseroRescueMap *map,
+			 BraseroRescueStatus status,
+			 guint64 from,
+			 guint64 *start,
+			 guint64 *size);
+
+guint64
+brasero_rescue_map_count (BraseroRescueMap *map,
+			  BraseroRescueStatus status);
+
+gchar *
+brasero_rescue_map_to_string (BraseroRescueMap *map,
+			      BraseroRescueStatus pass);
+
+G_END_DECLS
+
+#endif /* _BURN_RESCUE_MAP_H */
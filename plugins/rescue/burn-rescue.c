@@ -0,0 +1,1061 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <glib.h>
+#include <glib-object.h>
+#include <glib/gstdio.h>
+#include <glib/gi18n-lib.h>
+#include <gmodule.h>
+
+#include "scsi-device.h"
+#include "scsi-mmc1.h"
+
+#include "burn-job.h"
+#include "brasero-plugin-registration.h"
+#include "brasero-tags.h"
+#include "brasero-drive.h"
+#include "brasero-medium.h"
+#include "brasero-track-image.h"
+#include "brasero-track-disc.h"
+
+#include "burn-rescue-map.h"
+
+
+#define BRASERO_TYPE_RESCUE         (brasero_rescue_get_type ())
+#define BRASERO_RESCUE(o)           (G_TYPE_CHECK_INSTANCE_CAST ((o), BRASERO_TYPE_RESCUE, BraseroRescue))
+#define BRASERO_RESCUE_CLASS(k)     (G_TYPE_CHECK_CLASS_CAST((k), BRASERO_TYPE_RESCUE, BraseroRescueClass))
+#define BRASERO_IS_RESCUE(o)        (G_TYPE_CHECK_INSTANCE_TYPE ((o), BRASERO_TYPE_RESCUE))
+#define BRASERO_IS_RESCUE_CLASS(k)  (G_TYPE_CHECK_CLASS_TYPE ((k), BRASERO_TYPE_RESCUE))
+#define BRASERO_RESCUE_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), BRASERO_TYPE_RESCUE, BraseroRescueClass))
+
+BRASERO_PLUGIN_BOILERPLATE (BraseroRescue, brasero_rescue, BRASERO_TYPE_JOB, BraseroJob);
+
+struct _BraseroRescuePrivate {
+	GError *error;
+	GThread *thread;
+	GMutex *mutex;
+	GCond *cond;
+	guint thread_id;
+
+	gint block_size;
+	gint retries;
+
+	guint cancel:1;
+};
+typedef struct _BraseroRescuePrivate BraseroRescuePrivate;
+
+#define BRASERO_RESCUE_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), BRASERO_TYPE_RESCUE, BraseroRescuePrivate))
+
+#define BRASERO_SCHEMA_CONFIG		"org.gnome.brasero.config"
+#define BRASERO_KEY_RESCUE_BLOCKS	"rescue-block-size"
+#define BRASERO_KEY_RESCUE_RETRIES	"rescue-retries"
+
+/* Number of sectors read at once in the first pass (default, min, max) */
+#define BRASERO_RESCUE_I_BLOCKS		32
+#define BRASERO_RESCUE_MIN_BLOCKS	2
+#define BRASERO_RESCUE_MAX_BLOCKS	256
+
+/* Number of reads of a bad sector at each speed (default, min, max) */
+#define BRASERO_RESCUE_I_RETRIES	4
+#define BRASERO_RESCUE_MIN_RETRIES	0
+#define BRASERO_RESCUE_MAX_RETRIES	32
+
+#define BRASERO_RESCUE_SECTOR_SIZE	2048
+#define BRASERO_RESCUE_RAW_SIZE		(BRASERO_RESCUE_SECTOR_SIZE + BRASERO_SCSI_C2_POINTERS_SIZE)
+
+/* The map is saved at most every 10 seconds while reading */
+#define BRASERO_RESCUE_SAVE_INTERVAL	(10 * G_USEC_PER_SEC)
+
+/* Read speeds (in kB/s) used in turn on bad sectors: maximum, 8x, 4x, 1x */
+static const gint rescue_speeds [] = { 0xFFFF, 1411, 706, 176 };
+
+static GObjectClass *parent_class = NULL;
+
+struct _BraseroRescueCtx {
+	BraseroRescue *self;
+	BraseroDeviceHandle *handle;
+
+	BraseroRescueMap *map;
+	gchar *map_path;
+	gint64 last_save;
+
+	int fd;
+
+	/* First sector read on the disc and number of sectors */
+	goffset start;
+	goffset sectors;
+
+	/* READ CD output (user data + C2 pointers), user data only and
+	 * whether C2 pointers flagged each sector */
+	guchar *raw;
+	guchar *data;
+	gboolean *c2;
+
+	guint64 c2_sectors;
+	guint speed;
+
+	/* Mode 1 or Mode 2 Form 1 */
+	BraseroScsiBlockType block_type;
+
+	guint use_c2:1;
+};
+typedef struct _BraseroRescueCtx BraseroRescueCtx;
+
+static void
+brasero_rescue_get_range (BraseroRescue *self,
+			  goffset *start,
+			  goffset *sectors)
+{
+	BraseroMedium *medium;
+	GValue *value = NULL;
+	BraseroTrack *track;
+	BraseroDrive *drive;
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+	medium = brasero_drive_get_medium (drive);
+
+	brasero_track_tag_lookup (track,
+				  BRASERO_TRACK_MEDIUM_ADDRESS_START_TAG,
+				  &value);
+	if (value) {
+		*start = g_value_get_uint64 (value);
+
+		value = NULL;
+		brasero_track_tag_lookup (track,
+					  BRASERO_TRACK_MEDIUM_ADDRESS_END_TAG,
+					  &value);
+		*sectors = g_value_get_uint64 (value) - *start;
+	}
+	else if (brasero_track_disc_get_track_num (BRASERO_TRACK_DISC (track)) > 0) {
+		guint num;
+
+		num = brasero_track_disc_get_track_num (BRASERO_TRACK_DISC (track));
+		brasero_medium_get_track_address (medium, num, NULL, start);
+		brasero_medium_get_track_space (medium, num, NULL, sectors);
+	}
+	else {
+		/* Like readcd, only read the last data track */
+		brasero_medium_get_last_data_track_address (medium, NULL, start);
+		brasero_medium_get_last_data_track_space (medium, NULL, sectors);
+	}
+}
+
+static gboolean
+brasero_rescue_thread_finished (gpointer data)
+{
+	goffset blocks = 0;
+	gchar *image = NULL;
+	BraseroRescue *self = data;
+	BraseroRescuePrivate *priv;
+	BraseroTrackImage *track = NULL;
+
+	priv = BRASERO_RESCUE_PRIVATE (self);
+	priv->thread_id = 0;
+
+	if (priv->error) {
+		GError *error;
+
+		error = priv->error;
+		priv->error = NULL;
+		brasero_job_error (BRASERO_JOB (self), error);
+		return FALSE;
+	}
+
+	track = brasero_track_image_new ();
+	brasero_job_get_image_output (BRASERO_JOB (self),
+				      &image,
+				      NULL);
+	brasero_track_image_set_source (track,
+					image,
+					NULL,
+					BRASERO_IMAGE_FORMAT_BIN);
+
+	brasero_job_get_session_output_size (BRASERO_JOB (self), &blocks, NULL);
+	brasero_track_image_set_block_num (track, blocks);
+
+	brasero_job_add_track (BRASERO_JOB (self), BRASERO_TRACK (track));
+	g_object_unref (track);
+
+	brasero_job_finished_track (BRASERO_JOB (self));
+	return FALSE;
+}
+
+/**
+ * Errors which mean there is no point going on reading
+ */
+
+static gboolean
+brasero_rescue_is_fatal (BraseroScsiErrCode code)
+{
+	return (code == BRASERO_SCSI_NO_MEDIUM
+	    ||  code == BRASERO_SCSI_ERRNO
+	    ||  code == BRASERO_SCSI_NOT_READY);
+}
+
+static gboolean
+brasero_rescue_c2_flagged (const guchar *pointers)
+{
+	guint i;
+
+	for (i = 0; i < BRASERO_SCSI_C2_POINTERS_SIZE; i ++) {
+		if (pointers [i])
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/**
+ * Reads @num sectors into ctx->data. When the drive supports them, C2 error
+ * pointers are requested as well and ctx->c2 tells which sectors had some.
+ */
+
+static BraseroScsiResult
+brasero_rescue_read_real (BraseroRescueCtx *ctx,
+			  guint64 sector,
+			  guint num,
+			  guint *c2_errors,
+			  BraseroScsiErrCode *code)
+{
+	BraseroScsiResult result;
+	guint i;
+
+	*c2_errors = 0;
+	*code = BRASERO_SCSI_ERROR_NONE;
+
+	if (ctx->use_c2) {
+		result = brasero_mmc1_read_block_c2 (ctx->handle,
+						     ctx->block_type,
+						     ctx->start + sector,
+						     num,
+						     ctx->raw,
+						     num * BRASERO_RESCUE_RAW_SIZE,
+						     code);
+		if (result == BRASERO_SCSI_OK) {
+			for (i = 0; i < num; i ++) {
+				guchar *raw;
+
+				raw = ctx->raw + i * BRASERO_RESCUE_RAW_SIZE;
+				memcpy (ctx->data + i * BRASERO_RESCUE_SECTOR_SIZE,
+					raw,
+					BRASERO_RESCUE_SECTOR_SIZE);
+
+				ctx->c2 [i] = brasero_rescue_c2_flagged (raw + BRASERO_RESCUE_SECTOR_SIZE);
+				if (ctx->c2 [i])
+					(*c2_errors) ++;
+			}
+
+			return BRASERO_SCSI_OK;
+		}
+
+		if (*code != BRASERO_SCSI_INVALID_FIELD
+		&&  *code != BRASERO_SCSI_INVALID_COMMAND)
+			return result;
+
+		BRASERO_JOB_LOG (ctx->self, "Drive doesn't report C2 error pointers");
+		ctx->use_c2 = FALSE;
+		*code = BRASERO_SCSI_ERROR_NONE;
+	}
+
+	result = brasero_mmc1_read_block (ctx->handle,
+					  TRUE,
+					  ctx->block_type,
+					  BRASERO_SCSI_BLOCK_HEADER_NONE,
+					  BRASERO_SCSI_BLOCK_NO_SUBCHANNEL,
+					  ctx->start + sector,
+					  num,
+					  ctx->data,
+					  num * BRASERO_RESCUE_SECTOR_SIZE,
+					  code);
+	if (result == BRASERO_SCSI_OK)
+		memset (ctx->c2, 0, num * sizeof (gboolean));
+
+	return result;
+}
+
+/**
+ * Sectors of the image are 2048 bytes so only Mode 1 and Mode 2 Form 1
+ * sectors (whose user data are that size) are read. Mode 1 is tried first.
+ * A bad sector can be reported with a wrong track mode as well so Mode 2
+ * Form 1 is kept only once a read succeeded with it.
+ */
+
+static BraseroScsiResult
+brasero_rescue_read (BraseroRescueCtx *ctx,
+		     guint64 sector,
+		     guint num,
+		     guint *c2_errors,
+		     BraseroScsiErrCode *code)
+{
+	BraseroScsiResult result;
+
+	result = brasero_rescue_read_real (ctx, sector, num, c2_errors, code);
+	if (result == BRASERO_SCSI_OK
+	||  *code != BRASERO_SCSI_INVALID_TRACK_MODE
+	||  ctx->block_type != BRASERO_SCSI_BLOCK_TYPE_MODE1)
+		return result;
+
+	ctx->block_type = BRASERO_SCSI_BLOCK_TYPE_MODE2_FORM1;
+	result = brasero_rescue_read_real (ctx, sector, num, c2_errors, code);
+	if (result != BRASERO_SCSI_OK) {
+		ctx->block_type = BRASERO_SCSI_BLOCK_TYPE_MODE1;
+		return result;
+	}
+
+	BRASERO_JOB_LOG (ctx->self, "Reading Mode 2 Form 1 sectors");
+	return result;
+}
+
+static gboolean
+brasero_rescue_write (BraseroRescueCtx *ctx,
+		      guint64 sector,
+		      guint num,
+		      GError **error)
+{
+	gsize remaining;
+	off_t offset;
+	guchar *data;
+
+	data = ctx->data;
+	remaining = num * BRASERO_RESCUE_SECTOR_SIZE;
+	offset = sector * BRASERO_RESCUE_SECTOR_SIZE;
+
+	while (remaining) {
+		ssize_t written;
+
+		written = pwrite (ctx->fd, data, remaining, offset);
+		if (written < 0) {
+			int errsv = errno;
+
+			if (errsv == EINTR)
+				continue;
+
+			g_set_error (error,
+				     BRASERO_BURN_ERROR,
+				     BRASERO_BURN_ERROR_GENERAL,
+				     _("Data could not be written (%s)"),
+				     g_strerror (errsv));
+			return FALSE;
+		}
+
+		data += written;
+		offset += written;
+		remaining -= written;
+	}
+
+	return TRUE;
+}
+
+/**
+ * Writes what was just read and updates the map. Sectors with C2 errors are
+ * kept but marked as bad so they are read again at lower speeds later.
+ */
+
+static gboolean
+brasero_rescue_record (BraseroRescueCtx *ctx,
+		       guint64 sector,
+		       guint num,
+		       GError **error)
+{
+	guint i;
+
+	if (!brasero_rescue_write (ctx, sector, num, error))
+		return FALSE;
+
+	i = 0;
+	while (i < num) {
+		gboolean c2;
+		guint run;
+
+		c2 = ctx->c2 [i];
+		for (run = 1; i + run < num && ctx->c2 [i + run] == c2; run ++);
+
+		brasero_rescue_map_set (ctx->map,
+					sector + i,
+					run,
+					c2 ? BRASERO_RESCUE_BAD_SECTOR:BRASERO_RESCUE_FINISHED);
+		i += run;
+	}
+
+	brasero_job_set_written_track (BRASERO_JOB (ctx->self),
+				       brasero_rescue_map_count (ctx->map, BRASERO_RESCUE_FINISHED) *
+				       BRASERO_RESCUE_SECTOR_SIZE);
+	return TRUE;
+}
+
+static void
+brasero_rescue_save_map (BraseroRescueCtx *ctx,
+			 BraseroRescueStatus pass,
+			 gboolean force)
+{
+	GError *error = NULL;
+	gint64 now;
+
+	now = g_get_monotonic_time ();
+	if (!force && now - ctx->last_save < BRASERO_RESCUE_SAVE_INTERVAL)
+		return;
+
+	ctx->last_save = now;
+	if (!brasero_rescue_map_save (ctx->map, ctx->map_path, pass, &error)) {
+		BRASERO_JOB_LOG (ctx->self, "Map could not be saved: %s", error->message);
+		g_error_free (error);
+	}
+}
+
+static void
+brasero_rescue_set_speed (BraseroRescueCtx *ctx,
+			  guint speed)
+{
+	BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+
+	if (ctx->speed == speed)
+		return;
+
+	ctx->speed = speed;
+	if (brasero_mmc1_set_cd_speed (ctx->handle,
+				       rescue_speeds [speed],
+				       0xFFFF,
+				       &code) != BRASERO_SCSI_OK)
+		BRASERO_JOB_LOG (ctx->self,
+				 "Read speed could not be set to %i kB/s (%s)",
+				 rescue_speeds [speed],
+				 brasero_scsi_strerror (code));
+	else
+		BRASERO_JOB_LOG (ctx->self, "Read speed set to %i kB/s", rescue_speeds [speed]);
+}
+
+static gboolean
+brasero_rescue_fatal_error (BraseroScsiErrCode code,
+			    GError **error)
+{
+	g_set_error (error,
+		     BRASERO_BURN_ERROR,
+		     BRASERO_BURN_ERROR_GENERAL,
+		     _("Error while reading the disc (%s)"),
+		     brasero_scsi_strerror (code));
+	return FALSE;
+}
+
+/**
+ * First pass: read everything not tried yet by large blocks. A block that
+ * fails is left for the second pass.
+ */
+
+static gboolean
+brasero_rescue_copy_pass (BraseroRescueCtx *ctx,
+			  GError **error)
+{
+	BraseroRescuePrivate *priv;
+	guint64 start, size;
+	guint64 from = 0;
+
+	priv = BRASERO_RESCUE_PRIVATE (ctx->self);
+	while (!priv->cancel
+	&&  brasero_rescue_map_find (ctx->map, BRASERO_RESCUE_NON_TRIED, from, &start, &size)) {
+		BraseroScsiErrCode code;
+		guint c2_errors;
+		guint num;
+
+		num = MIN (size, priv->block_size);
+		if (brasero_rescue_read (ctx, start, num, &c2_errors, &code) == BRASERO_SCSI_OK) {
+			if (c2_errors)
+				BRASERO_JOB_LOG (ctx->self,
+						 "%u sector(s) with C2 errors between %"G_GUINT64_FORMAT" and %"G_GUINT64_FORMAT,
+						 c2_errors,
+						 ctx->start + start,
+						 ctx->start + start + num);
+
+			if (!brasero_rescue_record (ctx, start, num, error))
+				return FALSE;
+		}
+		else if (brasero_rescue_is_fatal (code))
+			return brasero_rescue_fatal_error (code, error);
+		else {
+			BRASERO_JOB_LOG (ctx->self,
+					 "Read error between %"G_GUINT64_FORMAT" and %"G_GUINT64_FORMAT" (%s)",
+					 ctx->start + start,
+					 ctx->start + start + num,
+					 brasero_scsi_strerror (code));
+			brasero_rescue_map_set (ctx->map, start, num, BRASERO_RESCUE_NON_TRIMMED);
+		}
+
+		from = start + num;
+		brasero_rescue_save_map (ctx, BRASERO_RESCUE_NON_TRIED, FALSE);
+	}
+
+	brasero_rescue_save_map (ctx, BRASERO_RESCUE_NON_TRIED, TRUE);
+	return TRUE;
+}
+
+/**
+ * Second pass: split the blocks which failed in two until the bad sectors
+ * are isolated.
+ */
+
+static gboolean
+brasero_rescue_bisect (BraseroRescueCtx *ctx,
+		       guint64 sector,
+		       guint num,
+		       GError **error)
+{
+	BraseroRescuePrivate *priv;
+	guint64 halves [2][2];
+	guint i;
+
+	if (num <= 1) {
+		brasero_rescue_map_set (ctx->map, sector, num, BRASERO_RESCUE_BAD_SECTOR);
+		return TRUE;
+	}
+
+	halves [0][0] = sector;
+	halves [0][1] = num / 2;
+	halves [1][0] = sector + num / 2;
+	halves [1][1] = num - num / 2;
+
+	priv = BRASERO_RESCUE_PRIVATE (ctx->self);
+	for (i = 0; i < 2 && !priv->cancel; i ++) {
+		BraseroScsiErrCode code;
+		guint c2_errors;
+
+		if (brasero_rescue_read (ctx, halves [i][0], halves [i][1], &c2_errors, &code) == BRASERO_SCSI_OK) {
+			if (!brasero_rescue_record (ctx, halves [i][0], halves [i][1], error))
+				return FALSE;
+		}
+		else if (brasero_rescue_is_fatal (code))
+			return brasero_rescue_fatal_error (code, error);
+		else if (halves [i][1] == 1)
+			brasero_rescue_map_set (ctx->map, halves [i][0], 1, BRASERO_RESCUE_BAD_SECTOR);
+		else if (!brasero_rescue_bisect (ctx, halves [i][0], halves [i][1], error))
+			return FALSE;
+
+		brasero_rescue_save_map (ctx, BRASERO_RESCUE_NON_TRIMMED, FALSE);
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_rescue_trim_pass (BraseroRescueCtx *ctx,
+			  GError **error)
+{
+	BraseroRescuePrivate *priv;
+	guint64 start, size;
+
+	priv = BRASERO_RESCUE_PRIVATE (ctx->self);
+	while (!priv->cancel
+	&&  brasero_rescue_map_find (ctx->map, BRASERO_RESCUE_NON_TRIMMED, 0, &start, &size)) {
+		if (!brasero_rescue_bisect (ctx, start, MIN (size, priv->block_size), error))
+			return FALSE;
+	}
+
+	brasero_rescue_save_map (ctx, BRASERO_RESCUE_NON_TRIMMED, TRUE);
+	return TRUE;
+}
+
+/**
+ * Last pass: read each bad sector again, going down in speed. A sector that
+ * can be read but still has C2 errors after all tries is kept as is.
+ */
+
+static gboolean
+brasero_rescue_retry_sector (BraseroRescueCtx *ctx,
+			     guint64 sector,
+			     GError **error)
+{
+	BraseroRescuePrivate *priv;
+	gboolean has_data = FALSE;
+	guint speed;
+
+	priv = BRASERO_RESCUE_PRIVATE (ctx->self);
+	for (speed = 0; speed < G_N_ELEMENTS (rescue_speeds); speed ++) {
+		gint retry;
+
+		brasero_rescue_set_speed (ctx, speed);
+		for (retry = 0; retry < priv->retries; retry ++) {
+			BraseroScsiErrCode code;
+			guint c2_errors;
+
+			if (priv->cancel)
+				return TRUE;
+
+			if (brasero_rescue_read (ctx, sector, 1, &c2_errors, &code) != BRASERO_SCSI_OK) {
+				if (brasero_rescue_is_fatal (code))
+					return brasero_rescue_fatal_error (code, error);
+
+				continue;
+			}
+
+			if (!brasero_rescue_write (ctx, sector, 1, error))
+				return FALSE;
+
+			if (!c2_errors) {
+				BRASERO_JOB_LOG (ctx->self,
+						 "Sector %"G_GUINT64_FORMAT" recovered at %i kB/s",
+						 ctx->start + sector,
+						 rescue_speeds [speed]);
+				brasero_rescue_map_set (ctx->map, sector, 1, BRASERO_RESCUE_FINISHED);
+				return TRUE;
+			}
+
+			has_data = TRUE;
+		}
+	}
+
+	if (has_data) {
+		BRASERO_JOB_LOG (ctx->self,
+				 "Sector %"G_GUINT64_FORMAT" kept with C2 errors",
+				 ctx->start + sector);
+		brasero_rescue_map_set (ctx->map, sector, 1, BRASERO_RESCUE_FINISHED);
+		ctx->c2_sectors ++;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_rescue_retry_pass (BraseroRescueCtx *ctx,
+			   GError **error)
+{
+	BraseroRescuePrivate *priv;
+	guint64 start, size;
+	guint64 from = 0;
+	gboolean success = TRUE;
+
+	priv = BRASERO_RESCUE_PRIVATE (ctx->self);
+	if (!priv->retries)
+		return TRUE;
+
+	while (success
+	&&    !priv->cancel
+	&&     brasero_rescue_map_find (ctx->map, BRASERO_RESCUE_BAD_SECTOR, from, &start, &size)) {
+		guint64 sector;
+
+		for (sector = start; sector < start + size && !priv->cancel; sector ++) {
+			success = brasero_rescue_retry_sector (ctx, sector, error);
+			if (!success)
+				break;
+
+			brasero_rescue_save_map (ctx, BRASERO_RESCUE_BAD_SECTOR, FALSE);
+		}
+
+		from = start + size;
+	}
+
+	/* Go back to the maximum speed */
+	brasero_rescue_set_speed (ctx, 0);
+	brasero_rescue_save_map (ctx, BRASERO_RESCUE_BAD_SECTOR, TRUE);
+	return success;
+}
+
+static gboolean
+brasero_rescue_open_output (BraseroRescueCtx *ctx,
+			    GError **error)
+{
+	GError *map_error = NULL;
+	gchar *image = NULL;
+	int flags;
+
+	brasero_job_get_image_output (BRASERO_JOB (ctx->self), &image, NULL);
+	ctx->map_path = g_strdup_printf ("%s.map", image);
+
+	/* Resume a previous run if there is a map matching the disc */
+	flags = O_WRONLY|O_CREAT;
+	if (g_file_test (image, G_FILE_TEST_EXISTS)
+	&&  g_file_test (ctx->map_path, G_FILE_TEST_EXISTS)) {
+		ctx->map = brasero_rescue_map_load (ctx->map_path, ctx->sectors, &map_error);
+		if (!ctx->map) {
+			BRASERO_JOB_LOG (ctx->self, "Ignoring map: %s", map_error->message);
+			g_error_free (map_error);
+		}
+		else
+			BRASERO_JOB_LOG (ctx->self,
+					 "Resuming from %s (%"G_GUINT64_FORMAT" sectors left)",
+					 ctx->map_path,
+					 ctx->sectors - brasero_rescue_map_count (ctx->map, BRASERO_RESCUE_FINISHED));
+	}
+
+	if (!ctx->map) {
+		ctx->map = brasero_rescue_map_new (ctx->sectors);
+		flags |= O_TRUNC;
+	}
+
+	ctx->fd = open (image, flags, S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	if (ctx->fd < 0) {
+		int errsv = errno;
+
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("\"%s\" could not be opened (%s)"),
+			     image,
+			     g_strerror (errsv));
+		g_free (image);
+		return FALSE;
+	}
+	g_free (image);
+
+	/* Unreadable sectors are left filled with zeros */
+	if (ftruncate (ctx->fd, ctx->sectors * BRASERO_RESCUE_SECTOR_SIZE)) {
+		int errsv = errno;
+
+		g_set_error (error,
+			     BRASERO_BURN_ERROR,
+			     BRASERO_BURN_ERROR_GENERAL,
+			     _("Data could not be written (%s)"),
+			     g_strerror (errsv));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gpointer
+brasero_rescue_thread (gpointer data)
+{
+	BraseroScsiErrCode code = BRASERO_SCSI_ERROR_NONE;
+	BraseroRescueCtx ctx = { NULL, };
+	BraseroRescue *self = data;
+	BraseroRescuePrivate *priv;
+	BraseroTrack *track = NULL;
+	BraseroDrive *drive;
+	guint64 bad_sectors;
+	gchar *string;
+
+	priv = BRASERO_RESCUE_PRIVATE (self);
+
+	ctx.self = self;
+	ctx.fd = -1;
+	ctx.use_c2 = TRUE;
+	ctx.block_type = BRASERO_SCSI_BLOCK_TYPE_MODE1;
+	brasero_rescue_get_range (self, &ctx.start, &ctx.sectors);
+
+	BRASERO_JOB_LOG (self,
+			 "Rescuing %"G_GINT64_FORMAT" sectors from sector %"G_GINT64_FORMAT,
+			 ctx.sectors,
+			 ctx.start);
+
+	if (!brasero_rescue_open_output (&ctx, &priv->error))
+		goto end;
+
+	brasero_job_get_current_track (BRASERO_JOB (self), &track);
+	drive = brasero_track_disc_get_drive (BRASERO_TRACK_DISC (track));
+	ctx.handle = brasero_device_handle_open (brasero_drive_get_device (drive), FALSE, &code);
+	if (!ctx.handle) {
+		priv->error = g_error_new (BRASERO_BURN_ERROR,
+					   BRASERO_BURN_ERROR_GENERAL,
+					   _("Error while reading the disc (%s)"),
+					   brasero_scsi_strerror (code));
+		goto end;
+	}
+
+	ctx.raw = g_malloc (priv->block_size * BRASERO_RESCUE_RAW_SIZE);
+	ctx.data = g_malloc (priv->block_size * BRASERO_RESCUE_SECTOR_SIZE);
+	ctx.c2 = g_new0 (gboolean, priv->block_size);
+	ctx.last_save = g_get_monotonic_time ();
+
+	brasero_job_set_current_action (BRASERO_JOB (self),
+					BRASERO_BURN_ACTION_DRIVE_COPY,
+					_("Copying disc"),
+					FALSE);
+	brasero_job_start_progress (BRASERO_JOB (self), TRUE);
+
+	if (!brasero_rescue_copy_pass (&ctx, &priv->error) || priv->cancel)
+		goto end;
+
+	brasero_job_set_current_action (BRASERO_JOB (self),
+					BRASERO_BURN_ACTION_DRIVE_COPY,
+					_("Reading damaged areas of the disc"),
+					FALSE);
+
+	if (!brasero_rescue_trim_pass (&ctx, &priv->error) || priv->cancel)
+		goto end;
+
+	brasero_rescue_retry_pass (&ctx, &priv->error);
+
+end:
+
+	if (ctx.map) {
+		bad_sectors = ctx.sectors - brasero_rescue_map_count (ctx.map, BRASERO_RESCUE_FINISHED);
+
+		string = brasero_rescue_map_to_string (ctx.map, BRASERO_RESCUE_FINISHED);
+		BRASERO_JOB_LOG (self,
+				 "%"G_GUINT64_FORMAT" unreadable sector(s), %"G_GUINT64_FORMAT" sector(s) kept with C2 errors. Map:\n%s",
+				 bad_sectors,
+				 ctx.c2_sectors,
+				 string);
+		g_free (string);
+
+		if (!bad_sectors)
+			g_remove (ctx.map_path);
+		else {
+			/* Keep the map so that another run only retries
+			 * the sectors that could not be read. The job
+			 * doesn't fail for them: that would remove the
+			 * image and then the map couldn't be used. */
+			brasero_rescue_map_save (ctx.map, ctx.map_path, BRASERO_RESCUE_BAD_SECTOR, NULL);
+			BRASERO_JOB_LOG (self,
+					 "%"G_GUINT64_FORMAT" sector(s) left filled with zeros, run again to retry them (map saved to %s)",
+					 bad_sectors,
+					 ctx.map_path);
+		}
+
+		brasero_rescue_map_free (ctx.map);
+	}
+
+	if (ctx.handle)
+		brasero_device_handle_close (ctx.handle);
+
+	if (ctx.fd >= 0)
+		close (ctx.fd);
+
+	g_free (ctx.map_path);
+	g_free (ctx.raw);
+	g_free (ctx.data);
+	g_free (ctx.c2);
+
+	if (!priv->cancel)
+		priv->thread_id = g_idle_add (brasero_rescue_thread_finished, self);
+
+	/* End thread */
+	g_mutex_lock (priv->mutex);
+	priv->thread = NULL;
+	g_cond_signal (priv->cond);
+	g_mutex_unlock (priv->mutex);
+
+	g_thread_exit (NULL);
+
+	return NULL;
+}
+
+static BraseroBurnResult
+brasero_rescue_start (BraseroJob *job,
+		      GError **error)
+{
+	BraseroRescue *self;
+	BraseroJobAction action;
+	BraseroRescuePrivate *priv;
+	GError *thread_error = NULL;
+
+	self = BRASERO_RESCUE (job);
+	priv = BRASERO_RESCUE_PRIVATE (self);
+
+	brasero_job_get_action (job, &action);
+	if (action == BRASERO_JOB_ACTION_SIZE) {
+		goffset start = 0;
+		goffset blocks = 0;
+
+		brasero_rescue_get_range (self, &start, &blocks);
+		brasero_job_set_output_size_for_current_track (job,
+							       blocks,
+							       blocks * BRASERO_RESCUE_SECTOR_SIZE);
+		return BRASERO_BURN_NOT_RUNNING;
+	}
+
+	if (action != BRASERO_JOB_ACTION_IMAGE)
+		return BRASERO_BURN_NOT_SUPPORTED;
+
+	if (priv->thread)
+		return BRASERO_BURN_RUNNING;
+
+	g_mutex_lock (priv->mutex);
+	priv->thread = g_thread_create (brasero_rescue_thread,
+					self,
+					FALSE,
+					&thread_error);
+	g_mutex_unlock (priv->mutex);
+
+	/* Reminder: this is not necessarily an error as the thread may have finished */
+	if (thread_error) {
+		g_propagate_error (error, thread_error);
+		return BRASERO_BURN_ERR;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_rescue_stop_real (BraseroRescue *self)
+{
+	BraseroRescuePrivate *priv;
+
+	priv = BRASERO_RESCUE_PRIVATE (self);
+
+	g_mutex_lock (priv->mutex);
+	if (priv->thread) {
+		priv->cancel = 1;
+		g_cond_wait (priv->cond, priv->mutex);
+		priv->cancel = 0;
+	}
+	g_mutex_unlock (priv->mutex);
+
+	if (priv->thread_id) {
+		g_source_remove (priv->thread_id);
+		priv->thread_id = 0;
+	}
+
+	if (priv->error) {
+		g_error_free (priv->error);
+		priv->error = NULL;
+	}
+}
+
+static BraseroBurnResult
+brasero_rescue_stop (BraseroJob *job,
+		     GError **error)
+{
+	brasero_rescue_stop_real (BRASERO_RESCUE (job));
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_rescue_class_init (BraseroRescueClass *klass)
+{
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+	BraseroJobClass *job_class = BRASERO_JOB_CLASS (klass);
+
+	g_type_class_add_private (klass, sizeof (BraseroRescuePrivate));
+
+	parent_class = g_type_class_peek_parent (klass);
+	object_class->finalize = brasero_rescue_finalize;
+
+	job_class->start = brasero_rescue_start;
+	job_class->stop = brasero_rescue_stop;
+}
+
+static void
+brasero_rescue_init (BraseroRescue *obj)
+{
+	BraseroRescuePrivate *priv;
+	GSettings *settings;
+
+	priv = BRASERO_RESCUE_PRIVATE (obj);
+
+	priv->mutex = g_mutex_new ();
+	priv->cond = g_cond_new ();
+
+	settings = g_settings_new (BRASERO_SCHEMA_CONFIG);
+	priv->block_size = g_settings_get_int (settings, BRASERO_KEY_RESCUE_BLOCKS);
+	if (priv->block_size < BRASERO_RESCUE_MIN_BLOCKS || priv->block_size > BRASERO_RESCUE_MAX_BLOCKS)
+		priv->block_size = BRASERO_RESCUE_I_BLOCKS;
+
+	priv->retries = g_settings_get_int (settings, BRASERO_KEY_RESCUE_RETRIES);
+	if (priv->retries < BRASERO_RESCUE_MIN_RETRIES || priv->retries > BRASERO_RESCUE_MAX_RETRIES)
+		priv->retries = BRASERO_RESCUE_I_RETRIES;
+
+	g_object_unref (settings);
+}
+
+static void
+brasero_rescue_finalize (GObject *object)
+{
+	BraseroRescuePrivate *priv;
+
+	priv = BRASERO_RESCUE_PRIVATE (object);
+
+	brasero_rescue_stop_real (BRASERO_RESCUE (object));
+
+	if (priv->mutex) {
+		g_mutex_free (priv->mutex);
+		priv->mutex = NULL;
+	}
+
+	if (priv->cond) {
+		g_cond_free (priv->cond);
+		priv->cond = NULL;
+	}
+
+	G_OBJECT_CLASS (parent_class)->finalize (object);
+}
+
+static void
+brasero_rescue_export_caps (BraseroPlugin *plugin)
+{
+	BraseroPluginConfOption *block_size;
+	BraseroPluginConfOption *retries;
+	GSList *output;
+	GSList *input;
+
+	brasero_plugin_define (plugin,
+			       "rescue",
+	                       NULL,
+			       _("Copies damaged data CDs to a disc image, retrying unreadable sectors"),
+			       "Philippe Rouquier",
+			       0);
+
+	/* It reads much slower than readcd or readom which use the same
+	 * priority or a higher one. So it's only used once the user activated
+	 * it in the plugin manager or gave it a positive priority. */
+	brasero_plugin_set_on_request (plugin, TRUE);
+
+	/* Sectors are written out of order so the output must be a file */
+	output = brasero_caps_image_new (BRASERO_PLUGIN_IO_ACCEPT_FILE,
+					 BRASERO_IMAGE_FORMAT_BIN);
+	input = brasero_caps_disc_new (BRASERO_MEDIUM_CD|
+				       BRASERO_MEDIUM_ROM|
+				       BRASERO_MEDIUM_WRITABLE|
+				       BRASERO_MEDIUM_REWRITABLE|
+				       BRASERO_MEDIUM_APPENDABLE|
+				       BRASERO_MEDIUM_CLOSED|
+				       BRASERO_MEDIUM_HAS_DATA);
+
+	brasero_plugin_link_caps (plugin, output, input);
+
+	g_slist_free (input);
+	g_slist_free (output);
+
+	block_size = brasero_plugin_conf_option_new (BRASERO_KEY_RESCUE_BLOCKS,
+						     _("Number of sectors read at once:"),
+						     BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (block_size,
+						  BRASERO_RESCUE_MIN_BLOCKS,
+						  BRASERO_RESCUE_MAX_BLOCKS);
+	brasero_plugin_add_conf_option (plugin, block_size);
+
+	retries = brasero_plugin_conf_option_new (BRASERO_KEY_RESCUE_RETRIES,
+						  _("Number of reads of an unreadable sector at each speed:"),
+						  BRASERO_PLUGIN_OPTION_INT);
+	brasero_plugin_conf_option_int_set_range (retries,
+						  BRASERO_RESCUE_MIN_RETRIES,
+						  BRASERO_RESCUE_MAX_RETRIES);
+	brasero_plugin_add_conf_option (plugin, retries);
+}
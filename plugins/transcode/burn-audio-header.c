@@ -0,0 +1,589 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 8; tab-width: 8 -*- */
+/*
+ * Libbrasero-burn
+ * Copyright (C) Philippe Rouquier 2005-2009 <bonfire-app@wanadoo.fr>
+ *
+ * Libbrasero-burn is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * The Libbrasero-burn authors hereby grant permission for non-GPL compatible
+ * GStreamer plugins to be used and distributed together with GStreamer
+ * and Libbrasero-burn. This permission is above and beyond the permissions granted
+ * by the GPL license by which Libbrasero-burn is covered. If you modify this code
+ * you may extend this exception to your version of the code, but you are not
+ * obligated to do so. If you do not wish to do so, delete this exception
+ * statement from your version.
+ * 
+ * Libbrasero-burn is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Library General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifdef HAVE_CONFIG_H
+#  include <config.h>
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "burn-audio-header.h"
+
+/**
+ * This reads the length of an audio file from its headers without decoding
+ * it, which is much faster than running a GStreamer pipeline over the whole
+ * file. It gives the number of samples and the rate of the stream for:
+ * - WAV and AIFF (PCM only)
+ * - FLAC (STREAMINFO)
+ * - MP3 with a Xing/Info frame and a LAME extension (for the encoder delay
+ *   and padding)
+ * - Ogg Vorbis and Opus (granule position of the last page)
+ * For anything else it fails and the caller should use GStreamer.
+ */
+
+#define BRASERO_AUDIO_HEADER_SECOND	G_GINT64_CONSTANT (1000000000)
+#define BRASERO_AUDIO_HEADER_MP3_SCAN	8192
+#define BRASERO_AUDIO_HEADER_OGG_TAIL	65536
+
+#define GET_LE16(MACRO_b)	((guint16) ((MACRO_b) [0] | ((MACRO_b) [1] << 8)))
+#define GET_LE32(MACRO_b)	((guint32) ((MACRO_b) [0] | ((MACRO_b) [1] << 8) | ((MACRO_b) [2] << 16) | ((guint32) (MACRO_b) [3] << 24)))
+#define GET_BE16(MACRO_b)	((guint16) (((MACRO_b) [0] << 8) | (MACRO_b) [1]))
+#define GET_BE32(MACRO_b)	((guint32) (((guint32) (MACRO_b) [0] << 24) | ((MACRO_b) [1] << 16) | ((MACRO_b) [2] << 8) | (MACRO_b) [3]))
+
+static gboolean
+brasero_audio_header_read (FILE *file,
+			   goffset offset,
+			   guchar *buffer,
+			   gsize size)
+{
+	if (fseeko (file, offset, SEEK_SET))
+		return FALSE;
+
+	return (fread (buffer, 1, size, file) == size);
+}
+
+static goffset
+brasero_audio_header_file_size (FILE *file)
+{
+	if (fseeko (file, 0, SEEK_END))
+		return -1;
+
+	return ftello (file);
+}
+
+/**
+ * ID3v2 tags may precede MP3 and FLAC streams
+ */
+
+static goffset
+brasero_audio_header_skip_id3 (FILE *file)
+{
+	goffset offset = 0;
+	guchar header [10];
+
+	while (brasero_audio_header_read (file, offset, header, sizeof (header))
+	&&     !memcmp (header, "ID3", 3)) {
+		guint32 size;
+
+		/* syncsafe integer */
+		size = ((header [6] & 0x7F) << 21) |
+		       ((header [7] & 0x7F) << 14) |
+		       ((header [8] & 0x7F) << 7) |
+		        (header [9] & 0x7F);
+
+		offset += size + 10;
+
+		/* footer */
+		if (header [5] & 0x10)
+			offset += 10;
+	}
+
+	return offset;
+}
+
+/**
+ * RIFF/WAVE
+ */
+
+static gboolean
+brasero_audio_header_wav (FILE *file,
+			  goffset file_size,
+			  guint64 *samples,
+			  guint *rate)
+{
+	guint block_align = 0;
+	goffset offset = 12;
+	guchar chunk [8];
+
+	while (brasero_audio_header_read (file, offset, chunk, sizeof (chunk))) {
+		guint32 size;
+
+		size = GET_LE32 (chunk + 4);
+		offset += 8;
+
+		if (!memcmp (chunk, "fmt ", 4)) {
+			guchar fmt [16];
+			guint format;
+
+			if (size < sizeof (fmt)
+			|| !brasero_audio_header_read (file, offset, fmt, sizeof (fmt)))
+				return FALSE;
+
+			/* PCM, IEEE float and extensible (PCM or float inside) */
+			format = GET_LE16 (fmt);
+			if (format != 1 && format != 3 && format != 0xFFFE)
+				return FALSE;
+
+			*rate = GET_LE32 (fmt + 4);
+			block_align = GET_LE16 (fmt + 12);
+		}
+		else if (!memcmp (chunk, "data", 4)) {
+			if (!block_align || !*rate)
+				return FALSE;
+
+			/* Streamed files don't have the right size */
+			if (size == 0 || size == G_MAXUINT32)
+				return FALSE;
+
+			if (offset + size > file_size)
+				size = file_size - offset;
+
+			*samples = size / block_align;
+			return TRUE;
+		}
+
+		/* chunks are word aligned */
+		offset += size + (size & 1);
+	}
+
+	return FALSE;
+}
+
+/**
+ * AIFF/AIFC
+ */
+
+static guint
+brasero_audio_header_extended_to_uint (const guchar *extended)
+{
+	guint64 mantissa;
+	gint exponent;
+
+	/* 80 bits IEEE 754 extended precision */
+	exponent = ((extended [0] & 0x7F) << 8) | extended [1];
+	mantissa = ((guint64) GET_BE32 (extended + 2) << 32) | GET_BE32 (extended + 6);
+
+	if (extended [0] & 0x80)
+		return 0;
+
+	exponent -= 16383;
+	if (exponent < 0 || exponent > 63)
+		return 0;
+
+	return mantissa >> (63 - exponent);
+}
+
+static gboolean
+brasero_audio_header_aiff (FILE *file,
+			   gboolean aifc,
+			   guint64 *samples,
+			   guint *rate)
+{
+	goffset offset = 12;
+	guchar chunk [8];
+
+	while (brasero_audio_header_read (file, offset, chunk, sizeof (chunk))) {
+		guint32 size;
+
+		size = GET_BE32 (chunk + 4);
+		offset += 8;
+
+		if (!memcmp (chunk, "COMM", 4)) {
+			guchar comm [22];
+
+			if (size < (aifc? 22:18)
+			|| !brasero_audio_header_read (file, offset, comm, aifc? 22:18))
+				return FALSE;
+
+			/* Only uncompressed AIFC */
+			if (aifc
+			&&  memcmp (comm + 18, "NONE", 4)
+			&&  memcmp (comm + 18, "sowt", 4)
+			&&  memcmp (comm + 18, "twos", 4)
+			&&  memcmp (comm + 18, "fl32", 4)
+			&&  memcmp (comm + 18, "fl64", 4))
+				return FALSE;
+
+			*samples = GET_BE32 (comm + 2);
+			*rate = brasero_audio_header_extended_to_uint (comm + 8);
+			return (*rate != 0);
+		}
+
+		offset += size + (size & 1);
+	}
+
+	return FALSE;
+}
+
+/**
+ * FLAC
+ */
+
+static gboolean
+brasero_audio_header_flac_streaminfo (const guchar *info,
+				      guint64 *samples,
+				      guint *rate)
+{
+	*rate = (info [10] << 12) | (info [11] << 4) | (info [12] >> 4);
+	*samples = ((guint64) (info [13] & 0x0F) << 32) | GET_BE32 (info + 14);
+
+	/* 0 means unknown */
+	return (*rate && *samples);
+}
+
+static gboolean
+brasero_audio_header_flac (FILE *file,
+			   goffset offset,
+			   guint64 *samples,
+			   guint *rate)
+{
+	guchar block [4 + 34];
+
+	/* STREAMINFO must be the first metadata block */
+	if (!brasero_audio_header_read (file, offset + 4, block, sizeof (block)))
+		return FALSE;
+
+	if ((block [0] & 0x7F) != 0)
+		return FALSE;
+
+	return brasero_audio_header_flac_streaminfo (block + 4, samples, rate);
+}
+
+/**
+ * Ogg (Vorbis and Opus)
+ */
+
+static gboolean
+brasero_audio_header_ogg (FILE *file,
+			  goffset file_size,
+			  guint64 *samples,
+			  guint *rate)
+{
+	guchar page [27 + 255 + 19];
+	guint64 granule = G_MAXUINT64;
+	guint64 pre_skip = 0;
+	guchar *packet;
+	guchar *tail;
+	guint32 serial;
+	goffset start;
+	gsize size;
+	gint i;
+
+	if (!brasero_audio_header_read (file, 0, page, 27))
+		return FALSE;
+
+	serial = GET_LE32 (page + 14);
+
+	/* The first page has only the identification header */
+	if (page [26] != 1
+	|| !brasero_audio_header_read (file, 27, page + 27, 1 + 19))
+		return FALSE;
+
+	packet = page + 28;
+	if (!memcmp (packet, "\x01vorbis", 7))
+		*rate = GET_LE32 (packet + 12);
+	else if (!memcmp (packet, "OpusHead", 8)) {
+		/* Opus granule positions are always at 48kHz */
+		*rate = 48000;
+		pre_skip = GET_LE16 (packet + 10);
+	}
+	else
+		return FALSE;
+
+	if (!*rate)
+		return FALSE;
+
+	/* Look for the last page of the stream and its granule position */
+	start = MAX (0, file_size - BRASERO_AUDIO_HEADER_OGG_TAIL);
+	size = file_size - start;
+	tail = g_malloc (size);
+	if (!brasero_audio_header_read (file, start, tail, size)) {
+		g_free (tail);
+		return FALSE;
+	}
+
+	for (i = size - 27; i >= 0; i --) {
+		guint64 position;
+
+		if (memcmp (tail + i, "OggS", 4))
+			continue;
+
+		if (GET_LE32 (tail + i + 14) != serial)
+			continue;
+
+		position = ((guint64) GET_LE32 (tail + i + 10) << 32) | GET_LE32 (tail + i + 6);
+
+		/* -1 means no packet ends on this page */
+		if (position == G_MAXUINT64)
+			continue;
+
+		granule = position;
+		break;
+	}
+	g_free (tail);
+
+	if (granule == G_MAXUINT64 || granule <= pre_skip)
+		return FALSE;
+
+	*samples = granule - pre_skip;
+	return TRUE;
+}
+
+/**
+ * MP3
+ */
+
+static const guint bitrates [2][3][15] = {
+	/* MPEG 1 */
+	{ { 0, 32, 64, 96, 128, 160, 192, 224, 256, 288, 320, 352, 384, 416, 448 },
+	  { 0, 32, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320, 384 },
+	  { 0, 32, 40, 48, 56, 64, 80, 96, 112, 128, 160, 192, 224, 256, 320 } },
+	/* MPEG 2 and 2.5 */
+	{ { 0, 32, 48, 56, 64, 80, 96, 112, 128, 144, 160, 176, 192, 224, 256 },
+	  { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 },
+	  { 0, 8, 16, 24, 32, 40, 48, 56, 64, 80, 96, 112, 128, 144, 160 } }
+};
+
+static const guint sample_rates [3] = { 44100, 48000, 32000 };
+
+typedef struct _BraseroAudioHeaderMpeg BraseroAudioHeaderMpeg;
+struct _BraseroAudioHeaderMpeg {
+	guint version;		/* 1, 2 or 3 for 2.5 */
+	guint layer;
+	guint rate;
+	guint samples;		/* per frame */
+	guint length;		/* of the frame in bytes */
+	guint mono:1;
+	guint crc:1;		/* a 16 bits CRC follows the header */
+};
+
+static gboolean
+brasero_audio_header_mpeg_frame (const guchar *header,
+				 BraseroAudioHeaderMpeg *frame)
+{
+	guint bitrate_index;
+	guint rate_index;
+	guint version;
+	guint padding;
+	guint bitrate;
+
+	/* sync */
+	if (header [0] != 0xFF || (header [1] & 0xE0) != 0xE0)
+		return FALSE;
+
+	version = (header [1] >> 3) & 0x03;
+	frame->layer = 4 - ((header [1] >> 1) & 0x03);
+	bitrate_index = header [2] >> 4;
+	rate_index = (header [2] >> 2) & 0x03;
+	padding = (header [2] >> 1) & 0x01;
+
+	/* reserved values and free format */
+	if (version == 1 || frame->layer == 4 || bitrate_index == 0 || bitrate_index == 15 || rate_index == 3)
+		return FALSE;
+
+	frame->version = (version == 3)? 1:(version == 2)? 2:3;
+	frame->rate = sample_rates [rate_index] >> (frame->version - 1);
+	frame->mono = ((header [3] >> 6) == 3);
+	frame->crc = !(header [1] & 0x01);
+
+	bitrate = bitrates [frame->version == 1? 0:1][frame->layer - 1][bitrate_index] * 1000;
+
+	if (frame->layer == 1) {
+		frame->samples = 384;
+		frame->length = (12 * bitrate / frame->rate + padding) * 4;
+	}
+	else if (frame->layer == 2 || frame->version == 1) {
+		frame->samples = 1152;
+		frame->length = 144 * bitrate / frame->rate + padding;
+	}
+	else {
+		frame->samples = 576;
+		frame->length = 72 * bitrate / frame->rate + padding;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+brasero_audio_header_mp3 (FILE *file,
+			  goffset offset,
+			  guint64 *samples,
+			  guint *rate)
+{
+	guchar buffer [BRASERO_AUDIO_HEADER_MP3_SCAN];
+	BraseroAudioHeaderMpeg frame;
+	gsize size;
+	guint side;
+	guint i;
+
+	if (fseeko (file, offset, SEEK_SET))
+		return FALSE;
+
+	size = fread (buffer, 1, sizeof (buffer), file);
+	if (size < 4)
+		return FALSE;
+
+	/* Find the first frame; make sure it is one by checking the next */
+	for (i = 0; i + 4 <= size; i ++) {
+		BraseroAudioHeaderMpeg next;
+
+		if (!brasero_audio_header_mpeg_frame (buffer + i, &frame))
+			continue;
+
+		if (i + frame.length + 4 > size)
+			break;
+
+		if (brasero_audio_header_mpeg_frame (buffer + i + frame.length, &next)
+		&&  next.version == frame.version
+		&&  next.layer == frame.layer
+		&&  next.rate == frame.rate)
+			break;
+	}
+
+	if (i + 4 > size || frame.layer != 3)
+		return FALSE;
+
+	*rate = frame.rate;
+
+	/* Xing/Info frame comes after the side information (and the CRC) */
+	if (frame.version == 1)
+		side = frame.mono? 17:32;
+	else
+		side = frame.mono? 9:17;
+
+	if (frame.crc)
+		side += 2;
+
+	if (i + 4 + side + 12 <= size
+	&& (!memcmp (buffer + i + 4 + side, "Xing", 4)
+	||  !memcmp (buffer + i + 4 + side, "Info", 4))) {
+		const guchar *xing;
+		const guchar *lame;
+		guint32 flags;
+		guint delay;
+		guint pad;
+
+		xing = buffer + i + 4 + side;
+		flags = GET_BE32 (xing + 4);
+
+		/* frame number field is optional */
+		if (!(flags & 0x01))
+			return FALSE;
+
+		*samples = (guint64) GET_BE32 (xing + 8) * frame.samples;
+
+		/* The encoder delay and the padding of the last frame are in
+		 * the LAME extension which follows the optional byte number,
+		 * TOC and quality fields. Without them the number of decoded
+		 * samples is unknown. */
+		lame = xing + 12;
+		if (flags & 0x02)
+			lame += 4;
+		if (flags & 0x04)
+			lame += 100;
+		if (flags & 0x08)
+			lame += 4;
+
+		if (lame + 24 > buffer + size
+		|| (memcmp (lame, "LAME", 4)
+		&&  memcmp (lame, "Lavf", 4)
+		&&  memcmp (lame, "Lavc", 4)))
+			return FALSE;
+
+		delay = (lame [21] << 4) | (lame [22] >> 4);
+		pad = ((lame [22] & 0x0F) << 8) | lame [23];
+		if (delay + pad >= *samples)
+			return FALSE;
+
+		*samples -= delay + pad;
+		return TRUE;
+	}
+
+	/* A VBRI frame (always 32 bytes after the header) gives the number of
+	 * frames but not the padding of the last one. Constant bitrate without
+	 * header: the size of the tags at the end of the file and the padding
+	 * of each frame makes it inexact. Both have to be decoded. */
+	return FALSE;
+}
+
+/**
+ * brasero_audio_header_get_duration:
+ * @path: the local path of a file
+ * @duration: the duration in nanoseconds
+ *
+ * Returns TRUE if the duration could be read from the headers of the file.
+ **/
+
+gboolean
+brasero_audio_header_get_duration (const gchar *path,
+				   gint64 *duration)
+{
+	gboolean result = FALSE;
+	guint64 samples = 0;
+	guchar header [12];
+	goffset file_size;
+	goffset offset;
+	guint rate = 0;
+	FILE *file;
+
+	file = g_fopen (path, "rb");
+	if (!file)
+		return FALSE;
+
+	file_size = brasero_audio_header_file_size (file);
+	if (file_size <= 0
+	|| !brasero_audio_header_read (file, 0, header, sizeof (header))) {
+		fclose (file);
+		return FALSE;
+	}
+
+	if (!memcmp (header, "RIFF", 4) && !memcmp (header + 8, "WAVE", 4))
+		result = brasero_audio_header_wav (file, file_size, &samples, &rate);
+	else if (!memcmp (header, "FORM", 4) && !memcmp (header + 8, "AIFF", 4))
+		result = brasero_audio_header_aiff (file, FALSE, &samples, &rate);
+	else if (!memcmp (header, "FORM", 4) && !memcmp (header + 8, "AIFC", 4))
+		result = brasero_audio_header_aiff (file, TRUE, &samples, &rate);
+	else if (!memcmp (header, "OggS", 4))
+		result = brasero_audio_header_ogg (file, file_size, &samples, &rate);
+	else {
+		offset = brasero_audio_header_skip_id3 (file);
+		if (brasero_audio_header_read (file, offset, header, 4)
+		&& !memcmp (header, "fLaC", 4))
+			result = brasero_audio_header_flac (file, offset, &samples, &rate);
+		else
+			result = brasero_audio_header_mp3 (file, offset, &samples, &rate);
+	}
+
+	fclose (file);
+
+	if (!result || !rate || !samples)
+		return FALSE;
+
+	if (duration)
+		*duration = (samples / rate) * BRASERO_AUDIO_HEADER_SECOND +
+			    (samples % rate) * BRASERO_AUDIO_HEADER_SECOND / rate;
+
+	return TRUE;
+}
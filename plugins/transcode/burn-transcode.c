@@ -50,6 +50,7 @@
 #include "burn-job.h"
 #include "brasero-plugin-registration.h"
 #include "burn-normalize.h"
+#include "burn-audio-header.h"
 
 
 #define BRASERO_TYPE_TRANSCODE         (brasero_transcode_get_type ())
@@ -89,6 +90,17 @@ struct BraseroTranscodePrivate {
 	gint64 segment_start;
 	gint64 segment_end;
 
+	/* local path => duration read from the headers of the file */
+	GHashTable *durations;
+
+	/* thread reading the headers */
+	GMutex *mutex;
+	GCond *cond;
+	GThread *thread;
+	GSList *headers;
+	gint headers_id;
+	guint cancel;
+
 	guint set_active_state:1;
 	guint mp3_size_pipeline:1;
 };
@@ -903,21 +915,277 @@ brasero_transcode_has_track_sibling (BraseroTranscode *transcode,
 	return result;
 }
 
+/* Number of threads reading the headers of the tracks */
+#define BRASERO_TRANSCODE_HEADER_THREADS	4
+
+typedef struct _BraseroTranscodeHeader BraseroTranscodeHeader;
+struct _BraseroTranscodeHeader {
+	gchar *path;
+	gint64 duration;
+	gboolean result;
+};
+
+static void
+brasero_transcode_headers_free (GSList *headers)
+{
+	GSList *iter;
+
+	for (iter = headers; iter; iter = iter->next) {
+		BraseroTranscodeHeader *header;
+
+		header = iter->data;
+		g_free (header->path);
+		g_free (header);
+	}
+	g_slist_free (headers);
+}
+
+static void
+brasero_transcode_header_thread (gpointer data,
+				 gpointer user_data)
+{
+	BraseroTranscodeHeader *header = data;
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (user_data);
+	if (priv->cancel)
+		return;
+
+	header->result = brasero_audio_header_get_duration (header->path,
+							    &header->duration);
+}
+
+static gboolean
+brasero_transcode_size_current (BraseroTranscode *transcode,
+				GError **error);
+
+static gboolean
+brasero_transcode_headers_read (gpointer data)
+{
+	BraseroTranscode *transcode = BRASERO_TRANSCODE (data);
+	BraseroTranscodePrivate *priv;
+	GError *error = NULL;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+	priv->headers_id = 0;
+
+	priv->durations = g_hash_table_new_full (g_str_hash,
+						 g_str_equal,
+						 g_free,
+						 g_free);
+
+	for (iter = priv->headers; iter; iter = iter->next) {
+		BraseroTranscodeHeader *header;
+
+		header = iter->data;
+		if (header->result) {
+			g_hash_table_insert (priv->durations,
+					     header->path,
+					     g_memdup (&header->duration, sizeof (gint64)));
+			header->path = NULL;
+		}
+	}
+	brasero_transcode_headers_free (priv->headers);
+	priv->headers = NULL;
+
+	BRASERO_JOB_LOG (transcode,
+			 "Length of %i tracks read from headers",
+			 g_hash_table_size (priv->durations));
+
+	if (!brasero_transcode_size_current (transcode, &error))
+		brasero_job_error (BRASERO_JOB (transcode), error);
+
+	return FALSE;
+}
+
+static gpointer
+brasero_transcode_headers_thread (gpointer data)
+{
+	BraseroTranscode *transcode = BRASERO_TRANSCODE (data);
+	BraseroTranscodePrivate *priv;
+	GThreadPool *pool;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+
+	/* Read the headers of all the tracks at once since most of the
+	 * time is spent waiting for the disc */
+	pool = g_thread_pool_new (brasero_transcode_header_thread,
+				  transcode,
+				  BRASERO_TRANSCODE_HEADER_THREADS,
+				  FALSE,
+				  NULL);
+	if (pool) {
+		for (iter = priv->headers; iter; iter = iter->next)
+			g_thread_pool_push (pool, iter->data, NULL);
+
+		/* wait for all of them */
+		g_thread_pool_free (pool, FALSE, TRUE);
+	}
+
+	if (!priv->cancel)
+		priv->headers_id = g_idle_add (brasero_transcode_headers_read, transcode);
+
+	/* End thread */
+	g_mutex_lock (priv->mutex);
+	priv->thread = NULL;
+	g_cond_signal (priv->cond);
+	g_mutex_unlock (priv->mutex);
+
+	g_thread_exit (NULL);
+	return NULL;
+}
+
+/**
+ * The first time a track is sized, the headers of all the stream tracks of
+ * the session are read in a thread; the job resumes in the main loop once it
+ * is done.
+ */
+
+static BraseroBurnResult
+brasero_transcode_read_headers (BraseroTranscode *transcode,
+				GError **error)
+{
+	BraseroTranscodePrivate *priv;
+	GError *thread_error = NULL;
+	GSList *tracks;
+	GSList *iter;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+
+	brasero_job_get_tracks (BRASERO_JOB (transcode), &tracks);
+	for (iter = tracks; iter; iter = iter->next) {
+		BraseroTranscodeHeader *header;
+		gchar *path;
+
+		if (!BRASERO_IS_TRACK_STREAM (iter->data))
+			continue;
+
+		if (brasero_track_stream_get_end (BRASERO_TRACK_STREAM (iter->data)) > 0)
+			continue;
+
+		path = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (iter->data), FALSE);
+		if (!path)
+			continue;
+
+		header = g_new0 (BraseroTranscodeHeader, 1);
+		header->path = path;
+		priv->headers = g_slist_prepend (priv->headers, header);
+	}
+
+	g_mutex_lock (priv->mutex);
+	priv->thread = g_thread_create (brasero_transcode_headers_thread,
+					transcode,
+					FALSE,
+					&thread_error);
+	g_mutex_unlock (priv->mutex);
+
+	if (thread_error) {
+		brasero_transcode_headers_free (priv->headers);
+		priv->headers = NULL;
+
+		g_propagate_error (error, thread_error);
+		return BRASERO_BURN_ERR;
+	}
+
+	return BRASERO_BURN_OK;
+}
+
+static void
+brasero_transcode_stop_headers (BraseroTranscode *transcode)
+{
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+
+	g_mutex_lock (priv->mutex);
+	if (priv->thread) {
+		priv->cancel = 1;
+		g_cond_wait (priv->cond, priv->mutex);
+		priv->cancel = 0;
+		priv->thread = NULL;
+	}
+	g_mutex_unlock (priv->mutex);
+
+	if (priv->headers_id) {
+		g_source_remove (priv->headers_id);
+		priv->headers_id = 0;
+	}
+
+	if (priv->headers) {
+		brasero_transcode_headers_free (priv->headers);
+		priv->headers = NULL;
+	}
+}
+
+static gboolean
+brasero_transcode_get_header_duration (BraseroTranscode *transcode,
+				       BraseroTrack *track,
+				       gint64 *duration)
+{
+	BraseroTranscodePrivate *priv;
+	gint64 *value;
+	gchar *path;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (transcode);
+
+	path = brasero_track_stream_get_source (BRASERO_TRACK_STREAM (track), FALSE);
+	if (!path)
+		return FALSE;
+
+	value = g_hash_table_lookup (priv->durations, path);
+	g_free (path);
+
+	if (!value)
+		return FALSE;
+
+	*duration = *value;
+	return TRUE;
+}
+
+static gboolean
+brasero_transcode_size_current (BraseroTranscode *transcode,
+				GError **error)
+{
+	BraseroTrack *track;
+	gint64 duration;
+
+	/* Most of the time the headers of the file give the length
+	 * without having to decode or parse the whole file */
+	brasero_job_get_current_track (BRASERO_JOB (transcode), &track);
+	if (brasero_transcode_get_header_duration (transcode, track, &duration)) {
+		BRASERO_JOB_LOG (transcode, "Length read from headers");
+		brasero_transcode_set_track_size (transcode, duration);
+		brasero_job_finished_track (BRASERO_JOB (transcode));
+		return TRUE;
+	}
+
+	if (!brasero_transcode_create_pipeline (transcode, error))
+		return FALSE;
+
+	brasero_job_start_progress (BRASERO_JOB (transcode), FALSE);
+	return TRUE;
+}
+
 static BraseroBurnResult
 brasero_transcode_start (BraseroJob *job,
 			 GError **error)
 {
+	BraseroTranscodePrivate *priv;
 	BraseroTranscode *transcode;
 	BraseroBurnResult result;
 	BraseroJobAction action;
 
 	transcode = BRASERO_TRANSCODE (job);
+	priv = BRASERO_TRANSCODE_PRIVATE (job);
 
 	brasero_job_get_action (job, &action);
 	brasero_job_set_use_average_rate (job, TRUE);
 
 	if (action == BRASERO_JOB_ACTION_SIZE) {
 		BraseroTrack *track;
+		gint64 duration;
 
 		/* see if the track size was already set since then no need to 
 		 * carry on with a lengthy get size and the library will do it
@@ -926,6 +1194,23 @@ brasero_transcode_start (BraseroJob *job,
 		if (brasero_track_stream_get_end (BRASERO_TRACK_STREAM (track)) > 0)
 			return BRASERO_BURN_NOT_SUPPORTED;
 
+		/* The headers are read once for all the tracks */
+		if (!priv->durations) {
+			brasero_job_set_current_action (job,
+							BRASERO_BURN_ACTION_GETTING_SIZE,
+							NULL,
+							TRUE);
+			return brasero_transcode_read_headers (transcode, error);
+		}
+
+		/* Most of the time the headers of the file give the length
+		 * without having to decode or parse the whole file */
+		if (brasero_transcode_get_header_duration (transcode, track, &duration)) {
+			BRASERO_JOB_LOG (transcode, "Length read from headers");
+			brasero_transcode_set_track_size (transcode, duration);
+			return BRASERO_BURN_NOT_RUNNING;
+		}
+
 		if (!brasero_transcode_create_pipeline (transcode, error))
 			return BRASERO_BURN_ERR;
 
@@ -1002,6 +1287,7 @@ brasero_transcode_stop (BraseroJob *job,
 		priv->pad_id = 0;
 	}
 
+	brasero_transcode_stop_headers (BRASERO_TRANSCODE (job));
 	brasero_transcode_stop_pipeline (BRASERO_TRANSCODE (job));
 	return BRASERO_BURN_OK;
 }
@@ -1705,7 +1991,13 @@ brasero_transcode_class_init (BraseroTranscodeClass *klass)
 
 static void
 brasero_transcode_init (BraseroTranscode *obj)
-{ }
+{
+	BraseroTranscodePrivate *priv;
+
+	priv = BRASERO_TRANSCODE_PRIVATE (obj);
+	priv->mutex = g_mutex_new ();
+	priv->cond = g_cond_new ();
+}
 
 static void
 brasero_transcode_finalize (GObject *object)
@@ -1719,8 +2011,24 @@ brasero_transcode_finalize (GObject *object)
 		priv->pad_id = 0;
 	}
 
+	brasero_transcode_stop_headers (BRASERO_TRANSCODE (object));
 	brasero_transcode_stop_pipeline (BRASERO_TRANSCODE (object));
 
+	if (priv->durations) {
+		g_hash_table_destroy (priv->durations);
+		priv->durations = NULL;
+	}
+
+	if (priv->mutex) {
+		g_mutex_free (priv->mutex);
+		priv->mutex = NULL;
+	}
+
+	if (priv->cond) {
+		g_cond_free (priv->cond);
+		priv->cond = NULL;
+	}
+
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
@@ -91,6 +91,9 @@ struct _BraseroAppPrivate
 
 	gchar *saved_contents;
 
+	/* Device paths of drives burning copies at the same time */
+	gchar **duplicate_devices;
+
 	guint is_maximized:1;
 	guint mainwin_running:1;
 };
@@ -505,6 +508,18 @@ brasero_app_is_running (BraseroApp *app)
 	return priv->mainwin_running;
 }
 
+void
+brasero_app_set_duplicate_devices (BraseroApp *app,
+				   gchar **devices)
+{
+	BraseroAppPrivate *priv;
+
+	priv = BRASERO_APP_PRIVATE (app);
+
+	g_strfreev (priv->duplicate_devices);
+	priv->duplicate_devices = g_strdupv (devices);
+}
+
 void
 brasero_app_set_parent (BraseroApp *app,
 			guint parent_xid)
@@ -529,6 +544,18 @@ brasero_app_burn (BraseroApp *app,
 
 	priv = BRASERO_APP_PRIVATE (app);
 
+	/* Drives that should burn a copy at the same time */
+	if (priv->duplicate_devices) {
+		GValue *value;
+
+		value = g_new0 (GValue, 1);
+		g_value_init (value, G_TYPE_STRV);
+		g_value_set_boxed (value, priv->duplicate_devices);
+		brasero_burn_session_tag_add (session,
+					      BRASERO_SESSION_DUPLICATE_DRIVES,
+					      value);
+	}
+
 	/* now setup the burn dialog */
 	dialog = brasero_burn_dialog_new ();
 	gtk_window_set_icon_name (GTK_WINDOW (dialog), "brasero");
@@ -2088,6 +2115,11 @@ brasero_app_finalize (GObject *object)
 		priv->saved_contents = NULL;
 	}
 
+	if (priv->duplicate_devices) {
+		g_strfreev (priv->duplicate_devices);
+		priv->duplicate_devices = NULL;
+	}
+
 	G_OBJECT_CLASS (brasero_app_parent_class)->finalize (object);
 }
 static void
@@ -62,6 +62,10 @@ void
 brasero_app_set_parent (BraseroApp *app,
 			guint xid);
 
+void
+brasero_app_set_duplicate_devices (BraseroApp *app,
+				   gchar **devices);
+
 void
 brasero_app_set_toplevel (BraseroApp *app, GtkWindow *window);
 
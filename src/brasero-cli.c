@@ -82,6 +82,10 @@ const GOptionEntry prog_options [] = {
 	  N_("Set the drive to be used for burning"),
 	  N_("DEVICE PATH") },
 
+	{ "duplicate", 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &cmd_line_options.duplicate_devices,
+	  N_("Also burn a copy with this drive at the same time (can be used several times)"),
+	  N_("DEVICE PATH") },
+
 	{ "image-file", 0, G_OPTION_FLAG_NO_ARG, G_OPTION_ARG_CALLBACK, brasero_cli_fake_device,
 	  N_("Create an image file instead of burning"),
 	  NULL },
@@ -260,6 +264,9 @@ brasero_cli_apply_options (BraseroApp *app)
 	if (cmd_line_options.parent_window)
 		brasero_app_set_parent (app, cmd_line_options.parent_window);
 
+	if (cmd_line_options.duplicate_devices)
+		brasero_app_set_duplicate_devices (app, cmd_line_options.duplicate_devices);
+
     	if (cmd_line_options.empty_project) {
 	    	brasero_app_create_mainwin (app);
 		manager = brasero_app_get_project_manager (app);
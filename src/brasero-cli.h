@@ -55,6 +55,7 @@ struct _BraseroCLI {
 	gboolean not_unique;
 
 	BraseroDrive *burner;
+	gchar **duplicate_devices;
 
 	gchar **files;
 };
@@ -29,6 +29,7 @@
 #include "brasero-drive-settings.h"
 #include "brasero-session.h"
 #include "brasero-session-helper.h"
+#include "brasero-tags.h"
 #include "brasero-drive-properties.h"
 
 typedef struct _BraseroDriveSettingsPrivate BraseroDriveSettingsPrivate;
@@ -52,6 +53,7 @@ struct _BraseroDriveSettingsPrivate
 
 #define BRASERO_SCHEMA_CONFIG			"org.gnome.brasero.config"
 #define BRASERO_PROPS_TMP_DIR			"tmpdir"
+#define BRASERO_PROPS_TMP_IMAGE_RAM_BUDGET	"tmpimage-ram-budget"
 
 #define BRASERO_DEST_SAVED_FLAGS		(BRASERO_DRIVE_PROPERTIES_FLAGS|BRASERO_BURN_FLAG_MULTI)
 
@@ -70,22 +72,9 @@ brasero_drive_settings_get_mapping_speed (GValue *value,
                                           GVariant *variant,
                                           gpointer user_data)
 {
-	if (!g_variant_get_int32 (variant)) {
-		BraseroDriveSettingsPrivate *priv;
-		BraseroMedium *medium;
-		BraseroDrive *drive;
-
-		priv = BRASERO_DRIVE_SETTINGS_PRIVATE (user_data);
-		drive = brasero_burn_session_get_burner (priv->session);
-		medium = brasero_drive_get_medium (drive);
-
-		/* Must not be NULL since we only bind when a medium is available */
-		g_assert (medium != NULL);
-
-		g_value_set_int64 (value, brasero_medium_get_max_write_speed (medium));
-	}
-	else
-		g_value_set_int64 (value, g_variant_get_int32 (variant) * 1000);
+	/* 0 means the user never chose a speed; leave it unset so that the
+	 * session can use the speed profile of the medium */
+	g_value_set_int64 (value, g_variant_get_int32 (variant) * 1000);
 
 	return TRUE;
 }
@@ -361,6 +350,11 @@ brasero_drive_settings_set_session (BraseroDriveSettings *self,
 	g_settings_bind (priv->config_settings,
 	                 BRASERO_PROPS_TMP_DIR, session,
 	                 "tmpdir", G_SETTINGS_BIND_DEFAULT);
+
+	brasero_burn_session_tag_add_int (session,
+	                                  BRASERO_SESSION_TMP_IMAGE_RAM_BUDGET,
+	                                  g_settings_get_int (priv->config_settings,
+	                                                      BRASERO_PROPS_TMP_IMAGE_RAM_BUDGET));
 }
 
 static void
@@ -36,6 +36,7 @@
 
 #include <libxml/xmlerror.h>
 #include <libxml/xmlwriter.h>
+#include <libxml/xmlreader.h>
 #include <libxml/parser.h>
 #include <libxml/xmlstring.h>
 #include <libxml/uri.h>
@@ -114,83 +115,6 @@ error:
 	return NULL;
 }
 
-static BraseroTrack *
-_read_data_track (xmlDocPtr project,
-		  xmlNodePtr item)
-{
-	BraseroTrackDataCfg *track;
-        GSList *grafts= NULL;
-        GSList *excluded = NULL;
-
-	track = brasero_track_data_cfg_new ();
-
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "graft")) {
-			if (!(grafts = _read_graft_point (project, item->xmlChildrenNode, grafts)))
-				goto error;
-		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "icon")) {
-			xmlChar *icon_path;
-
-			icon_path = xmlNodeListGetString (project,
-							  item->xmlChildrenNode,
-							  1);
-			if (!icon_path)
-				goto error;
-
-			brasero_track_data_cfg_set_icon (track, (gchar *) icon_path, NULL);
-                        g_free (icon_path);
-		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "restored")) {
-			xmlChar *restored;
-
-			restored = xmlNodeListGetString (project,
-							 item->xmlChildrenNode,
-							 1);
-			if (!restored)
-				goto error;
-
-                        brasero_track_data_cfg_dont_filter_uri (track, (gchar *) restored);
-                        g_free (restored);
-		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "excluded")) {
-			xmlChar *excluded_uri;
-
-			excluded_uri = xmlNodeListGetString (project,
-							     item->xmlChildrenNode,
-							     1);
-			if (!excluded_uri)
-				goto error;
-
-			excluded = g_slist_prepend (excluded, xmlURIUnescapeString ((char*) excluded_uri, 0, NULL));
-			g_free (excluded_uri);
-		}
-		else if (item->type == XML_ELEMENT_NODE)
-			goto error;
-
-		item = item->next;
-	}
-
-        grafts = g_slist_reverse (grafts);
-        excluded = g_slist_reverse (excluded);
-        brasero_track_data_set_source (BRASERO_TRACK_DATA (track),
-                                                           grafts,
-                                                           excluded);
-	return BRASERO_TRACK (track);
-
-error:
-
-        g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
-        g_slist_free (grafts);
-
-        g_slist_foreach (excluded, (GFunc) g_free, NULL);
-        g_slist_free (excluded);
-
-	g_object_unref (track);
-
-	return NULL;
-}
-
 static BraseroTrack *
 _read_audio_track (xmlDocPtr project,
 		   xmlNodePtr uris,
@@ -362,61 +286,330 @@ error:
 	return NULL;
 }
 
+/**
+ * Projects are read with an xmlTextReader so that only the current element is
+ * in memory at any time. Grafts and excluded URIs of data tracks are handed
+ * to the track in batches as they are read instead of being gathered first.
+ */
+
+#define BRASERO_PROJECT_LOAD_BATCH		1024
+#define BRASERO_PROJECT_PROGRESS_INTERVAL	512
+
+typedef struct _BraseroProjectReader BraseroProjectReader;
+struct _BraseroProjectReader {
+	xmlTextReaderPtr reader;
+
+	/* Progress */
+	GtkWidget *status;
+	guint status_ctx;
+	goffset size;
+	guint nodes;
+	gint percent;
+
+	/* Binary snapshot of the data tree if there is an up to date one */
+	gchar *snapshot;
+
+	guint pending:1;
+};
+
+static void
+brasero_project_reader_progress (BraseroProjectReader *self)
+{
+	GdkWindow *window;
+	gchar *string;
+	gint percent;
+
+	if (!self->status || self->size <= 0)
+		return;
+
+	self->nodes ++;
+	if (self->nodes % BRASERO_PROJECT_PROGRESS_INTERVAL)
+		return;
+
+	percent = xmlTextReaderByteConsumed (self->reader) * 100 / self->size;
+	if (percent == self->percent)
+		return;
+
+	self->percent = percent;
+
+	/* Translators: %i is a percentage */
+	string = g_strdup_printf (_("Loading project (%i%%)"), CLAMP (percent, 0, 100));
+	gtk_statusbar_pop (GTK_STATUSBAR (self->status), self->status_ctx);
+	gtk_statusbar_push (GTK_STATUSBAR (self->status), self->status_ctx, string);
+	g_free (string);
+
+	/* Only redraw the status bar. Running the main loop here would let
+	 * any other event (like opening another project) be handled in the
+	 * middle of the parsing. */
+	window = gtk_widget_get_window (self->status);
+	if (window) {
+		gtk_widget_queue_draw (self->status);
+		gdk_window_process_updates (window, TRUE);
+	}
+}
+
+/**
+ * Moves to the next element child of the element at @depth - 1.
+ * Returns 1 if there is one, 0 if there is no more child and -1 on error.
+ */
+static gint
+brasero_project_reader_next_element (BraseroProjectReader *self,
+				     gint depth)
+{
+	while (1) {
+		gint node_depth;
+		gint type;
+
+		if (self->pending)
+			self->pending = FALSE;
+		else {
+			gint res;
+
+			res = xmlTextReaderRead (self->reader);
+			if (res <= 0)
+				return res;
+
+			brasero_project_reader_progress (self);
+		}
+
+		type = xmlTextReaderNodeType (self->reader);
+		node_depth = xmlTextReaderDepth (self->reader);
+		if (node_depth < depth) {
+			/* Keep the node for the upper level unless it is the
+			 * end of the parent element */
+			if (type != XML_READER_TYPE_END_ELEMENT
+			||  node_depth != depth - 1)
+				self->pending = TRUE;
+
+			return 0;
+		}
+
+		if (node_depth == depth && type == XML_READER_TYPE_ELEMENT)
+			return 1;
+	}
+
+	return -1;
+}
+
+static xmlChar *
+brasero_project_reader_get_string (BraseroProjectReader *self)
+{
+	xmlNodePtr node;
+
+	node = xmlTextReaderExpand (self->reader);
+	if (!node)
+		return NULL;
+
+	return xmlNodeListGetString (xmlTextReaderCurrentDoc (self->reader),
+				     node->xmlChildrenNode,
+				     1);
+}
+
+static gchar *
+brasero_project_snapshot_get_path (const gchar *path)
+{
+	gchar *snapshot;
+	gchar *checksum;
+	gchar *name;
+
+	checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+	name = g_strconcat (checksum, ".snapshot", NULL);
+	g_free (checksum);
+
+	snapshot = g_build_filename (g_get_user_cache_dir (),
+				     "brasero",
+				     "snapshots",
+				     name,
+				     NULL);
+	g_free (name);
+	return snapshot;
+}
+
+static void
+brasero_project_save_snapshot (const gchar *path,
+			       BraseroTrackDataCfg *track)
+{
+	gchar *directory;
+	gchar *snapshot;
+
+	snapshot = brasero_project_snapshot_get_path (path);
+	directory = g_path_get_dirname (snapshot);
+	g_mkdir_with_parents (directory, S_IRWXU);
+	g_free (directory);
+
+	/* Don't leave an outdated snapshot behind if it fails (which happens
+	 * if the project is still loading) */
+	if (!brasero_track_data_cfg_save_snapshot (track, snapshot, NULL))
+		g_remove (snapshot);
+
+	g_free (snapshot);
+}
+
+static BraseroTrack *
+_read_data_track (BraseroProjectReader *self)
+{
+	BraseroTrackDataCfg *track;
+        GSList *grafts= NULL;
+        GSList *excluded = NULL;
+	gboolean restored = FALSE;
+	guint num = 0;
+	gint res;
+
+	track = brasero_track_data_cfg_new ();
+
+	/* The snapshot has the whole tree so grafts and excluded URIs are then
+	 * useless; if it can't be loaded, fall back on them. */
+	if (self->snapshot)
+		restored = brasero_track_data_cfg_load_snapshot (track, self->snapshot, NULL);
+
+	if (!restored && !brasero_track_data_cfg_load_begin (track)) {
+		g_object_unref (track);
+		return NULL;
+	}
+
+	while ((res = brasero_project_reader_next_element (self, 3)) == 1) {
+		const xmlChar *name;
+
+		name = xmlTextReaderConstName (self->reader);
+		if (restored
+		&& (!xmlStrcmp (name, (const xmlChar *) "graft")
+		||  !xmlStrcmp (name, (const xmlChar *) "excluded"))) {
+			/* Already in the snapshot */
+		}
+		else if (!xmlStrcmp (name, (const xmlChar *) "graft")) {
+			xmlNodePtr graft;
+
+			graft = xmlTextReaderExpand (self->reader);
+			if (!graft)
+				goto error;
+
+			if (!(grafts = _read_graft_point (xmlTextReaderCurrentDoc (self->reader), graft->xmlChildrenNode, grafts)))
+				goto error;
+
+			num ++;
+		}
+		else if (!xmlStrcmp (name, (const xmlChar *) "icon")) {
+			xmlChar *icon_path;
+
+			icon_path = brasero_project_reader_get_string (self);
+			if (!icon_path)
+				goto error;
+
+			brasero_track_data_cfg_set_icon (track, (gchar *) icon_path, NULL);
+                        g_free (icon_path);
+		}
+		else if (!xmlStrcmp (name, (const xmlChar *) "restored")) {
+			xmlChar *restored;
+
+			restored = brasero_project_reader_get_string (self);
+			if (!restored)
+				goto error;
+
+                        brasero_track_data_cfg_dont_filter_uri (track, (gchar *) restored);
+                        g_free (restored);
+		}
+		else if (!xmlStrcmp (name, (const xmlChar *) "excluded")) {
+			xmlChar *excluded_uri;
+
+			excluded_uri = brasero_project_reader_get_string (self);
+			if (!excluded_uri)
+				goto error;
+
+			excluded = g_slist_prepend (excluded, xmlURIUnescapeString ((char*) excluded_uri, 0, NULL));
+			g_free (excluded_uri);
+
+			num ++;
+		}
+		else
+			goto error;
+
+		if (num >= BRASERO_PROJECT_LOAD_BATCH) {
+			brasero_track_data_cfg_load_add (track,
+							 g_slist_reverse (grafts),
+							 g_slist_reverse (excluded));
+			grafts = NULL;
+			excluded = NULL;
+			num = 0;
+		}
+	}
+
+	if (res < 0)
+		goto error;
+
+	if (restored)
+		return BRASERO_TRACK (track);
+
+	brasero_track_data_cfg_load_add (track,
+					 g_slist_reverse (grafts),
+					 g_slist_reverse (excluded));
+	brasero_track_data_cfg_load_end (track);
+	return BRASERO_TRACK (track);
+
+error:
+
+        g_slist_foreach (grafts, (GFunc) brasero_graft_point_free, NULL);
+        g_slist_free (grafts);
+
+        g_slist_foreach (excluded, (GFunc) g_free, NULL);
+        g_slist_free (excluded);
+
+	g_object_unref (track);
+
+	return NULL;
+}
+
 static gboolean
-_get_tracks (xmlDocPtr project,
-	     xmlNodePtr track_node,
-	     BraseroBurnSession *session)
+_get_tracks (BraseroProjectReader *self,
+	     GSList **tracks_retval)
 {
 	GSList *tracks = NULL;
-	GSList *iter;
-
-	track_node = track_node->xmlChildrenNode;
+	gint res;
 
-	while (track_node) {
+	while ((res = brasero_project_reader_next_element (self, 2)) == 1) {
 		BraseroTrack *newtrack;
+		const xmlChar *name;
+		xmlNodePtr node;
 
-		if (!xmlStrcmp (track_node->name, (const xmlChar *) "audio")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, FALSE);
+		name = xmlTextReaderConstName (self->reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "audio")) {
+			node = xmlTextReaderExpand (self->reader);
+			if (!node)
+				goto error;
+
+			newtrack = _read_audio_track (xmlTextReaderCurrentDoc (self->reader), node->xmlChildrenNode, FALSE);
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "data")) {
-			newtrack = _read_data_track (project, track_node->xmlChildrenNode);
+		else if (!xmlStrcmp (name, (const xmlChar *) "data")) {
+			newtrack = _read_data_track (self);
 
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (!xmlStrcmp (track_node->name, (const xmlChar *) "video")) {
-			newtrack = _read_audio_track (project, track_node->xmlChildrenNode, TRUE);
+		else if (!xmlStrcmp (name, (const xmlChar *) "video")) {
+			node = xmlTextReaderExpand (self->reader);
+			if (!node)
+				goto error;
+
+			newtrack = _read_audio_track (xmlTextReaderCurrentDoc (self->reader), node->xmlChildrenNode, TRUE);
 
 			if (!newtrack)
 				goto error;
 
 			tracks = g_slist_append (tracks, newtrack);
 		}
-		else if (track_node->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		track_node = track_node->next;
 	}
 
-	if (!tracks)
+	if (res < 0 || !tracks)
 		goto error;
 
-	for (iter = tracks; iter; iter = iter->next) {
-		BraseroTrack *newtrack;
-
-		newtrack = iter->data;
-		brasero_burn_session_add_track (session, newtrack, NULL);
-		g_object_unref (newtrack);
-	}
-
-	g_slist_free (tracks);
-
+	*tracks_retval = tracks;
 	return TRUE;
 
 error :
@@ -434,14 +627,17 @@ brasero_project_open_project_xml (const gchar *uri,
 				  BraseroBurnSession *session,
 				  gboolean warn_user)
 {
-	xmlNodePtr track_node = NULL;
+	BraseroProjectReader self = { NULL, };
+	GSList *tracks = NULL;
 	gchar *label = NULL;
 	gchar *cover = NULL;
-	xmlDocPtr project;
-	xmlNodePtr item;
+	const xmlChar *name;
+	GStatBuf info;
 	gboolean retval;
+	GSList *iter;
 	GFile *file;
 	gchar *path;
+	gint res;
 
 	file = g_file_new_for_commandline_arg (uri);
 	path = g_file_get_path (file);
@@ -450,71 +646,110 @@ brasero_project_open_project_xml (const gchar *uri,
 		return FALSE;
 
 	/* start parsing xml doc */
-	project = xmlParseFile (path);
-    	g_free (path);
-
-	if (!project) {
+	self.reader = xmlReaderForFile (path, NULL, 0);
+	if (!self.reader) {
+		g_free (path);
 	    	if (warn_user)
 			brasero_project_invalid_project_dialog (_("The project could not be opened"));
 
 		return FALSE;
 	}
 
+	if (!g_stat (path, &info)) {
+		GStatBuf snapshot_info;
+
+		self.size = info.st_size;
+
+		/* Only use a snapshot written after the project was */
+		self.snapshot = brasero_project_snapshot_get_path (path);
+		if (g_stat (self.snapshot, &snapshot_info)
+		||  snapshot_info.st_mtime < info.st_mtime) {
+			g_free (self.snapshot);
+			self.snapshot = NULL;
+		}
+	}
+    	g_free (path);
+
+	self.percent = -1;
+	self.status = brasero_app_get_statusbar1 (brasero_app_get_default ());
+	if (self.status)
+		self.status_ctx = gtk_statusbar_get_context_id (GTK_STATUSBAR (self.status),
+								"loading_info");
+
 	/* parses the "header" */
-	item = xmlDocGetRootElement (project);
-	if (!item) {
+	res = brasero_project_reader_next_element (&self, 0);
+	if (res <= 0) {
 	    	if (warn_user)
-			brasero_project_invalid_project_dialog (_("The file is empty"));
+			brasero_project_invalid_project_dialog (res < 0? _("The project could not be opened"):_("The file is empty"));
+
+		if (self.status)
+			gtk_statusbar_pop (GTK_STATUSBAR (self.status), self.status_ctx);
 
-		xmlFreeDoc (project);
+		xmlFreeTextReader (self.reader);
+		g_free (self.snapshot);
 		return FALSE;
 	}
 
-	if (xmlStrcmp (item->name, (const xmlChar *) "braseroproject")
-	||  item->next)
+	if (xmlStrcmp (xmlTextReaderConstName (self.reader), (const xmlChar *) "braseroproject"))
 		goto error;
 
-	item = item->children;
-	while (item) {
-		if (!xmlStrcmp (item->name, (const xmlChar *) "version")) {
+	while ((res = brasero_project_reader_next_element (&self, 1)) == 1) {
+		name = xmlTextReaderConstName (self.reader);
+		if (!xmlStrcmp (name, (const xmlChar *) "version")) {
 			/* simply ignore it */
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "label")) {
-			label = (gchar *) xmlNodeListGetString (project,
-								item->xmlChildrenNode,
-								1);
+		else if (!xmlStrcmp (name, (const xmlChar *) "label")) {
+			if (label)
+				goto error;
+
+			label = (gchar *) brasero_project_reader_get_string (&self);
 			if (!(label))
 				goto error;
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "cover")) {
+		else if (!xmlStrcmp (name, (const xmlChar *) "cover")) {
 			xmlChar *escaped;
 
-			escaped = xmlNodeListGetString (project,
-							item->xmlChildrenNode,
-							1);
+			if (cover)
+				goto error;
+
+			escaped = brasero_project_reader_get_string (&self);
 			if (!escaped)
 				goto error;
 
 			cover = g_uri_unescape_string ((char *) escaped, NULL);
 			g_free (escaped);
 		}
-		else if (!xmlStrcmp (item->name, (const xmlChar *) "track")) {
-			if (track_node)
+		else if (!xmlStrcmp (name, (const xmlChar *) "track")) {
+			if (tracks)
 				goto error;
 
-			track_node = item;
+			if (!_get_tracks (&self, &tracks))
+				goto error;
 		}
-		else if (item->type == XML_ELEMENT_NODE)
+		else
 			goto error;
-
-		item = item->next;
 	}
 
-	retval = _get_tracks (project, track_node, session);
-	if (!retval)
+	if (res < 0 || !tracks)
 		goto error;
 
-	xmlFreeDoc (project);
+	retval = TRUE;
+
+	if (self.status)
+		gtk_statusbar_pop (GTK_STATUSBAR (self.status), self.status_ctx);
+
+	xmlFreeTextReader (self.reader);
+	g_free (self.snapshot);
+
+	/* Only add the tracks once the whole project was read */
+	for (iter = tracks; iter; iter = iter->next) {
+		BraseroTrack *newtrack;
+
+		newtrack = iter->data;
+		brasero_burn_session_add_track (session, newtrack, NULL);
+		g_object_unref (newtrack);
+	}
+	g_slist_free (tracks);
 
         brasero_burn_session_set_label (session, label);
         g_free (label);
@@ -536,12 +771,22 @@ brasero_project_open_project_xml (const gchar *uri,
 
 error:
 
+	if (tracks) {
+		g_slist_foreach (tracks, (GFunc) g_object_unref, NULL);
+		g_slist_free (tracks);
+	}
+
 	if (cover)
 		g_free (cover);
 	if (label)
 		g_free (label);
 
-	xmlFreeDoc (project);
+	if (self.status)
+		gtk_statusbar_pop (GTK_STATUSBAR (self.status), self.status_ctx);
+
+	xmlFreeTextReader (self.reader);
+	g_free (self.snapshot);
+
     	if (warn_user)
 		brasero_project_invalid_project_dialog (_("It does not seem to be a valid Brasero project"));
 
@@ -808,6 +1053,7 @@ gboolean
 brasero_project_save_project_xml (BraseroBurnSession *session,
 				  const gchar *uri)
 {
+	BraseroTrackDataCfg *data_track = NULL;
 	BraseroTrackType *track_type = NULL;
 	xmlTextWriter *project;
 	gboolean retval;
@@ -912,6 +1158,9 @@ brasero_project_save_project_xml (BraseroBurnSession *session,
 			if (!retval)
 				goto error;
 
+			if (BRASERO_IS_TRACK_DATA_CFG (track))
+				data_track = BRASERO_TRACK_DATA_CFG (track);
+
 			success = xmlTextWriterEndElement (project); /* data */
 			if (success < 0)
 				goto error;
@@ -932,6 +1181,11 @@ brasero_project_save_project_xml (BraseroBurnSession *session,
 
 	xmlTextWriterEndDocument (project);
 	xmlFreeTextWriter (project);
+
+	/* Written after the project so that it is more recent */
+	if (data_track)
+		brasero_project_save_snapshot (path, data_track);
+
 	g_free (path);
 	return TRUE;
 
@@ -619,7 +619,7 @@ brasero_split_dialog_metadata_finished_cb (BraseroMetadata *metadata,
 	BraseroMetadataInfo info = { NULL, };
 	BraseroSplitDialogPrivate *priv;
 	gboolean added_silence;
-	GSList *iter;
+	guint i;
 
 	priv = BRASERO_SPLIT_DIALOG_PRIVATE (self);
 
@@ -637,20 +637,18 @@ brasero_split_dialog_metadata_finished_cb (BraseroMetadata *metadata,
 	}
 
 	brasero_metadata_get_result (metadata, &info, NULL);
-	if (!info.silences) {
+	if (!info.silences || !info.silences->len) {
 		brasero_split_dialog_no_silence_message (self);
+		brasero_metadata_info_clear (&info);
 		return;
 	}
 
 	/* remove silences */
 	added_silence = FALSE;
-	for (iter = info.silences; iter; iter = iter->next) {
+	for (i = 0; i < info.silences->len; i ++) {
 		BraseroMetadataSilence *silence;
 
-		silence = iter->data;
-
-		if (!silence)
-			continue;
+		silence = &g_array_index (info.silences, BraseroMetadataSilence, i);
 
 		if (silence->start >= priv->end)
 			continue;